@@ -15,6 +15,22 @@ export enum NPDFOutlineFormat {
     Unknown = 0xFF
 }
 
+/**
+ * A bookmark of Outline.build and Outline.toTree
+ */
+export interface NPDFOutlineNode {
+    title: string
+    // page index of the destination, -1 if the destination is not a page of the document
+    page: number
+    // defaults to NPDFDestinationFit.Fit
+    fit?: NPDFDestinationFit
+    // top (FitH, FitBH) or left (FitV, FitBV) coordinate, defaults to the top or left edge of the page
+    value?: number
+    // show the children expanded, defaults to false
+    open?: boolean
+    children?: NPDFOutlineNode[]
+}
+
 export interface NPDFFontMetrics {
     lineSpacing: number
     underlineThickness: number
@@ -114,6 +130,100 @@ export enum NPDFAlignment {
     Right
 }
 
+/**
+ * Opcodes for Painter.execute. Each opcode consumes its operands, in the listed order,
+ * from the operand Float64Array. `string` is an index into the string table and
+ * `resource` an index into the resource table, booleans are encoded as 0 or 1.
+ */
+export enum NPDFPainterOp {
+    MoveTo, // x y
+    LineTo, // x y
+    CubicBezierTo, // x1 y1 x2 y2 x3 y3
+    HorizontalLineTo, // x
+    VerticalLineTo, // y
+    SmoothCurveTo, // x1 y1 x2 y2
+    QuadCurveTo, // x1 y1 x2 y2
+    ArcTo, // x1 y1 x2 y2 rotation large sweep
+    ClosePath,
+    Close,
+    Rectangle, // x y width height
+    Ellipse, // x y width height
+    Circle, // x y radius
+    Stroke,
+    Fill,
+    FillAndStroke,
+    EndPath,
+    Clip,
+    Save,
+    Restore,
+    SetColor, // r g b
+    SetStrokingColor, // r g b
+    SetGrey, // v
+    SetStrokingGrey, // v
+    SetColorCMYK, // c m y k
+    SetStrokingColorCMYK, // c m y k
+    SetStrokeWidth, // w
+    SetStrokeStyle, // style scale
+    SetLineCapStyle, // style
+    SetLineJoinStyle, // style
+    SetMiterLimit, // v
+    SetClipRect, // x y width height
+    SetFont, // resource
+    SetExtGState, // resource
+    DrawLine, // x1 y1 x2 y2
+    DrawText, // x y string
+    DrawTextAligned, // x y width alignment string
+    DrawMultiLineText, // x y width height alignment vertical string
+    DrawImage, // resource x y scaleX scaleY
+    BeginText, // x y
+    MoveTextPosition, // x y
+    AddText, // string
+    EndText
+}
+
+export interface NPDFTextLayoutOptions {
+    /**
+     * Apply the font's kerning pairs when measuring (TrueType / OpenType fonts only)
+     */
+    kerning?: boolean
+    /**
+     * Hyphenation hook, returns the character indices at which word may be broken with a hyphen.
+     * Soft hyphens (\u00AD) in the text are always break opportunities.
+     */
+    hyphenate?: (word: string) => number[]
+}
+
+export type NPDFStreamTableChunk = string[] | string[][] | Float64Array
+
+export interface NPDFStreamTableOptions {
+    font: nopodofo.Font
+    columns: Array<{ width: number, alignment?: NPDFAlignment, decimals?: number }>
+    header?: string[]
+    headerFont?: nopodofo.Font
+    headerBackground?: nopodofo.Color
+    /**
+     * Media box of the created pages, defaults to US Letter
+     */
+    pageSize?: nopodofo.Rect
+    margin?: number
+    padding?: number
+    /**
+     * Cell border stroke width, 0 disables borders
+     */
+    border?: number
+    wordWrap?: boolean
+}
+
+export interface NPDFDisplayListSlots {
+    ops: Uint8Array
+    operands: Float64Array
+    /**
+     * Positions in operands replaced by the number values passed to drawList
+     */
+    numbers?: Uint32Array
+    resources?: Array<nopodofo.Font | nopodofo.ExtGState | nopodofo.Image>
+}
+
 export type NPDFDictionaryKeyType = 'boolean' | 'long' | 'name' | 'real'
 
 export type NPDFInternal = any
@@ -129,6 +239,77 @@ export enum NPDFSigFlags {
     SignatureExistsAppendOnly = 3
 }
 
+export type NPDFImageSource = string | Buffer | { source: string | Buffer, format?: NPDFImageFormat }
+
+export interface NPDFImageLoadOptions {
+    // format of sources that do not specify one, defaults to data
+    format?: NPDFImageFormat
+    // worker threads, defaults to the hardware concurrency
+    threads?: number
+    optimize?: NPDFImageOptimizeOptions
+}
+
+export interface NPDFImageOptimizeOptions {
+    // target resolution, defaults to 150
+    dpi?: number
+    // only downsample above dpi * threshold, defaults to 1.5
+    threshold?: number
+    // zlib compression level -1 - 9
+    compressionLevel?: number
+    // Document.optimizeImages worker threads, defaults to the hardware concurrency
+    threads?: number
+    // placement size in points, Image.load only
+    width?: number
+    height?: number
+}
+
+export interface NPDFImageReport {
+    action: 'passthrough' | 'recompressed' | 'downsampled' | 'skipped'
+    originalWidth: number
+    originalHeight: number
+    width: number
+    height: number
+    // resolution at the largest placement, 0 when unknown
+    dpi: number
+    originalBytes: number
+    bytes: number
+    saved: number
+    // Document.optimizeImages only
+    object?: number
+    generation?: number
+}
+
+export interface NPDFRedactOptions {
+    // paint the rects after removing the content below them, defaults to true
+    fill?: boolean
+    // RGB fill color, defaults to black
+    color?: number[]
+    // Document.redact worker threads, defaults to the hardware concurrency
+    threads?: number
+}
+
+export interface NPDFRedactReport {
+    // glyphs removed from text show operators
+    glyphs: number
+    // image XObject placements and inline images removed
+    images: number
+    // form XObject placements removed, a form is removed whole
+    forms: number
+    // /Resources /XObject entries removed because nothing on the page draws them any more
+    resources: number
+}
+
+export interface NPDFImageCacheStats {
+    entries: number
+    bytes: number
+    limit: number
+    // images copied from the process wide cache into a document
+    hits: number
+    // images resolved to an XObject already embedded in the same document
+    documentHits: number
+    misses: number
+}
+
 export enum NPDFImageFormat {
     data,
     png,
@@ -373,6 +554,128 @@ export enum NPDFWriteMode {
     Compact = 0x02
 }
 
+export interface NPDFToJSOptions {
+    /**
+     * Replace Ref values with the objects they point to. An object referenced more than once is converted once
+     * and shared, a reference back to an object that is still being converted (i.e. /Parent) is left as a Ref.
+     */
+    resolveRefs?: boolean
+    // number of references followed from the starting object, defaults to -1 (no limit)
+    depth?: number
+    // create each dictionary key and name string once per call, defaults to true
+    keyCache?: boolean
+}
+
+/**
+ * Metadata of every terminal field of a form, one typed array per attribute indexed by field.
+ * Names and values are indexes into the strings table.
+ */
+export interface NPDFFormDescription {
+    count: number
+    strings: string[]
+    name: Uint32Array
+    // NPDFFieldType
+    type: Uint8Array
+    // -1 when the field has no value, selected list box options are joined by '\n'
+    value: Int32Array
+    // left, bottom, width, height of each field's widget, 4 entries per field
+    rect: Float64Array
+    // /Ff field flags
+    flags: Uint32Array
+    // page index of the widget, -1 when the widget is not on a page
+    page: Int32Array
+}
+
+export interface NPDFAnnotationBatchOptions {
+    // /C of every annotation, 0, 1 (grey), 3 (RGB) or 4 (CMYK) components
+    color?: number[] | Float64Array
+    // RGB /C per annotation, 3 entries per annotation, takes precedence over color
+    colors?: Float64Array
+    // /QuadPoints, 8 entries per annotation. Highlight, Underline, Squiggly and StrikeOut
+    // annotations cover their rect when not given
+    quadPoints?: Float64Array
+    // NPDFAnnotationFlag bits
+    flags?: number
+    // /CA constant opacity
+    opacity?: number
+    title?: string
+    contents?: string
+}
+
+export interface NPDFAnnotationGeometry {
+    count: number
+    // index of each annotation in the page's annotations, see Page.getAnnotation
+    index: Uint32Array
+    // object number, 0 for a direct annotation
+    object: Uint32Array
+    // NPDFAnnotation, 255 when unknown
+    type: Uint8Array
+    // left, bottom, width, height, 4 entries per annotation
+    rect: Float64Array
+    // NPDFAnnotationFlag bits
+    flags: Uint32Array
+    // /C, 4 entries per annotation, unused components are NaN
+    color: Float64Array
+    // every annotation's /QuadPoints, annotation i has quadPoints[quadStart[i]] to quadPoints[quadStart[i + 1]]
+    quadPoints: Float64Array
+    quadStart: Uint32Array
+}
+
+export interface NPDFWriteOptions {
+    /**
+     * Pack non-stream objects into compressed object streams (/ObjStm) and write the
+     * cross reference section as an /XRef stream. Output is written as PDF 1.5 or later.
+     */
+    objectStreams?: boolean
+    /**
+     * Flate compress every stream that does not have a filter before the document is written.
+     * Compression runs on a pool of worker threads, the written output is identical to a serial run.
+     */
+    compress?: boolean
+    /**
+     * zlib compression level, 0 (none) - 9 (best), defaults to -1 (zlib default). Lower levels are faster.
+     */
+    compressionLevel?: number
+    /**
+     * Number of compression threads, defaults to the number of cores
+     */
+    threads?: number
+    /**
+     * Write a linearized (fast web view) file: the objects needed for the first page are written first,
+     * followed by the remaining pages in order, with a hint stream and linearization dictionary.
+     * Uses classic cross reference tables, objectStreams is ignored when set.
+     */
+    linearize?: boolean
+}
+
+export interface NPDFGCOptions extends NPDFWriteOptions {
+    /**
+     * Write the collected document to this path instead of returning a Buffer
+     */
+    output?: string
+}
+
+export interface NPDFGCStats {
+    /**
+     * Unreachable objects plus duplicate streams removed
+     */
+    objectsRemoved: number
+    /**
+     * Streams removed because an identical stream was kept
+     */
+    duplicateStreams: number
+    /**
+     * Input size minus output size, 0 if the output is not smaller
+     */
+    bytesRemoved: number
+    /**
+     * Size of the collected document
+     */
+    size: number
+}
+
+export type GCCallback = (err: Error, data: Buffer | string, stats: NPDFGCStats) => void
+
 export enum NPDFActions {
     GoTo = 0,
     GoToR,
@@ -752,9 +1055,9 @@ export namespace nopodofo {
         constructor(file: string, doc: Base, embed?: boolean)
 
         /**
-         * Copy an existing FileSpec from an Obj
+         * Copy an existing FileSpec from an Obj, pass the document owning obj to keep it alive as long as the FileSpec
          */
-        constructor(obj: Object)
+        constructor(obj: Object, doc?: Base)
 
         readonly name: string
 
@@ -763,6 +1066,15 @@ export namespace nopodofo {
          * @returns {Buffer | undefined}
          */
         getContents(): Buffer | undefined
+
+        /**
+         * @desc Decode the embedded file to a file or a Writable on a worker thread, chunk by chunk.
+         * The document must not be modified until the returned promise settles.
+         * @param destination - file path or Writable stream
+         * @param opts.end - end the Writable once the file has been written, default true
+         * @returns the decoded length in bytes
+         */
+        extractTo(destination: string | NodeJS.WritableStream, opts?: { end?: boolean }): Promise<number>
     }
 
     export class Form {
@@ -774,6 +1086,38 @@ export namespace nopodofo {
         SigFlags?: NPDFSigFlags
 
         // createAppearanceStream<T extends Field>(bg: Color, fg: Color, font: Font, size: number)
+
+        /**
+         * @desc Find a field by its fully qualified name (partial names joined by '.', i.e. "address.city").
+         * Fields are indexed once per document, lookups do not scan the pages.
+         * @returns null if there is no such field or the field has no widget on a page
+         */
+        getField<T extends Field>(name: string): T | null
+
+        /**
+         * @desc Fully qualified names of the terminal fields in AcroForm /Fields order
+         */
+        fieldNames(): string[]
+
+        /**
+         * @desc Delete fields by fully qualified name or reference. The fields are removed from /Fields, the /Kids of their
+         * parents, /CO and their widgets from the pages /Annots in a single pass; parents left without kids are removed too.
+         * @returns the number of fields removed, unknown names and references are skipped
+         */
+        deleteFields(fields: Array<string | Ref>): number
+
+        /**
+         * @desc Columnar metadata of every terminal field, collected in one pass over /Fields
+         */
+        describe(): NPDFFormDescription
+
+        /**
+         * @desc Describe the forms of many PDF documents, each buffer is parsed and described on the worker pool
+         * @param buffers - PDF documents
+         * @param opts - threads: worker threads, 0 (default) uses the hardware concurrency
+         * @returns descriptions in buffer order
+         */
+        static describeMany(buffers: Buffer[], opts?: { threads?: number }): Promise<NPDFFormDescription[]>
     }
 
     export class Image {
@@ -786,8 +1130,49 @@ export namespace nopodofo {
          */
         constructor(doc: Base, source: string | Buffer, format?: NPDFImageFormat)
 
+        /**
+         * Read, decode and compress the image on a worker thread, then embed it in the document
+         * @param {Base} doc
+         * @param {string | Buffer} source
+         * @param {NPDFImageFormat} [format] - defaults to data
+         * @param {NPDFImageOptimizeOptions} [optimize] - downsample / recompress for the placement size
+         * @param {Callback<Image>} cb
+         * @returns void
+         */
+        static load(doc: Base, source: string | Buffer, cb: Callback<Image>): void
+        static load(doc: Base, source: string | Buffer, format: NPDFImageFormat, cb: Callback<Image>): void
+        static load(doc: Base, source: string | Buffer, format: NPDFImageFormat, optimize: NPDFImageOptimizeOptions, cb: Callback<Image>): void
+
+        /**
+         * Decode many images in parallel, calls back with the Images in source order
+         * @param {Base} doc
+         * @param {NPDFImageSource[]} sources
+         * @param {NPDFImageLoadOptions} [opts]
+         * @param {Callback<Image[]>} cb
+         * @returns void
+         */
+        static loadMany(doc: Base, sources: Array<NPDFImageSource>, cb: Callback<Image[]>): void
+        static loadMany(doc: Base, sources: Array<NPDFImageSource>, opts: NPDFImageLoadOptions, cb: Callback<Image[]>): void
+
+        /**
+         * Counters and size of the process wide image cache
+         */
+        static cacheStats(): NPDFImageCacheStats
+
+        /**
+         * Bound the encoded image data kept by the process wide cache, in bytes (default 64MB).
+         * 0 disables the process wide cache, images are still shared within a document.
+         */
+        static setCacheLimit(bytes: number): void
+
+        static clearCache(): void
+
         readonly width: number
         readonly height: number
+        /**
+         * What optimizing the image on load did, null when it was not optimized
+         */
+        readonly report: NPDFImageReport | null
 
         setICCProfile(input: Buffer, colorComponent: number, alt: NPDFColorSpace): void
 
@@ -833,6 +1218,30 @@ export namespace nopodofo {
          */
         listFonts(): { name: string, id: string, file: string }[]
 
+        /**
+         * Downsample and recompress the images drawn on the pages of the document
+         * @param {NPDFImageOptimizeOptions} [opts]
+         * @returns {NPDFImageReport[]} one report per image
+         */
+        optimizeImages(opts?: NPDFImageOptimizeOptions): NPDFImageReport[]
+
+        /**
+         * Remove the content drawn under rects from the page at the same index in pages, see Page.redact.
+         * The content of the pages is rewritten in parallel.
+         * @param pages - zero based page index per rect
+         * @param rects - Rect instances or left, bottom, width, height, 4 entries per rect
+         * @returns one report per page of the document
+         */
+        redact(pages: Uint32Array, rects: Rect[] | Float64Array, opts?: NPDFRedactOptions): NPDFRedactReport[]
+
+        /**
+         * Write every file of the /EmbeddedFiles name tree into dir, decoding files in parallel
+         * @param dir - an existing directory
+         * @param opts.threads - worker threads, defaults to the hardware concurrency
+         * @returns the written file paths
+         */
+        extractAll(dir: string, opts?: { threads?: number }): Promise<string[]>
+
         /**
          * Deletes one or more pages from the document by removing the pages reference
          * from the pages tree. This does NOT remove the page object as the page object
@@ -842,6 +1251,27 @@ export namespace nopodofo {
          */
         splicePages(startIndex: number, count: number): void
 
+        /**
+         * Every page of the document in page order, read from a flat page index that is
+         * built once instead of walking the pages tree for each page.
+         */
+        pages(): Page[]
+
+        /**
+         * Move the page at order[i] to index i. The pages tree is rebuilt once, balanced.
+         * Pages obtained before the call stay valid, only their index changes.
+         * @param order - a permutation of the page indices
+         */
+        reorderPages(order: number[] | Uint32Array): void
+
+        /**
+         * Remove the pages at indices from the pages tree and rebuild it once, balanced.
+         * Like splicePages the page objects are not removed.
+         * @param indices - zero based page indices, in any order
+         * @returns the page count
+         */
+        deletePages(indices: number[] | Uint32Array): number
+
         /**
          * Copies one or more pages from another pdf to this document
          * This function copies the entire document to the target document and then
@@ -861,16 +1291,23 @@ export namespace nopodofo {
          * @param cb - if file path was provided as destination, this must be a callback function
          */
         write(destination: Callback<Buffer> | string, cb?: Callback<string>): void
+        write(destination: string, opts: NPDFWriteOptions, cb: Callback<string>): void
+        write(opts: NPDFWriteOptions, cb: Callback<Buffer>): void
 
         /**
          * Performs garbage collection on the document. All objects not
-         * reachable by the trailer are deleted.
-         * @param file - pdf document, file path or node buffer
+         * reachable by the trailer are deleted, identical streams are merged
+         * and the remaining objects are renumbered. A loaded Document is not
+         * modified, the collected copy is returned.
+         * @param file - file path, node buffer or loaded Document
          * @param pwd - if document is password protected this parameter is required
-         * @param cb - function
+         * @param opts - write options for the collected document, output writes to a file
+         * @param cb - receives the collected document (Buffer, or the output path) and stats
          */
-        static gc(file: Buffer, pwd: string, cb: Callback<Buffer>): void
-        static gc(file: Buffer, cb: Callback<Buffer>): void
+        static gc(file: Buffer | string | Document, pwd: string, cb: GCCallback): void
+        static gc(file: Buffer | string | Document, pwd: string, opts: NPDFGCOptions, cb: GCCallback): void
+        static gc(file: Buffer | string | Document, opts: NPDFGCOptions, cb: GCCallback): void
+        static gc(file: Buffer | string | Document, cb: GCCallback): void
 
         /**
          * Check for the existence of a signature field(s)
@@ -921,6 +1358,14 @@ export namespace nopodofo {
 
         attachFile(file: string): void
 
+        /**
+         * Embed a file path or Readable a chunk at a time, the data is encoded into a temporary file and
+         * the embedded file stream is written when the source ends
+         * @param source - file path or Readable of Buffer chunks
+         * @param opts.name - attachment name, defaults to the path, required for a Readable without a path
+         */
+        attachStream(source: string | NodeJS.ReadableStream, opts?: { name?: string }): Promise<FileSpec>
+
         insertPage(rect: Rect, index: number): Page
 
         isLinearized(): boolean
@@ -943,6 +1388,12 @@ export namespace nopodofo {
         getObject(ref: Ref): Object
 
         getNames(create: boolean): Object | null
+        /**
+         * @desc Get a name tree of the /Names dictionary, i.e. 'EmbeddedFiles' or 'Dests'
+         * @param create - create the /Names dictionary and the tree if they do not exist
+         * @param tree - the /Names dictionary key of the tree
+         */
+        getNames(create: boolean, tree: string): NameTree | null
 
         createXObject(rect: Rect): XObject
 
@@ -952,9 +1403,44 @@ export namespace nopodofo {
 
         getAttachment(fileName: string): FileSpec
 
+        /**
+         * Create one annotation per rect on the page of the same index in pages, see Page.addAnnotations
+         * @returns the number of annotations created
+         */
+        addAnnotations(type: NPDFAnnotation, pages: Uint32Array, rects: Float64Array, opts?: NPDFAnnotationBatchOptions): number
+
+        /**
+         * Read the annotation geometry of every page, pages are read in parallel, see Page.getAnnotations
+         * @param opts.threads - worker threads, defaults to the hardware concurrency
+         */
+        getAnnotations(opts?: { types?: NPDFAnnotation[], threads?: number }): NPDFAnnotationGeometry[]
+
         addNamedDestination(page: Page, destination: NPDFDestinationFit, name: string): void
     }
 
+    /**
+     * A name tree of the document's /Names dictionary. Lookups binary search the tree, set rebuilds it balanced.
+     * @see Base#getNames
+     */
+    export class NameTree {
+        /**
+         * @returns the value of key with references resolved, null if the key does not exist
+         */
+        get(key: string): Object | null
+
+        /**
+         * @returns every key in tree order
+         */
+        keys(): string[]
+
+        /**
+         * @desc Add or replace many entries at once. The tree is rebuilt with at most 64 entries or kids per node.
+         * Indirect Objects are stored as references.
+         * @returns the number of keys in the tree
+         */
+        set(entries: Array<[string, Object | Ref]>): number
+    }
+
     export class Object {
         readonly reference: Ref
         readonly length: number
@@ -999,6 +1485,12 @@ export namespace nopodofo {
         clear(): void
 
         resolveIndirectKey(key: string): Object
+
+        /**
+         * @desc Convert the object, and everything it contains, to plain javascript values in a single native call.
+         * Dictionaries become objects, hex strings and raw data become Buffers.
+         */
+        toJS(opts?: NPDFToJSOptions): any
     }
 
     export class Array {
@@ -1040,7 +1532,7 @@ export namespace nopodofo {
          * @link{https://corymickelson.github.io/NoPoDoFo/documentation/bestpractices.html}
          *
          */
-        asArray(): any[]
+        asArray(opts?: NPDFToJSOptions): any[]
     }
 
     export class Ref {
@@ -1086,7 +1578,7 @@ export namespace nopodofo {
          * will have additional overhead, for more information on this overhead please read
          * @link{https://corymickelson.github.io/NoPoDoFo/documentation/bestpractices.html}
          */
-        asObject(): Object
+        asObject(opts?: NPDFToJSOptions): Object
     }
 
     /**
@@ -1122,11 +1614,12 @@ export namespace nopodofo {
         /**
          *
          * @param {string} [file]
-         * @param {{version: NPDFVersion, writer: NPDFWriteMode, encrypt: Encrypt}} [opts] -
-         *      defaults to {pdf1.7, writeMode_default, null}
+         * @param {{version: NPDFVersion, writer: NPDFWriteMode, encrypt: Encrypt, objectStreams: boolean, linearize: boolean}} [opts] -
+         *      defaults to {pdf1.7, writeMode_default, null, false, false}. With objectStreams or linearize the
+         *      document is streamed to memory and rewritten when closed.
          * @returns {StreamDocument}
          */
-        constructor(file?: string, opts?: { version: NPDFVersion, writer: NPDFWriteMode, encrypt?: Encrypt })
+        constructor(file?: string, opts?: { version: NPDFVersion, writer: NPDFWriteMode, encrypt?: Encrypt, objectStreams?: boolean, linearize?: boolean })
 
         /**
          * Closing a stream document will prevent any further writes to the document.
@@ -1273,9 +1766,9 @@ export namespace nopodofo {
 
         drawTextAligned(point: NPDFPoint & { width: number }, text: string, alignment: NPDFAlignment): void
 
-        drawMultiLineText(rect: Rect, value: string, alignment?: NPDFAlignment, vertical?: NPDFVerticalAlignment): void
+        drawMultiLineText(rect: Rect, value: string, alignment?: NPDFAlignment, vertical?: NPDFVerticalAlignment, opts?: NPDFTextLayoutOptions): void
 
-        getMultiLineText(width: number, text: string, skipSpaces?: boolean): string[]
+        getMultiLineText(width: number, text: string, skipSpaces?: boolean, opts?: NPDFTextLayoutOptions): string[]
 
         beginText(point: NPDFPoint): void
 
@@ -1291,6 +1784,39 @@ export namespace nopodofo {
 
         drawImage(img: Image, x: number, y: number, opts?: { width?: number, height?: number, scaleX?: number, scaleY?: number }): void
 
+        /**
+         * Run a command buffer of NPDFPainterOp opcodes in a single native call.
+         * Operands are consumed in order from operands, text operands index strings
+         * and Font, ExtGState and Image operands index resources.
+         */
+        execute(ops: Uint8Array, operands: Float64Array, strings?: string[], resources?: Array<Font | ExtGState | Image>): void
+
+        /**
+         * Run a command buffer once into a new Form XObject with the bounding box rect. The optional slot
+         * program is stored with the DisplayList and replayed on every drawList with the texts as its string
+         * table and the numbers written to the operand positions listed in slots.numbers.
+         */
+        record(rect: Rect, ops: Uint8Array, operands: Float64Array, strings?: string[], resources?: Array<Font | ExtGState | Image>,
+               slots?: NPDFDisplayListSlots): DisplayList
+
+        /**
+         * Draw a DisplayList at x, y: a single Do operator plus the slot program, if any
+         */
+        drawList(list: DisplayList, x: number, y: number, values?: { texts?: string[], numbers?: number[] }): void
+
+    }
+
+    export class DisplayList {
+        /**
+         * The Form XObject holding the recorded content
+         */
+        readonly xobject: XObject
+        readonly numberSlots: number
+
+        /**
+         * Use Painter.record to create a DisplayList
+         */
+        constructor(native: NPDFExternal<XObject>)
     }
 
     export class Font {
@@ -1313,6 +1839,11 @@ export namespace nopodofo {
 
         stringWidth(v: string): number
 
+        /**
+         * Measure many strings in one call, widths are read from the font's cached width table
+         */
+        measure(values: string[], opts?: { kerning?: boolean }): Float64Array
+
         write(content: string, stream: Stream): void
 
         embed(): void
@@ -1393,6 +1924,27 @@ export namespace nopodofo {
 
         createAnnotation(type: NPDFAnnotation, rect: Rect): Annotation
 
+        /**
+         * Create one annotation per rect in a single call
+         * @param type - annotation type of every annotation
+         * @param rects - left, bottom, width, height, 4 entries per annotation
+         * @returns the index of the first new annotation
+         */
+        addAnnotations(type: NPDFAnnotation, rects: Float64Array, opts?: NPDFAnnotationBatchOptions): number
+
+        /**
+         * Read the geometry of the page's annotations as typed array columns
+         * @param opts.types - only annotations of these types
+         */
+        getAnnotations(opts?: { types?: NPDFAnnotation[] }): NPDFAnnotationGeometry
+
+        /**
+         * Remove the text, images and forms drawn under rects from the page's content stream
+         * and paint the rects. The removed content does not remain anywhere in the document.
+         * @param rects - Rect instances or left, bottom, width, height, 4 entries per rect
+         */
+        redact(rects: Rect[] | Float64Array, opts?: NPDFRedactOptions): NPDFRedactReport
+
         createField(type: NPDFFieldType, annot: Annotation, form: Form, opts?: Object): Field
 
         deleteField(index: number): void
@@ -1434,6 +1986,18 @@ export namespace nopodofo {
         getParent(): Outline
 
         erase(): void
+
+        /**
+         * @desc Create the whole tree as children of this item in one call. Items pointing at the same page and fit
+         * share a destination and /Count is updated once for the whole outline.
+         * @returns the number of items created
+         */
+        build(tree: NPDFOutlineNode[]): number
+
+        /**
+         * @desc Serialize the children of this item, destinations are resolved to page indexes
+         */
+        toTree(): NPDFOutlineNode[]
     }
 
     export class Stream {
@@ -1459,6 +2023,32 @@ export namespace nopodofo {
         copy(filtered?: boolean): Buffer
     }
 
+    /**
+     * Renders rows as they are added, creating pages as needed and repeating the header row on every page
+     */
+    export class StreamTable {
+        constructor(doc: Base, opts: NPDFStreamTableOptions)
+
+        readonly pageCount: number
+        readonly rowCount: number
+
+        /**
+         * Render a chunk of rows: a flat, row major string[] or Float64Array with one value per column, or string[][]
+         */
+        addRows(rows: NPDFStreamTableChunk): void
+
+        /**
+         * Pull chunks from source until it returns null or undefined
+         */
+        draw(source: () => NPDFStreamTableChunk | null | undefined): void
+
+        /**
+         * Finish the last page, returns the number of pages created. Must be called, the rows on the last page of a table
+         * collected unfinished are dropped
+         */
+        finish(): number
+    }
+
     export class SimpleTable {
         constructor(doc: Base, cols: number, rows: number)
 
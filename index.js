@@ -855,6 +855,56 @@ var NPDFAlignment;
     NPDFAlignment[NPDFAlignment["Center"] = 1] = "Center";
     NPDFAlignment[NPDFAlignment["Right"] = 2] = "Right";
 })(NPDFAlignment = exports.NPDFAlignment || (exports.NPDFAlignment = {}));
+/**
+ * Opcodes for Painter.execute, operands are read from the operand array in
+ * the order documented in index.d.ts
+ */
+var NPDFPainterOp;
+(function (NPDFPainterOp) {
+    NPDFPainterOp[NPDFPainterOp["MoveTo"] = 0] = "MoveTo";
+    NPDFPainterOp[NPDFPainterOp["LineTo"] = 1] = "LineTo";
+    NPDFPainterOp[NPDFPainterOp["CubicBezierTo"] = 2] = "CubicBezierTo";
+    NPDFPainterOp[NPDFPainterOp["HorizontalLineTo"] = 3] = "HorizontalLineTo";
+    NPDFPainterOp[NPDFPainterOp["VerticalLineTo"] = 4] = "VerticalLineTo";
+    NPDFPainterOp[NPDFPainterOp["SmoothCurveTo"] = 5] = "SmoothCurveTo";
+    NPDFPainterOp[NPDFPainterOp["QuadCurveTo"] = 6] = "QuadCurveTo";
+    NPDFPainterOp[NPDFPainterOp["ArcTo"] = 7] = "ArcTo";
+    NPDFPainterOp[NPDFPainterOp["ClosePath"] = 8] = "ClosePath";
+    NPDFPainterOp[NPDFPainterOp["Close"] = 9] = "Close";
+    NPDFPainterOp[NPDFPainterOp["Rectangle"] = 10] = "Rectangle";
+    NPDFPainterOp[NPDFPainterOp["Ellipse"] = 11] = "Ellipse";
+    NPDFPainterOp[NPDFPainterOp["Circle"] = 12] = "Circle";
+    NPDFPainterOp[NPDFPainterOp["Stroke"] = 13] = "Stroke";
+    NPDFPainterOp[NPDFPainterOp["Fill"] = 14] = "Fill";
+    NPDFPainterOp[NPDFPainterOp["FillAndStroke"] = 15] = "FillAndStroke";
+    NPDFPainterOp[NPDFPainterOp["EndPath"] = 16] = "EndPath";
+    NPDFPainterOp[NPDFPainterOp["Clip"] = 17] = "Clip";
+    NPDFPainterOp[NPDFPainterOp["Save"] = 18] = "Save";
+    NPDFPainterOp[NPDFPainterOp["Restore"] = 19] = "Restore";
+    NPDFPainterOp[NPDFPainterOp["SetColor"] = 20] = "SetColor";
+    NPDFPainterOp[NPDFPainterOp["SetStrokingColor"] = 21] = "SetStrokingColor";
+    NPDFPainterOp[NPDFPainterOp["SetGrey"] = 22] = "SetGrey";
+    NPDFPainterOp[NPDFPainterOp["SetStrokingGrey"] = 23] = "SetStrokingGrey";
+    NPDFPainterOp[NPDFPainterOp["SetColorCMYK"] = 24] = "SetColorCMYK";
+    NPDFPainterOp[NPDFPainterOp["SetStrokingColorCMYK"] = 25] = "SetStrokingColorCMYK";
+    NPDFPainterOp[NPDFPainterOp["SetStrokeWidth"] = 26] = "SetStrokeWidth";
+    NPDFPainterOp[NPDFPainterOp["SetStrokeStyle"] = 27] = "SetStrokeStyle";
+    NPDFPainterOp[NPDFPainterOp["SetLineCapStyle"] = 28] = "SetLineCapStyle";
+    NPDFPainterOp[NPDFPainterOp["SetLineJoinStyle"] = 29] = "SetLineJoinStyle";
+    NPDFPainterOp[NPDFPainterOp["SetMiterLimit"] = 30] = "SetMiterLimit";
+    NPDFPainterOp[NPDFPainterOp["SetClipRect"] = 31] = "SetClipRect";
+    NPDFPainterOp[NPDFPainterOp["SetFont"] = 32] = "SetFont";
+    NPDFPainterOp[NPDFPainterOp["SetExtGState"] = 33] = "SetExtGState";
+    NPDFPainterOp[NPDFPainterOp["DrawLine"] = 34] = "DrawLine";
+    NPDFPainterOp[NPDFPainterOp["DrawText"] = 35] = "DrawText";
+    NPDFPainterOp[NPDFPainterOp["DrawTextAligned"] = 36] = "DrawTextAligned";
+    NPDFPainterOp[NPDFPainterOp["DrawMultiLineText"] = 37] = "DrawMultiLineText";
+    NPDFPainterOp[NPDFPainterOp["DrawImage"] = 38] = "DrawImage";
+    NPDFPainterOp[NPDFPainterOp["BeginText"] = 39] = "BeginText";
+    NPDFPainterOp[NPDFPainterOp["MoveTextPosition"] = 40] = "MoveTextPosition";
+    NPDFPainterOp[NPDFPainterOp["AddText"] = 41] = "AddText";
+    NPDFPainterOp[NPDFPainterOp["EndText"] = 42] = "EndText";
+})(NPDFPainterOp = exports.NPDFPainterOp || (exports.NPDFPainterOp = {}));
 var NPDFBlendMode;
 (function (NPDFBlendMode) {
     NPDFBlendMode["Normal"] = "Normal";
@@ -2,14 +2,24 @@ import {
     EncryptOption,
     nopodofo,
     NPDFActions,
+    NPDFAnnotation,
+    NPDFAnnotationBatchOptions,
+    NPDFAnnotationGeometry,
     NPDFCreateFontOpts,
     NPDFDestinationFit,
     NPDFImageFormat,
+    NPDFImageLoadOptions,
+    NPDFImageOptimizeOptions,
+    NPDFImageReport,
+    NPDFImageSource,
     NPDFInfo,
     NPDFPageLayout,
     NPDFPageMode,
+    NPDFRedactOptions,
+    NPDFRedactReport,
     NPDFVersion,
     NPDFWriteMode,
+    NPDFWriteOptions,
     ProtectionOption
 } from "../index"
 import {NPage} from "./NPage"
@@ -111,6 +121,21 @@ export class NDocument {
         return new NImage(this, new nopodofo.Image(this.base, src, format))
     }
 
+    /**
+     * Decode and embed an image without blocking the event loop
+     */
+    loadImage(src: string | Buffer, format: NPDFImageFormat = NPDFImageFormat.data): Promise<NImage> {
+        return new Promise((resolve, reject) =>
+            nopodofo.Image.load(this.base, src, format, (err, image) =>
+                err ? reject(err) : resolve(new NImage(this, image))))
+    }
+
+    loadImages(sources: Array<NPDFImageSource>, opts: NPDFImageLoadOptions = {}): Promise<NImage[]> {
+        return new Promise((resolve, reject) =>
+            nopodofo.Image.loadMany(this.base, sources, opts, (err, images) =>
+                err ? reject(err) : resolve(images.map(i => new NImage(this, i)))))
+    }
+
 
     getPageCount(): number {
         return this.base.getPageCount()
@@ -153,6 +178,10 @@ export class NDocument {
         this.base.attachFile(file)
     }
 
+    async attachStream(source: string | NodeJS.ReadableStream, opts?: { name?: string }): Promise<nopodofo.FileSpec> {
+        return new NFileSpec(this, await this.base.attachStream(source, opts))
+    }
+
     insertPage(rect: NRect, index: number): NPage {
         const page = this.base.insertPage((rect as any).self, index)
         return new NPage(this, page)
@@ -186,7 +215,12 @@ export class NDocument {
         return new NObject(this, obj)
     }
 
-    getNames(create: boolean): NObject | null {
+    getNames(create: boolean): NObject | null
+    getNames(create: boolean, tree: string): nopodofo.NameTree | null
+    getNames(create: boolean, tree?: string): NObject | nopodofo.NameTree | null {
+        if (tree !== undefined) {
+            return this.base.getNames(create, tree)
+        }
         const names = this.base.getNames(create)
         if (names) {
             return new NObject(this, names)
@@ -213,6 +247,14 @@ export class NDocument {
         return new NFileSpec(this, n)
     }
 
+    addAnnotations(type: NPDFAnnotation, pages: Uint32Array, rects: Float64Array, opts?: NPDFAnnotationBatchOptions): number {
+        return this.base.addAnnotations(type, pages, rects, opts)
+    }
+
+    getAnnotations(opts?: { types?: NPDFAnnotation[], threads?: number }): NPDFAnnotationGeometry[] {
+        return this.base.getAnnotations(opts)
+    }
+
     addNamedDestination(page: nopodofo.Page, destination: NPDFDestinationFit, name: string): void {
         this.base.addNamedDestination(page, destination, name)
     }
@@ -233,7 +275,7 @@ export class NDocument {
 
     static to(
         dest?: string,
-        opts?: { version: NPDFVersion, writer: NPDFWriteMode, encrypt?: NEncrypt })
+        opts?: { version: NPDFVersion, writer: NPDFWriteMode, encrypt?: NEncrypt, objectStreams?: boolean, linearize?: boolean })
         : NDocument {
         if (opts && opts.hasOwnProperty('encrypt')) {
             opts.encrypt = (opts.encrypt as any).self
@@ -286,21 +328,46 @@ class NMemoryDocument extends NDocument {
         return (this.base as nopodofo.Document).listFonts()
     }
 
+    optimizeImages(opts?: NPDFImageOptimizeOptions): NPDFImageReport[] {
+        return (this.base as nopodofo.Document).optimizeImages(opts)
+    }
+
+    redact(pages: Uint32Array, rects: NRect[] | Float64Array, opts?: NPDFRedactOptions): NPDFRedactReport[] {
+        const native = rects instanceof Float64Array ? rects : rects.map(r => (r as any).self)
+        return (this.base as nopodofo.Document).redact(pages, native, opts)
+    }
+
+    extractAll(dir: string, opts?: { threads?: number }): Promise<string[]> {
+        return (this.base as nopodofo.Document).extractAll(dir, opts)
+    }
+
     splicePages(startIndex: number, count: number): void {
         (this.base as nopodofo.Document).splicePages(startIndex, count)
     }
 
+    pages(): NPage[] {
+        return (this.base as nopodofo.Document).pages().map(page => new NPage(this, page))
+    }
+
+    reorderPages(order: number[] | Uint32Array): void {
+        (this.base as nopodofo.Document).reorderPages(order)
+    }
+
+    deletePages(indices: number[] | Uint32Array): number {
+        return (this.base as nopodofo.Document).deletePages(indices)
+    }
+
     insertPages(fromDoc: nopodofo.Document, startIndex: number, count: number): number {
         return (this.base as nopodofo.Document).insertPages(fromDoc, startIndex, count)
     }
 
-    write(destination?: string): Promise<string | Buffer> {
+    write(destination?: string, opts: NPDFWriteOptions = {}): Promise<string | Buffer> {
         return new Promise((resolve, reject) => {
                 if (destination)
-                    (this.base as nopodofo.Document).write(destination, (err, data) =>
+                    (this.base as nopodofo.Document).write(destination, opts, (err, data) =>
                         err ? reject(err) : resolve(data))
                 else
-                    (this.base as nopodofo.Document).write((err, data) =>
+                    (this.base as nopodofo.Document).write(opts, (err, data) =>
                         err ? reject(err) : resolve(data))
             }
         )
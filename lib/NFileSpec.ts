@@ -12,4 +12,8 @@ export class NFileSpec implements nopodofo.FileSpec {
     getContents(): Buffer | undefined {
         return this.self.getContents()
     }
+
+    extractTo(destination: string | NodeJS.WritableStream, opts?: { end?: boolean }): Promise<number> {
+        return this.self.extractTo(destination, opts)
+    }
 }
@@ -104,6 +104,10 @@ export class NFont {
         return this.self.stringWidth(v)
     }
 
+    measure(values: string[], opts?: { kerning?: boolean }): Float64Array {
+        return this.self.measure(values, opts)
+    }
+
     write(content: string, stream: nopodofo.Stream): void {
         this.self.write(content, stream)
     }
@@ -1,5 +1,6 @@
-import {nopodofo, NPDFSigFlags} from "../index"
+import {nopodofo, NPDFFormDescription, NPDFSigFlags} from "../index"
 import {NDocument} from "./NDocument"
+import {NField} from "./NField"
 
 export class NForm implements nopodofo.Form {
     get needAppearances(): boolean {
@@ -50,6 +51,27 @@ export class NForm implements nopodofo.Form {
         this.self.CO = value
     }
 
+    getField<T extends nopodofo.Field>(name: string): NField | null {
+        const field = this.self.getField(name)
+        return field ? NField.create(this.parent, field) : null
+    }
+
+    fieldNames(): string[] {
+        return this.self.fieldNames()
+    }
+
+    deleteFields(fields: Array<string | nopodofo.Ref>): number {
+        return this.self.deleteFields(fields.map(f => typeof f === 'string' ? f : ((f as any).self || f)))
+    }
+
+    describe(): NPDFFormDescription {
+        return this.self.describe()
+    }
+
+    static describeMany(buffers: Buffer[], opts?: { threads?: number }): Promise<NPDFFormDescription[]> {
+        return nopodofo.Form.describeMany(buffers, opts)
+    }
+
     constructor(private parent: NDocument, private self: nopodofo.Form) {
 
     }
@@ -1,4 +1,4 @@
-import {nopodofo, NPDFColorSpace} from "../index"
+import {nopodofo, NPDFColorSpace, NPDFImageReport} from "../index"
 import {NDocument} from "./NDocument";
 
 export class NImage implements nopodofo.Image {
@@ -14,6 +14,10 @@ export class NImage implements nopodofo.Image {
         return this.self.width
     }
 
+    get report(): NPDFImageReport | null {
+        return this.self.report
+    }
+
     setInterpolate(v: boolean): void {
         return this.self.setInterpolate(v)
     }
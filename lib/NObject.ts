@@ -1,4 +1,4 @@
-import {Callback, nopodofo} from "../index";
+import {Callback, nopodofo, NPDFToJSOptions} from "../index";
 import {NDocument} from "./NDocument";
 import Ref = nopodofo.Ref;
 
@@ -326,6 +326,10 @@ export class NObject {
         return this.self.resolveIndirectKey(key)
     }
 
+    toJS(opts?: NPDFToJSOptions): any {
+        return this.self.toJS(opts)
+    }
+
     constructor(private parent: NDocument, public self: nopodofo.Object) {
     }
 }
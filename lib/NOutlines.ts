@@ -1,5 +1,5 @@
 import {NDocument} from './NDocument'
-import {nopodofo, NPDFOutlineFormat} from '../index'
+import {nopodofo, NPDFOutlineFormat, NPDFOutlineNode} from '../index'
 import {NDestination} from "./NDestination";
 import {NAction} from "./NAction";
 import {NObject} from "./NObject";
@@ -114,6 +114,14 @@ export class NOutlineItem {
         this.self.erase()
     }
 
+    build(tree: NPDFOutlineNode[]): number {
+        return this.self.build(tree)
+    }
+
+    toTree(): NPDFOutlineNode[] {
+        return this.self.toTree()
+    }
+
     private getItem(m: 'last' | 'first' | 'next' | 'prev'): NOutlineItem | null {
         const item = (this.self as nopodofo.Outline)[m]
         if (item) {
@@ -1,4 +1,15 @@
-import {nopodofo, NPDFAnnotation, NPDFFieldType, NPDFPageEvent, NPDFPageLayout, NPDFPageMode} from '../'
+import {
+    nopodofo,
+    NPDFAnnotation,
+    NPDFAnnotationBatchOptions,
+    NPDFAnnotationGeometry,
+    NPDFFieldType,
+    NPDFPageEvent,
+    NPDFPageLayout,
+    NPDFPageMode,
+    NPDFRedactOptions,
+    NPDFRedactReport
+} from '../'
 import {NDocument} from "./NDocument";
 import {NAnnotation} from "./NAnnotation";
 import {NObject} from "./NObject";
@@ -63,6 +74,19 @@ export class NPage {
         return new NAnnotation(this.parent, annot)
     }
 
+    addAnnotations(type: NPDFAnnotation, rects: Float64Array, opts?: NPDFAnnotationBatchOptions): number {
+        return this.self.addAnnotations(type, rects, opts)
+    }
+
+    getAnnotations(opts?: { types?: NPDFAnnotation[] }): NPDFAnnotationGeometry {
+        return this.self.getAnnotations(opts)
+    }
+
+    redact(rects: NRect[] | Float64Array, opts?: NPDFRedactOptions): NPDFRedactReport {
+        const native = rects instanceof Float64Array ? rects : rects.map(r => (r as any).self)
+        return this.self.redact(native, opts)
+    }
+
     createField(type: NPDFFieldType, annot: NAnnotation, form: nopodofo.Form, opts?: NObject): NField {
         const field = this.self.createField(type, annot.self, form, opts as any)
         switch (type) {
@@ -3,8 +3,10 @@ import {
     NPDFAlignment,
     NPDFLineCapStyle,
     NPDFLineJoinStyle,
+    NPDFPainterOp,
     NPDFPoint,
     NPDFStokeStyle,
+    NPDFTextLayoutOptions,
     NPDFVerticalAlignment
 } from "../index";
 import {NDocument} from "./NDocument";
@@ -12,6 +14,135 @@ import {NPage} from "./NPage";
 import {NXObject} from "./NXObject";
 import {NExtGState} from "./NExtGState";
 import {NFont} from "./NFont";
+import {NImage} from "./NImage";
+
+/**
+ * Accumulates Painter operations into the compact form consumed by Painter.execute.
+ * Strings and resources are interned, repeated text or fonts are stored once.
+ */
+export class NPainterCommands {
+    private ops: number[] = []
+    private operands: number[] = []
+    private strings: string[] = []
+    private stringIndex = new Map<string, number>()
+    private resources: any[] = []
+
+    get length(): number {
+        return this.ops.length
+    }
+
+    op(code: NPDFPainterOp, ...operands: number[]): this {
+        this.ops.push(code)
+        for (const v of operands) {
+            this.operands.push(v)
+        }
+        return this
+    }
+
+    text(value: string): number {
+        let i = this.stringIndex.get(value)
+        if (i === undefined) {
+            i = this.strings.push(value) - 1
+            this.stringIndex.set(value, i)
+        }
+        return i
+    }
+
+    resource(value: NFont | NExtGState | NImage | nopodofo.Font | nopodofo.ExtGState | nopodofo.Image): number {
+        const native = (value as any).self || value
+        let i = this.resources.indexOf(native)
+        if (i === -1) {
+            i = this.resources.push(native) - 1
+        }
+        return i
+    }
+
+    moveTo(x: number, y: number): this {
+        return this.op(NPDFPainterOp.MoveTo, x, y)
+    }
+
+    lineTo(x: number, y: number): this {
+        return this.op(NPDFPainterOp.LineTo, x, y)
+    }
+
+    rectangle(x: number, y: number, width: number, height: number): this {
+        return this.op(NPDFPainterOp.Rectangle, x, y, width, height)
+    }
+
+    setColor(r: number, g: number, b: number): this {
+        return this.op(NPDFPainterOp.SetColor, r, g, b)
+    }
+
+    setStrokingColor(r: number, g: number, b: number): this {
+        return this.op(NPDFPainterOp.SetStrokingColor, r, g, b)
+    }
+
+    setStrokeWidth(w: number): this {
+        return this.op(NPDFPainterOp.SetStrokeWidth, w)
+    }
+
+    setFont(font: NFont | nopodofo.Font): this {
+        return this.op(NPDFPainterOp.SetFont, this.resource(font))
+    }
+
+    drawText(x: number, y: number, value: string): this {
+        return this.op(NPDFPainterOp.DrawText, x, y, this.text(value))
+    }
+
+    drawLine(x1: number, y1: number, x2: number, y2: number): this {
+        return this.op(NPDFPainterOp.DrawLine, x1, y1, x2, y2)
+    }
+
+    drawImage(img: NImage | nopodofo.Image, x: number, y: number, scaleX = 1, scaleY = 1): this {
+        return this.op(NPDFPainterOp.DrawImage, this.resource(img), x, y, scaleX, scaleY)
+    }
+
+    stroke(): this {
+        return this.op(NPDFPainterOp.Stroke)
+    }
+
+    fill(): this {
+        return this.op(NPDFPainterOp.Fill)
+    }
+
+    save(): this {
+        return this.op(NPDFPainterOp.Save)
+    }
+
+    restore(): this {
+        return this.op(NPDFPainterOp.Restore)
+    }
+
+    /**
+     * Run every recorded operation on the painter in one native call
+     */
+    execute(painter: NPainter | nopodofo.Painter): void {
+        const native: nopodofo.Painter = (painter as any).self || painter
+        const b = this.buffers()
+        native.execute(b.ops, b.operands, b.strings, b.resources)
+    }
+
+    /**
+     * Index of the next operand, used to mark number slots of a DisplayList
+     */
+    get operandCount(): number {
+        return this.operands.length
+    }
+
+    buffers(): { ops: Uint8Array, operands: Float64Array, strings: string[], resources: any[] } {
+        return {
+            ops: Uint8Array.from(this.ops),
+            operands: Float64Array.from(this.operands),
+            strings: this.strings,
+            resources: this.resources
+        }
+    }
+
+    clear(): void {
+        this.ops = []
+        this.operands = []
+    }
+}
 
 export class NPainter {
     private self: nopodofo.Painter;
@@ -96,8 +227,8 @@ export class NPainter {
         this.self.drawLine(p1, p2)
     }
 
-    drawMultiLineText(rect: nopodofo.Rect, value: string, alignment?: NPDFAlignment, vertical?: NPDFVerticalAlignment): void {
-        this.self.drawMultiLineText(rect, value, alignment, vertical)
+    drawMultiLineText(rect: nopodofo.Rect, value: string, alignment?: NPDFAlignment, vertical?: NPDFVerticalAlignment, opts?: NPDFTextLayoutOptions): void {
+        this.self.drawMultiLineText(rect, value, alignment, vertical, opts)
     }
 
     drawText(point: NPDFPoint, text: string): void {
@@ -132,8 +263,8 @@ export class NPainter {
         return this.self.getCurrentPath()
     }
 
-    getMultiLineText(width: number, text: string, skipSpaces?: boolean): Array<string> {
-        return this.self.getMultiLineText(width, text, skipSpaces)
+    getMultiLineText(width: number, text: string, skipSpaces?: boolean, opts?: NPDFTextLayoutOptions): Array<string> {
+        return this.self.getMultiLineText(width, text, skipSpaces, opts)
     }
 
     horizontalLineTo(v: number): void {
@@ -236,4 +367,36 @@ export class NPainter {
         this.self.verticalLineTo(v)
     }
 
+    /**
+     * Record commands into a reusable DisplayList. Text operands of slots index the texts passed to drawList,
+     * numbers lists the operand positions (see NPainterCommands.operandCount) replaced by the drawList numbers.
+     */
+    record(rect: nopodofo.Rect, commands: NPainterCommands, slots?: { commands: NPainterCommands, numbers?: number[] }): nopodofo.DisplayList {
+        const b = commands.buffers()
+        if (!slots) {
+            return this.self.record(rect, b.ops, b.operands, b.strings, b.resources)
+        }
+        const s = slots.commands.buffers()
+        return this.self.record(rect, b.ops, b.operands, b.strings, b.resources, {
+            ops: s.ops,
+            operands: s.operands,
+            numbers: Uint32Array.from(slots.numbers || []),
+            resources: s.resources
+        })
+    }
+
+    drawList(list: nopodofo.DisplayList, x: number, y: number, values?: { texts?: string[], numbers?: number[] }): void {
+        this.self.drawList(list, x, y, values)
+    }
+
+    execute(commands: NPainterCommands): void
+    execute(ops: Uint8Array, operands: Float64Array, strings?: string[], resources?: Array<nopodofo.Font | nopodofo.ExtGState | nopodofo.Image>): void
+    execute(ops: Uint8Array | NPainterCommands, operands?: Float64Array, strings?: string[], resources?: Array<nopodofo.Font | nopodofo.ExtGState | nopodofo.Image>): void {
+        if (ops instanceof NPainterCommands) {
+            ops.execute(this.self)
+        } else {
+            this.self.execute(ops, operands as Float64Array, strings, resources)
+        }
+    }
+
 }
@@ -1,4 +1,4 @@
-import {nopodofo, NPDFPoint} from "../index"
+import {nopodofo, NPDFPoint, NPDFStreamTableChunk, NPDFStreamTableOptions} from "../index"
 import {NDocument} from "./NDocument"
 import {NPainter} from "./NPainter"
 import {NFont} from "./NFont"
@@ -149,3 +149,44 @@ export class NTable {
     }
 
 }
+
+/**
+ * Streaming table renderer, rows may come from an array, a synchronous callback or an (async) iterator of chunks.
+ * Only the chunk being drawn is held in memory.
+ */
+export class NStreamTable {
+    private self: nopodofo.StreamTable
+
+    get pageCount(): number {
+        return this.self.pageCount
+    }
+
+    get rowCount(): number {
+        return this.self.rowCount
+    }
+
+    constructor(private parent: NDocument, opts: NPDFStreamTableOptions) {
+        this.self = new nopodofo.StreamTable((parent as any).base, opts)
+    }
+
+    addRows(rows: NPDFStreamTableChunk): void {
+        this.self.addRows(rows)
+    }
+
+    async render(source: (() => NPDFStreamTableChunk | null | undefined) |
+        Iterable<NPDFStreamTableChunk> | AsyncIterable<NPDFStreamTableChunk>): Promise<number> {
+        if (typeof source === 'function') {
+            this.self.draw(source)
+        } else if ((source as any)[Symbol.asyncIterator]) {
+            for await (const chunk of source as AsyncIterable<NPDFStreamTableChunk>) {
+                this.self.addRows(chunk)
+            }
+        } else {
+            for (const chunk of source as Iterable<NPDFStreamTableChunk>) {
+                this.self.addRows(chunk)
+            }
+        }
+        return this.self.finish()
+    }
+}
+
@@ -86,4 +86,36 @@ export class AnnotationSpec {
         const subject = page.createAnnotation((NPDFAnnotation as any)[s], new Rect(0, 0, 100, 100))
         Expect((subject as any)[p]).toBeDefined()
     }
+
+    @AsyncTest('Add and read annotations in bulk')
+    @TestCase('mem')
+    @TestCase('stream')
+    public async bulkTest(t: string) {
+        const doc = (this as any)[t] as Base
+        const page = doc.getPage(0)
+        const n = 1000
+        const rects = new Float64Array(n * 4)
+        for (let i = 0; i < n; i++) {
+            rects.set([10 + (i % 20) * 25, 10 + Math.floor(i / 20) * 14, 20, 12], i * 4)
+        }
+        const before = page.annotationCount()
+        const first = page.addAnnotations(NPDFAnnotation.Highlight, rects, {color: [1, 1, 0], title: 'bulk'})
+        Expect(first).toBe(before)
+        Expect(page.annotationCount()).toBe(before + n)
+        Expect(page.getAnnotation(first + 1).rect.left).toBe(35)
+        if (t === 'stream') return
+
+        const geometry = page.getAnnotations({types: [NPDFAnnotation.Highlight]})
+        Expect(geometry.count).toBe(n)
+        Expect(geometry.index[0]).toBe(first)
+        Expect(geometry.type[0]).toBe(NPDFAnnotation.Highlight)
+        Expect(Array.from(geometry.rect.subarray(4, 8))).toEqual([35, 10, 20, 12])
+        Expect(Array.from(geometry.color.subarray(0, 3))).toEqual([1, 1, 0])
+        Expect(geometry.quadStart[n]).toBe(n * 8)
+        Expect(Array.from(geometry.quadPoints.subarray(0, 8))).toEqual([10, 22, 30, 22, 10, 10, 30, 10])
+
+        const all = doc.getAnnotations({types: [NPDFAnnotation.Highlight], threads: 2})
+        Expect(all.length).toBe(doc.getPageCount())
+        Expect(all[0].count).toBe(n)
+    }
 }
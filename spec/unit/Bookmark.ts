@@ -103,4 +103,29 @@ export class BookmarkSpec {
         return Promise.resolve()
     }
 
-}
\ No newline at end of file
+    @AsyncTest('Outline build and toTree')
+    @TestCase('mem')
+    @TestCase('stream')
+    public async buildTree(t: string) {
+        const root = (this as any)[t].getOutlines(true) as Outline
+        const tree = [
+            {
+                title: 'one', page: 0, open: true, children: [
+                    {title: 'one.one', page: 0, fit: NPDFDestinationFit.FitH, value: 500},
+                    {title: 'one.two', page: 0, children: [{title: 'one.two.one', page: 0}]}
+                ]
+            },
+            {title: 'two', page: 0}
+        ]
+        Expect(root.build(tree)).toBe(5)
+        const built = root.toTree().slice(-2)
+        Expect(built.map(n => n.title)).toEqual(['one', 'two'])
+        Expect(built[0].open).toBe(true)
+        Expect((built[0].children as any[]).map(n => n.title)).toEqual(['one.one', 'one.two'])
+        Expect((built[0].children as any[])[0].fit).toBe(NPDFDestinationFit.FitH)
+        Expect((built[0].children as any[])[0].value).toBe(500)
+        Expect((built[0].children as any[])[1].open).toBe(false)
+        Expect(built[1].page).toBe(0)
+        return Promise.resolve()
+    }
+}
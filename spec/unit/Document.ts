@@ -1,8 +1,8 @@
 import {AsyncSetup, AsyncTeardown, AsyncTest, Expect, TestCase, TestFixture, Timeout} from 'alsatian'
-import {nopodofo, nopodofo as npdf} from '../../'
+import {nopodofo, nopodofo as npdf, NPDFVersion, NPDFWriteMode} from '../../'
 import {join} from "path";
-import {readFileSync} from "fs";
-import {platform} from 'os'
+import {existsSync, readFileSync, unlinkSync} from "fs";
+import {platform, tmpdir} from 'os'
 import Document = nopodofo.Document;
 
 @TestFixture("(Mem)Document")
@@ -88,6 +88,27 @@ export class MemDocSpec {
         return Promise.resolve()
     }
 
+    @AsyncTest("Reorder and delete pages in bulk")
+    public async bulkPageOperations() {
+        Expect(this.subject.pages().length).toBe(this.subject.getPageCount())
+        const doc = new npdf.Document()
+        const n = 100
+        doc.createPages(Array.from({length: n}, (_, i) => new npdf.Rect(0, 0, 100 + i, 100)))
+        const first = doc.getPage(0)
+        doc.reorderPages(Array.from({length: n}, (_, i) => n - 1 - i))
+        Expect(first.width).toBe(100)
+        Expect(doc.getPage(n - 1).width).toBe(100)
+        Expect(doc.pages().map(p => p.width)).toEqual(Array.from({length: n}, (_, i) => 100 + n - 1 - i))
+        Expect(() => doc.reorderPages([0, 0])).toThrowError(RangeError, "order must list every page index once")
+        Expect(doc.deletePages(new Uint32Array([n - 1, 0, 2]))).toBe(n - 3)
+        Expect(doc.getPage(0).width).toBe(100 + n - 2)
+        Expect(doc.getPage(1).width).toBe(100 + n - 4)
+        const copy = await new Promise<Document>((resolve, reject) => doc.write((e, data) =>
+            e ? reject(e) : new npdf.Document().load(data, (err, d) => err ? reject(err) : resolve(d))))
+        Expect(copy.pages().map(p => p.width)).toEqual(doc.pages().map(p => p.width))
+        return Promise.resolve()
+    }
+
     @AsyncTest("Insert pages from other document")
     public async insertTest(t: string) {
         const doc = this.subject
@@ -219,6 +240,69 @@ export class MemDocSpec {
         }
     }
 
+    @AsyncTest("Write with object streams")
+    public async objectStreamsTest() {
+        const plain = await new Promise<Buffer>((resolve, reject) =>
+            this.subject.write((e, d) => e ? reject(e) : resolve(d)))
+        const packed = await new Promise<Buffer>((resolve, reject) =>
+            this.subject.write({objectStreams: true}, (e, d) => e ? reject(e) : resolve(d)))
+        Expect(packed.length).toBeLessThan(plain.length)
+        Expect(packed.includes('/ObjStm')).toBeTruthy()
+        Expect(packed.includes('/XRef')).toBeTruthy()
+        const doc = await this.resolveLoad(packed)
+        Expect(doc.getPageCount()).toBe(this.subject.getPageCount())
+    }
+
+    @AsyncTest("StreamDocument flushes object streams in batches")
+    public async streamObjectStreamsTest() {
+        const out = join(tmpdir(), 'stream-objstm.pdf')
+        const stream = new npdf.StreamDocument(out,
+            {version: NPDFVersion.Pdf17, writer: NPDFWriteMode.Default, objectStreams: true})
+        for (let i = 0; i < 150; i++) {
+            stream.createPage(new npdf.Rect(0, 0, 612, 792))
+        }
+        Expect(stream.close()).toBe(out)
+        Expect(existsSync(`${out}.part`)).toBe(false)
+        const packed = readFileSync(out)
+        Expect((packed.toString('latin1').match(/\/Type\s*\/ObjStm/g) || []).length).toBeGreaterThan(1)
+        const doc = await this.resolveLoad(out)
+        Expect(doc.getPageCount()).toBe(150)
+        unlinkSync(out)
+    }
+
+    @AsyncTest("Write with parallel stream compression")
+    public async compressStreamsTest() {
+        const write = (threads: number) => new Promise<Buffer>((resolve, reject) =>
+            this.subject.write({compress: true, compressionLevel: 1, threads}, (e, d) => e ? reject(e) : resolve(d)))
+        const serial = await write(1)
+        const parallel = await write(4)
+        Expect(parallel.length).toBe(serial.length)
+        const doc = await this.resolveLoad(parallel)
+        Expect(doc.getPageCount()).toBe(this.subject.getPageCount())
+    }
+
+    @AsyncTest("Write linearized")
+    public async linearizeTest() {
+        const data = await new Promise<Buffer>((resolve, reject) =>
+            this.subject.write({linearize: true}, (e, d) => e ? reject(e) : resolve(d)))
+        Expect(data.indexOf('/Linearized 1')).toBeLessThan(1024)
+        Expect(data.indexOf('/Linearized 1')).toBeGreaterThan(0)
+        const doc = await this.resolveLoad(data)
+        Expect(doc.isLinearized()).toBe(true)
+        Expect(doc.getPageCount()).toBe(this.subject.getPageCount())
+    }
+
+    @AsyncTest("Garbage collect a loaded document")
+    public async gcDocumentTest() {
+        const [data, stats] = await new Promise<[Buffer, any]>((resolve, reject) =>
+            Document.gc(this.subject, (e, d, s) => e ? reject(e) : resolve([d as Buffer, s])))
+        Expect(stats.size).toBe(data.length)
+        Expect(stats.objectsRemoved).toBeGreaterThan(-1)
+        Expect(stats.duplicateStreams).toBeLessThan(stats.objectsRemoved + 1)
+        const doc = await this.resolveLoad(data)
+        Expect(doc.getPageCount()).toBe(this.subject.getPageCount())
+    }
+
     @AsyncTest("Get Document Fonts")
     public async fontsTest() {
         const doc = this.subject
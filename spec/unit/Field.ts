@@ -1,6 +1,7 @@
 import {AsyncTest, Expect, Test, TestCase, TestFixture, Timeout} from 'alsatian'
 import {nopodofo, NPDFAnnotation, NPDFFieldType, NPDFName, NPDFPaintOp} from '../../'
 import {join} from 'path'
+import {readFileSync} from 'fs'
 import Dictionary = nopodofo.Dictionary;
 
 @TestFixture('Form Field')
@@ -169,4 +170,68 @@ export class FieldSpec {
             })
         })
     }
+
+    @AsyncTest('Form field lookup by name')
+    public async formFieldLookup() {
+        return new Promise((resolve, reject) => {
+            const doc = new nopodofo.Document()
+            doc.load(this.filePath, (e: Error) => {
+                if (e) Expect.fail(e.message)
+                const names = doc.form.fieldNames()
+                Expect(names.length).toBeGreaterThan(0)
+                names.forEach(name => {
+                    const field = doc.form.getField(name)
+                    Expect(field).not.toBeNull()
+                    Expect(name.split('.').pop()).toBe((field as nopodofo.Field).fieldName)
+                })
+                Expect(doc.form.getField('NoPoDoFo.missing.field')).toBeNull()
+                return resolve()
+            })
+        })
+    }
+
+    @AsyncTest('Form describe')
+    public async formDescribe() {
+        return new Promise((resolve, reject) => {
+            const doc = new nopodofo.Document()
+            doc.load(this.filePath, async (e: Error) => {
+                if (e) Expect.fail(e.message)
+                const d = doc.form.describe()
+                const names = doc.form.fieldNames()
+                Expect(d.count).toBe(names.length)
+                Expect(d.rect.length).toBe(d.count * 4)
+                Expect(Array.from(d.name).map(i => d.strings[i])).toEqual(names)
+                for (let i = 0; i < d.count; i++) {
+                    const field = doc.form.getField(names[i]) as nopodofo.Field
+                    Expect(d.type[i]).toBe(field.type)
+                    Expect(d.page[i]).toBeGreaterThan(-1)
+                }
+                const many = await nopodofo.Form.describeMany([readFileSync(this.filePath), readFileSync(this.filePath)])
+                Expect(many.length).toBe(2)
+                many.forEach(m => {
+                    Expect(m.strings).toEqual(d.strings)
+                    Expect(Array.from(m.rect)).toEqual(Array.from(d.rect))
+                })
+                return resolve()
+            })
+        })
+    }
+
+    @AsyncTest('Form delete fields')
+    public async formDeleteFields() {
+        return new Promise((resolve, reject) => {
+            const doc = new nopodofo.Document()
+            doc.load(this.filePath, (e: Error) => {
+                if (e) Expect.fail(e.message)
+                const names = doc.form.fieldNames()
+                const annots = doc.getPage(0).annotationCount()
+                const deleted = names.slice(0, 2)
+                Expect(doc.form.deleteFields([...deleted, 'NoPoDoFo.missing.field'])).toBe(deleted.length)
+                Expect(doc.form.fieldNames()).toEqual(names.slice(2))
+                deleted.forEach(name => Expect(doc.form.getField(name)).toBeNull())
+                Expect(doc.getPage(0).annotationCount()).toBe(annots - deleted.length)
+                return resolve()
+            })
+        })
+    }
 }
@@ -1,5 +1,8 @@
 import {AsyncSetup, AsyncTeardown, AsyncTest, Expect, TestCase, TestFixture} from 'alsatian'
 import {join} from "path";
+import {createReadStream, mkdtempSync, readFileSync} from "fs";
+import {tmpdir} from "os";
+import {PassThrough} from "stream";
 import {nopodofo, NPDFName} from '../../'
 import Document = nopodofo.Document;
 import StreamDocument = nopodofo.StreamDocument;
@@ -109,5 +112,83 @@ export class FileSpecPreWrite {
             }
         }
     }
-}
 
+    @AsyncTest("Name tree lookup and balanced bulk insert")
+    public async nameTree() {
+        this.mem.attachFile(join(__dirname, '../test-documents/scratch.txt'))
+        const tree = this.mem.getNames(true, NPDFName.EMBEDDED_FILES) as nopodofo.NameTree
+        const existing = tree.keys()
+        Expect(existing.length).toBeGreaterThan(0)
+        const spec = tree.get(existing[existing.length - 1]) as Object
+        Expect(spec).not.toBeNull()
+        Expect(tree.get('missing.txt')).toBeNull()
+        const entries: Array<[string, Ref]> = []
+        for (let i = 0; i < 5000; i++) {
+            entries.push([`file-${String(i).padStart(4, '0')}`, spec.reference])
+        }
+        Expect(tree.set(entries)).toBe(existing.length + 5000)
+        const keys = tree.keys()
+        Expect(keys.length).toBe(existing.length + 5000)
+        Expect(keys.slice().sort()).toEqual(keys)
+        Expect(tree.get('file-4321')).not.toBeNull()
+        Expect(this.mem.getAttachment('scratch.txt')).not.toBeNull()
+        let root = (this.mem.getNames(false) as Object).getDictionary().getKey<Object | Ref>(NPDFName.EMBEDDED_FILES)
+        if (root instanceof Ref) {
+            root = this.mem.getObject(root)
+        }
+        Expect((root as Object).getDictionary().getKeys().includes(NPDFName.KIDS)).toBeTruthy()
+        // nodes replaced by another set stay valid for existing wrappers
+        const kid = this.mem.getObject((root as Object).getDictionary().getKey<Object>(NPDFName.KIDS).getArray().at(0) as Ref)
+        tree.set([['another.txt', spec.reference]])
+        Expect(kid.getDictionary().getKeys().length).toBeGreaterThan(0)
+        return Promise.resolve()
+    }
+
+    @AsyncTest("Extract attachments to a file, a Writable and a directory")
+    public async extract() {
+        const source = join(__dirname, '../test-documents/scratch.txt')
+        const expected = readFileSync(source)
+        this.mem.attachFile(source)
+        const spec = this.mem.getAttachment('scratch.txt')
+        const dir = mkdtempSync(join(tmpdir(), 'nopodofo-'))
+        Expect(await spec.extractTo(join(dir, 'copy.txt'))).toBe(expected.length)
+        Expect(readFileSync(join(dir, 'copy.txt')).equals(expected)).toBeTruthy()
+        const chunks: Buffer[] = []
+        const writable = new PassThrough()
+        writable.on('data', chunk => chunks.push(chunk))
+        Expect(await spec.extractTo(writable)).toBe(expected.length)
+        Expect(Buffer.concat(chunks).equals(expected)).toBeTruthy()
+        // differs from scratch.txt only in case, must not overwrite it
+        await this.mem.attachStream(source, {name: 'SCRATCH.TXT'})
+        const paths = await this.mem.extractAll(dir)
+        Expect(paths.length).toBeGreaterThan(1)
+        Expect(new Set(paths.map(p => p.toLowerCase())).size).toBe(paths.length)
+        Expect(paths.some(p => readFileSync(p).equals(expected))).toBeTruthy()
+        return Promise.resolve()
+    }
+
+    @AsyncTest("Attach a path and a Readable as streamed attachments")
+    public async attachStream() {
+        const source = join(__dirname, '../test-documents/scratch.txt')
+        const expected = readFileSync(source)
+        const readable = createReadStream(source)
+        const events = ['data', 'end', 'error']
+        const listeners = events.map(event => readable.listenerCount(event))
+        const spec = await this.mem.attachStream(readable, {name: 'readable.txt'})
+        Expect(spec.name).toContain('readable.txt')
+        // the listeners hold the document, they are removed once it settles
+        Expect(events.map(event => readable.listenerCount(event))).toEqual(listeners)
+        const dir = mkdtempSync(join(tmpdir(), 'nopodofo-'))
+        Expect(await spec.extractTo(join(dir, 'readable.txt'))).toBe(expected.length)
+        Expect(readFileSync(join(dir, 'readable.txt')).equals(expected)).toBeTruthy()
+        // the document stays usable while the source is read
+        const pending = this.stream.attachStream(source)
+        const pages = this.stream.getPageCount()
+        this.stream.createPage(new nopodofo.Rect(0, 0, 612, 792))
+        Expect(this.stream.getPageCount()).toBe(pages + 1)
+        const fromPath = await pending
+        Expect(fromPath.name).toContain('scratch.txt')
+        Expect(this.stream.getNames(false)).not.toBeNull()
+        return Promise.resolve()
+    }
+}
@@ -69,4 +69,22 @@ export class FontSpec {
         Expect(metric.lineSpacing).toEqual(metricSub.lineSpacing)
     }
 
-}
\ No newline at end of file
+    @AsyncTest('Measure strings')
+    @TestCase('mem')
+    @TestCase('stream')
+    public async measure(m: string) {
+        const doc: Base = (this as any)[m]
+        const firaCode = doc.createFont({
+            fontName: 'Fira Code',
+            fileName: join(__dirname, '../test-documents/FiraCode_Regular.ttf')
+        })
+        const values = ['Header', 'a longer cell value', '']
+        const widths = firaCode.measure(values)
+        Expect(widths.length).toBe(3)
+        for (let i = 0; i < values.length; i++) {
+            Expect(widths[i]).toBe(firaCode.stringWidth(values[i]))
+        }
+        Expect(widths[1]).toBeGreaterThan(widths[0])
+        Expect(widths[2]).toBe(0)
+    }
+}
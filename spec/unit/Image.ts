@@ -1,6 +1,6 @@
 import {AsyncTest, Expect, TestFixture, Timeout} from 'alsatian'
 import {join} from "path";
-import {nopodofo, NPDFName} from '../../'
+import {nopodofo, NPDFImageFormat, NPDFName} from '../../'
 import {readFileSync, writeFileSync} from "fs";
 import {v4} from 'uuid'
 import Rect = nopodofo.Rect;
@@ -83,6 +83,128 @@ export class ImageSpec {
         await this.testDocument(data)
     }
 
+    @AsyncTest('Identical images share one XObject')
+    public async dedupImages() {
+        const imgSrc = readFileSync(join(__dirname, '../test-documents/test.jpg'))
+        Image.clearCache()
+        const doc = new StreamDocument()
+        const painter = new Painter(doc)
+        const first = new Image(doc, imgSrc)
+        const second = new Image(doc, join(__dirname, '../test-documents/test.jpg'))
+        let stats = Image.cacheStats()
+        Expect(stats.documentHits).toBeGreaterThan(0)
+        for (let i = 0; i < 3; i++) {
+            const page = doc.createPage(new Rect(0, 0, 612, 792))
+            painter.setPage(page)
+            painter.drawImage(i % 2 ? first : second, 0, 0, {width: 20, height: 30})
+            painter.finishPage()
+        }
+        // a second document copies the cached data
+        const other = new StreamDocument()
+        const third = new Image(other, imgSrc)
+        Expect(third.width).toBe(first.width)
+        stats = Image.cacheStats()
+        Expect(stats.entries).toBe(1)
+        Expect(stats.hits).toBeGreaterThan(0)
+        other.close()
+
+        const data = doc.close() as Buffer
+        const images = data.toString('latin1').match(/\/Subtype\s*\/Image/g) || []
+        Expect(images.length).toBe(1)
+        await this.testDocument(data)
+    }
+
+    @AsyncTest('Changing a shared image copies its XObject')
+    public async copySharedImage() {
+        const src = join(__dirname, '../test-documents/test.jpg')
+        const doc = new Document()
+        const first = new Image(doc, src)
+        const second = new Image(doc, src)
+        second.setInterpolate(true)
+        const page = doc.createPage(new Rect(0, 0, 612, 792))
+        const painter = new Painter(doc)
+        painter.setPage(page)
+        painter.drawImage(first, 0, 0, {width: 20, height: 30})
+        painter.drawImage(second, 100, 0, {width: 20, height: 30})
+        painter.finishPage()
+        const data: Buffer = await new Promise<Buffer>((resolve, reject) =>
+            doc.write((e, d) => e ? reject(e) : resolve(d as Buffer)))
+        const text = data.toString('latin1')
+        Expect((text.match(/\/Subtype\s*\/Image/g) || []).length).toBe(2)
+        Expect((text.match(/\/Interpolate\s*true/g) || []).length).toBe(1)
+    }
+
+    @AsyncTest('Load images off the main thread')
+    public async loadImagesAsync() {
+        const src = join(__dirname, '../test-documents/test.jpg')
+        const doc = new StreamDocument()
+        const image = await new Promise<Image>((resolve, reject) =>
+            Image.load(doc, readFileSync(src), NPDFImageFormat.jpeg, (e, i) => e ? reject(e) : resolve(i)))
+        const batch = await new Promise<Image[]>((resolve, reject) =>
+            Image.loadMany(doc, [src, {source: readFileSync(src), format: NPDFImageFormat.jpeg}], {threads: 2},
+                (e, i) => e ? reject(e) : resolve(i)))
+        Expect(batch.length).toBe(2)
+        batch.forEach(i => Expect(i.width).toBe(image.width))
+        const failure = await new Promise<Error>(resolve =>
+            Image.loadMany(doc, [src, '/not/an/image.jpg'], e => resolve(e)))
+        Expect(failure).toBeDefined()
+        Expect(failure.message).toMatch(/^image 1:/)
+        const page = doc.createPage(new Rect(0, 0, 612, 792))
+        const painter = new Painter(doc)
+        painter.setPage(page)
+        painter.drawImage(batch[1], 0, page.height - image.height, {width: 20, height: 30})
+        painter.finishPage()
+        await this.testDocument(doc.close())
+    }
+
+    @AsyncTest('Optimize images on load and per document')
+    public async optimizeImages() {
+        // test.jpg is 178 x 178 pixels, placed at 36 x 36 points it has 356 dpi
+        const src = join(__dirname, '../test-documents/test.jpg')
+        const stream = new StreamDocument()
+        const plain = await new Promise<Image>((resolve, reject) =>
+            Image.load(stream, src, (e, i) => e ? reject(e) : resolve(i)))
+        Expect(plain.report).toBeNull()
+        const small = await new Promise<Image>((resolve, reject) =>
+            Image.load(stream, src, NPDFImageFormat.jpeg, {dpi: 72, width: 36, height: 36},
+                (e, i) => e ? reject(e) : resolve(i)))
+        Expect(small.report).not.toBeNull()
+        Expect(small.report!.action).toBe('downsampled')
+        Expect(small.report!.dpi).toBe(356)
+        Expect(small.report!.width).toBe(36)
+        Expect(small.report!.height).toBe(36)
+        Expect(small.report!.bytes).toBeLessThan(small.report!.originalBytes)
+        Expect(small.report!.saved).toBe(small.report!.originalBytes - small.report!.bytes)
+        stream.close()
+
+        const doc = new Document()
+        await new Promise(resolve => doc.load(join(__dirname, '../test-documents/test.pdf'), e => {
+            if (e) Expect.fail(e.message)
+            resolve()
+        }))
+        const image = new Image(doc, src)
+        const page = doc.getPage(0)
+        const painter = new Painter(doc)
+        painter.setPage(page)
+        painter.drawImage(image, 0, 0, {width: 36, height: 36})
+        painter.finishPage()
+        const write = () => new Promise<Buffer>((resolve, reject) =>
+            doc.write((e, d) => e ? reject(e) : resolve(d as Buffer)))
+        const before = await write()
+        const reports = doc.optimizeImages({dpi: 72})
+        const report = reports.find(r => r.originalWidth === 178 && r.originalHeight === 178)
+        Expect(report).toBeDefined()
+        Expect(report!.action).toBe('downsampled')
+        Expect(report!.dpi).toBe(356)
+        Expect(report!.width).toBe(36)
+        Expect(report!.height).toBe(36)
+        Expect(report!.bytes).toBeLessThan(report!.originalBytes)
+        reports.forEach(r => Expect(r.saved).not.toBeLessThan(0))
+        const after = await write()
+        Expect(after.length).toBeLessThan(before.length)
+        Expect(after.toString('latin1')).toMatch(/\/Width\s+36\b/)
+    }
+
     public async testDocument(data: string | Buffer) {
         const doc = new Document();
         (doc as Document).load(data, (e, d) => {
@@ -1,6 +1,7 @@
 import {AsyncSetup, AsyncTeardown, AsyncTest, Expect, TestCase, TestFixture, Timeout} from 'alsatian'
-import {nopodofo} from '../../'
+import {nopodofo, NPDFFontEncoding} from '../../'
 import {join} from "path";
+import {constants, inflateSync} from 'zlib'
 import Document = nopodofo.Document;
 import Base = nopodofo.Base;
 import Rect = nopodofo.Rect;
@@ -115,4 +116,79 @@ export class pageSpec {
         })
     }
 
-}
\ No newline at end of file
+    @AsyncTest('Redact content under rects')
+    public async redactTest() {
+        const page = this.mem.getPage(0)
+        const none = page.redact(new Float64Array([0, 0, 1, 1]), {fill: false})
+        Expect(none.glyphs).toBe(0)
+        Expect(none.resources).toBe(0)
+        const all = page.redact([new Rect(0, 0, page.width, page.height)], {color: [0, 0, 0]})
+        Expect(all.glyphs).toBeGreaterThan(0)
+        Expect(all.resources).toBeLessThanOrEqual(all.images + all.forms)
+        const tokens = new nopodofo.ContentsTokenizer(this.mem, 0).readSync()
+        for (let item = tokens.next(); !item.done; item = tokens.next()) {
+            Expect(item.value.trim()).toBe('')
+        }
+        const reports = this.mem.redact(new Uint32Array([0]), new Float64Array([0, 0, 1, 1]), {threads: 2})
+        Expect(reports.length).toBe(this.mem.getPageCount())
+        Expect(() => this.stream.getPage(0).redact([new Rect(0, 0, 10, 10)])).toThrow()
+    }
+
+    @AsyncTest('Redact part of a page and write the result')
+    public async redactPartialTest() {
+        const doc = new Document()
+        const page = doc.createPage(new Rect(0, 0, 612, 792))
+        const painter = new nopodofo.Painter(doc)
+        painter.setPage(page)
+        const font = doc.createFont({fontName: 'Helvetica', encoding: NPDFFontEncoding.WinAnsi})
+        font.size = 12
+        painter.font = font
+        // CONFIDENTIAL is 88pt wide at 12pt, VISIBLE starts well right of the rect
+        painter.drawText({x: 100, y: 700}, 'CONFIDENTIAL')
+        painter.drawText({x: 300, y: 700}, 'VISIBLE')
+        const image = new nopodofo.Image(doc, join(__dirname, '../test-documents/test.jpg'))
+        painter.drawImage(image, 100, 400, {width: 50, height: 50})
+        painter.finishPage()
+
+        const report = page.redact([new Rect(90, 690, 120, 30), new Rect(90, 390, 70, 70)], {fill: false})
+        Expect(report.glyphs).toBe('CONFIDENTIAL'.length)
+        Expect(report.images).toBe(1)
+        Expect(report.resources).toBe(1)
+        const shown = (d: Document) => {
+            const tokens = new nopodofo.ContentsTokenizer(d, 0).readSync()
+            let text = ''
+            for (let item = tokens.next(); !item.done; item = tokens.next()) {
+                text += item.value
+            }
+            return text
+        }
+        Expect(shown(doc)).toContain('VISIBLE')
+        Expect(shown(doc)).not.toContain('CONFIDENTIAL')
+
+        const data = await new Promise<Buffer>((resolve, reject) =>
+            doc.write((e, d) => e ? reject(e) : resolve(d)))
+        // the raw file and every inflated stream, including unreferenced ones
+        const raw = data.toString('latin1')
+        let contents = raw
+        const start = /stream\r?\n/g
+        for (let m = start.exec(raw); m; m = start.exec(raw)) {
+            const from = m.index + m[0].length
+            try {
+                contents += inflateSync(data.slice(from, raw.indexOf('endstream', from)),
+                    {finishFlush: constants.Z_SYNC_FLUSH}).toString('latin1')
+            } catch (e) {
+                // not Flate encoded
+            }
+        }
+        Expect(contents).toContain('VISIBLE')
+        Expect(contents).not.toContain('CONFIDENTIAL')
+        Expect(raw.match(/\/Subtype\s*\/Image/g)).toBeNull()
+
+        const reloaded = await new Promise<Document>((resolve, reject) => {
+            const copy = new Document()
+            copy.load(data, e => e ? reject(e) : resolve(copy))
+        })
+        Expect(shown(reloaded)).toContain('VISIBLE')
+        Expect(shown(reloaded)).not.toContain('CONFIDENTIAL')
+    }
+}
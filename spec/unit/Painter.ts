@@ -1,5 +1,5 @@
 import {AsyncTest, Expect, Test, TestFixture} from 'alsatian'
-import {CONVERSION, nopodofo, NPDFFontEncoding} from '../../'
+import {CONVERSION, nopodofo, NPDFFontEncoding, NPDFPainterOp} from '../../'
 import {join} from 'path'
 
 if (!global.gc) {
@@ -54,6 +54,117 @@ export class PainterSpec {
         Expect(Buffer.isBuffer(output)).toBeTruthy()
     }
 
+    @Test('Painter execute command buffer')
+    public painterExecute() {
+        const doc = new nopodofo.Document()
+        const page = doc.createPage(new nopodofo.Rect(0, 0, 612, 792))
+        const painter = new nopodofo.Painter(doc)
+        painter.setPage(page)
+        const font = doc.createFont({fontName: 'Courier', embed: false})
+        const ops = Uint8Array.from([
+            NPDFPainterOp.SetFont,
+            NPDFPainterOp.SetColor,
+            NPDFPainterOp.DrawText,
+            NPDFPainterOp.Rectangle,
+            NPDFPainterOp.Stroke,
+            NPDFPainterOp.DrawText])
+        const operands = Float64Array.from([
+            0,
+            1, 0, 0,
+            100, 700, 0,
+            90, 690, 200, 30,
+            100, 650, 1])
+        painter.execute(ops, operands, ['CommandBuffer', 'SecondLine'], [font])
+        Expect(() => painter.execute(Uint8Array.from([NPDFPainterOp.LineTo]), Float64Array.from([1])))
+            .toThrow()
+        painter.finishPage()
+        const contents = new nopodofo.ContentsTokenizer(doc, 0).readSync()
+        let found = 0
+        let it = contents.next()
+        while (!it.done) {
+            if (it.value.includes('CommandBuffer') || it.value.includes('SecondLine')) found++
+            it = contents.next()
+        }
+        Expect(found).toBe(2)
+    }
+
+    @Test('Painter record and draw DisplayList')
+    public painterDisplayList() {
+        const doc = new nopodofo.Document()
+        const font = doc.createFont({fontName: 'Courier', embed: false})
+        const painter = new nopodofo.Painter(doc)
+        const list = painter.record(
+            new nopodofo.Rect(0, 0, 612, 100),
+            Uint8Array.from([NPDFPainterOp.SetFont, NPDFPainterOp.DrawText, NPDFPainterOp.DrawLine]),
+            Float64Array.from([0, 20, 60, 0, 20, 50, 592, 50]),
+            ['Letterhead'],
+            [font],
+            {
+                ops: Uint8Array.from([NPDFPainterOp.SetFont, NPDFPainterOp.DrawText]),
+                operands: Float64Array.from([0, 500, 20, 0]),
+                numbers: Uint32Array.from([1]),
+                resources: [font]
+            })
+        Expect(list instanceof nopodofo.DisplayList).toBeTruthy()
+        Expect(list.numberSlots).toBe(1)
+        for (let i = 0; i < 2; i++) {
+            const page = doc.createPage(new nopodofo.Rect(0, 0, 612, 792))
+            painter.setPage(page)
+            painter.drawList(list, 0, 692, {texts: [`Page ${i + 1}`], numbers: [520]})
+            painter.finishPage()
+        }
+        for (let i = 0; i < 2; i++) {
+            const contents = new nopodofo.ContentsTokenizer(doc, i).readSync()
+            let found = false
+            let it = contents.next()
+            while (!it.done) {
+                if (it.value.includes(`Page ${i + 1}`)) found = true
+                it = contents.next()
+            }
+            Expect(found).toBeTruthy()
+        }
+        const other = new nopodofo.Document()
+        const otherPainter = new nopodofo.Painter(other)
+        otherPainter.setPage(other.createPage(new nopodofo.Rect(0, 0, 612, 792)))
+        Expect(() => otherPainter.drawList(list, 0, 0)).toThrow()
+        otherPainter.finishPage()
+    }
+
+    @Test('Stream table paginates and repeats the header')
+    public streamTable() {
+        const doc = new nopodofo.Document()
+        const font = doc.createFont({fontName: 'Courier', embed: false})
+        const table = new nopodofo.StreamTable(doc, {
+            font,
+            columns: [{width: 100}, {width: 300}, {width: 100, decimals: 2}],
+            header: ['Id', 'Description', 'Amount']
+        })
+        let row = 0
+        table.draw(() => {
+            if (row >= 200) return null
+            const chunk: string[] = []
+            for (let i = 0; i < 50; i++, row++) {
+                chunk.push(`${row}`, `Ledger entry ${row}`, (row * 1.5).toFixed(2))
+            }
+            return chunk
+        })
+        table.addRows(Float64Array.from([200, 0, 1.25]))
+        const pages = table.finish()
+        Expect(table.rowCount).toBe(201)
+        Expect(pages).toBeGreaterThan(1)
+        Expect(doc.getPageCount()).toBe(pages)
+        for (let i = 0; i < pages; i++) {
+            const contents = new nopodofo.ContentsTokenizer(doc, i).readSync()
+            let header = false
+            let it = contents.next()
+            while (!it.done) {
+                if (it.value.includes('Description')) header = true
+                it = contents.next()
+            }
+            Expect(header).toBeTruthy()
+        }
+    }
+
     @AsyncTest('Painter drawing apis')
     public async painter() {
         let doc = new nopodofo.Document()
@@ -85,6 +85,44 @@ export class PrimitiveSpec {
         }
     }
 
+    @AsyncTest('Object graph to Javascript values')
+    public async objectToJS() {
+        let doc = await NDocument.from(join(__dirname, '../test-documents/test.pdf'))
+        try {
+            const shallow = doc.catalog.toJS()
+            Expect(shallow.Type).toBe('Catalog')
+            Expect(shallow.Pages instanceof nopodofo.Ref).toBe(true)
+
+            const catalog = doc.catalog.toJS({resolveRefs: true})
+            const pages = catalog.Pages
+            Expect(pages.Type).toBe('Pages')
+            Expect(Array.isArray(pages.Kids)).toBe(true)
+            // /Parent points back to the Pages node that is still being converted
+            Expect(pages.Kids[0].Parent instanceof nopodofo.Ref).toBe(true)
+
+            const limited = doc.catalog.toJS({resolveRefs: true, depth: 1})
+            Expect(limited.Pages.Type).toBe('Pages')
+            Expect(limited.Pages.Kids[0] instanceof nopodofo.Ref).toBe(true)
+
+            // a reference chain deeper than the nesting limit ends in a Ref
+            const mem = new nopodofo.Document()
+            const chain = Array.from({length: 400}, () => mem.createXObject(new nopodofo.Rect(0, 0, 1, 1)))
+            for (let i = 0; i + 1 < chain.length; i++) {
+                chain[i].contents.getDictionary().addKey('Next', chain[i + 1].reference)
+            }
+            let node = chain[0].contents.toJS({resolveRefs: true})
+            let levels = 0
+            while (node.Next && !(node.Next instanceof nopodofo.Ref)) {
+                node = node.Next
+                levels++
+            }
+            Expect(levels).toBeLessThan(chain.length - 1)
+            Expect(node.Next instanceof nopodofo.Ref).toBe(true)
+        } catch (e) {
+            Expect.fail(e)
+        }
+    }
+
     @AsyncTest('nopodofo.Array manipulation')
     public arrayManipulations() {
         return new Promise((resolve, reject) => {
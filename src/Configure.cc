@@ -1,6 +1,6 @@
 #include "Configure.h"
+#include "Logger.h"
 #include "ValidateArguments.h"
-#include <spdlog/sinks/basic_file_sink.h>
 
 using namespace Napi;
 
@@ -26,42 +26,30 @@ Configure::Initialize(Napi::Env& env, Napi::Object& target)
 Configure::Configure(const Napi::CallbackInfo& info)
   : ObjectWrap(info)
 {
-  DbgLog = spdlog::get("DbgLog");
 }
 void
 Configure::EnableDebugLogging(const CallbackInfo& info, const JsValue& value)
 {
-  if (DbgLog == nullptr) {
+  if (Logger::Get() == nullptr) {
     Error::New(info.Env(),
                "Before debug logging can be enabled the output must be set. "
                "See Configure::logFile in the docs")
       .ThrowAsJavaScriptException();
     return;
   }
-  if (value.IsBoolean() && value.As<Boolean>() == true) {
-    DbgLog->set_level(spdlog::level::debug);
-    DbgLog->flush_on(spdlog::level::debug);
-  } else {
-    DbgLog->set_level(spdlog::level::off);
-  }
+  Logger::SetDebug(value.IsBoolean() && value.As<Boolean>() == true);
 }
 JsValue
 Configure::GetDebugLogging(const Napi::CallbackInfo& info)
 {
-  bool enabled = false;
-  if (DbgLog->level() == spdlog::level::debug) {
-    enabled = true;
-  }
-  return Boolean::New(info.Env(), enabled);
+  return Boolean::New(info.Env(), Logger::Enabled());
 }
 void
 Configure::LogOutput(const Napi::CallbackInfo& info)
 {
-  AssertCallbackInfo(info, { { 0, { option(napi_string) } } });
+  AssertArguments<ArgTypes<napi_string>>(info);
   const auto output = info[0].As<String>().Utf8Value();
-  if (!DbgLog) {
-    DbgLog = spdlog::basic_logger_mt("DbgLog", output);
-  } else {
+  if (!Logger::Configure(output)) {
     if (info.Env().Global().Has("console")) {
       info.Env()
         .Global()
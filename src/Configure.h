@@ -7,7 +7,6 @@
 
 
 #include <napi.h>
-#include "spdlog/spdlog.h"
 
 using JsValue = Napi::Value;
 
@@ -23,8 +22,6 @@ public:
 	void EnableDebugLogging(const Napi::CallbackInfo&, const JsValue&);
 	JsValue GetDebugLogging(const Napi::CallbackInfo&);
 	void LogOutput(const Napi::CallbackInfo&);
-private:
-	std::shared_ptr<spdlog::logger> DbgLog;
 };
 
 }
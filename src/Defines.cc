@@ -1,15 +1,12 @@
 #include "Defines.h"
-#include "spdlog/spdlog.h"
+#include "Logger.h"
 #include <iostream>
 
 namespace NoPoDoFo {
 int
 FileAccess(std::string& file)
 {
-	auto dbgLog = spdlog::get("DbgLog");
-	std::stringstream msg;
-	msg << "Attempting to access file " << file;
-	if(dbgLog != nullptr) dbgLog->debug(msg.str());
+  NPDF_LOG_DEBUG("Attempting to access file {}", file);
   auto found = 0;
 #ifdef __APPLE__
   if (access(file.c_str(), F_OK) == -1) {
@@ -22,11 +19,7 @@ FileAccess(std::string& file)
     found = 1;
   }
 #endif
-  if(found == 0) {
-  	if(dbgLog != nullptr)dbgLog->debug("file not found");
-  } else {
-  	if(dbgLog != nullptr)dbgLog->debug("file found");
-  }
+  NPDF_LOG_DEBUG(found == 0 ? "file not found" : "file found");
   return found;
 }
 /**
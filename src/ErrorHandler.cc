@@ -18,7 +18,7 @@
  */
 
 #include "ErrorHandler.h"
-#include "spdlog/spdlog.h"
+#include "Logger.h"
 
 using namespace PoDoFo;
 
@@ -31,21 +31,19 @@ using std::stringstream;
 
 ErrorHandler::ErrorHandler(PoDoFo::PdfError& err, const CallbackInfo& info)
 {
-  DbgLog = spdlog::get("DbgLog");
   const auto msg = WriteMsg(err);
   stringstream eMsg;
   eMsg << "PoDoFo error: " << msg << endl;
   err.PrintErrorMsg();
-  if(DbgLog != nullptr) DbgLog->debug(eMsg.str());
+  NPDF_LOG_DEBUG(eMsg.str());
   Error::New(info.Env(), eMsg.str()).ThrowAsJavaScriptException();
 }
 
 ErrorHandler::ErrorHandler(Error& err, const CallbackInfo& info)
 {
-  DbgLog = spdlog::get("DbgLog");
   stringstream msg;
   msg << "JS error: " << err.Message() << endl;
-  if(DbgLog != nullptr) DbgLog->debug(msg.str());
+  NPDF_LOG_DEBUG(msg.str());
   Error::New(info.Env(), msg.str()).ThrowAsJavaScriptException();
 }
 
@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include "spdlog/logger.h"
 
 class ErrorHandler
 {
@@ -38,6 +37,5 @@ public:
 
 private:
   static std::string ParseMsgFromPdfError(PoDoFo::PdfError&);
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 #endif // NPDF_ERRORHANDLER_H
@@ -0,0 +1,62 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Logger.h"
+#include "spdlog/async.h"
+#include "spdlog/sinks/basic_file_sink.h"
+#include <mutex>
+
+namespace NoPoDoFo {
+
+std::shared_ptr<spdlog::logger> Logger::Owner;
+std::atomic<spdlog::logger*> Logger::Instance(nullptr);
+std::atomic<bool> Logger::Debug(false);
+
+bool
+Logger::Configure(const std::string& file, size_t queueSize)
+{
+  static std::mutex lock;
+  std::lock_guard<std::mutex> guard(lock);
+  if (Owner) {
+    return false;
+  }
+  spdlog::init_thread_pool(queueSize, 1);
+  Owner =
+    spdlog::create_async_nb<spdlog::sinks::basic_file_sink_mt>("DbgLog", file);
+  Owner->set_level(spdlog::level::off);
+  Instance.store(Owner.get(), std::memory_order_release);
+  return true;
+}
+
+void
+Logger::SetDebug(bool enabled)
+{
+  auto logger = Get();
+  if (logger == nullptr) {
+    return;
+  }
+  if (enabled) {
+    logger->set_level(spdlog::level::debug);
+    logger->flush_on(spdlog::level::debug);
+  } else {
+    logger->set_level(spdlog::level::off);
+  }
+  Debug.store(enabled, std::memory_order_relaxed);
+}
+}
@@ -0,0 +1,82 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_LOGGER_H
+#define NPDF_LOGGER_H
+
+#include "spdlog/spdlog.h"
+#include <atomic>
+#include <memory>
+#include <string>
+
+// Compile time gate, building with -DNPDF_DEBUG_LOG=0 removes every debug
+// log statement
+#ifndef NPDF_DEBUG_LOG
+#define NPDF_DEBUG_LOG 1
+#endif
+
+namespace NoPoDoFo {
+
+/**
+ * Process wide handle to the debug logger configured by Configure.logFile.
+ * The logger is looked up once instead of through the spdlog registry (a
+ * mutex and a map lookup) by every wrapper, and the runtime level is
+ * mirrored in an atomic so a disabled log statement costs a relaxed load.
+ */
+class Logger
+{
+public:
+  // The debug logger, nullptr until configured
+  static spdlog::logger* Get()
+  {
+    return Instance.load(std::memory_order_acquire);
+  }
+  static bool Enabled() { return Debug.load(std::memory_order_relaxed); }
+
+  /**
+   * Log to file through a bounded queue drained by a background thread,
+   * when the queue is full the oldest messages are dropped instead of
+   * blocking the caller. Returns false if a logger is already configured.
+   */
+  static bool Configure(const std::string& file, size_t queueSize = 8192);
+  static void SetDebug(bool);
+
+private:
+  static std::shared_ptr<spdlog::logger> Owner;
+  static std::atomic<spdlog::logger*> Instance;
+  static std::atomic<bool> Debug;
+};
+}
+
+#if NPDF_DEBUG_LOG
+// Arguments are only evaluated when debug logging is enabled
+#define NPDF_LOG_DEBUG(...)                                                    \
+  do {                                                                         \
+    if (NoPoDoFo::Logger::Enabled()) {                                         \
+      if (auto npdfLogger = NoPoDoFo::Logger::Get())                           \
+        npdfLogger->debug(__VA_ARGS__);                                        \
+    }                                                                          \
+  } while (0)
+#else
+#define NPDF_LOG_DEBUG(...)                                                    \
+  do {                                                                         \
+  } while (0)
+#endif
+
+#endif // NPDF_LOGGER_H
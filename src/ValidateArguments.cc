@@ -18,60 +18,30 @@
  */
 
 #include "ValidateArguments.h"
+#include "Logger.h"
 #include <sstream>
-#include "spdlog/spdlog.h"
 
 using std::endl;
-using std::map;
 using std::stringstream;
-using std::vector;
 
 namespace NoPoDoFo {
 
-std::vector<int>
-AssertCallbackInfo(const Napi::CallbackInfo& info,
-                   const std::map<int, std::vector<option>>& vars)
+void
+ThrowArgumentCount(const Napi::CallbackInfo& info, size_t expected)
 {
-  vector<int> argIndex;
-  auto dbglog = spdlog::get("DbgLog");
-  for (auto item : vars) {
-    auto valid = false;
-    if (static_cast<int>(info.Length()) - 1 < item.first) {
-      for (size_t i = 0; i < item.second.size(); i++) {
-        if (!item.second[i].has_value()) {
-          valid = true;
-          argIndex.emplace_back(i);
-          break;
-        }
-      }
-      if (!valid) {
-        stringstream eMsg;
-        eMsg << "Expected " << vars.size()
-             << " parameters but received " << info.Length() << endl;
-        if(dbglog != nullptr) dbglog->debug(eMsg.str());
-        Napi::Error::New(info.Env(), eMsg.str()).ThrowAsJavaScriptException();
-        return {};
-      }
-    } else {
-      const auto t = info[static_cast<size_t>(item.first)].Type();
-      for (size_t i = 0; i < static_cast<size_t>(item.second.size()); i++) {
-        auto opt = item.second[i];
-        if (opt.has_value() && opt.value() == t) {
-          valid = true;
-          argIndex.emplace_back(i);
-          break;
-        }
-      }
-      if (!valid) {
-        stringstream eMsg;
-        eMsg << "Invalid function argument at index " << item.first << endl;
-				if(dbglog != nullptr) dbglog->debug(eMsg.str());
-        Napi::TypeError::New(info.Env(), eMsg.str())
-          .ThrowAsJavaScriptException();
-        return {};
-      }
-    }
-  }
-  return argIndex;
+  stringstream eMsg;
+  eMsg << "Expected " << expected << " parameters but received "
+       << info.Length() << endl;
+  NPDF_LOG_DEBUG(eMsg.str());
+  throw Napi::Error::New(info.Env(), eMsg.str());
+}
+
+void
+ThrowArgumentType(const Napi::CallbackInfo& info, size_t index)
+{
+  stringstream eMsg;
+  eMsg << "Invalid function argument at index " << index << endl;
+  NPDF_LOG_DEBUG(eMsg.str());
+  throw Napi::TypeError::New(info.Env(), eMsg.str());
 }
 }
@@ -16,39 +16,90 @@
  * You should have received a copy of the GNU Affero General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+
 #ifndef NPDF_VALIDATEARGUMENTS_H
 #define NPDF_VALIDATEARGUMENTS_H
 
-#include <map>
+#include <array>
 #include <napi.h>
-#include <optional/optional.hpp>
-#include <vector>
+#include <utility>
 
 namespace NoPoDoFo {
 
-using option = tl::optional<napi_valuetype>;
 /**
- * Assert caller argument(s). Since arguments can be variable the assertion
- * checks the type for each index and returns an int array of matching values.
+ * Type accepted by ArgTypes for an argument that was not provided. An
+ * argument explicitly passed as undefined has the type napi_undefined.
+ */
+constexpr int ArgOmitted = -1;
+
+/**
+ * The types accepted at one argument index, in order of preference. The
+ * position of the matching type is what AssertArguments returns for the
+ * argument.
+ */
+template<int... Types>
+struct ArgTypes
+{
+  static_assert(sizeof...(Types) > 0,
+                "An argument requires at least one type");
+
+  // Position of the argument's type in Types, -1 if the type is not accepted
+  static int Match(const Napi::CallbackInfo& info, size_t index)
+  {
+    constexpr int types[] = { Types... };
+    const int type = index < info.Length()
+                       ? static_cast<int>(info[index].Type())
+                       : ArgOmitted;
+    for (size_t i = 0; i < sizeof...(Types); ++i) {
+      if (types[i] == type) {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+};
+
+[[noreturn]] void
+ThrowArgumentCount(const Napi::CallbackInfo&, size_t expected);
+[[noreturn]] void
+ThrowArgumentType(const Napi::CallbackInfo&, size_t index);
+
+template<typename... Args, size_t... Index>
+std::array<int, sizeof...(Args)>
+MatchArguments(const Napi::CallbackInfo& info, std::index_sequence<Index...>)
+{
+  return { { Args::Match(info, Index)... } };
+}
+
+/**
+ * Assert caller argument(s). Each ArgTypes lists the types accepted at that
+ * argument index, the result holds the position of the matching type for
+ * every argument. A JS Error is thrown when a required argument is missing
+ * and a TypeError when an argument has none of the listed types. The
+ * signature is fixed at compile time, checking it does not allocate.
  *
  * @example
- *      std::map validOptions;
- *      validOptions.insert(std::make_pair(0, {napi_valuetype::napi_external,
- *          napi_valuetype::napi_object}))
- *      validOptions.insert(std::make_pair(1,
- *          {napi_valuetype::napi_string, napi_valuetype::napi_function}))
- *      validOptions.insert(std::make_pair(2, {napi_valuetype::napi_null,
- *          napi_valuetype::napi_function}))
- *      vector<int> opt = AssertCallbackInfo(info,
- *          validOptions) // {0,0,0} == napi_external, napi_string, napi_null
- *
- * @param info
- * @param vars
- * @return
+ *      // {0, 1} == napi_string, napi_function
+ *      auto opts =
+ *        AssertArguments<ArgTypes<napi_string, napi_object>,
+ *                        ArgTypes<ArgOmitted, napi_function>>(info);
  */
-std::vector<int>
-AssertCallbackInfo(const Napi::CallbackInfo& info,
-                   const std::map<int, std::vector<option>>& vars);
+template<typename... Args>
+std::array<int, sizeof...(Args)>
+AssertArguments(const Napi::CallbackInfo& info)
+{
+  const auto indices =
+    MatchArguments<Args...>(info, std::index_sequence_for<Args...>());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (indices[i] == -1) {
+      if (i >= info.Length()) {
+        ThrowArgumentCount(info, indices.size());
+      }
+      ThrowArgumentType(info, i);
+    }
+  }
+  return indices;
+}
 }
 
 #endif // NPDF_VALIDATEARGUMENTS_H
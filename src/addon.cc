@@ -33,6 +33,7 @@
 #include "doc/CheckBox.h"
 #include "doc/ComboBox.h"
 #include "doc/Destination.h"
+#include "doc/DisplayList.h"
 #include "doc/Encoding.h"
 #include "doc/Encrypt.h"
 #include "doc/ExtGState.h"
@@ -42,6 +43,7 @@
 #include "doc/Image.h"
 #include "doc/ListBox.h"
 #include "doc/ListField.h"
+#include "doc/NameTree.h"
 #include "doc/Outline.h"
 #include "doc/Page.h"
 #include "doc/Painter.h"
@@ -51,6 +53,7 @@
 #include "doc/Signer.h"
 #include "doc/SimpleTable.h"
 #include "doc/StreamDocument.h"
+#include "doc/StreamTable.h"
 #include "doc/TextField.h"
 #include <napi.h>
 
@@ -82,6 +85,7 @@ INIT(Napi::Env env, Napi::Object exports)
   NoPoDoFo::Data::Initialize(env, exports);
   NoPoDoFo::Destination::Initialize(env, exports);
   NoPoDoFo::Dictionary::Initialize(env, exports);
+  NoPoDoFo::DisplayList::Initialize(env, exports);
   NoPoDoFo::Document::Initialize(env, exports);
   NoPoDoFo::ExtGState::Initialize(env, exports);
   NoPoDoFo::Encoding::Initialize(env, exports);
@@ -91,6 +95,7 @@ INIT(Napi::Env env, Napi::Object exports)
   NoPoDoFo::Form::Initialize(env, exports);
   NoPoDoFo::Image::Initialize(env, exports);
   NoPoDoFo::ListBox::Initialize(env, exports);
+  NoPoDoFo::NameTree::Initialize(env, exports);
   NoPoDoFo::Obj::Initialize(env, exports);
   NoPoDoFo::XObject::Initialize(env, exports);
   NoPoDoFo::Outline::Initialize(env, exports);
@@ -103,6 +108,7 @@ INIT(Napi::Env env, Napi::Object exports)
   NoPoDoFo::SignatureField::Initialize(env, exports);
   NoPoDoFo::SimpleTable::Initialize(env, exports);
   NoPoDoFo::StreamDocument::Initialize(env, exports);
+  NoPoDoFo::StreamTable::Initialize(env, exports);
   NoPoDoFo::TextField::Initialize(env, exports);
   NoPoDoFo::Ref::Initialize(env, exports);
   if (env.Global().Has("console")) {
@@ -18,14 +18,15 @@
  */
 
 #include "Array.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "../ValidateArguments.h"
 #include "Data.h"
 #include "Date.h"
 #include "Dictionary.h"
+#include "Materializer.h"
 #include "Obj.h"
 #include "Ref.h"
-#include "spdlog/spdlog.h"
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -54,17 +55,14 @@ Array::Array(const CallbackInfo& info)
              : *info[0].As<External<PdfArray>>().Data())
         : *(Init = new PdfArray()))
 {
-  DbgLog = spdlog::get("DbgLog");
   if (Init != nullptr) {
-    if (DbgLog != nullptr)
-      DbgLog->debug("Initialized New Array");
+    NPDF_LOG_DEBUG("Initialized New Array");
   }
 }
 
 Array::~Array()
 {
-  if (DbgLog != nullptr)
-    DbgLog->debug("Array cleanup");
+  NPDF_LOG_DEBUG("Array cleanup");
   HandleScope scope(Env());
   for (auto child : Children) {
     delete child;
@@ -149,7 +147,7 @@ Array::IsDirty(const CallbackInfo& info)
 JsValue
 Array::At(const CallbackInfo& info)
 {
-  AssertCallbackInfo(info, { { 0, { option(napi_number) } } });
+  AssertArguments<ArgTypes<napi_number>>(info);
   return GetObjAtIndex(info.Env(), info[0].As<Number>().Int32Value());
 }
 
@@ -230,8 +228,7 @@ Array::GetObjAtIndex(Napi::Env env, size_t index)
   }
   // Create copy for shift and pop operations
   const auto child = new PdfObject(*item);
-  if (DbgLog != nullptr)
-    DbgLog->debug("Array[{}] = {}", index, child->GetDataTypeString());
+  NPDF_LOG_DEBUG("Array[{}] = {}", index, child->GetDataTypeString());
   Children.push_back(child);
   const auto initPtr = Napi::External<PdfObject>::New(env, child);
   const auto instance = Obj::Constructor.New({ initPtr });
@@ -259,13 +256,19 @@ Array::Clear(const CallbackInfo& info)
 JsValue
 Array::ToJsArray(const Napi::CallbackInfo& info)
 {
-  Napi::Array js = Napi::Array::New(info.Env());
-  auto it = GetArray().begin();
-  while (it != GetArray().end()) {
-    Obj::TrickleDown(info.Env(), nullptr, (*it), js);
-    it++;
+  MaterializeOptions options;
+  if (info.Length() > 0 && info[0].IsObject()) {
+    options = ParseMaterializeOptions(info[0].As<Object>());
   }
-  return js;
+  try {
+    Materializer materializer(
+      info.Env(), Parent ? Parent->GetOwner() : nullptr, options);
+    return Parent ? materializer.Convert(*Parent)
+                  : materializer.Convert(GetArray());
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
 }
 
 }
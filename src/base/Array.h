@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using std::vector;
 using JsValue = Napi::Value;
@@ -61,7 +60,6 @@ private:
   PoDoFo::PdfArray& Self;
   PoDoFo::PdfArray* Init = nullptr;
   PoDoFo::PdfObject* Parent = nullptr;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
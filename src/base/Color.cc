@@ -18,17 +18,15 @@
  */
 
 #include "Color.h"
+#include "../Logger.h"
 #include "../Defines.h"
 #include "../ValidateArguments.h"
-#include <optional/optional.hpp>
-#include <spdlog/spdlog.h>
 
 using namespace PoDoFo;
 using namespace Napi;
 using std::string;
 using std::stringstream;
 using std::vector;
-using tl::nullopt;
 
 namespace NoPoDoFo {
 
@@ -63,17 +61,11 @@ Color::Initialize(Napi::Env& env, Napi::Object& target)
 Color::Color(const CallbackInfo& info)
   : ObjectWrap(info)
 {
-  vector<int> opts =
-    AssertCallbackInfo(info,
-                       { { 0,
-                           { option(napi_number),
-                             option(napi_object),
-                             option(napi_external),
-                             option(napi_string) } },
-                         { 1, { nullopt, option(napi_number) } },
-                         { 2, { nullopt, option(napi_number) } },
-                         { 3, { nullopt, option(napi_number) } } });
-  DbgLog = spdlog::get("DbgLog");
+  auto opts = AssertArguments<
+    ArgTypes<napi_number, napi_object, napi_external, napi_string>,
+    ArgTypes<ArgOmitted, napi_number>,
+    ArgTypes<ArgOmitted, napi_number>,
+    ArgTypes<ArgOmitted, napi_number>>(info);
   if (opts[0] == 3) {
     const auto cs = info[0].As<String>().Utf8Value().c_str();
     Self = new PdfColor(PdfColor::FromString(cs));
@@ -102,7 +94,7 @@ Color::Color(const CallbackInfo& info)
 
 Color::~Color()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Color Cleanup");
+  NPDF_LOG_DEBUG("Color Cleanup");
   HandleScope scope(Env());
   delete Self;
 }
@@ -20,7 +20,6 @@
 #ifndef NPDF_COLOR_H
 #define NPDF_COLOR_H
 
-#include "spdlog/logger.h"
 #include <napi.h>
 #include <podofo/podofo.h>
 
@@ -64,7 +63,6 @@ public:
   PdfColor* Self;
 
 private:
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 
@@ -18,10 +18,10 @@
  */
 
 #include "ContentsTokenizer.h"
+#include "../Logger.h"
 #include "../doc/Document.h"
 
 #include <iostream>
-#include <spdlog/spdlog.h>
 #include <sstream>
 #include <stack>
 
@@ -45,12 +45,11 @@ ContentsTokenizer::ContentsTokenizer(const Napi::CallbackInfo& info)
 {
   Self =
     make_unique<PdfContentsTokenizer>(Doc.GetDocument().GetPage(PageIndex));
-  DbgLog = spdlog::get("DbgLog");
 }
 
 ContentsTokenizer::~ContentsTokenizer()
 {
-  if(DbgLog != nullptr) DbgLog->debug("ContentsTokenizer Cleanup");
+  NPDF_LOG_DEBUG("ContentsTokenizer Cleanup");
 }
 void
 ContentsTokenizer::Initialize(Napi::Env& env, Napi::Object& target)
@@ -20,7 +20,6 @@
 #define NPDF_CONTENTSTOKENIZER_H
 
 #include "../doc/Document.h"
-#include "spdlog/logger.h"
 #include <napi.h>
 #include <podofo/podofo.h>
 
@@ -47,7 +46,6 @@ public:
 private:
   std::unique_ptr<PoDoFo::PdfContentsTokenizer> Self;
   Document& Doc;
-  std::shared_ptr<spdlog::logger> DbgLog;
 
   int PageIndex;
   void AddText(PoDoFo::PdfFont*, const PoDoFo::PdfString&);
@@ -18,8 +18,8 @@
  */
 
 #include "Data.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
-#include <spdlog/spdlog.h>
 
 using namespace PoDoFo;
 using namespace Napi;
@@ -43,7 +43,6 @@ Data::Data(const Napi::CallbackInfo& info)
       .ThrowAsJavaScriptException();
     return;
   }
-  DbgLog = spdlog::get("DbgLog");
   if (info[0].IsString()) {
     const auto strData = info[0].As<String>().Utf8Value();
     Self = make_unique<PdfData>(strData.c_str());
@@ -59,7 +58,7 @@ Data::Data(const Napi::CallbackInfo& info)
 
 Data::~Data()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Data Cleanup");
+  NPDF_LOG_DEBUG("Data Cleanup");
 }
 
 void
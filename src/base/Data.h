@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using JsValue = Napi::Value;
 
@@ -41,7 +40,6 @@ public:
 
 private:
   std::unique_ptr<PoDoFo::PdfData> Self;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
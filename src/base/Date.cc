@@ -18,15 +18,12 @@
  */
 
 #include "Date.h"
+#include "../Logger.h"
 #include "../ValidateArguments.h"
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
 
-using Option = tl::optional<napi_valuetype>;
-using tl::nullopt;
-
 namespace NoPoDoFo {
 
 FunctionReference Date::Constructor; // NOLINT
@@ -39,9 +36,8 @@ FunctionReference Date::Constructor; // NOLINT
 Date::Date(const Napi::CallbackInfo& info)
   : ObjectWrap(info)
 {
-  auto argIndex = AssertCallbackInfo(
-    info, { { 0, { option(napi_string), nullopt, option(napi_external) } } });
-  DbgLog = spdlog::get("DbgLog");
+  auto argIndex =
+    AssertArguments<ArgTypes<napi_string, ArgOmitted, napi_external>>(info);
   if (argIndex[0] == 0) {
     Self = new PdfDate(info[0].As<String>().Utf8Value());
     if (!Self->IsValid()) {
@@ -58,7 +54,7 @@ Date::Date(const Napi::CallbackInfo& info)
 }
 Date::~Date()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Date Cleanup");
+  NPDF_LOG_DEBUG("Date Cleanup");
   HandleScope scope(Env());
   delete Self;
 }
@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using JsValue = Napi::Value;
 
@@ -44,7 +43,6 @@ public:
 
 private:
   PoDoFo::PdfDate* Self;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NOPODOFO_DATE_H
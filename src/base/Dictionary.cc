@@ -18,12 +18,13 @@
  */
 
 #include "Dictionary.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "Array.h"
+#include "Materializer.h"
 #include "Obj.h"
 #include "Ref.h"
 #include <algorithm>
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -56,9 +57,8 @@ Dictionary::Dictionary(const CallbackInfo& info)
                 : *info[0].As<External<PdfDictionary>>().Data())
            : *(Init = new PdfDictionary()))
 {
-  DbgLog = spdlog::get("DbgLog");
   if(Init != nullptr) {
-    if(DbgLog != nullptr) DbgLog->debug("New Dictionary Created");
+    NPDF_LOG_DEBUG("New Dictionary Created");
   }
 }
 
@@ -91,7 +91,7 @@ Dictionary::Initialize(Napi::Env& env, Napi::Object& target)
 }
 Dictionary::~Dictionary()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Dictionary Cleanup");
+  NPDF_LOG_DEBUG("Dictionary Cleanup");
   HandleScope scope(Env());
   for (auto i : Children) {
     delete i;
@@ -434,14 +434,22 @@ Dictionary::Write(const CallbackInfo& info)
   }
   return info.Env().Undefined();
 }
-JsValue Dictionary::ToJsObject(const Napi::CallbackInfo &info )
+JsValue
+Dictionary::ToJsObject(const Napi::CallbackInfo& info)
 {
-	Napi::Object target = Napi::Object::New(info.Env());
-	auto it = GetDictionary().GetKeys().begin();
-	while(it != GetDictionary().GetKeys().end()) {
-		Obj::TrickleDown(info.Env(), &(it->first), *it->second, target);
-		it++;
-	}
-	return target;
+  MaterializeOptions options;
+  if (info.Length() > 0 && info[0].IsObject()) {
+    options = ParseMaterializeOptions(info[0].As<Object>());
+  }
+  try {
+    // References can only be resolved through the document owning Parent
+    Materializer materializer(
+      info.Env(), Parent ? Parent->GetOwner() : nullptr, options);
+    return Parent ? materializer.Convert(*Parent)
+                  : materializer.Convert(GetDictionary());
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
 }
 }
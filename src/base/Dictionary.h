@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using JsValue = Napi::Value;
 using std::vector;
@@ -62,7 +61,6 @@ private:
   PoDoFo::PdfDictionary& Self;
   PoDoFo::PdfDictionary* Init = nullptr;
   PoDoFo::PdfObject* Parent = nullptr;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
@@ -0,0 +1,202 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GarbageCollector.h"
+#include "Names.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+using namespace PoDoFo;
+
+using std::function;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+namespace NoPoDoFo {
+
+namespace {
+// 64 bit FNV-1a, only used to bucket candidate duplicates
+uint64_t
+Fnv1a(const char* data, size_t length, uint64_t hash = 14695981039346656037ULL)
+{
+  for (size_t i = 0; i < length; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+struct StreamDigest
+{
+  PdfObject* Obj = nullptr;
+  const char* Data = nullptr;
+  size_t Length = 0;
+  string Dictionary;
+  uint64_t Hash = 0;
+};
+}
+
+GarbageCollector::GarbageCollector(PdfVecObjects& objects, PdfObject& trailer)
+  : Objects(objects)
+  , Trailer(trailer)
+{}
+
+const GCStats&
+GarbageCollector::Collect(unsigned int threads)
+{
+  Mark();
+  MergeStreams(threads);
+  Sweep();
+  return Stats;
+}
+
+void
+GarbageCollector::Visit(PdfObject& obj, const function<void(PdfObject&)>& fn)
+{
+  switch (obj.GetDataType()) {
+    case ePdfDataType_Reference:
+      fn(obj);
+      break;
+    case ePdfDataType_Array:
+      for (auto& item : obj.GetArray()) {
+        Visit(item, fn);
+      }
+      break;
+    case ePdfDataType_Dictionary:
+      for (auto& key : obj.GetDictionary().GetKeys()) {
+        Visit(*key.second, fn);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void
+GarbageCollector::Mark()
+{
+  vector<PdfObject*> pending;
+  auto mark = [&](PdfObject& ref) {
+    auto target = Objects.GetObject(ref.GetReference());
+    if (!target) {
+      // Assign through PdfVariant, PdfObject::operator= also copies the
+      // indirect reference of the right hand side
+      static_cast<PdfVariant&>(ref) = PdfVariant::NullValue;
+      return;
+    }
+    if (Reachable.insert(target).second) {
+      pending.push_back(target);
+    }
+  };
+  Visit(Trailer, mark);
+  while (!pending.empty()) {
+    auto obj = pending.back();
+    pending.pop_back();
+    Visit(*obj, mark);
+  }
+}
+
+void
+GarbageCollector::MergeStreams(unsigned int threads)
+{
+  vector<StreamDigest> streams;
+  for (auto obj : Objects) {
+    if (!Reachable.count(obj) || !obj->HasStream()) {
+      continue;
+    }
+    auto mem = dynamic_cast<PdfMemStream*>(obj->GetStream());
+    if (!mem) {
+      continue;
+    }
+    StreamDigest digest;
+    digest.Obj = obj;
+    digest.Data = mem->Get();
+    digest.Length = static_cast<size_t>(mem->GetLength());
+    PdfDictionary dict(obj->GetDictionary());
+    dict.RemoveKey(PdfName(Name::LENGTH));
+    PdfVariant(dict).ToString(digest.Dictionary, ePdfWriteMode_Compact);
+    streams.push_back(std::move(digest));
+  }
+
+  // Stream data is loaded above, hashing only reads it
+  ParallelFor(streams.size(), threads, [&streams](size_t i) {
+    auto& digest = streams[i];
+    digest.Hash = Fnv1a(digest.Data,
+                        digest.Length,
+                        Fnv1a(digest.Dictionary.data(), digest.Dictionary.size()));
+  });
+
+  unordered_map<uint64_t, vector<StreamDigest*>> buckets;
+  for (auto& digest : streams) {
+    auto& bucket = buckets[digest.Hash];
+    auto original =
+      std::find_if(bucket.begin(), bucket.end(), [&digest](StreamDigest* kept) {
+        return kept->Length == digest.Length &&
+               kept->Dictionary == digest.Dictionary &&
+               memcmp(kept->Data, digest.Data, digest.Length) == 0;
+      });
+    if (original != bucket.end()) {
+      Duplicates[digest.Obj] = (*original)->Obj;
+    } else {
+      bucket.push_back(&digest);
+    }
+  }
+  if (Duplicates.empty()) {
+    return;
+  }
+
+  auto redirect = [this](PdfObject& ref) {
+    auto target = Objects.GetObject(ref.GetReference());
+    auto it = Duplicates.find(target);
+    if (it != Duplicates.end()) {
+      static_cast<PdfVariant&>(ref) = PdfVariant(it->second->Reference());
+    }
+  };
+  Visit(Trailer, redirect);
+  for (auto obj : Reachable) {
+    if (!Duplicates.count(obj)) {
+      Visit(*obj, redirect);
+    }
+  }
+}
+
+void
+GarbageCollector::Sweep()
+{
+  vector<PdfReference> garbage;
+  for (auto obj : Objects) {
+    if (Duplicates.count(obj)) {
+      Stats.DuplicateStreams++;
+    } else if (!Reachable.count(obj)) {
+      Stats.Unreachable++;
+    } else {
+      continue;
+    }
+    garbage.push_back(obj->Reference());
+  }
+  for (auto& ref : garbage) {
+    delete Objects.RemoveObject(ref, false);
+  }
+  Objects.RenumberObjects(&Trailer);
+}
+}
@@ -0,0 +1,74 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_GARBAGECOLLECTOR_H
+#define NPDF_GARBAGECOLLECTOR_H
+
+#include <podofo/podofo.h>
+#include <functional>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+namespace NoPoDoFo {
+
+struct GCStats
+{
+  // Objects not reachable from the trailer
+  size_t Unreachable = 0;
+  // Streams removed because an identical stream was kept
+  size_t DuplicateStreams = 0;
+};
+
+/**
+ * GarbageCollector compacts a PdfVecObjects in place. Every object reachable
+ * from the trailer is marked, streams with identical dictionaries and data are
+ * merged into a single object, everything else is deleted and the remaining
+ * objects are renumbered densely starting at 1. References to objects that do
+ * not exist are replaced with null, as the PDF spec defines them. Unreachable
+ * objects are deleted without being loaded, with on demand parsing they are
+ * never parsed or decrypted.
+ *
+ * Objects are deleted, so this must not run on a PdfMemDocument that may
+ * still hand out pointers to them (fonts, pages, javascript wrappers).
+ */
+class GarbageCollector
+{
+public:
+  GarbageCollector(PoDoFo::PdfVecObjects&, PoDoFo::PdfObject& trailer);
+  explicit GarbageCollector(const GarbageCollector&) = delete;
+  const GarbageCollector& operator=(const GarbageCollector&) = delete;
+  // threads is used for hashing stream data, 0 uses the hardware concurrency
+  const GCStats& Collect(unsigned int threads = 0);
+
+private:
+  void Mark();
+  void MergeStreams(unsigned int threads);
+  void Sweep();
+  static void Visit(PoDoFo::PdfObject&,
+                    const std::function<void(PoDoFo::PdfObject&)>&);
+
+  PoDoFo::PdfVecObjects& Objects;
+  PoDoFo::PdfObject& Trailer;
+  std::unordered_set<PoDoFo::PdfObject*> Reachable;
+  std::map<PoDoFo::PdfObject*, PoDoFo::PdfObject*> Duplicates;
+  GCStats Stats;
+};
+}
+#endif // NPDF_GARBAGECOLLECTOR_H
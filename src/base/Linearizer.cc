@@ -0,0 +1,645 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Linearizer.h"
+#include "Names.h"
+#include "Writer.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+
+using namespace PoDoFo;
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace NoPoDoFo {
+
+namespace {
+// Numbers in the linearization dictionary and first page trailer are written
+// before the values are known, padding keeps their size fixed
+const size_t FIELD_WIDTH = 10;
+
+string
+Padded(size_t value)
+{
+  auto field = std::to_string(value);
+  field.append(FIELD_WIDTH - std::min(FIELD_WIDTH, field.size()), ' ');
+  return field;
+}
+
+string
+XRefEntry(size_t offset)
+{
+  char entry[21];
+  snprintf(entry,
+           sizeof(entry),
+           "%010llu 00000 n \n",
+           static_cast<unsigned long long>(offset));
+  return entry;
+}
+
+size_t
+Total(const vector<size_t>& lengths)
+{
+  size_t total = 0;
+  for (const auto length : lengths) {
+    total += length;
+  }
+  return total;
+}
+
+// Copy length bytes from the current position of file to device
+void
+Copy(FILE* file, PdfOutputDevice* device, size_t length)
+{
+  vector<char> chunk(64 * 1024);
+  while (length > 0) {
+    const auto n = fread(chunk.data(), 1, std::min(length, chunk.size()), file);
+    if (n == 0) {
+      PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidDeviceOperation,
+                              "Failed to read a temporary file");
+    }
+    device->Write(chunk.data(), static_cast<pdf_long>(n));
+    length -= n;
+  }
+}
+
+// Bits needed to represent value
+int
+Bits(size_t value)
+{
+  int bits = 0;
+  while (value) {
+    bits++;
+    value >>= 1;
+  }
+  return bits;
+}
+
+// Hint tables are bit packed, most significant bit first
+class BitWriter
+{
+public:
+  void Write(size_t value, int bits)
+  {
+    for (int b = bits - 1; b >= 0; b--) {
+      Current = static_cast<unsigned char>((Current << 1) | ((value >> b) & 1));
+      if (++Count == 8) {
+        Data.push_back(static_cast<char>(Current));
+        Current = 0;
+        Count = 0;
+      }
+    }
+  }
+  // Pad to the next byte boundary
+  void Flush()
+  {
+    if (Count) {
+      Data.push_back(static_cast<char>(Current << (8 - Count)));
+      Current = 0;
+      Count = 0;
+    }
+  }
+  string Data;
+
+private:
+  unsigned char Current = 0;
+  int Count = 0;
+};
+
+template<typename F>
+void
+ForEachReference(const PdfVariant& value, F& fn)
+{
+  switch (value.GetDataType()) {
+    case ePdfDataType_Reference:
+      fn(value.GetReference());
+      break;
+    case ePdfDataType_Array:
+      for (const auto& item : value.GetArray()) {
+        ForEachReference(item, fn);
+      }
+      break;
+    case ePdfDataType_Dictionary:
+      for (const auto& key : value.GetDictionary().GetKeys()) {
+        ForEachReference(*key.second, fn);
+      }
+      break;
+    default:
+      break;
+  }
+}
+}
+
+Linearizer::Linearizer(PdfVecObjects* objects,
+                       const PdfObject* trailer,
+                       PdfEncrypt* encrypt,
+                       EPdfWriteMode mode,
+                       int compressionLevel)
+  : Objects(objects)
+  , Trailer(trailer)
+  , Encrypt(encrypt)
+  , Mode(mode)
+  , CompressionLevel(compressionLevel)
+{}
+
+PdfObject*
+Linearizer::Resolve(const PdfObject* value) const
+{
+  if (!value || !value->IsReference()) {
+    return nullptr;
+  }
+  return Objects->GetObject(value->GetReference());
+}
+
+void
+Linearizer::CollectPages(PdfObject* node, set<PdfObject*>& seen)
+{
+  if (!node || !node->IsDictionary() || !seen.insert(node).second) {
+    return;
+  }
+  const auto type = node->GetDictionary().GetKey(PdfName::KeyType);
+  const auto kids = node->GetDictionary().GetKey(PdfName(Name::KIDS));
+  if ((type && type->IsName() && type->GetName() == PdfName(Name::PAGES)) ||
+      (kids && kids->IsArray())) {
+    PageTree.insert(node);
+    if (kids && kids->IsArray()) {
+      for (const auto& kid : kids->GetArray()) {
+        CollectPages(Resolve(&kid), seen);
+      }
+    }
+  } else {
+    Pages.push_back(node);
+  }
+}
+
+vector<PdfObject*>
+Linearizer::Closure(PdfObject* root, const set<PdfObject*>& stops) const
+{
+  vector<PdfObject*> order{ root };
+  set<PdfObject*> seen{ root };
+  auto follow = [&](const PdfReference& ref) {
+    auto target = Objects->GetObject(ref);
+    if (target && !stops.count(target) && seen.insert(target).second) {
+      order.push_back(target);
+    }
+  };
+  // Breadth first, objects are written in the order they are needed
+  for (size_t i = 0; i < order.size(); i++) {
+    ForEachReference(*order[i], follow);
+  }
+  return order;
+}
+
+void
+Linearizer::Partition()
+{
+  const auto catalog =
+    Resolve(Trailer->GetDictionary().GetKey(PdfName(Name::ROOT)));
+  if (!catalog || !catalog->IsDictionary()) {
+    PODOFO_RAISE_ERROR_INFO(ePdfError_NoObject, "Document catalog not found");
+  }
+  set<PdfObject*> seen;
+  CollectPages(Resolve(catalog->GetDictionary().GetKey(PdfName(Name::PAGES))),
+               seen);
+  if (Pages.empty()) {
+    PODOFO_RAISE_ERROR_INFO(ePdfError_PageNotFound,
+                            "A document without pages can not be linearized");
+  }
+
+  // Page closures stop at other pages, the page tree and anything loaded
+  // when the document is opened
+  set<PdfObject*> stops(Pages.begin(), Pages.end());
+  stops.insert(PageTree.begin(), PageTree.end());
+  stops.insert(catalog);
+  set<PdfObject*> assigned{ catalog };
+  DocumentLevel.push_back(catalog);
+  for (const auto& key : { Name::VIEWER_PREFERENCES, Name::OPEN_ACTION }) {
+    const auto value = Resolve(catalog->GetDictionary().GetKey(PdfName(key)));
+    if (!value || stops.count(value)) {
+      continue;
+    }
+    for (auto obj : Closure(value, stops)) {
+      if (assigned.insert(obj).second) {
+        DocumentLevel.push_back(obj);
+      }
+    }
+  }
+  stops.insert(DocumentLevel.begin(), DocumentLevel.end());
+
+  vector<vector<PdfObject*>> closures;
+  map<PdfObject*, size_t> usage;
+  for (auto page : Pages) {
+    closures.emplace_back(Closure(page, stops));
+    for (auto obj : closures.back()) {
+      usage[obj]++;
+    }
+  }
+
+  FirstPage = closures[0];
+  assigned.insert(FirstPage.begin(), FirstPage.end());
+  PageObjects.resize(Pages.size());
+  SharedReferences.resize(Pages.size());
+  for (size_t i = 1; i < Pages.size(); i++) {
+    for (auto obj : closures[i]) {
+      if (usage[obj] == 1 && assigned.insert(obj).second) {
+        PageObjects[i].push_back(obj);
+      }
+    }
+  }
+  for (size_t i = 1; i < Pages.size(); i++) {
+    for (auto obj : closures[i]) {
+      if (usage[obj] > 1 && assigned.insert(obj).second) {
+        Shared.push_back(obj);
+      }
+    }
+  }
+
+  // Shared object hint table entries: the first page section, then the
+  // shared objects section
+  map<PdfObject*, size_t> identifiers;
+  for (size_t i = 0; i < FirstPage.size(); i++) {
+    identifiers[FirstPage[i]] = i;
+  }
+  for (size_t i = 0; i < Shared.size(); i++) {
+    identifiers[Shared[i]] = FirstPage.size() + i;
+  }
+  for (size_t i = 1; i < Pages.size(); i++) {
+    for (auto obj : closures[i]) {
+      if (usage[obj] > 1) {
+        SharedReferences[i].push_back(identifiers[obj]);
+      }
+    }
+  }
+
+  for (auto obj : *Objects) {
+    if (obj->Reference().IsIndirect() && !assigned.count(obj)) {
+      Other.push_back(obj);
+    }
+  }
+}
+
+void
+Linearizer::Remap(PdfVariant& value) const
+{
+  switch (value.GetDataType()) {
+    case ePdfDataType_Reference: {
+      const auto it = Numbers.find(value.GetReference());
+      // A reference to a missing object is a reference to null
+      value = it == Numbers.end() ? PdfVariant::NullValue
+                                  : PdfVariant(PdfReference(it->second, 0));
+      break;
+    }
+    case ePdfDataType_Array:
+      for (auto& item : value.GetArray()) {
+        Remap(item);
+      }
+      break;
+    case ePdfDataType_Dictionary:
+      for (auto& key : value.GetDictionary().GetKeys()) {
+        Remap(*key.second);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+vector<size_t>
+Linearizer::Spill(FILE* file, const vector<PdfObject*>& objs)
+{
+  vector<size_t> lengths;
+  lengths.reserve(objs.size());
+  for (auto obj : objs) {
+    PdfVariant value(*obj);
+    Remap(value);
+    const PdfReference ref(Numbers.at(obj->Reference()), 0);
+    string text;
+    if (obj->HasStream()) {
+      char* buffer = nullptr;
+      pdf_long length = 0;
+      obj->GetStream()->GetCopy(&buffer, &length);
+      const string data(buffer, static_cast<size_t>(length));
+      podofo_free(buffer);
+      text = Writer::SerializeObject(ref, value, &data, Encrypt, Mode);
+    } else {
+      text = Writer::SerializeObject(ref, value, nullptr, Encrypt, Mode);
+    }
+    if (fwrite(text.data(), 1, text.size(), file) != text.size()) {
+      PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidDeviceOperation,
+                              "Failed to write a temporary file");
+    }
+    lengths.push_back(text.size());
+  }
+  return lengths;
+}
+
+string
+Linearizer::CreateHintStream(const vector<size_t>& pageLengths,
+                             const vector<size_t>& sharedLengths,
+                             size_t firstPageOffset,
+                             size_t sharedOffset,
+                             size_t& sharedTable) const
+{
+  BitWriter hints;
+
+  // Page offset hint table, ISO 32000-1 Table F.3
+  vector<size_t> objectCounts(Pages.size());
+  objectCounts[0] = FirstPage.size();
+  for (size_t i = 1; i < Pages.size(); i++) {
+    objectCounts[i] = PageObjects[i].size();
+  }
+  const auto objects =
+    std::minmax_element(objectCounts.begin(), objectCounts.end());
+  const auto lengths =
+    std::minmax_element(pageLengths.begin(), pageLengths.end());
+  size_t mostShared = 0;
+  size_t greatestIdentifier = 0;
+  for (const auto& references : SharedReferences) {
+    mostShared = std::max(mostShared, references.size());
+    for (auto id : references) {
+      greatestIdentifier = std::max(greatestIdentifier, id);
+    }
+  }
+  const auto objectBits = Bits(*objects.second - *objects.first);
+  const auto lengthBits = Bits(*lengths.second - *lengths.first);
+  const auto sharedBits = Bits(mostShared);
+  const auto identifierBits = Bits(greatestIdentifier);
+  hints.Write(*objects.first, 32);
+  hints.Write(firstPageOffset, 32);
+  hints.Write(static_cast<size_t>(objectBits), 16);
+  hints.Write(*lengths.first, 32);
+  hints.Write(static_cast<size_t>(lengthBits), 16);
+  // Content streams are not located separately, they are described as
+  // starting at the page and spanning the page's length
+  hints.Write(0, 32);
+  hints.Write(0, 16);
+  hints.Write(*lengths.first, 32);
+  hints.Write(static_cast<size_t>(lengthBits), 16);
+  hints.Write(static_cast<size_t>(sharedBits), 16);
+  hints.Write(static_cast<size_t>(identifierBits), 16);
+  hints.Write(0, 16);
+  hints.Write(1, 16);
+
+  for (auto count : objectCounts) {
+    hints.Write(count - *objects.first, objectBits);
+  }
+  hints.Flush();
+  for (auto length : pageLengths) {
+    hints.Write(length - *lengths.first, lengthBits);
+  }
+  hints.Flush();
+  for (const auto& references : SharedReferences) {
+    hints.Write(references.size(), sharedBits);
+  }
+  hints.Flush();
+  for (const auto& references : SharedReferences) {
+    for (auto id : references) {
+      hints.Write(id, identifierBits);
+    }
+  }
+  hints.Flush();
+  for (auto length : pageLengths) {
+    hints.Write(length - *lengths.first, lengthBits);
+  }
+  hints.Flush();
+
+  // Shared object hint table, ISO 32000-1 Table F.5, one object per group
+  sharedTable = hints.Data.size();
+  const auto groups =
+    std::minmax_element(sharedLengths.begin(), sharedLengths.end());
+  const auto groupBits = Bits(*groups.second - *groups.first);
+  hints.Write(Shared.empty() ? 0 : Numbers.at(Shared[0]->Reference()), 32);
+  hints.Write(Shared.empty() ? 0 : sharedOffset, 32);
+  hints.Write(FirstPage.size(), 32);
+  hints.Write(sharedLengths.size(), 32);
+  hints.Write(0, 16);
+  hints.Write(*groups.first, 32);
+  hints.Write(static_cast<size_t>(groupBits), 16);
+  for (auto length : sharedLengths) {
+    hints.Write(length - *groups.first, groupBits);
+  }
+  hints.Flush();
+  // No group carries an MD5 signature
+  for (size_t i = 0; i < sharedLengths.size(); i++) {
+    hints.Write(0, 1);
+  }
+  hints.Flush();
+  return hints.Data;
+}
+
+void
+Linearizer::Write(PdfOutputDevice* device,
+                  EPdfVersion version,
+                  const PdfString& original,
+                  const PdfString& identifier)
+{
+  Partition();
+
+  // Objects after the first page are numbered 1 - m and listed by the main
+  // xref table, the first page section is numbered m+1 - n
+  pdf_objnum next = 1;
+  auto number = [&](const vector<PdfObject*>& objs) {
+    for (auto obj : objs) {
+      Numbers[obj->Reference()] = next++;
+    }
+  };
+  for (size_t i = 1; i < PageObjects.size(); i++) {
+    number(PageObjects[i]);
+  }
+  number(Shared);
+  number(Other);
+  const auto mainSize = next;
+  const auto linNumber = next++;
+  number(DocumentLevel);
+  const auto encryptNumber = Encrypt ? next++ : 0;
+  number(FirstPage);
+  const auto hintNumber = next++;
+  const auto size = next;
+
+  if (Encrypt) {
+    Encrypt->GenerateEncryptionKey(original);
+  }
+  // Every offset depends on the length of the objects before it, the
+  // serialized objects are spilled to a temporary file in write order and
+  // copied to the device once the offsets are known
+  std::unique_ptr<FILE, int (*)(FILE*)> spill(std::tmpfile(), &fclose);
+  if (!spill) {
+    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidDeviceOperation,
+                            "Failed to create a temporary file");
+  }
+  const auto documentLevel = Spill(spill.get(), DocumentLevel);
+  string encryptDict;
+  if (Encrypt) {
+    PdfVariant dict{ PdfDictionary() };
+    Encrypt->CreateEncryptionDictionary(dict.GetDictionary());
+    // The encryption dictionary itself is never encrypted
+    encryptDict = Writer::SerializeObject(
+      PdfReference(encryptNumber, 0), dict, nullptr, nullptr, Mode);
+  }
+  const auto firstPage = Spill(spill.get(), FirstPage);
+  vector<vector<size_t>> pages(Pages.size());
+  for (size_t i = 1; i < Pages.size(); i++) {
+    pages[i] = Spill(spill.get(), PageObjects[i]);
+  }
+  const auto shared = Spill(spill.get(), Shared);
+  const auto other = Spill(spill.get(), Other);
+
+  auto linearization = [&](size_t fileLength,
+                           size_t hintOffset,
+                           size_t hintLength,
+                           size_t firstPageEnd,
+                           size_t mainXRef) {
+    std::ostringstream out;
+    out << linNumber << " 0 obj\n<< /" << Name::LINEARIZED << " 1 /"
+        << Name::L << " " << Padded(fileLength) << " /" << Name::H << " [ "
+        << Padded(hintOffset) << " " << Padded(hintLength) << " ] /"
+        << Name::O << " " << Padded(Numbers.at(Pages[0]->Reference()))
+        << " /" << Name::E << " " << Padded(firstPageEnd) << " /" << Name::N
+        << " " << Padded(Pages.size()) << " /" << Name::T << " "
+        << Padded(mainXRef) << " >>\nendobj\n";
+    return out.str();
+  };
+  auto firstTrailer = [&](size_t prev) {
+    PdfVariant dict{ PdfDictionary() };
+    dict.GetDictionary().AddKey(PdfName::KeySize,
+                                static_cast<pdf_int64>(size));
+    for (const auto& key : { Name::ROOT, Name::INFO }) {
+      const auto value = Trailer->GetDictionary().GetKey(PdfName(key));
+      if (value) {
+        PdfVariant remapped(*value);
+        Remap(remapped);
+        dict.GetDictionary().AddKey(PdfName(key), remapped);
+      }
+    }
+    if (Encrypt) {
+      dict.GetDictionary().AddKey(PdfName(Name::ENCRYPT),
+                                  PdfReference(encryptNumber, 0));
+    }
+    PdfArray id;
+    id.push_back(original);
+    id.push_back(identifier);
+    dict.GetDictionary().AddKey(PdfName(Name::ID), id);
+    string text;
+    dict.ToString(text, ePdfWriteMode_Compact);
+    text.insert(text.rfind(">>"), "/" + Name::PREV + " " + Padded(prev));
+    return "trailer\n" + text + "\nstartxref\n0\n%%EOF\n";
+  };
+
+  Writer::WriteHeader(device, std::max(version, ePdfVersion_1_2));
+  vector<size_t> offsets(size, 0);
+  size_t pos = static_cast<size_t>(device->Tell());
+  const auto linOffset = pos;
+  offsets[linNumber] = linOffset;
+  pos += linearization(0, 0, 0, 0, 0).size();
+  const auto firstXRefOffset = pos;
+  const auto firstXRefHeader = "xref\n" + std::to_string(linNumber) + " " +
+                               std::to_string(size - linNumber) + "\n";
+  pos += firstXRefHeader.size() + 20 * (size - linNumber) +
+         firstTrailer(0).size();
+  for (size_t i = 0; i < DocumentLevel.size(); i++) {
+    offsets[Numbers.at(DocumentLevel[i]->Reference())] = pos;
+    pos += documentLevel[i];
+  }
+  if (Encrypt) {
+    offsets[encryptNumber] = pos;
+    pos += encryptDict.size();
+  }
+  const auto hintOffset = pos;
+
+  // Hint table offsets are given as if the hint stream was not in the file
+  vector<size_t> pageLengths(Pages.size());
+  pageLengths[0] = Total(firstPage);
+  for (size_t i = 1; i < Pages.size(); i++) {
+    pageLengths[i] = Total(pages[i]);
+  }
+  vector<size_t> sharedLengths;
+  sharedLengths.insert(sharedLengths.end(), firstPage.begin(), firstPage.end());
+  sharedLengths.insert(sharedLengths.end(), shared.begin(), shared.end());
+  size_t sharedOffset = hintOffset;
+  for (auto length : pageLengths) {
+    sharedOffset += length;
+  }
+  size_t sharedTable = 0;
+  const auto hintData = CreateHintStream(
+    pageLengths, sharedLengths, hintOffset, sharedOffset, sharedTable);
+  PdfVariant hintDict{ PdfDictionary() };
+  hintDict.GetDictionary().AddKey(PdfName(Name::S),
+                                  static_cast<pdf_int64>(sharedTable));
+  hintDict.GetDictionary().AddKey(PdfName::KeyFilter,
+                                  PdfName(Name::FLATE_DECODE));
+  const auto deflated =
+    Writer::Deflate(hintData.data(), hintData.size(), CompressionLevel);
+  const auto hint = Writer::SerializeObject(
+    PdfReference(hintNumber, 0), hintDict, &deflated, Encrypt, Mode);
+  offsets[hintNumber] = hintOffset;
+  pos += hint.size();
+
+  auto place = [&](const vector<PdfObject*>& objs,
+                   const vector<size_t>& lengths) {
+    for (size_t i = 0; i < objs.size(); i++) {
+      offsets[Numbers.at(objs[i]->Reference())] = pos;
+      pos += lengths[i];
+    }
+  };
+  place(FirstPage, firstPage);
+  const auto firstPageEnd = pos;
+  for (size_t i = 1; i < Pages.size(); i++) {
+    place(PageObjects[i], pages[i]);
+  }
+  place(Shared, shared);
+  place(Other, other);
+
+  const auto mainXRefOffset = pos;
+  auto mainXRef = "xref\n0 " + std::to_string(mainSize) + "\n";
+  // /T is the offset of the white-space before the first main xref entry
+  const auto firstEntry = mainXRefOffset + mainXRef.size() - 1;
+  mainXRef += "0000000000 65535 f \n";
+  for (pdf_objnum n = 1; n < mainSize; n++) {
+    mainXRef += XRefEntry(offsets[n]);
+  }
+  mainXRef += "trailer\n<< /" + Name::SIZE + " " + std::to_string(mainSize) +
+              " >>\nstartxref\n" + std::to_string(firstXRefOffset) +
+              "\n%%EOF\n";
+  const auto fileLength = mainXRefOffset + mainXRef.size();
+
+  auto write = [device](const string& text) {
+    device->Write(text.data(), static_cast<pdf_long>(text.size()));
+  };
+  write(linearization(
+    fileLength, hintOffset, hint.size(), firstPageEnd, firstEntry));
+  write(firstXRefHeader);
+  for (auto n = linNumber; n < size; n++) {
+    write(XRefEntry(offsets[n]));
+  }
+  write(firstTrailer(mainXRefOffset));
+  rewind(spill.get());
+  Copy(spill.get(), device, Total(documentLevel));
+  write(encryptDict);
+  write(hint);
+  // first page, remaining pages, shared and other objects
+  Copy(spill.get(), device, mainXRefOffset - hintOffset - hint.size());
+  write(mainXRef);
+  device->Flush();
+}
+}
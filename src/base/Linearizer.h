@@ -0,0 +1,99 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_LINEARIZER_H
+#define NPDF_LINEARIZER_H
+
+#include <cstdio>
+#include <map>
+#include <podofo/podofo.h>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace NoPoDoFo {
+
+/**
+ * Linearizer writes a PdfVecObjects as a linearized (fast web view) file,
+ * ISO 32000-1 Annex F. Objects are renumbered and ordered as:
+ *
+ *   header, linearization dictionary, first page xref and trailer,
+ *   catalog and open action objects, primary hint stream,
+ *   every object needed to show the first page,
+ *   the remaining pages each followed by their private objects,
+ *   objects shared by more than one page, everything else,
+ *   main xref and trailer
+ *
+ * The hint stream carries the page offset and shared object hint tables.
+ * The source objects are not modified.
+ */
+class Linearizer
+{
+public:
+  Linearizer(PoDoFo::PdfVecObjects*,
+             const PoDoFo::PdfObject* trailer,
+             PoDoFo::PdfEncrypt*,
+             PoDoFo::EPdfWriteMode,
+             int compressionLevel);
+  explicit Linearizer(const Linearizer&) = delete;
+  const Linearizer& operator=(const Linearizer&) = delete;
+  void Write(PoDoFo::PdfOutputDevice*,
+             PoDoFo::EPdfVersion,
+             const PoDoFo::PdfString& original,
+             const PoDoFo::PdfString& identifier);
+
+private:
+  void Partition();
+  void CollectPages(PoDoFo::PdfObject*, std::set<PoDoFo::PdfObject*>&);
+  std::vector<PoDoFo::PdfObject*> Closure(
+    PoDoFo::PdfObject*,
+    const std::set<PoDoFo::PdfObject*>& stops) const;
+  PoDoFo::PdfObject* Resolve(const PoDoFo::PdfObject*) const;
+  void Remap(PoDoFo::PdfVariant&) const;
+  // Append the serialized objects to file, returns the length of each
+  std::vector<size_t> Spill(FILE*, const std::vector<PoDoFo::PdfObject*>&);
+  std::string CreateHintStream(const std::vector<size_t>& pageLengths,
+                               const std::vector<size_t>& sharedLengths,
+                               size_t firstPageOffset,
+                               size_t sharedOffset,
+                               size_t& sharedTable) const;
+
+  PoDoFo::PdfVecObjects* Objects;
+  const PoDoFo::PdfObject* Trailer;
+  PoDoFo::PdfEncrypt* Encrypt;
+  PoDoFo::EPdfWriteMode Mode;
+  int CompressionLevel;
+
+  std::vector<PoDoFo::PdfObject*> Pages;
+  std::set<PoDoFo::PdfObject*> PageTree;
+  // Catalog and document level objects needed when the file is opened
+  std::vector<PoDoFo::PdfObject*> DocumentLevel;
+  // Every object the first page needs, the first page object leads
+  std::vector<PoDoFo::PdfObject*> FirstPage;
+  // Page object and private objects of pages 1 - n, index 0 is unused
+  std::vector<std::vector<PoDoFo::PdfObject*>> PageObjects;
+  // Objects used by more than one page, excluding the first page section
+  std::vector<PoDoFo::PdfObject*> Shared;
+  std::vector<PoDoFo::PdfObject*> Other;
+  // Shared object hint table identifiers referenced by each page
+  std::vector<std::vector<size_t>> SharedReferences;
+  std::map<PoDoFo::PdfReference, PoDoFo::pdf_objnum> Numbers;
+};
+}
+#endif // NPDF_LINEARIZER_H
@@ -0,0 +1,195 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Materializer.h"
+#include "Ref.h"
+#include <algorithm>
+#include <limits>
+#include <string>
+
+using namespace Napi;
+using namespace PoDoFo;
+
+namespace NoPoDoFo {
+
+MaterializeOptions
+ParseMaterializeOptions(const Napi::Object& opts)
+{
+  MaterializeOptions options;
+  if (opts.Has("resolveRefs") && opts.Get("resolveRefs").IsBoolean()) {
+    options.ResolveRefs = opts.Get("resolveRefs").As<Boolean>();
+  }
+  if (opts.Has("depth") && opts.Get("depth").IsNumber()) {
+    options.Depth = std::max(-1, opts.Get("depth").As<Number>().Int32Value());
+  }
+  if (opts.Has("keyCache") && opts.Get("keyCache").IsBoolean()) {
+    options.KeyCache = opts.Get("keyCache").As<Boolean>();
+  }
+  return options;
+}
+
+Materializer::Materializer(Napi::Env env,
+                           PdfVecObjects* objects,
+                           const MaterializeOptions& options)
+  : Env(env)
+  , Objects(objects)
+  , Options(options)
+{
+  if (Options.Depth < 0) {
+    Options.Depth = std::numeric_limits<int>::max();
+  }
+}
+
+Napi::Value
+Materializer::Convert(const PdfObject& root)
+{
+  if (root.IsReference()) {
+    return FromReference(root.GetReference(), Options.Depth);
+  }
+  // Guard against references back to the root
+  const auto ref = root.Reference();
+  if (ref.ObjectNumber() == 0) {
+    return FromObject(root, Options.Depth);
+  }
+  Path.insert(ref);
+  auto value = FromObject(root, Options.Depth);
+  Path.erase(ref);
+  return value;
+}
+
+Napi::Value
+Materializer::Convert(const PdfDictionary& root)
+{
+  return FromDictionary(root, Options.Depth);
+}
+
+Napi::Value
+Materializer::Convert(const PdfArray& root)
+{
+  return FromArray(root, Options.Depth);
+}
+
+Napi::Value
+Materializer::FromObject(const PdfObject& item, int depth)
+{
+  switch (item.GetDataType()) {
+    case ePdfDataType_Bool:
+      return Boolean::New(Env, item.GetBool());
+    case ePdfDataType_Number:
+      return Number::New(Env, static_cast<double>(item.GetNumber()));
+    case ePdfDataType_Real:
+      return Number::New(Env, item.GetReal());
+    case ePdfDataType_String:
+      return String::New(Env, item.GetString().GetStringUtf8());
+    case ePdfDataType_HexString:
+      return Buffer<char>::Copy(
+        Env, item.GetString().GetString(), item.GetString().GetLength());
+    case ePdfDataType_Name:
+      return Key(item.GetName());
+    case ePdfDataType_Array:
+      return FromArray(item.GetArray(), depth);
+    case ePdfDataType_Dictionary:
+      return FromDictionary(item.GetDictionary(), depth);
+    case ePdfDataType_Null:
+      return Env.Null();
+    case ePdfDataType_Reference:
+      return FromReference(item.GetReference(), depth);
+    case ePdfDataType_RawData: {
+      const auto& raw = item.GetRawData().data();
+      return Buffer<char>::Copy(Env, raw.c_str(), raw.size());
+    }
+    default:
+      throw Error::New(Env, "Unknown Datatype");
+  }
+}
+
+Napi::Object
+Materializer::FromDictionary(const PdfDictionary& dict, int depth)
+{
+  if (Nesting >= MaxNesting) {
+    throw Error::New(Env, "Object nesting is deeper than " +
+                            std::to_string(MaxNesting) + " levels");
+  }
+  ++Nesting;
+  auto target = Napi::Object::New(Env);
+  for (const auto& key : dict.GetKeys()) {
+    target.Set(Key(key.first), FromObject(*key.second, depth));
+  }
+  --Nesting;
+  return target;
+}
+
+Napi::Array
+Materializer::FromArray(const PdfArray& array, int depth)
+{
+  if (Nesting >= MaxNesting) {
+    throw Error::New(Env, "Object nesting is deeper than " +
+                            std::to_string(MaxNesting) + " levels");
+  }
+  ++Nesting;
+  auto target = Napi::Array::New(Env, array.size());
+  uint32_t i = 0;
+  for (const auto& item : array) {
+    target.Set(i++, FromObject(item, depth));
+  }
+  --Nesting;
+  return target;
+}
+
+Napi::Value
+Materializer::FromReference(const PdfReference& ref, int depth)
+{
+  if (!Options.ResolveRefs || !Objects || depth == 0 || Path.count(ref) ||
+      Nesting >= MaxNesting) {
+    return Ref::Constructor.New({ Number::New(Env, ref.ObjectNumber()),
+                                  Number::New(Env, ref.GenerationNumber()) });
+  }
+  const auto done = Done.find(ref);
+  if (done != Done.end() && done->second.Depth >= depth - 1) {
+    return done->second.Value;
+  }
+  const auto target = Objects->GetObject(ref);
+  if (!target) {
+    return Env.Null();
+  }
+  Path.insert(ref);
+  ++Nesting;
+  auto value = FromObject(*target, depth - 1);
+  --Nesting;
+  Path.erase(ref);
+  Done[ref] = { value, depth - 1 };
+  return value;
+}
+
+Napi::Value
+Materializer::Key(const PdfName& name)
+{
+  if (!Options.KeyCache) {
+    return String::New(Env, name.GetName());
+  }
+  const auto& key = name.GetName();
+  const auto cached = Keys.find(key);
+  if (cached != Keys.end()) {
+    return cached->second;
+  }
+  auto value = String::New(Env, key);
+  Keys.emplace(key, value);
+  return value;
+}
+}
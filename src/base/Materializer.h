@@ -0,0 +1,104 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_MATERIALIZER_H
+#define NPDF_MATERIALIZER_H
+
+#include <map>
+#include <napi.h>
+#include <podofo/podofo.h>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace NoPoDoFo {
+
+/**
+ * Options shared by Object.toJS, Dictionary.asObject and Array.asArray
+ */
+struct MaterializeOptions
+{
+  // Replace references with the objects they point to
+  bool ResolveRefs = false;
+  // Number of references followed from the root, -1 follows all of them
+  int Depth = -1;
+  // Create the JS string of each dictionary key once per call
+  bool KeyCache = true;
+};
+
+/**
+ * Read MaterializeOptions from a javascript options object, unknown keys are
+ * ignored.
+ */
+MaterializeOptions
+ParseMaterializeOptions(const Napi::Object&);
+
+/**
+ * Materializer converts a PDF object graph to plain javascript values in a
+ * single native walk. Dictionaries become objects, arrays become arrays
+ * (allocated at their final length), names and strings become strings, hex
+ * strings and raw data become Buffers and references become Ref instances,
+ * or the referenced object when references are resolved.
+ *
+ * A resolved object is converted once per walk, later references to it
+ * share the same javascript value. A reference to an object that is still
+ * being converted (a cycle, i.e. /Parent) is left as a Ref.
+ *
+ * The walk is recursive, it is bounded by MaxNesting levels of arrays,
+ * dictionaries and followed references: deeper references are left as Refs,
+ * deeper direct objects throw, whatever the depth option is.
+ *
+ * A Materializer holds javascript values and must not outlive the handle
+ * scope it was created in.
+ */
+class Materializer
+{
+public:
+  Materializer(Napi::Env, PoDoFo::PdfVecObjects*, const MaterializeOptions&);
+  Napi::Value Convert(const PoDoFo::PdfObject&);
+  Napi::Value Convert(const PoDoFo::PdfDictionary&);
+  Napi::Value Convert(const PoDoFo::PdfArray&);
+
+private:
+  struct Resolved
+  {
+    Napi::Value Value;
+    // References that were still followed below the object
+    int Depth;
+  };
+
+  Napi::Value FromObject(const PoDoFo::PdfObject&, int depth);
+  Napi::Object FromDictionary(const PoDoFo::PdfDictionary&, int depth);
+  Napi::Array FromArray(const PoDoFo::PdfArray&, int depth);
+  Napi::Value FromReference(const PoDoFo::PdfReference&, int depth);
+  Napi::Value Key(const PoDoFo::PdfName&);
+
+  static const int MaxNesting = 256;
+
+  Napi::Env Env;
+  PoDoFo::PdfVecObjects* Objects;
+  MaterializeOptions Options;
+  std::unordered_map<std::string, Napi::Value> Keys;
+  std::map<PoDoFo::PdfReference, Resolved> Done;
+  std::set<PoDoFo::PdfReference> Path;
+  // Arrays, dictionaries and references being converted
+  int Nesting = 0;
+};
+}
+#endif // NPDF_MATERIALIZER_H
@@ -81,6 +81,7 @@ const std::string CFM = "CFM";
 const std::string CH = "Ch";
 const std::string CHAR_PROCS = "CharProcs";
 const std::string CHAR_SET = "CharSet";
+const std::string CHECK_SUM = "CheckSum";
 const std::string CICI_SIGNIT = "CICI.SignIt";
 const std::string CID_FONT_TYPE0 = "CIDFontType0";
 const std::string CID_FONT_TYPE2 = "CIDFontType2";
@@ -272,6 +273,7 @@ const std::string LENGTH1 = "Length1";
 const std::string LENGTH2 = "Length2";
 const std::string LIGHTEN = "Lighten";
 const std::string LIMITS = "Limits";
+const std::string LINEARIZED = "Linearized";
 const std::string LJ = "LJ";
 const std::string LL = "LL";
 const std::string LLE = "LLE";
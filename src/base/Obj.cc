@@ -18,11 +18,12 @@
  */
 
 #include "Obj.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "Array.h"
 #include "Dictionary.h"
+#include "Materializer.h"
 #include "Ref.h"
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -113,7 +114,8 @@ Obj::Initialize(Napi::Env& env, Napi::Object& target)
       InstanceMethod("getArray", &Obj::GetArray),
       InstanceMethod("getRawData", &Obj::GetRawData),
       InstanceMethod("clear", &Obj::Clear),
-      InstanceMethod("resolveIndirectKey", &Obj::MustGetIndirect) });
+      InstanceMethod("resolveIndirectKey", &Obj::MustGetIndirect),
+      InstanceMethod("toJS", &Obj::ToJS) });
   Constructor = Persistent(ctor);
   Constructor.SuppressDestruct();
   target.Set("Object", ctor);
@@ -121,18 +123,21 @@ Obj::Initialize(Napi::Env& env, Napi::Object& target)
 
 Obj::Obj(const Napi::CallbackInfo& info)
   : ObjectWrap<Obj>(info)
-  , NObj(info.Length() == 1 && info[0].IsExternal()
+  , NObj(info.Length() >= 1 && info[0].IsExternal()
           ? *info[0].As<External<PdfObject>>().Data()
           : *(Init = InitObject(info)))
 {
-  DbgLog = spdlog::get("DbgLog");
-  if(Init != nullptr) {
-    if(DbgLog != nullptr) DbgLog->debug("New Object Created");
+  if (info.Length() == 2 && info[0].IsExternal() && info[1].IsBoolean() &&
+      info[1].As<Boolean>()) {
+    // an object owned by this instance, e.g. a copy of a direct value
+    Init = &NObj;
+  } else if(Init != nullptr) {
+    NPDF_LOG_DEBUG("New Object Created");
   }
 }
 Obj::~Obj()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Object Cleanup");
+  NPDF_LOG_DEBUG("Object Cleanup");
   HandleScope scope(Env());
   delete Init;
 }
@@ -154,10 +159,8 @@ Obj::GetStream(const CallbackInfo& info)
       output << "/tmp/" << NObj.Reference().GenerationNumber() << "."
              << NObj.Reference().ObjectNumber() << ".txt" << endl;
       const auto outfile = output.str().c_str();
-      stringstream msg;
-      msg << "This Object does not have a stream associated with it" << endl;
       cout << "Writing Object to: " << outfile << endl;
-      if(DbgLog != nullptr) DbgLog->debug(msg.str());
+      NPDF_LOG_DEBUG("This Object does not have a stream associated with it");
       PdfOutputDevice outDevice(outfile);
       NObj.WriteObject(&outDevice, ePdfWriteMode_Clean, nullptr);
       return info.Env().Undefined();
@@ -450,102 +453,19 @@ Obj::MustGetIndirect(const CallbackInfo& info)
   const auto target = NObj.MustGetIndirectKey(name);
   return Constructor.New({ External<PdfObject>::New(info.Env(), target) });
 }
-void Obj::TrickleDown(Napi::Env env, const PoDoFo::PdfName *name, PoDoFo::PdfObject &item, Napi::Value &target)
+JsValue
+Obj::ToJS(const CallbackInfo& info)
 {
-	switch (item.GetDataType()) {
-		case ePdfDataType_Bool:
-			target.IsArray() ?
-			target.As<Napi::Array>().Set(target.As<Napi::Array>().Length(), Boolean::New(env, item.GetBool()))
-											 :
-			target.As<Object>().Set(String::New(env, name->GetName()), Boolean::New(env, item.GetBool()));
-			break;
-		case ePdfDataType_Number:
-			target.IsArray() ?
-			target.As<Napi::Array>().Set(target.As<Napi::Array>().Length(), Number::New(env, item.GetNumber()))
-											 :
-			target.As<Object>().Set(String::New(env, name->GetName()), Number::New(env, item.GetNumber()));
-			break;
-		case ePdfDataType_Real:
-			target.IsArray() ?
-			target.As<Napi::Array>().Set(target.As<Napi::Array>().Length(), Number::New(env, item.GetReal()))
-											 :
-			target.As<Object>().Set(String::New(env, name->GetName()), Number::New(env, item.GetReal()));
-			break;
-		case ePdfDataType_String:
-			target.IsArray() ?
-			target.As<Napi::Array>()
-						.Set(target.As<Napi::Array>().Length(), String::New(env, item.GetString().GetStringUtf8()))
-											 :
-			target.As<Object>().Set(String::New(env, name->GetName()), String::New(env, item.GetString().GetStringUtf8()));
-			break;
-		case ePdfDataType_HexString:
-			target.IsArray() ?
-			target.As<Napi::Array>().Set(target.As<Napi::Array>().Length(), Buffer<char>::Copy(env,
-																																														 item.GetString()
-																																																 .GetString(),
-																																														 item.GetString()
-																																																 .GetLength()))
-											 :
-			target.As<Object>().Set(String::New(env, name->GetName()), Buffer<char>::Copy(env,
-																																										item.GetString().GetString(),
-																																										item.GetString().GetLength()));
-			break;
-		case ePdfDataType_Name:
-			target.IsArray() ?
-			target.As<Napi::Array>().Set(target.As<Napi::Array>().Length(), String::New(env, item.GetName().GetName()))
-											 :
-			target.As<Object>().Set(String::New(env, name->GetName()), String::New(env, item.GetName().GetName()));
-			break;
-		case ePdfDataType_Array: {
-			Napi::Array nested = Napi::Array::New(env);
-			auto it = item.GetArray().begin();
-			while (it != item.GetArray().end()) {
-				TrickleDown(env, nullptr, (*it), nested);
-				it++;
-			}
-			target.IsArray() ?
-			target.As<Napi::Array>().Set(target.As<Napi::Array>().Length(), nested) :
-			target.As<Object>().Set(String::New(env, name->GetName()), nested);
-			break;
-		}
-		case ePdfDataType_Dictionary: {
-			Napi::Object nested = Napi::Object::New(env);
-			auto it = item.GetDictionary().GetKeys().begin();
-			Napi::Object obj = Napi::Object::New(env);
-			while (it != item.GetDictionary().GetKeys().end()) {
-				TrickleDown(env, &(it->first), *it->second, nested);
-				it++;
-			}
-			target.IsArray() ?
-			target.As<Napi::Array>().Set(target.As<Napi::Array>().Length(), nested) :
-			target.As<Object>().Set(String::New(env, name->GetName()), nested);
-			break;
-		}
-		case ePdfDataType_Null:
-			target.IsArray() ?
-			target.As<Napi::Array>().Set(target.As<Napi::Array>().Length(), env.Null())
-											 :
-			target.As<Object>().Set(String::New(env, name->GetName()), env.Null());
-			break;
-		case ePdfDataType_Reference: {
-			auto ref = Ref::Constructor.New({
-																				Number::New(env, item.GetReference().ObjectNumber()),
-																				Number::New(env, item.GetReference().GenerationNumber())});
-			target.IsArray() ?
-			target.As<Napi::Array>().Set(target.As<Napi::Array>().Length(), ref)
-											 :
-			target.As<Object>().Set(String::New(env, name->GetName()), ref);
-			break;
-		}
-		case ePdfDataType_RawData: {
-			auto raw = Napi::Buffer<char>::Copy(env, item.GetRawData().data().c_str(), item.GetRawData().data().size());
-			target.IsArray() ?
-			target.As<Napi::Array>().Set(target.As<Napi::Array>().Length(), raw)
-											 :
-			target.As<Object>().Set(String::New(env, name->GetName()), raw);
-			break;
-		}
-		case ePdfDataType_Unknown: Error::New(env, "Unknown Datatype").ThrowAsJavaScriptException();
-	}
+  MaterializeOptions options;
+  if (info.Length() > 0 && info[0].IsObject()) {
+    options = ParseMaterializeOptions(info[0].As<Object>());
+  }
+  try {
+    Materializer materializer(info.Env(), GetObject().GetOwner(), options);
+    return materializer.Convert(GetObject());
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
 }
 }
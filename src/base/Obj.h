@@ -23,7 +23,6 @@
 #include <napi.h>
 #include <podofo/podofo.h>
 #include <iostream>
-#include <spdlog/logger.h>
 
 using std::cout;
 using std::endl;
@@ -39,7 +38,6 @@ public:
   ~Obj();
   static Napi::FunctionReference Constructor;
   static void Initialize(Napi::Env& env, Napi::Object& target);
-	static void TrickleDown(Napi::Env, const PoDoFo::PdfName *, PoDoFo::PdfObject &, Napi::Value &);
   JsValue GetStream(const Napi::CallbackInfo&);
   JsValue HasStream(const Napi::CallbackInfo&);
   JsValue GetObjectLength(const Napi::CallbackInfo&);
@@ -61,6 +59,7 @@ public:
   void SetImmutable(const Napi::CallbackInfo&, const JsValue&);
   void Clear(const Napi::CallbackInfo&);
   JsValue MustGetIndirect(const Napi::CallbackInfo&);
+  JsValue ToJS(const Napi::CallbackInfo&);
 
   PoDoFo::PdfObject& GetObject() const
   {
@@ -70,7 +69,6 @@ public:
 private:
   PoDoFo::PdfObject& NObj;
   PoDoFo::PdfObject* Init = nullptr;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
@@ -0,0 +1,150 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace NoPoDoFo {
+
+namespace {
+
+/**
+ * Worker threads shared by every ParallelFor call. The pool is started on
+ * first use, sized to the hardware concurrency and never torn down; its
+ * threads are detached so process exit does not wait on them.
+ */
+class WorkerPool
+{
+public:
+  static WorkerPool& Get()
+  {
+    static auto* pool = new WorkerPool(); // intentionally leaked
+    return *pool;
+  }
+  size_t Size() const { return Size_; }
+  void Post(std::function<void()> task)
+  {
+    {
+      std::lock_guard<std::mutex> guard(Lock);
+      Tasks.push_back(std::move(task));
+    }
+    Ready.notify_one();
+  }
+
+private:
+  WorkerPool()
+    : Size_(std::max(1u, std::thread::hardware_concurrency()))
+  {
+    for (size_t t = 0; t < Size_; t++) {
+      std::thread([this]() { Run(); }).detach();
+    }
+  }
+  void Run()
+  {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> guard(Lock);
+        Ready.wait(guard, [this]() { return !Tasks.empty(); });
+        task = std::move(Tasks.front());
+        Tasks.pop_front();
+      }
+      task();
+    }
+  }
+  const size_t Size_;
+  std::mutex Lock;
+  std::condition_variable Ready;
+  std::deque<std::function<void()>> Tasks;
+};
+
+/**
+ * State of one ParallelFor call. Helpers posted to the pool keep it alive
+ * through a shared_ptr, a helper that starts after every index was claimed
+ * returns without touching fn, so the caller only waits for indexes to
+ * complete, never for queued helpers to run.
+ */
+struct Job
+{
+  Job(size_t count, const std::function<void(size_t)>& fn)
+    : Count(count)
+    , Fn(fn)
+  {}
+  const size_t Count;
+  const std::function<void(size_t)>& Fn;
+  std::atomic<size_t> Next{ 0 };
+  size_t Done = 0;
+  std::exception_ptr Error;
+  std::mutex Lock;
+  std::condition_variable Finished;
+
+  void Run()
+  {
+    size_t i;
+    while ((i = Next.fetch_add(1)) < Count) {
+      std::exception_ptr error;
+      try {
+        Fn(i);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      std::lock_guard<std::mutex> guard(Lock);
+      if (error && !Error) {
+        Error = error;
+      }
+      if (++Done == Count) {
+        Finished.notify_all();
+      }
+    }
+  }
+};
+}
+
+void
+ParallelFor(size_t count,
+            unsigned int threads,
+            const std::function<void(size_t)>& fn)
+{
+  if (count == 0) {
+    return;
+  }
+  auto& pool = WorkerPool::Get();
+  if (threads == 0) {
+    threads = static_cast<unsigned int>(pool.Size());
+  }
+  const auto workers = std::min(static_cast<size_t>(threads), count);
+  auto job = std::make_shared<Job>(count, fn);
+  for (size_t t = 1; t < workers; t++) {
+    pool.Post([job]() { job->Run(); });
+  }
+  job->Run();
+  std::unique_lock<std::mutex> guard(job->Lock);
+  job->Finished.wait(guard, [&job]() { return job->Done == job->Count; });
+  if (job->Error) {
+    std::rethrow_exception(job->Error);
+  }
+}
+}
@@ -0,0 +1,45 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_PARALLEL_H
+#define NPDF_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+namespace NoPoDoFo {
+
+/**
+ * Run fn(i) for every i in [0, count) across up to threads worker threads,
+ * the calling thread participates and returns once every index is done.
+ * Indexes are claimed in order so results written by index are deterministic
+ * regardless of scheduling. threads == 0 uses the hardware concurrency.
+ * Helpers come from a process-wide pool started on first use, so calls do
+ * not create threads; a busy pool only means the caller does more of the
+ * work itself.
+ *
+ * fn must not touch V8 and must only touch PoDoFo objects that are not
+ * shared between indexes.
+ */
+void
+ParallelFor(size_t count,
+            unsigned int threads,
+            const std::function<void(size_t)>& fn);
+}
+#endif // NPDF_PARALLEL_H
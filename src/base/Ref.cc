@@ -18,13 +18,12 @@
  */
 
 #include "Ref.h"
+#include "../Logger.h"
 #include <iosfwd>
 #include <iostream>
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using std::cout;
-using std::endl;
 
 namespace NoPoDoFo {
 
@@ -33,13 +32,12 @@ FunctionReference Ref::Constructor; // NOLINT
 Ref::Ref(const CallbackInfo& info)
   : ObjectWrap(info)
 {
-  DbgLog = spdlog::get("DbgLog");
   if (info.Length() == 2 && info[0].IsNumber() && info[1].IsNumber()) {
     Self = new PdfReference(info[0].As<Number>(),
                             static_cast<const PoDoFo::pdf_gennum>(
                               info[1].As<Number>().Uint32Value()));
   } else if (info.Length() == 1 && info[0].IsExternal()) {
-    if(DbgLog != nullptr) DbgLog->debug("Creating a new PdfReference Copy");
+    NPDF_LOG_DEBUG("Creating a new PdfReference Copy");
     Self = new PdfReference(*info[0].As<External<PdfReference>>().Data());
   } else {
     Error::New(info.Env(),
@@ -49,10 +47,9 @@ Ref::Ref(const CallbackInfo& info)
 }
 Ref::~Ref()
 {
-  std::stringstream dbgMsg;
-  dbgMsg << "Cleaning up Ref " << Self->ObjectNumber() << " : "
-       << Self->GenerationNumber() << endl;
-  if(DbgLog != nullptr) DbgLog->debug(dbgMsg.str());
+  NPDF_LOG_DEBUG("Cleaning up Ref {} : {}",
+                 Self->ObjectNumber(),
+                 Self->GenerationNumber());
   delete Self;
 }
 void
@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using namespace Napi;
 
@@ -44,7 +43,6 @@ public:
 
   PdfReference* Self;
 private:
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 
 }
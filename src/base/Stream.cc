@@ -18,16 +18,15 @@
  */
 
 #include "Stream.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "../ValidateArguments.h"
 #include "Obj.h"
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
 
 using std::string;
-using tl::nullopt;
 
 namespace NoPoDoFo {
 
@@ -39,11 +38,10 @@ Stream::Stream(const CallbackInfo& info)
              ? *info[0].As<External<PdfStream>>().Data()
              : *Obj::Unwrap(info[0].As<Object>())->GetObject().GetStream())
 {
-  DbgLog = spdlog::get("DbgLog");
 }
 Stream::~Stream()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Stream Cleanup");
+  NPDF_LOG_DEBUG("Stream Cleanup");
 }
 void
 Stream::Initialize(Napi::Env& env, Napi::Object& target)
@@ -112,10 +110,8 @@ Stream::Write(const CallbackInfo& info)
 {
   string output;
   Function cb;
-  const auto opts =
-    AssertCallbackInfo(info,
-                       { { 0, { option(napi_function), option(napi_string) } },
-                         { 1, { nullopt, option(napi_function) } } });
+  const auto opts = AssertArguments<ArgTypes<napi_function, napi_string>,
+                                    ArgTypes<ArgOmitted, napi_function>>(info);
   if (opts[0] == 0) {
     cb = info[0].As<Function>();
   }
@@ -133,11 +129,10 @@ Stream::Write(const CallbackInfo& info)
 void
 Stream::BeginAppend(const Napi::CallbackInfo& info)
 {
-  const auto opt = AssertCallbackInfo(
-    info,
-    { { 0, { nullopt, option(napi_boolean), option(napi_external) } },
-      { 1, { nullopt, option(napi_boolean) } },
-      { 2, { nullopt, option(napi_boolean) } } });
+  const auto opt =
+    AssertArguments<ArgTypes<ArgOmitted, napi_boolean, napi_external>,
+                    ArgTypes<ArgOmitted, napi_boolean>,
+                    ArgTypes<ArgOmitted, napi_boolean>>(info);
   auto clearExisting = true;
   auto deleteFilter = true;
   std::vector<EPdfFilter>* filters = nullptr;
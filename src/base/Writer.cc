@@ -0,0 +1,616 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Writer.h"
+#include "Linearizer.h"
+#include "Names.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <ctime>
+#include <memory>
+#include <openssl/evp.h>
+#include <sstream>
+#include <zlib.h>
+
+using namespace Napi;
+using namespace PoDoFo;
+
+using std::function;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+namespace NoPoDoFo {
+
+// Maximum number of objects packed into a single /ObjStm
+const size_t OBJECT_STREAM_SIZE = 100;
+
+WriteOptions
+ParseWriteOptions(const Napi::Object& opts)
+{
+  WriteOptions options;
+  if (opts.Has("objectStreams") && opts.Get("objectStreams").IsBoolean()) {
+    options.ObjectStreams = opts.Get("objectStreams").As<Boolean>();
+  }
+  if (opts.Has("compress") && opts.Get("compress").IsBoolean()) {
+    options.Compress = opts.Get("compress").As<Boolean>();
+  }
+  if (opts.Has("compressionLevel") && opts.Get("compressionLevel").IsNumber()) {
+    options.CompressionLevel = std::min(
+      9, std::max(-1, opts.Get("compressionLevel").As<Number>().Int32Value()));
+  }
+  if (opts.Has("threads") && opts.Get("threads").IsNumber()) {
+    options.Threads = opts.Get("threads").As<Number>().Uint32Value();
+  }
+  if (opts.Has("linearize") && opts.Get("linearize").IsBoolean()) {
+    options.Linearize = opts.Get("linearize").As<Boolean>();
+  }
+  return options;
+}
+
+Writer::Writer(PdfVecObjects* objects, const PdfObject* trailer)
+  : Objects(objects)
+  , Trailer(trailer)
+{}
+
+Writer::~Writer()
+{
+  delete Encrypt;
+}
+
+void
+Writer::SetPdfVersion(EPdfVersion version)
+{
+  Version = version;
+}
+
+void
+Writer::SetWriteMode(EPdfWriteMode mode)
+{
+  Mode = mode;
+}
+
+void
+Writer::SetEncrypted(const PdfEncrypt& encrypt)
+{
+  delete Encrypt;
+  Encrypt = PdfEncrypt::CreatePdfEncrypt(encrypt);
+}
+
+void
+Writer::SetReleaseWritten(bool release)
+{
+  ReleaseWritten = release;
+}
+
+void
+Writer::SetOptions(const WriteOptions& options)
+{
+  Options = options;
+}
+
+void
+Writer::WriteDocument(PdfMemDocument& doc,
+                      PdfOutputDevice* device,
+                      const WriteOptions& options)
+{
+  if (!options.ObjectStreams && !options.Compress && !options.Linearize) {
+    doc.Write(device);
+    return;
+  }
+  // Subset fonts add their font file streams when embedded
+  doc.EmbedSubsetFonts();
+  if (options.Compress) {
+    CompressStreams(&doc.GetObjects(), options);
+  }
+  if (!options.ObjectStreams && !options.Linearize) {
+    doc.Write(device);
+    return;
+  }
+  Writer writer(&doc.GetObjects(), doc.GetTrailer());
+  writer.SetPdfVersion(doc.GetPdfVersion());
+  writer.SetWriteMode(doc.GetWriteMode());
+  if (doc.GetEncrypt()) {
+    writer.SetEncrypted(*doc.GetEncrypt());
+  }
+  writer.SetOptions(options);
+  writer.Write(device);
+}
+
+void
+Writer::Rewrite(const PdfRefCountedInputDevice& input,
+                PdfOutputDevice* output,
+                const WriteOptions& options,
+                const string& pwd,
+                const PdfEncrypt* encrypt,
+                const function<void(PdfVecObjects&, PdfObject&)>& prepare)
+{
+  PdfVecObjects objects;
+  objects.SetAutoDelete(true);
+  PdfParser parser(&objects);
+  // Objects are parsed, and decrypted, when first used
+  try {
+    parser.ParseFile(input, true);
+  } catch (PdfError& err) {
+    if (err.GetError() != ePdfError_InvalidPassword || pwd.empty()) {
+      throw;
+    }
+    parser.SetPassword(pwd);
+  }
+  PdfObject trailer(*parser.GetTrailer());
+  trailer.GetDictionary().RemoveKey(PdfName(Name::ENCRYPT));
+  if (prepare) {
+    prepare(objects, trailer);
+  }
+  if (options.Compress) {
+    CompressStreams(&objects, options);
+  }
+  Writer writer(&objects, &trailer);
+  writer.SetPdfVersion(parser.GetPdfVersion());
+  if (encrypt) {
+    writer.SetEncrypted(*encrypt);
+  } else if (parser.GetEncrypted()) {
+    writer.SetEncrypted(*parser.GetEncrypt());
+  }
+  writer.SetOptions(options);
+  // The parsed objects are scratch, drop each one once it has been written
+  writer.SetReleaseWritten(true);
+  writer.Write(output);
+}
+
+void
+Writer::Write(PdfOutputDevice* device)
+{
+  if (Options.Linearize) {
+    PdfString original;
+    PdfString identifier;
+    FileIdentifiers(original, identifier);
+    Linearizer linearizer(
+      Objects, Trailer, Encrypt, Mode, Options.CompressionLevel);
+    linearizer.Write(device, Version, original, identifier);
+    return;
+  }
+  if (!Options.ObjectStreams) {
+    PdfWriter writer(Objects, Trailer);
+    writer.SetPdfVersion(Version);
+    writer.SetWriteMode(Mode);
+    if (Encrypt) {
+      writer.SetEncrypted(*Encrypt);
+    }
+    writer.Write(device);
+    return;
+  }
+  WriteObjectStreams(device);
+}
+
+void
+Writer::WriteObjectStreams(PdfOutputDevice* device)
+{
+  PdfString original;
+  PdfString identifier;
+  FileIdentifiers(original, identifier);
+
+  pdf_objnum next = 0;
+  for (auto obj : *Objects) {
+    next = std::max(next, obj->Reference().ObjectNumber());
+  }
+  ++next;
+
+  std::unique_ptr<PdfObject> encryptObj;
+  if (Encrypt) {
+    Encrypt->GenerateEncryptionKey(original);
+    encryptObj.reset(new PdfObject(PdfReference(next++, 0), PdfDictionary()));
+    Encrypt->CreateEncryptionDictionary(encryptObj->GetDictionary());
+  }
+  vector<XRefEntry> entries(next);
+  entries[0].Field3 = 65535;
+
+  WriteHeader(device, std::max(Version, ePdfVersion_1_5));
+
+  if (encryptObj) {
+    auto& entry = entries[encryptObj->Reference().ObjectNumber()];
+    entry.Type = 1;
+    entry.Field2 = static_cast<pdf_uint64>(device->Tell());
+    // The encryption dictionary itself is never encrypted
+    encryptObj->WriteObject(device, Mode, nullptr);
+  }
+
+  // Objects are written in a single pass, an /ObjStm is flushed as soon as
+  // it is full so at most OBJECT_STREAM_SIZE objects are pending at a time
+  vector<PdfObject*> batch;
+  batch.reserve(OBJECT_STREAM_SIZE);
+  for (auto obj : *Objects) {
+    if (!obj->Reference().IsIndirect()) {
+      continue;
+    }
+    if (obj->Reference().GenerationNumber() == 0 && !obj->HasStream()) {
+      batch.emplace_back(obj);
+      if (batch.size() == OBJECT_STREAM_SIZE) {
+        WriteObjectStream(device, batch, entries, next++);
+        batch.clear();
+      }
+      continue;
+    }
+    auto& entry = entries[obj->Reference().ObjectNumber()];
+    entry.Type = 1;
+    entry.Field2 = static_cast<pdf_uint64>(device->Tell());
+    entry.Field3 = obj->Reference().GenerationNumber();
+    obj->WriteObject(device, Mode, Encrypt);
+    if (ReleaseWritten) {
+      Release(obj);
+    }
+  }
+  if (!batch.empty()) {
+    WriteObjectStream(device, batch, entries, next++);
+  }
+
+  const auto xrefNumber = next;
+  entries.resize(xrefNumber + 1);
+  WriteXRefStream(device,
+                  PdfReference(xrefNumber, 0),
+                  entries,
+                  original,
+                  identifier,
+                  encryptObj.get());
+  device->Flush();
+}
+
+void
+Writer::WriteObjectStream(PdfOutputDevice* device,
+                          const vector<PdfObject*>& batch,
+                          vector<XRefEntry>& entries,
+                          pdf_objnum streamNumber)
+{
+  if (entries.size() <= streamNumber) {
+    entries.resize(streamNumber + 1);
+  }
+  PdfRefCountedBuffer body;
+  PdfOutputDevice bodyDevice(&body);
+  stringstream offsets;
+  pdf_uint32 index = 0;
+  for (auto obj : batch) {
+    const auto n = obj->Reference().ObjectNumber();
+    offsets << n << " " << bodyDevice.Tell() << " ";
+    // Strings inside an object stream are covered by the encryption of the
+    // object stream and must not be encrypted individually
+    obj->Write(&bodyDevice, Mode, nullptr, PdfName::KeyNull);
+    bodyDevice.Print("\n");
+    entries[n].Type = 2;
+    entries[n].Field2 = streamNumber;
+    entries[n].Field3 = index++;
+  }
+  auto data = offsets.str();
+  const auto first = data.size();
+  data.append(body.GetBuffer(), bodyDevice.GetLength());
+
+  PdfDictionary dict;
+  dict.AddKey(PdfName::KeyType, PdfName(Name::OBJ_STM));
+  dict.AddKey(PdfName(Name::N), static_cast<pdf_int64>(index));
+  dict.AddKey(PdfName(Name::FIRST), static_cast<pdf_int64>(first));
+  dict.AddKey(PdfName::KeyFilter, PdfName(Name::FLATE_DECODE));
+  entries[streamNumber].Type = 1;
+  entries[streamNumber].Field2 = static_cast<pdf_uint64>(device->Tell());
+  WriteStream(device,
+              PdfReference(streamNumber, 0),
+              dict,
+              Deflate(data.data(), data.size(), Options.CompressionLevel),
+              Encrypt);
+  if (ReleaseWritten) {
+    for (auto obj : batch) {
+      Release(obj);
+    }
+  }
+}
+
+void
+Writer::Release(PdfObject* obj)
+{
+  if (obj->HasStream()) {
+    obj->GetStream()->Set("", 0, TVecFilters());
+  }
+  // Numbers are kept, a stream that has not been parsed yet may read its
+  // /Length from an object that has already been written
+  if (obj->IsDictionary() || obj->IsArray() || obj->IsString() ||
+      obj->IsHexString()) {
+    static_cast<PdfVariant&>(*obj) = PdfVariant();
+  }
+}
+
+void
+Writer::WriteHeader(PdfOutputDevice* device, EPdfVersion version)
+{
+  string v;
+  switch (version) {
+    case ePdfVersion_1_0:
+      v = "1.0";
+      break;
+    case ePdfVersion_1_1:
+      v = "1.1";
+      break;
+    case ePdfVersion_1_2:
+      v = "1.2";
+      break;
+    case ePdfVersion_1_3:
+      v = "1.3";
+      break;
+    case ePdfVersion_1_4:
+      v = "1.4";
+      break;
+    case ePdfVersion_1_5:
+      v = "1.5";
+      break;
+    case ePdfVersion_1_6:
+      v = "1.6";
+      break;
+    case ePdfVersion_1_7:
+      v = "1.7";
+      break;
+  }
+  device->Print("%%PDF-%s\n%%%s\n", v.c_str(), "\xe2\xe3\xcf\xd3");
+}
+
+void
+Writer::WriteStream(PdfOutputDevice* device,
+                    const PdfReference& ref,
+                    PdfDictionary& dict,
+                    const string& data,
+                    PdfEncrypt* encrypt)
+{
+  auto out = data;
+  if (encrypt) {
+    encrypt->SetCurrentReference(ref);
+    const auto length =
+      encrypt->CalculateStreamLength(static_cast<pdf_long>(data.size()));
+    out.resize(static_cast<size_t>(length));
+    encrypt->Encrypt(reinterpret_cast<const unsigned char*>(data.data()),
+                     static_cast<pdf_long>(data.size()),
+                     reinterpret_cast<unsigned char*>(&out[0]),
+                     length);
+  }
+  dict.AddKey(PdfName::KeyLength, static_cast<pdf_int64>(out.size()));
+  device->Print("%u %u obj\n",
+                static_cast<unsigned>(ref.ObjectNumber()),
+                static_cast<unsigned>(ref.GenerationNumber()));
+  PdfVariant(dict).Write(device, Mode, nullptr);
+  device->Print("\nstream\n");
+  device->Write(out.data(), static_cast<pdf_long>(out.size()));
+  device->Print("\nendstream\nendobj\n");
+}
+
+string
+Writer::SerializeObject(const PdfReference& ref,
+                        PdfVariant& value,
+                        const string* stream,
+                        PdfEncrypt* encrypt,
+                        EPdfWriteMode mode)
+{
+  string data;
+  if (stream) {
+    data = *stream;
+    if (encrypt) {
+      encrypt->SetCurrentReference(ref);
+      const auto length =
+        encrypt->CalculateStreamLength(static_cast<pdf_long>(data.size()));
+      data.resize(static_cast<size_t>(length));
+      encrypt->Encrypt(reinterpret_cast<const unsigned char*>(stream->data()),
+                       static_cast<pdf_long>(stream->size()),
+                       reinterpret_cast<unsigned char*>(&data[0]),
+                       length);
+    }
+    value.GetDictionary().AddKey(PdfName::KeyLength,
+                                 static_cast<pdf_int64>(data.size()));
+  }
+  PdfRefCountedBuffer buffer;
+  PdfOutputDevice device(&buffer);
+  device.Print("%u %u obj\n",
+               static_cast<unsigned>(ref.ObjectNumber()),
+               static_cast<unsigned>(ref.GenerationNumber()));
+  if (encrypt) {
+    encrypt->SetCurrentReference(ref);
+  }
+  value.Write(&device, mode, encrypt);
+  if (stream) {
+    device.Print("\nstream\n");
+    device.Write(data.data(), static_cast<pdf_long>(data.size()));
+    device.Print("\nendstream");
+  }
+  device.Print("\nendobj\n");
+  return string(buffer.GetBuffer(), static_cast<size_t>(device.GetLength()));
+}
+
+void
+Writer::WriteXRefStream(PdfOutputDevice* device,
+                        const PdfReference& ref,
+                        vector<XRefEntry>& entries,
+                        const PdfString& original,
+                        const PdfString& identifier,
+                        const PdfObject* encryptObj)
+{
+  const auto offset = static_cast<pdf_uint64>(device->Tell());
+  auto& self = entries[ref.ObjectNumber()];
+  self.Type = 1;
+  self.Field2 = offset;
+
+  // Size the second column to the largest offset or object stream number
+  pdf_uint64 largest = 0;
+  for (const auto& entry : entries) {
+    largest = std::max(largest, entry.Field2);
+  }
+  int width = 1;
+  while (width < 8 && (largest >> (8 * width)) != 0) {
+    width++;
+  }
+  string data;
+  data.reserve(entries.size() * static_cast<size_t>(width + 3));
+  for (const auto& entry : entries) {
+    data.push_back(static_cast<char>(entry.Type));
+    for (int b = width - 1; b >= 0; b--) {
+      data.push_back(static_cast<char>((entry.Field2 >> (8 * b)) & 0xff));
+    }
+    data.push_back(static_cast<char>((entry.Field3 >> 8) & 0xff));
+    data.push_back(static_cast<char>(entry.Field3 & 0xff));
+  }
+
+  PdfDictionary dict;
+  dict.AddKey(PdfName::KeyType, PdfName(Name::XREF));
+  dict.AddKey(PdfName::KeySize, static_cast<pdf_int64>(entries.size()));
+  PdfArray w;
+  w.push_back(static_cast<pdf_int64>(1));
+  w.push_back(static_cast<pdf_int64>(width));
+  w.push_back(static_cast<pdf_int64>(2));
+  dict.AddKey(PdfName(Name::W), w);
+  dict.AddKey(PdfName::KeyFilter, PdfName(Name::FLATE_DECODE));
+  for (const auto& key : { Name::ROOT, Name::INFO }) {
+    const auto value = Trailer->GetDictionary().GetKey(PdfName(key));
+    if (value) {
+      dict.AddKey(PdfName(key), *value);
+    }
+  }
+  if (encryptObj) {
+    dict.AddKey(PdfName(Name::ENCRYPT), encryptObj->Reference());
+  }
+  PdfArray id;
+  id.push_back(original);
+  id.push_back(identifier);
+  dict.AddKey(PdfName(Name::ID), id);
+
+  // The cross reference stream is never encrypted
+  WriteStream(device,
+              ref,
+              dict,
+              Deflate(data.data(), data.size(), Options.CompressionLevel),
+              nullptr);
+  device->Print("startxref\n%s\n%%%%EOF\n", std::to_string(offset).c_str());
+}
+
+void
+Writer::FileIdentifiers(PdfString& original, PdfString& identifier) const
+{
+  // The first entry of /ID is kept stable across rewrites, it is also the
+  // value the encryption key is derived from.
+  identifier = CreateFileIdentifier();
+  original = identifier;
+  const auto id = Trailer->GetDictionary().GetKey(PdfName(Name::ID));
+  if (id && id->IsArray() && !id->GetArray().empty() &&
+      (id->GetArray()[0].IsHexString() || id->GetArray()[0].IsString())) {
+    original = id->GetArray()[0].GetString();
+  }
+}
+
+PdfString
+Writer::CreateFileIdentifier() const
+{
+  PdfRefCountedBuffer buffer;
+  PdfOutputDevice device(&buffer);
+  device.Print("%s %u ",
+               std::to_string(std::time(nullptr)).c_str(),
+               static_cast<unsigned>(Objects->GetSize()));
+  const auto info = Trailer->GetDictionary().GetKey(PdfName(Name::INFO));
+  if (info && info->IsReference() && Objects->GetObject(info->GetReference())) {
+    Objects->GetObject(info->GetReference())
+      ->Write(&device, ePdfWriteMode_Compact, nullptr, PdfName::KeyNull);
+  }
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int length = 0;
+  EVP_Digest(buffer.GetBuffer(),
+             static_cast<size_t>(device.GetLength()),
+             digest,
+             &length,
+             EVP_md5(),
+             nullptr);
+  return PdfString(reinterpret_cast<const char*>(digest), length, true);
+}
+
+void
+Writer::CompressStreams(PdfVecObjects* objects, const WriteOptions& options)
+{
+  struct Candidate
+  {
+    PdfObject* Obj;
+    string Data;
+    string Deflated;
+  };
+  vector<Candidate> batch;
+  size_t batchSize = 0;
+
+  auto flush = [&]() {
+    ParallelFor(batch.size(), options.Threads, [&](size_t i) {
+      batch[i].Deflated = Deflate(
+        batch[i].Data.data(), batch[i].Data.size(), options.CompressionLevel);
+    });
+    for (auto& item : batch) {
+      // Keep the original when deflate does not make the stream smaller
+      if (item.Deflated.size() >= item.Data.size()) {
+        continue;
+      }
+      PdfInputDevice input(item.Deflated.data(), item.Deflated.size());
+      item.Obj->GetStream()->SetRawData(
+        &input, static_cast<pdf_long>(item.Deflated.size()));
+      item.Obj->GetDictionary().AddKey(PdfName::KeyFilter,
+                                       PdfName(Name::FLATE_DECODE));
+    }
+    batch.clear();
+    batchSize = 0;
+  };
+
+  for (auto obj : *objects) {
+    if (!obj->HasStream() || !obj->IsDictionary() ||
+        obj->GetDictionary().HasKey(PdfName::KeyFilter)) {
+      continue;
+    }
+    // XMP metadata is left readable for non-PDF aware tools
+    const auto type = obj->GetDictionary().GetKey(PdfName::KeyType);
+    if (type && type->IsName() && type->GetName() == PdfName(Name::METADATA)) {
+      continue;
+    }
+    char* buffer = nullptr;
+    pdf_long length = 0;
+    obj->GetStream()->GetCopy(&buffer, &length);
+    if (length == 0) {
+      podofo_free(buffer);
+      continue;
+    }
+    Candidate item{ obj, string(buffer, static_cast<size_t>(length)), "" };
+    podofo_free(buffer);
+    batchSize += item.Data.size();
+    batch.emplace_back(std::move(item));
+    // Bound the memory held by uncompressed copies
+    if (batchSize > 64 * 1024 * 1024) {
+      flush();
+    }
+  }
+  flush();
+}
+
+string
+Writer::Deflate(const char* data, size_t length, int level)
+{
+  auto size = compressBound(static_cast<uLong>(length));
+  string out(size, '\0');
+  if (compress2(reinterpret_cast<Bytef*>(&out[0]),
+                &size,
+                reinterpret_cast<const Bytef*>(data),
+                static_cast<uLong>(length),
+                level) != Z_OK) {
+    PODOFO_RAISE_ERROR_INFO(ePdfError_Flate, "Failed to deflate stream data");
+  }
+  out.resize(size);
+  return out;
+}
+}
@@ -0,0 +1,163 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_WRITER_H
+#define NPDF_WRITER_H
+
+#include <napi.h>
+#include <podofo/podofo.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace NoPoDoFo {
+
+/**
+ * Options shared by Document.write, Document.gc and the StreamDocument
+ * constructor.
+ */
+struct WriteOptions
+{
+  // Pack non-stream objects into /ObjStm streams and write an /XRef stream
+  bool ObjectStreams = false;
+  // Flate compress every unfiltered stream on a thread pool before writing
+  bool Compress = false;
+  // zlib compression level, -1 (zlib default) or 0 - 9
+  int CompressionLevel = -1;
+  // Worker threads used for compression, 0 uses the hardware concurrency
+  unsigned int Threads = 0;
+  // Write a linearized (fast web view) file, takes precedence over
+  // ObjectStreams
+  bool Linearize = false;
+};
+
+/**
+ * Read WriteOptions from a javascript options object, unknown keys are
+ * ignored.
+ */
+WriteOptions
+ParseWriteOptions(const Napi::Object&);
+
+/**
+ * Writer serializes a PdfVecObjects and trailer to an output device. When
+ * object streams are requested every indirect, non-stream, generation 0
+ * object is packed into a compressed /ObjStm and the cross reference section
+ * is written as a compressed /XRef stream (PDF 1.5+). Each /ObjStm is
+ * written as soon as it is full. Linearized output is
+ * written by the Linearizer. Otherwise writing is delegated to PoDoFo's
+ * PdfWriter.
+ */
+class Writer
+{
+public:
+  Writer(PoDoFo::PdfVecObjects*, const PoDoFo::PdfObject* trailer);
+  explicit Writer(const Writer&) = delete;
+  const Writer& operator=(const Writer&) = delete;
+  ~Writer();
+  void SetPdfVersion(PoDoFo::EPdfVersion);
+  void SetWriteMode(PoDoFo::EPdfWriteMode);
+  void SetEncrypted(const PoDoFo::PdfEncrypt&);
+  void SetOptions(const WriteOptions&);
+  // Drop the value and stream data of each object once it has been written
+  // with object streams, for objects the Writer's caller no longer needs
+  void SetReleaseWritten(bool);
+  void Write(PoDoFo::PdfOutputDevice*);
+
+  /**
+   * Write a PdfMemDocument, PdfMemDocument::Write is used when no option
+   * requires the NoPoDoFo writer.
+   */
+  static void WriteDocument(PoDoFo::PdfMemDocument&,
+                            PoDoFo::PdfOutputDevice*,
+                            const WriteOptions&);
+
+  /**
+   * Parse a complete PDF from the input device and write it back out. If
+   * encrypt is provided it replaces the encryption of the parsed document.
+   * prepare runs on the parsed objects and a copy of the trailer (without
+   * /Encrypt) before anything is compressed or written.
+   */
+  static void Rewrite(
+    const PoDoFo::PdfRefCountedInputDevice&,
+    PoDoFo::PdfOutputDevice*,
+    const WriteOptions&,
+    const std::string& pwd = "",
+    const PoDoFo::PdfEncrypt* encrypt = nullptr,
+    const std::function<void(PoDoFo::PdfVecObjects&, PoDoFo::PdfObject&)>&
+      prepare = nullptr);
+
+  /**
+   * Deflate the data of every stream without a /Filter in parallel. Stream
+   * data is read and replaced on the calling thread, only zlib runs on the
+   * workers, so the written output does not depend on thread scheduling.
+   */
+  static void CompressStreams(PoDoFo::PdfVecObjects*, const WriteOptions&);
+
+  static std::string Deflate(const char*, size_t, int level);
+  static void WriteHeader(PoDoFo::PdfOutputDevice*, PoDoFo::EPdfVersion);
+
+  // Serialize an object to "n g obj ... endobj" text, the stream (if any)
+  // is encrypted with encrypt
+  static std::string SerializeObject(const PoDoFo::PdfReference&,
+                                     PoDoFo::PdfVariant&,
+                                     const std::string* stream,
+                                     PoDoFo::PdfEncrypt*,
+                                     PoDoFo::EPdfWriteMode);
+
+private:
+  struct XRefEntry
+  {
+    unsigned char Type = 0;
+    PoDoFo::pdf_uint64 Field2 = 0;
+    PoDoFo::pdf_uint32 Field3 = 0;
+  };
+
+  void WriteObjectStreams(PoDoFo::PdfOutputDevice*);
+  void WriteObjectStream(PoDoFo::PdfOutputDevice*,
+                         const std::vector<PoDoFo::PdfObject*>&,
+                         std::vector<XRefEntry>&,
+                         PoDoFo::pdf_objnum);
+  static void Release(PoDoFo::PdfObject*);
+  void WriteStream(PoDoFo::PdfOutputDevice*,
+                   const PoDoFo::PdfReference&,
+                   PoDoFo::PdfDictionary&,
+                   const std::string&,
+                   PoDoFo::PdfEncrypt*);
+  void WriteXRefStream(PoDoFo::PdfOutputDevice*,
+                       const PoDoFo::PdfReference&,
+                       std::vector<XRefEntry>&,
+                       const PoDoFo::PdfString& original,
+                       const PoDoFo::PdfString& identifier,
+                       const PoDoFo::PdfObject* encryptObj);
+  // original is the first /ID entry of the source, or identifier when the
+  // source has none
+  void FileIdentifiers(PoDoFo::PdfString& original,
+                       PoDoFo::PdfString& identifier) const;
+  PoDoFo::PdfString CreateFileIdentifier() const;
+
+  PoDoFo::PdfVecObjects* Objects;
+  const PoDoFo::PdfObject* Trailer;
+  PoDoFo::PdfEncrypt* Encrypt = nullptr;
+  PoDoFo::EPdfVersion Version = PoDoFo::ePdfVersion_1_7;
+  PoDoFo::EPdfWriteMode Mode = PoDoFo::ePdfWriteMode_Default;
+  WriteOptions Options;
+  bool ReleaseWritten = false;
+};
+}
+#endif // NPDF_WRITER_H
@@ -18,10 +18,10 @@
  */
 
 #include "XObject.h"
+#include "../Logger.h"
 #include "../doc/Rect.h"
 #include "Obj.h"
 #include "Ref.h"
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -33,10 +33,9 @@ FunctionReference XObject::Constructor; // NOLINT
 XObject::XObject(const CallbackInfo& info)
   : ObjectWrap(info)
 {
-  DbgLog = spdlog::get("DbgLog");
   // create an xobject from an existing object (must be an xobject)
   if (info[0].IsExternal()) {
-    if(DbgLog != nullptr) DbgLog->debug("XObject copy");
+    NPDF_LOG_DEBUG("XObject copy");
     auto copy = info[0].As<External<PdfXObject>>().Data();
     Self = new PdfXObject(*copy);
   }
@@ -45,14 +44,14 @@ XObject::XObject(const CallbackInfo& info)
            info[0].As<Object>().InstanceOf(Rect::constructor.Value()) &&
            info[1].IsExternal()) {
     auto rect = Rect::Unwrap(info[0].As<Object>());
-    if(DbgLog != nullptr) DbgLog->debug("New XObject");
+    NPDF_LOG_DEBUG("New XObject");
     PdfDocument* doc = info[1].As<External<PdfDocument>>().Data();
     Self = new PdfXObject(rect->GetRect(), doc);
   }
 }
 XObject::~XObject()
 {
-  if(DbgLog != nullptr) DbgLog->debug("XObject Cleanup");
+  NPDF_LOG_DEBUG("XObject Cleanup");
   HandleScope scope(Env());
   delete Self;
 }
@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using JsValue = Napi::Value;
 
@@ -45,7 +44,6 @@ public:
 
 private:
   PoDoFo::PdfXObject* Self;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_XOBJECT_H
@@ -18,17 +18,16 @@
  */
 
 #include "Action.h"
+#include "../Logger.h"
 #include "../ValidateArguments.h"
 #include "../base/Dictionary.h"
 #include "../base/Obj.h"
 #include "Document.h"
 #include "StreamDocument.h"
-#include <spdlog/spdlog.h>
 
 using namespace PoDoFo;
 using namespace Napi;
 
-using tl::nullopt;
 
 namespace NoPoDoFo {
 
@@ -38,18 +37,13 @@ Action::Action(const Napi::CallbackInfo& info)
   : ObjectWrap(info)
 {
 
-	DbgLog = spdlog::get("DbgLog");
-  const auto opts =
-    AssertCallbackInfo(info,
-                       { { 0, { option(napi_external), option(napi_object) } },
-                         { 1, { nullopt, option(napi_number) } } });
+  const auto opts = AssertArguments<ArgTypes<napi_external, napi_object>,
+                                    ArgTypes<ArgOmitted, napi_number>>(info);
   // Create Copy Constructor Action
   if (opts[0] == 0 && info.Length() == 1) {
     Self =
       new PdfAction(info[0].As<External<PdfAction>>().Data()->GetObject());
-    if(DbgLog != nullptr) {
-			DbgLog->debug("PdfAction Copied from external object");
-    }
+    NPDF_LOG_DEBUG("PdfAction Copied from external object");
   }
   // Create a new Action
   else if (opts[0] == 1 && opts[1] == 1) {
@@ -66,7 +60,7 @@ Action::Action(const Napi::CallbackInfo& info)
     }
     const auto t = static_cast<EPdfAction>(info[1].As<Number>().Uint32Value());
     Self = new PdfAction(t, doc);
-    if(DbgLog != nullptr) DbgLog->debug("new PdfAction created");
+    NPDF_LOG_DEBUG("new PdfAction created");
   } else {
     TypeError::New(
       info.Env(),
@@ -76,7 +70,7 @@ Action::Action(const Napi::CallbackInfo& info)
 }
 Action::~Action()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Action Cleanup");
+  NPDF_LOG_DEBUG("Action Cleanup");
   delete Self;
 }
 void
@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using JsValue = Napi::Value;
 
@@ -48,7 +47,6 @@ public:
 
 private:
   PoDoFo::PdfAction* Self;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_ACTION_H
@@ -18,6 +18,7 @@
  */
 
 #include "Annotation.h"
+#include "../Logger.h"
 #include "../Defines.h"
 #include "../ErrorHandler.h"
 #include "../ValidateArguments.h"
@@ -29,7 +30,6 @@
 #include "Page.h"
 #include "Rect.h"
 #include <algorithm>
-#include <spdlog/spdlog.h>
 
 using std::cout;
 using std::endl;
@@ -44,15 +44,12 @@ Annotation::Annotation(const CallbackInfo& info)
   : ObjectWrap(info)
   , Self(*info[0].As<External<PdfAnnotation>>().Data())
 {
-  DbgLog = spdlog::get("DbgLog");
-  if(DbgLog != nullptr)
-    DbgLog->debug("PdfAnnotation from external object");
+  NPDF_LOG_DEBUG("PdfAnnotation from external object");
 }
 
 Annotation::~Annotation()
 {
-  if(DbgLog != nullptr)
-    DbgLog->debug("Annotation Cleanup");
+  NPDF_LOG_DEBUG("Annotation Cleanup");
 }
 void
 Annotation::Initialize(Napi::Env& env, Napi::Object& target)
@@ -122,7 +119,7 @@ Annotation::SetAppearanceStream(const CallbackInfo& info)
       .ThrowAsJavaScriptException();
     return;
   }
-  if (DbgLog != nullptr && DbgLog->level() == spdlog::level::debug) {
+  if (Logger::Enabled()) {
     std::stringbuf out;
     std::ostream stream(&out);
     PdfOutputDevice device(&stream);
@@ -130,7 +127,7 @@ Annotation::SetAppearanceStream(const CallbackInfo& info)
       ->GetXObject()
       .GetObject()
       ->Write(&device, ePdfWriteMode_Clean);
-    DbgLog->debug(out.str());
+    NPDF_LOG_DEBUG(out.str());
   }
   GetAnnotation().SetAppearanceStream(
     &(XObject::Unwrap(info[0].As<Object>())->GetXObject()));
@@ -212,8 +209,7 @@ JsValue
 Annotation::GetDestination(const CallbackInfo& info)
 {
   if (!GetAnnotation().HasDestination()) {
-    if(DbgLog != nullptr)
-      DbgLog->debug("Getting Destination that does not exist");
+    NPDF_LOG_DEBUG("Getting Destination that does not exist");
     return info.Env().Null();
   }
   auto doc = Document::Unwrap(info[0].As<Object>())->Base;
@@ -238,8 +234,7 @@ JsValue
 Annotation::GetAction(const CallbackInfo& info)
 {
   if (!GetAnnotation().HasAction()) {
-    if(DbgLog != nullptr)
-      DbgLog->debug("Getting PdfAction that does not exist");
+    NPDF_LOG_DEBUG("Getting PdfAction that does not exist");
     return info.Env().Null();
   }
   PdfAction* currentAction = GetAnnotation().GetAction();
@@ -467,17 +462,17 @@ JsValue
 Annotation::GetAttachment(const CallbackInfo& info)
 {
   if (!GetAnnotation().HasFileAttachement()) {
-    if(DbgLog != nullptr) DbgLog->debug("Getting attachment that does not exist");
+    NPDF_LOG_DEBUG("Getting attachment that does not exist");
     return info.Env().Null();
   }
   auto file = GetAnnotation().GetFileAttachement()->GetObject();
 
-  if (DbgLog != nullptr && DbgLog->level() == spdlog::level::debug) {
+  if (Logger::Enabled()) {
     std::stringbuf buf;
     std::ostream stream(&buf);
     PdfOutputDevice device(&stream);
     file->Write(&device, ePdfWriteMode_Clean);
-    DbgLog->debug(buf.str());
+    NPDF_LOG_DEBUG(buf.str());
   }
   return FileSpec::Constructor.New({ External<PdfObject>::New(
     info.Env(), new PdfObject(*file), [](Napi::Env env, PdfObject* data) {
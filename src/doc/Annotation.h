@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using namespace Napi;
 
@@ -68,7 +67,6 @@ public:
 
 private:
   PoDoFo::PdfAnnotation& Self;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_ANNOTATION_H
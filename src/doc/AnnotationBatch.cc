@@ -0,0 +1,407 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AnnotationBatch.h"
+#include "../base/Names.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Napi;
+using namespace PoDoFo;
+
+using std::string;
+using std::vector;
+
+namespace NoPoDoFo {
+
+namespace {
+
+// /Subtype names by EPdfAnnotation
+const char* const Subtypes[] = {
+  "Text", "Link", "FreeText", "Line", "Square", "Circle", "Polygon",
+  "PolyLine", "Highlight", "Underline", "Squiggly", "StrikeOut", "Stamp",
+  "Caret", "Ink", "Popup", "FileAttachment", "Sound", "Movie", "Widget",
+  "Screen", "PrinterMark", "TrapNet", "Watermark", "3D", "RichMedia",
+  "WebMedia"
+};
+const size_t SubtypeCount = sizeof(Subtypes) / sizeof(Subtypes[0]);
+
+// Numbers of a javascript Array or Float64Array
+vector<double>
+Numbers(const Napi::Value& value, const string& name)
+{
+  vector<double> numbers;
+  if (value.IsTypedArray() &&
+      value.As<TypedArray>().TypedArrayType() == napi_float64_array) {
+    auto values = value.As<Float64Array>();
+    numbers.assign(values.Data(), values.Data() + values.ElementLength());
+  } else if (value.IsArray()) {
+    auto values = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < values.Length(); i++) {
+      if (!values.Get(i).IsNumber()) {
+        throw TypeError::New(value.Env(), name + " must contain numbers");
+      }
+      numbers.push_back(values.Get(i).As<Number>().DoubleValue());
+    }
+  } else {
+    throw TypeError::New(value.Env(),
+                         name + " must be an Array or Float64Array");
+  }
+  return numbers;
+}
+
+const PdfObject*
+Resolve(const PdfVecObjects& objects, const PdfObject* value)
+{
+  if (value && value->IsReference()) {
+    return objects.GetObject(value->GetReference());
+  }
+  return value;
+}
+
+double
+NumberOf(const PdfObject& value)
+{
+  return value.IsReal() ? value.GetReal()
+                        : static_cast<double>(value.GetNumber());
+}
+
+PdfArray
+ArrayOf(const double* values, size_t count)
+{
+  PdfArray array;
+  array.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    array.push_back(PdfObject(values[i]));
+  }
+  return array;
+}
+
+// Annotation keys read by AnnotationGeometry::Read
+const std::string* const GeometryKeys[] = { &Name::SUBTYPE,
+                                            &Name::RECT,
+                                            &Name::F,
+                                            &Name::C,
+                                            &Name::QUADPOINTS };
+}
+
+AnnotationStyle
+AnnotationStyle::Parse(const Napi::Object& opts, size_t count)
+{
+  AnnotationStyle style;
+  auto env = opts.Env();
+  if (opts.Has("color")) {
+    style.Color = Numbers(opts.Get("color"), "color");
+    const auto n = style.Color.size();
+    if (n != 0 && n != 1 && n != 3 && n != 4) {
+      throw RangeError::New(env, "color must have 0, 1, 3 or 4 components");
+    }
+  }
+  if (opts.Has("colors")) {
+    style.Colors = Numbers(opts.Get("colors"), "colors");
+    if (style.Colors.size() != count * 3) {
+      throw RangeError::New(env, "colors requires 3 values per annotation");
+    }
+  }
+  if (opts.Has("quadPoints")) {
+    style.QuadPoints = Numbers(opts.Get("quadPoints"), "quadPoints");
+    if (style.QuadPoints.size() != count * 8) {
+      throw RangeError::New(env,
+                            "quadPoints requires 8 values per annotation");
+    }
+  }
+  if (opts.Has("flags") && opts.Get("flags").IsNumber()) {
+    style.Flags = opts.Get("flags").As<Number>().Int64Value();
+  }
+  if (opts.Has("opacity") && opts.Get("opacity").IsNumber()) {
+    style.Opacity = opts.Get("opacity").As<Number>().DoubleValue();
+  }
+  if (opts.Has("title") && opts.Get("title").IsString()) {
+    style.Title = opts.Get("title").As<String>().Utf8Value();
+  }
+  if (opts.Has("contents") && opts.Get("contents").IsString()) {
+    style.Contents = opts.Get("contents").As<String>().Utf8Value();
+  }
+  return style;
+}
+
+uint32_t
+AnnotationBatch::Add(PdfVecObjects& objects,
+                     PdfPage& page,
+                     EPdfAnnotation type,
+                     const double* rects,
+                     size_t count,
+                     const AnnotationStyle& style,
+                     size_t first)
+{
+  auto pageObj = page.GetObject();
+  auto annots = pageObj->GetIndirectKey(Name::ANNOTS);
+  if (!annots || !annots->IsArray()) {
+    pageObj->GetDictionary().AddKey(Name::ANNOTS, PdfArray());
+    annots = pageObj->GetDictionary().GetKey(Name::ANNOTS);
+  }
+  auto& array = annots->GetArray();
+  const auto start = static_cast<uint32_t>(array.size());
+  array.reserve(array.size() + count);
+
+  // the keys every annotation of the batch shares
+  PdfDictionary shared;
+  shared.AddKey(Name::TYPE, PdfName(Name::ANNOT));
+  shared.AddKey(Name::SUBTYPE, PdfName(Subtype(type)));
+  shared.AddKey(Name::P, pageObj->Reference());
+  if (style.Flags >= 0) {
+    shared.AddKey(Name::F, static_cast<pdf_int64>(style.Flags));
+  }
+  if (style.Opacity >= 0) {
+    shared.AddKey(Name::CA, style.Opacity);
+  }
+  if (!style.Title.empty()) {
+    shared.AddKey(
+      Name::T,
+      PdfString(reinterpret_cast<const pdf_utf8*>(style.Title.c_str())));
+  }
+  if (!style.Contents.empty()) {
+    shared.AddKey(
+      Name::CONTENTS,
+      PdfString(reinterpret_cast<const pdf_utf8*>(style.Contents.c_str())));
+  }
+  if (style.Colors.empty() && !style.Color.empty()) {
+    shared.AddKey(Name::C, ArrayOf(style.Color.data(), style.Color.size()));
+  }
+  const bool markup =
+    type == ePdfAnnotation_Highlight || type == ePdfAnnotation_Underline ||
+    type == ePdfAnnotation_Squiggly || type == ePdfAnnotation_StrikeOut;
+
+  for (size_t i = 0; i < count; i++) {
+    const double* r = rects + i * 4;
+    const double left = std::min(r[0], r[0] + r[2]);
+    const double right = std::max(r[0], r[0] + r[2]);
+    const double bottom = std::min(r[1], r[1] + r[3]);
+    const double top = std::max(r[1], r[1] + r[3]);
+    auto annot = objects.CreateObject(shared);
+    auto& dict = annot->GetDictionary();
+    const double rect[] = { left, bottom, right, top };
+    dict.AddKey(Name::RECT, ArrayOf(rect, 4));
+    if (!style.Colors.empty()) {
+      dict.AddKey(Name::C, ArrayOf(&style.Colors[(first + i) * 3], 3));
+    }
+    if (!style.QuadPoints.empty()) {
+      dict.AddKey(Name::QUADPOINTS,
+                  ArrayOf(&style.QuadPoints[(first + i) * 8], 8));
+    } else if (markup) {
+      // upper left, upper right, lower left, lower right
+      const double quad[] = { left,  top,    right, top,
+                              left,  bottom, right, bottom };
+      dict.AddKey(Name::QUADPOINTS, ArrayOf(quad, 8));
+    }
+    array.push_back(annot->Reference());
+  }
+  return start;
+}
+
+uint8_t
+AnnotationBatch::Type(const PdfObject& annot)
+{
+  const auto subtype = annot.GetDictionary().GetKey(Name::SUBTYPE);
+  if (!subtype || !subtype->IsName()) {
+    return ePdfAnnotation_Unknown;
+  }
+  const auto& name = subtype->GetName().GetName();
+  for (size_t i = 0; i < SubtypeCount; i++) {
+    if (name == Subtypes[i]) {
+      return static_cast<uint8_t>(i);
+    }
+  }
+  return ePdfAnnotation_Unknown;
+}
+
+const char*
+AnnotationBatch::Subtype(EPdfAnnotation type)
+{
+  const auto i = static_cast<size_t>(type);
+  return i < SubtypeCount ? Subtypes[i] : nullptr;
+}
+
+EPdfAnnotation
+AnnotationBatch::ParseType(const Napi::Value& value)
+{
+  if (!value.IsNumber() ||
+      value.As<Number>().Uint32Value() >= SubtypeCount) {
+    throw TypeError::New(value.Env(), "type must be an NPDFAnnotation");
+  }
+  return static_cast<EPdfAnnotation>(value.As<Number>().Uint32Value());
+}
+
+Float64Array
+AnnotationBatch::ParseRects(const Napi::Value& value)
+{
+  if (!value.IsTypedArray() ||
+      value.As<TypedArray>().TypedArrayType() != napi_float64_array) {
+    throw TypeError::New(value.Env(), "rects must be a Float64Array");
+  }
+  auto rects = value.As<Float64Array>();
+  if (rects.ElementLength() % 4 != 0) {
+    throw RangeError::New(value.Env(),
+                          "rects requires left, bottom, width and height "
+                          "per annotation");
+  }
+  return rects;
+}
+
+std::set<uint8_t>
+AnnotationBatch::ParseTypes(const Napi::Value& opts)
+{
+  std::set<uint8_t> types;
+  if (!opts.IsObject() || !opts.As<Object>().Has("types")) {
+    return types;
+  }
+  for (const auto type : Numbers(opts.As<Object>().Get("types"), "types")) {
+    types.insert(static_cast<uint8_t>(type));
+  }
+  return types;
+}
+
+vector<const PdfObject*>
+AnnotationGeometry::Annotations(const PdfVecObjects& objects,
+                                const PdfPage& page)
+{
+  vector<const PdfObject*> annotations;
+  const auto annots =
+    Resolve(objects, page.GetObject()->GetDictionary().GetKey(Name::ANNOTS));
+  if (!annots || !annots->IsArray()) {
+    return annotations;
+  }
+  annotations.reserve(annots->GetArray().size());
+  for (const auto& item : annots->GetArray()) {
+    // IsDictionary loads a delayed object, Read may then run off the main
+    // thread
+    const auto annot = Resolve(objects, &item);
+    if (!annot || !annot->IsDictionary()) {
+      annotations.push_back(nullptr);
+      continue;
+    }
+    for (const auto key : GeometryKeys) {
+      const auto value = Resolve(objects, annot->GetDictionary().GetKey(*key));
+      if (value) {
+        value->GetDataType();
+      }
+    }
+    annotations.push_back(annot);
+  }
+  return annotations;
+}
+
+AnnotationGeometry
+AnnotationGeometry::Read(const PdfVecObjects& objects,
+                         const vector<const PdfObject*>& annotations,
+                         const std::set<uint8_t>& types)
+{
+  const auto nan = std::numeric_limits<double>::quiet_NaN();
+  AnnotationGeometry geometry;
+  for (size_t i = 0; i < annotations.size(); i++) {
+    const auto annot = annotations[i];
+    if (!annot) {
+      continue;
+    }
+    const auto type = AnnotationBatch::Type(*annot);
+    if (!types.empty() && !types.count(type)) {
+      continue;
+    }
+    const auto& dict = annot->GetDictionary();
+    geometry.Indexes.push_back(static_cast<uint32_t>(i));
+    geometry.Objects.push_back(annot->Reference().ObjectNumber());
+    geometry.Types.push_back(type);
+
+    const auto rect = Resolve(objects, dict.GetKey(Name::RECT));
+    if (rect && rect->IsArray() && rect->GetArray().size() == 4) {
+      const PdfRect r(rect->GetArray());
+      geometry.Rects.insert(
+        geometry.Rects.end(),
+        { r.GetLeft(), r.GetBottom(), r.GetWidth(), r.GetHeight() });
+    } else {
+      geometry.Rects.insert(geometry.Rects.end(), 4, 0.0);
+    }
+
+    const auto flags = Resolve(objects, dict.GetKey(Name::F));
+    geometry.Flags.push_back(
+      flags && flags->IsNumber() ? static_cast<uint32_t>(flags->GetNumber())
+                                 : 0);
+
+    const auto color = Resolve(objects, dict.GetKey(Name::C));
+    size_t components = 0;
+    if (color && color->IsArray()) {
+      for (const auto& c : color->GetArray()) {
+        if (components == 4) {
+          break;
+        }
+        if (c.IsNumber() || c.IsReal()) {
+          geometry.Colors.push_back(NumberOf(c));
+          ++components;
+        }
+      }
+    }
+    geometry.Colors.insert(geometry.Colors.end(), 4 - components, nan);
+
+    const auto quads = Resolve(objects, dict.GetKey(Name::QUADPOINTS));
+    if (quads && quads->IsArray()) {
+      for (const auto& q : quads->GetArray()) {
+        if (q.IsNumber() || q.IsReal()) {
+          geometry.QuadPoints.push_back(NumberOf(q));
+        }
+      }
+    }
+    geometry.QuadStart.push_back(
+      static_cast<uint32_t>(geometry.QuadPoints.size()));
+  }
+  return geometry;
+}
+
+Napi::Object
+AnnotationGeometry::ToJS(const Napi::Env& env) const
+{
+  auto js = Object::New(env);
+  auto indexes = Uint32Array::New(env, Indexes.size());
+  auto objects = Uint32Array::New(env, Objects.size());
+  auto types = Uint8Array::New(env, Types.size());
+  auto rects = Float64Array::New(env, Rects.size());
+  auto flags = Uint32Array::New(env, Flags.size());
+  auto colors = Float64Array::New(env, Colors.size());
+  auto quadPoints = Float64Array::New(env, QuadPoints.size());
+  auto quadStart = Uint32Array::New(env, QuadStart.size());
+  std::copy(Indexes.begin(), Indexes.end(), indexes.Data());
+  std::copy(Objects.begin(), Objects.end(), objects.Data());
+  std::copy(Types.begin(), Types.end(), types.Data());
+  std::copy(Rects.begin(), Rects.end(), rects.Data());
+  std::copy(Flags.begin(), Flags.end(), flags.Data());
+  std::copy(Colors.begin(), Colors.end(), colors.Data());
+  std::copy(QuadPoints.begin(), QuadPoints.end(), quadPoints.Data());
+  std::copy(QuadStart.begin(), QuadStart.end(), quadStart.Data());
+  js.Set("count", Number::New(env, Size()));
+  js.Set("index", indexes);
+  js.Set("object", objects);
+  js.Set("type", types);
+  js.Set("rect", rects);
+  js.Set("flags", flags);
+  js.Set("color", colors);
+  js.Set("quadPoints", quadPoints);
+  js.Set("quadStart", quadStart);
+  return js;
+}
+}
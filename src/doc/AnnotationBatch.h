@@ -0,0 +1,126 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_ANNOTATIONBATCH_H
+#define NPDF_ANNOTATIONBATCH_H
+
+#include <cstdint>
+#include <napi.h>
+#include <podofo/podofo.h>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace NoPoDoFo {
+
+/**
+ * Options of one addAnnotations call. Per annotation values are packed,
+ * Colors three (RGB) and QuadPoints eight numbers per annotation.
+ */
+struct AnnotationStyle
+{
+  // /C of every annotation, 0 (none), 1, 3 or 4 components
+  std::vector<double> Color;
+  // RGB /C per annotation, takes precedence over Color
+  std::vector<double> Colors;
+  std::vector<double> QuadPoints;
+  // /F, not set when negative
+  int64_t Flags = -1;
+  // /CA, not set when negative
+  double Opacity = -1;
+  std::string Title;
+  std::string Contents;
+
+  static AnnotationStyle Parse(const Napi::Object&, size_t count);
+};
+
+/**
+ * AnnotationBatch creates many annotations of one type in a single pass over
+ * a page's /Annots, writing the annotation dictionaries directly instead of
+ * going through a PdfAnnotation per annotation.
+ */
+class AnnotationBatch
+{
+public:
+  // Append one annotation per rect (left, bottom, width, height) to page.
+  // Text markup types get QuadPoints covering their rect when the style has
+  // none. first is the index of rects[0] in the style's packed values.
+  // Returns the /Annots index of the first new annotation.
+  static uint32_t Add(PoDoFo::PdfVecObjects&,
+                      PoDoFo::PdfPage&,
+                      PoDoFo::EPdfAnnotation,
+                      const double* rects,
+                      size_t count,
+                      const AnnotationStyle&,
+                      size_t first = 0);
+
+  // The EPdfAnnotation code of an annotation's /Subtype,
+  // ePdfAnnotation_Unknown when it is missing or not known
+  static uint8_t Type(const PoDoFo::PdfObject&);
+  static const char* Subtype(PoDoFo::EPdfAnnotation);
+
+  // Arguments shared by the Page and Document methods: an NPDFAnnotation,
+  // a Float64Array of rects and the types of an options object
+  static PoDoFo::EPdfAnnotation ParseType(const Napi::Value&);
+  static Napi::Float64Array ParseRects(const Napi::Value&);
+  static std::set<uint8_t> ParseTypes(const Napi::Value& opts);
+};
+
+/**
+ * Columnar geometry of the annotations of a page, one column per attribute:
+ * /Annots index, type, rect, flags, color and quad points. Annotations have
+ * to be loaded on the main thread with Annotations, Read only reads them and
+ * may run on a worker thread.
+ */
+class AnnotationGeometry
+{
+public:
+  // The annotation dictionaries of a page in /Annots order, nullptr for
+  // entries that are not a dictionary
+  static std::vector<const PoDoFo::PdfObject*> Annotations(
+    const PoDoFo::PdfVecObjects&,
+    const PoDoFo::PdfPage&);
+  // Describe the annotations with a type in types, every annotation when
+  // types is empty
+  static AnnotationGeometry Read(const PoDoFo::PdfVecObjects&,
+                                 const std::vector<const PoDoFo::PdfObject*>&,
+                                 const std::set<uint8_t>& types);
+  Napi::Object ToJS(const Napi::Env&) const;
+
+  size_t Size() const { return Types.size(); }
+
+private:
+  // index in the page's /Annots
+  std::vector<uint32_t> Indexes;
+  // object number, 0 for a direct annotation
+  std::vector<uint32_t> Objects;
+  // EPdfAnnotation code
+  std::vector<uint8_t> Types;
+  // left, bottom, width, height, four per annotation
+  std::vector<double> Rects;
+  // /F annotation flags
+  std::vector<uint32_t> Flags;
+  // /C, four per annotation, unused components are NaN
+  std::vector<double> Colors;
+  // every annotation's /QuadPoints, QuadStart[i] to QuadStart[i + 1]
+  std::vector<double> QuadPoints;
+  std::vector<uint32_t> QuadStart = { 0 };
+};
+}
+#endif // NPDF_ANNOTATIONBATCH_H
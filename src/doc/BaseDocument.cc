@@ -18,22 +18,30 @@
  */
 
 #include "BaseDocument.h"
+#include "../Logger.h"
 #include "../Defines.h"
 #include "../ErrorHandler.h"
 #include "../ValidateArguments.h"
 #include "../base/Names.h"
 #include "../base/Obj.h"
+#include "../base/Parallel.h"
 #include "../base/Ref.h"
+#include "../base/Writer.h"
 #include "../base/XObject.h"
 #include "../doc/Rect.h"
+#include "AnnotationBatch.h"
 #include "Document.h"
 #include "Encrypt.h"
 #include "FileSpec.h"
 #include "Font.h"
 #include "Form.h"
+#include "NameTree.h"
 #include "Outline.h"
 #include "Page.h"
-#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <unordered_set>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -42,7 +50,6 @@ using std::cout;
 using std::endl;
 using std::string;
 using std::stringstream;
-using tl::nullopt;
 
 namespace NoPoDoFo {
 
@@ -56,11 +63,9 @@ namespace NoPoDoFo {
  */
 BaseDocument::BaseDocument(const Napi::CallbackInfo& info, const bool inMem)
 {
-  DbgLog = spdlog::get("DbgLog");
   if (inMem) {
-    Base = new PdfMemDocument();
-    if (DbgLog != nullptr)
-      DbgLog->debug("New PdfMemDocument");
+    Base = new OwnedDocument<PdfMemDocument>(this);
+    NPDF_LOG_DEBUG("New PdfMemDocument");
   } else {
     auto version = ePdfVersion_1_7;
     auto writeMode = ePdfWriteMode_Default;
@@ -80,36 +85,63 @@ BaseDocument::BaseDocument(const Napi::CallbackInfo& info, const bool inMem)
         const auto nEncObj = Encrypt::Unwrap(nObj.Get("encrypt").As<Object>());
         encrypt = PdfEncrypt::CreatePdfEncrypt(*nEncObj->Self);
       }
+      const auto options = ParseWriteOptions(nObj);
+      ObjectStreams = options.ObjectStreams;
+      Linearize = options.Linearize;
+    }
+    // PdfImmediateWriter only writes classic xref tables in object order,
+    // with object streams or linearization the document is streamed to a
+    // spool file next to the destination (or to memory without one) and
+    // repacked on close. Encryption is applied by the repacking writer.
+    if (RepackOnClose()) {
+      StreamDocEncrypt = encrypt;
+      encrypt = nullptr;
     }
     if (info.Length() > 0 && info[0].IsString()) {
       Output = info[0].As<String>().Utf8Value();
-      Base =
-        new PdfStreamedDocument(Output.c_str(), version, encrypt, writeMode);
-      std::stringstream dbgMsg;
-      dbgMsg << "New PdfStreamedDocument to " << Output.c_str() << endl;
-      if (DbgLog != nullptr)
-        DbgLog->debug(dbgMsg.str());
+    }
+    if (!Output.empty() && !RepackOnClose()) {
+      Base = new OwnedDocument<PdfStreamedDocument>(
+        this, Output.c_str(), version, encrypt, writeMode);
+      NPDF_LOG_DEBUG("New PdfStreamedDocument to {}", Output);
+    } else if (!Output.empty()) {
+      Spool = Output + ".part";
+      StreamDocOutputDevice = new PdfOutputDevice(Spool.c_str());
+      Base = new OwnedDocument<PdfStreamedDocument>(
+        this, StreamDocOutputDevice, version, encrypt, writeMode);
+      NPDF_LOG_DEBUG("New PdfStreamedDocument to {}", Spool);
     } else {
       StreamDocRefCountedBuffer = new PdfRefCountedBuffer(2048);
       StreamDocOutputDevice = new PdfOutputDevice(StreamDocRefCountedBuffer);
-      Base = new PdfStreamedDocument(
-        StreamDocOutputDevice, version, encrypt, writeMode);
-      if (DbgLog != nullptr)
-        DbgLog->debug("New PdfStreamedDocument to Buffer");
+      Base = new OwnedDocument<PdfStreamedDocument>(
+        this, StreamDocOutputDevice, version, encrypt, writeMode);
+      NPDF_LOG_DEBUG("New PdfStreamedDocument to Buffer");
     }
   }
 }
 
+BaseDocument*
+BaseDocument::Of(const PdfVecObjects* objects)
+{
+  const auto owned = dynamic_cast<DocumentOwner*>(
+    objects ? objects->GetParentDocument() : nullptr);
+  return owned ? owned->Owner : nullptr;
+}
+
 BaseDocument::~BaseDocument()
 {
-  if (DbgLog != nullptr)
-    DbgLog->debug("BaseDocument Cleanup");
+  NPDF_LOG_DEBUG("BaseDocument Cleanup");
   for (auto c : Copies) {
     delete c;
   }
+  PageOrder.Release();
   delete Base;
   delete StreamDocOutputDevice;
   delete StreamDocRefCountedBuffer;
+  delete StreamDocEncrypt;
+  if (!Spool.empty()) {
+    std::remove(Spool.c_str());
+  }
 }
 
 JsValue
@@ -127,8 +159,8 @@ BaseDocument::GetPage(const CallbackInfo& info)
       .ThrowAsJavaScriptException();
     return {};
   }
-  return Page::Constructor.New(
-    { External<PdfPage>::New(info.Env(), Base->GetPage(n)) });
+  const auto page = PageOrder.Page(*Base, *Base->GetPage(n)->GetObject());
+  return Page::Constructor.New({ External<PdfPage>::New(info.Env(), page) });
 }
 
 void
@@ -217,12 +249,258 @@ BaseDocument::AttachFile(const CallbackInfo& info)
       .ThrowAsJavaScriptException();
     return;
   }
-  auto embed = true;
-  if (!Output.empty() || (StreamDocOutputDevice && StreamDocRefCountedBuffer)) {
-    embed = false;
+  try {
+    EmbeddedFileEncoder file(*Base, value);
+    file.AppendFile(value);
+    file.Finish();
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
   }
-  const PdfFileSpec attachment(value.c_str(), embed, Base);
-  Base->AttachFile(attachment);
+  AttachmentNamesBuilt = false;
+}
+
+namespace {
+
+/**
+ * Encodes a file from disk into a temporary file on a worker thread, the
+ * embedded file stream and its file specification are added on the main
+ * thread once it is done.
+ */
+class AttachFileAsync final : public AsyncWorker
+{
+public:
+  AttachFileAsync(const Object& doc,
+                  BaseDocument& base,
+                  string path,
+                  const string& name)
+    : AsyncWorker(doc.Env(), "attach_file_async")
+    , Deferred(Promise::Deferred::New(doc.Env()))
+    , Doc(Persistent(doc))
+    , Base(base)
+    , File(new EmbeddedFileEncoder(*base.Base, name))
+    , Path(std::move(path))
+  {}
+  Promise GetPromise() { return Deferred.Promise(); }
+
+protected:
+  void Execute() override
+  {
+    try {
+      File->AppendFile(Path);
+    } catch (PdfError& err) {
+      SetError(ErrorHandler::WriteMsg(err));
+    }
+  }
+  void OnOK() override
+  {
+    HandleScope scope(Env());
+    try {
+      const auto spec = Base.FinishAttachment(*File);
+      Deferred.Resolve(FileSpec::Constructor.New(
+        { External<PdfObject>::New(Env(), spec), Doc.Value() }));
+    } catch (PdfError& err) {
+      Deferred.Reject(
+        Napi::Error::New(Env(), ErrorHandler::WriteMsg(err)).Value());
+    }
+  }
+  void OnError(const Napi::Error& err) override
+  {
+    Deferred.Reject(err.Value());
+  }
+
+private:
+  Promise::Deferred Deferred;
+  ObjectReference Doc;
+  BaseDocument& Base;
+  std::unique_ptr<EmbeddedFileEncoder> File;
+  string Path;
+};
+
+/**
+ * The state of attachStream(Readable), 'data' chunks are encoded as they
+ * arrive and the embedded file stream and file specification are added on
+ * 'end'.
+ */
+struct ReadableAttachment
+{
+  ReadableAttachment(const Object& doc,
+                     BaseDocument& base,
+                     const Object& readable,
+                     const string& name)
+    : Deferred(Promise::Deferred::New(doc.Env()))
+    , Doc(Persistent(doc))
+    , Readable(Persistent(readable))
+    , Base(base)
+    , File(*base.Base, name)
+  {}
+  void Fail(const JsValue& failure)
+  {
+    if (Settled) {
+      return;
+    }
+    Settled = true;
+    Release(failure.Env());
+    Deferred.Reject(failure);
+  }
+  // The listeners' functions hold this attachment, remove them and drop the
+  // references so the attachment, the Readable and the document can be
+  // collected. The temporary file is closed.
+  void Release(const Napi::Env& env)
+  {
+    auto readable = Readable.Value();
+    auto remove = readable.Get("removeListener");
+    if (remove.IsFunction()) {
+      const std::pair<const char*, FunctionReference*> listeners[] = {
+        { "data", &OnData }, { "end", &OnEnd }, { "error", &OnError }
+      };
+      for (const auto& listener : listeners) {
+        if (!listener.second->IsEmpty()) {
+          remove.As<Function>().Call(
+            readable,
+            { String::New(env, listener.first), listener.second->Value() });
+        }
+      }
+    }
+    OnData.Reset();
+    OnEnd.Reset();
+    OnError.Reset();
+    Readable.Reset();
+    Doc.Reset();
+    File.Close();
+  }
+
+  Promise::Deferred Deferred;
+  ObjectReference Doc;
+  ObjectReference Readable;
+  FunctionReference OnData;
+  FunctionReference OnEnd;
+  FunctionReference OnError;
+  BaseDocument& Base;
+  EmbeddedFileEncoder File;
+  bool Settled = false;
+};
+}
+
+/**
+ * attachStream(source, opts?) embeds a file path or Readable as a Flate
+ * encoded stream, a chunk at a time, without reading the whole file into
+ * memory. The data is encoded into a temporary file (a path on a worker
+ * thread) and the stream is written once the source ends. opts.name names
+ * the attachment, it defaults to the path (or the path of a fs.ReadStream).
+ * Resolves to the new FileSpec.
+ */
+JsValue
+BaseDocument::AttachStream(const CallbackInfo& info)
+{
+  auto env = info.Env();
+  if (info.Length() < 1 ||
+      !(info[0].IsString() ||
+        (info[0].IsObject() && info[0].As<Object>().Get("on").IsFunction()))) {
+    throw TypeError::New(env, "attachStream expects a file path or Readable");
+  }
+  string name;
+  if (info.Length() >= 2 && info[1].IsObject() &&
+      info[1].As<Object>().Get("name").IsString()) {
+    name = info[1].As<Object>().Get("name").As<String>().Utf8Value();
+  } else if (info[0].IsString()) {
+    name = info[0].As<String>().Utf8Value();
+  } else if (info[0].As<Object>().Get("path").IsString()) {
+    name = info[0].As<Object>().Get("path").As<String>().Utf8Value();
+  } else {
+    throw TypeError::New(env, "attachStream requires opts.name for a Readable");
+  }
+  try {
+    if (info[0].IsString()) {
+      auto path = info[0].As<String>().Utf8Value();
+      if (!FileAccess(path)) {
+        throw Napi::Error::New(env, "File: " + path + " not found");
+      }
+      auto worker = new AttachFileAsync(
+        info.This().As<Object>(), *this, std::move(path), name);
+      worker->Queue();
+      return worker->GetPromise();
+    }
+    auto readable = info[0].As<Object>();
+    auto attachment = std::make_shared<ReadableAttachment>(
+      info.This().As<Object>(), *this, readable, name);
+    attachment->OnData = Persistent(
+      Function::New(env, [attachment](const CallbackInfo& args) {
+        if (attachment->Settled) {
+          return;
+        }
+        if (args.Length() < 1 || !args[0].IsBuffer()) {
+          attachment->Fail(
+            TypeError::New(args.Env(), "attachStream expects Buffer chunks")
+              .Value());
+          return;
+        }
+        auto chunk = args[0].As<Buffer<char>>();
+        try {
+          attachment->File.Append(chunk.Data(), chunk.Length());
+        } catch (PdfError& err) {
+          attachment->Fail(
+            Napi::Error::New(args.Env(), ErrorHandler::WriteMsg(err))
+              .Value());
+        }
+      }));
+    attachment->OnEnd = Persistent(
+      Function::New(env, [attachment](const CallbackInfo& args) {
+        if (attachment->Settled) {
+          return;
+        }
+        attachment->Settled = true;
+        JsValue spec;
+        JsValue failure;
+        try {
+          const auto file =
+            attachment->Base.FinishAttachment(attachment->File);
+          spec = FileSpec::Constructor.New(
+            { External<PdfObject>::New(args.Env(), file),
+              attachment->Doc.Value() });
+        } catch (PdfError& err) {
+          failure =
+            Napi::Error::New(args.Env(), ErrorHandler::WriteMsg(err)).Value();
+        }
+        attachment->Release(args.Env());
+        if (failure.IsEmpty()) {
+          attachment->Deferred.Resolve(spec);
+        } else {
+          attachment->Deferred.Reject(failure);
+        }
+      }));
+    attachment->OnError = Persistent(
+      Function::New(env, [attachment](const CallbackInfo& args) {
+        attachment->Fail(args.Length() > 0 ? args[0] : args.Env().Undefined());
+      }));
+    auto on = readable.Get("on").As<Function>();
+    on.Call(readable,
+            { String::New(env, "data"), attachment->OnData.Value() });
+    on.Call(readable, { String::New(env, "end"), attachment->OnEnd.Value() });
+    on.Call(readable,
+            { String::New(env, "error"), attachment->OnError.Value() });
+    return attachment->Deferred.Promise();
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return env.Undefined();
+}
+
+/**
+ * Add an encoded attachment to the document, fails if a StreamDocument was
+ * closed while the attachment was being read
+ */
+PdfObject*
+BaseDocument::FinishAttachment(EmbeddedFileEncoder& file)
+{
+  if (Closed) {
+    file.Abort();
+    PODOFO_RAISE_ERROR_INFO(ePdfError_InternalLogic,
+                            "The document was closed before the attachment "
+                            "was written");
+  }
+  const auto spec = file.Finish();
+  AttachmentNamesBuilt = false;
+  return spec;
 }
 
 JsValue
@@ -273,6 +551,12 @@ JsValue
 BaseDocument::GetWriteMode(const CallbackInfo& info)
 {
   string writeMode;
+  if (Linearize) {
+    return Napi::String::New(info.Env(), "Linearized");
+  }
+  if (ObjectStreams) {
+    return Napi::String::New(info.Env(), "ObjectStreams");
+  }
   switch (Base->GetWriteMode()) {
     case ePdfWriteMode_Clean: {
       writeMode = "Clean";
@@ -338,8 +622,7 @@ BaseDocument::GetObject(const CallbackInfo& info)
     stringstream oss;
     oss << "NoPoDoFo is unable to resolve reference " << ref->ObjectNumber()
         << " : " << ref->GenerationNumber();
-    if (DbgLog != nullptr)
-      DbgLog->debug(oss.str());
+    NPDF_LOG_DEBUG(oss.str());
     Error::New(info.Env(), oss.str()).ThrowAsJavaScriptException();
     return {};
   }
@@ -384,7 +667,9 @@ BaseDocument::CreateFont(const CallbackInfo& info)
     return info.Env().Undefined();
   }
   const auto font = CreateFontObject(info.Env(), info[0].As<Object>(), false);
-  return Font::Constructor.New({ External<PdfFont>::New(info.Env(), font) });
+  return Font::Constructor.New(
+    { External<PdfFont>::New(info.Env(), font),
+      External<BaseDocument>::New(info.Env(), this) });
 }
 /**
  * @note Javascript args (doc:Document, pageN:number, atN:number)
@@ -411,6 +696,7 @@ BaseDocument::InsertExistingPage(const CallbackInfo& info)
     return {};
   }
   Base->InsertExistingPageAt(memDoc->GetDocument(), memPageN, atN);
+  PageOrder.Invalidate();
   return Number::New(info.Env(), Base->GetPageCount());
 }
 JsValue
@@ -435,10 +721,8 @@ BaseDocument::GetInfo(const CallbackInfo& info)
 JsValue
 BaseDocument::GetOutlines(const CallbackInfo& info)
 {
-  auto opts = AssertCallbackInfo(
-    info,
-    { { 0, { nullopt, option(napi_boolean), option(napi_string) } },
-      { 1, { nullopt, option(napi_string) } } });
+  auto opts = AssertArguments<ArgTypes<ArgOmitted, napi_boolean, napi_string>,
+                              ArgTypes<ArgOmitted, napi_string>>(info);
 
   PdfOutlineItem* outlines = nullptr;
   // Create with default options
@@ -468,21 +752,44 @@ BaseDocument::GetOutlines(const CallbackInfo& info)
   return Outline::Constructor.New(
     { External<PdfOutlineItem>::New(info.Env(), outlines) });
 }
+/**
+ * getNames(create, tree?) returns the document's /Names dictionary, or with
+ * tree (i.e. "EmbeddedFiles", "Dests") that name tree as a NameTree
+ */
 JsValue
 BaseDocument::GetNamesTree(const CallbackInfo& info)
 {
-  auto names = Base->GetNamesTree(info[0].As<Boolean>());
+  const bool create = info.Length() > 0 && info[0].ToBoolean();
+  auto names = Base->GetNamesTree(create);
   if (!names) {
     return info.Env().Null();
   }
-  return Obj::Constructor.New(
-    { External<PdfObject>::New(info.Env(), names->GetObject()) });
+  if (info.Length() < 2 || !info[1].IsString()) {
+    return Obj::Constructor.New(
+      { External<PdfObject>::New(info.Env(), names->GetObject()) });
+  }
+  const auto type = info[1].As<String>().Utf8Value();
+  auto tree = names->GetObject()->GetIndirectKey(PdfName(type));
+  if (!tree || !tree->IsDictionary()) {
+    if (!create) {
+      return info.Env().Null();
+    }
+    tree = Base->GetObjects()->CreateObject();
+    names->GetObject()->GetDictionary().AddKey(PdfName(type),
+                                               tree->Reference());
+  }
+  return NameTree::Constructor.New(
+    { External<BaseDocument>::New(info.Env(), this),
+      External<PdfObject>::New(info.Env(), tree),
+      String::New(info.Env(), type) });
 }
 JsValue
 BaseDocument::CreatePage(const CallbackInfo& info)
 {
   const auto r = Rect::Unwrap(info[0].As<Object>())->GetRect();
-  const auto page = Base->CreatePage(r);
+  const auto obj = Base->CreatePage(r)->GetObject();
+  PageOrder.Invalidate();
+  const auto page = PageOrder.Page(*Base, *obj);
   return Page::Constructor.New({ External<PdfPage>::New(info.Env(), page) });
 }
 JsValue
@@ -495,6 +802,7 @@ BaseDocument::CreatePages(const Napi::CallbackInfo& info)
       Rect::Unwrap(coll.Get(static_cast<uint32_t>(i)).As<Object>())->GetRect());
   }
   Base->CreatePages(rects);
+  PageOrder.Invalidate();
   return Number::New(info.Env(), Base->GetPageCount());
 }
 JsValue
@@ -503,8 +811,10 @@ BaseDocument::InsertPage(const Napi::CallbackInfo& info)
   const auto rect = Rect::Unwrap(info[0].As<Object>())->GetRect();
   const int index = info[1].As<Number>();
   Base->InsertPage(rect, index);
-  return Page::Constructor.New(
-    { External<PdfPage>::New(info.Env(), Base->GetPage(index)) });
+  PageOrder.Invalidate();
+  const auto page =
+    PageOrder.Page(*Base, *Base->GetPage(index)->GetObject());
+  return Page::Constructor.New({ External<PdfPage>::New(info.Env(), page) });
 }
 
 void
@@ -531,85 +841,357 @@ BaseDocument::Append(const Napi::CallbackInfo& info)
     auto mergedDoc = Document::Unwrap(info[0].As<Object>());
     Base->Append(mergedDoc->GetDocument());
   }
+  PageOrder.Invalidate();
 }
 
 JsValue
 BaseDocument::GetAttachment(const CallbackInfo& info)
 {
   const string name = info[0].As<String>();
-  if (Base->GetAttachment(name)) {
-    return FileSpec::Constructor.New({ External<PdfObject>::New(
-      info.Env(), Base->GetAttachment(name)->GetObject()) });
-  }
-  if (Base->GetNamesTree(false) == nullptr ||
-      Base->GetNamesTree(false)->GetObject() == nullptr ||
-      !Base->GetNamesTree(false)->GetObject()->IsDictionary() ||
-      !Base->GetNamesTree(false)->GetObject()->GetDictionary().HasKey(
-        Name::EMBEDDED_FILES)) {
-    if (DbgLog != nullptr)
-      DbgLog->debug("GetAttachment: PDF does not have any attachments\n");
+  const auto names = Base->GetNamesTree(false);
+  const auto files = names && names->GetObject()
+                       ? names->GetObject()->GetIndirectKey(
+                           Name::EMBEDDED_FILES)
+                       : nullptr;
+  if (!files || !files->IsDictionary()) {
+    NPDF_LOG_DEBUG("GetAttachment: PDF does not have any attachments");
+    return info.Env().Null();
+  }
+  auto file =
+    NameTree::Find(*Base->GetObjects(), *files, NameTree::Key(name));
+  if (!file || !file->IsDictionary()) {
+    file = AttachmentByName(*files, name);
+  }
+  if (!file) {
     return info.Env().Null();
   }
-  auto findAttachment = [&](PdfArray& arr) -> PdfObject* {
-    for (auto&& ii : arr) {
-      PdfObject* item = ii.IsReference()
-                          ? Base->GetObjects()->GetObject(ii.GetReference())
-                          : &ii;
-      PdfObject* fileSpec = nullptr;
-      if (item->IsDictionary() && item->GetDictionary().HasKey(Name::TYPE) &&
-          (item->GetDictionary().GetKey(Name::TYPE)->GetName() ==
-             Name::FILESPEC ||
-           item->GetDictionary().GetKey(Name::TYPE)->GetName() == Name::F)) {
-        fileSpec = item;
-
-        if (fileSpec->GetDictionary().HasKey(Name::UF)) {
-          PdfObject* uf = fileSpec->MustGetIndirectKey(Name::UF);
-          if (DbgLog != nullptr)
-            DbgLog->debug("GetAttachment: PDF Attachment name:%s\n",
-                          uf->GetString().GetStringUtf8().c_str());
-          if (uf->IsString() && uf->GetString().GetStringUtf8() == name) {
-            fileSpec->GetDictionary().RemoveKey(PdfName(Name::TYPE));
-            fileSpec->GetDictionary().AddKey(PdfName(Name::TYPE),
-                                             PdfName(Name::FILESPEC));
-            return fileSpec;
-          }
+  return FileSpec::Constructor.New(
+    { External<PdfObject>::New(info.Env(), file), info.This() });
+}
+
+/**
+ * Find a file specification of /EmbeddedFiles by its /UF name, through the
+ * AttachmentNames index. The index is built on first use and rebuilt only
+ * after it was invalidated, by adding attachments, setting the name tree or
+ * loading a file, or when the cached file specification no longer has the
+ * name. A miss on a current index is answered without walking the tree.
+ */
+PdfObject*
+BaseDocument::AttachmentByName(const PdfObject& files, const string& name)
+{
+  const auto named = [&name](const PdfObject* spec) {
+    if (!spec || !spec->IsDictionary() ||
+        !spec->GetDictionary().HasKey(Name::TYPE)) {
+      return false;
+    }
+    const auto type = spec->GetDictionary().GetKey(Name::TYPE);
+    const auto uf = spec->GetIndirectKey(Name::UF);
+    return type->IsName() &&
+           (type->GetName() == Name::FILESPEC || type->GetName() == Name::F) &&
+           uf && uf->IsString() && uf->GetString().GetStringUtf8() == name;
+  };
+  for (auto attempt = 0; attempt < 2; ++attempt) {
+    if (!AttachmentNamesBuilt) {
+      AttachmentNames.clear();
+      NameTree::Entries entries;
+      NameTree::Collect(*Base->GetObjects(), files, entries);
+      for (const auto& entry : entries) {
+        if (!entry.second.IsReference()) {
+          continue;
+        }
+        const auto spec =
+          Base->GetObjects()->GetObject(entry.second.GetReference());
+        const auto uf = spec && spec->IsDictionary()
+                          ? spec->GetIndirectKey(Name::UF)
+                          : nullptr;
+        if (uf && uf->IsString()) {
+          AttachmentNames.emplace(uf->GetString().GetStringUtf8(),
+                                  entry.second.GetReference());
         }
       }
+      AttachmentNamesBuilt = true;
     }
-    return nullptr;
-  };
-  PdfObject* embeddedFiles =
-    Base->GetNamesTree(false)->GetObject()->MustGetIndirectKey(
-      Name::EMBEDDED_FILES);
-  PdfObject* file;
-  if (embeddedFiles->GetDictionary().HasKey(Name::NAMES) &&
-      embeddedFiles->MustGetIndirectKey(Name::NAMES)->IsArray()) {
-    PdfObject* names = nullptr;
-    names = embeddedFiles->MustGetIndirectKey(Name::NAMES);
-    if ((file = findAttachment(names->GetArray())) != nullptr) {
-      return FileSpec::Constructor.New(
-        { External<PdfObject>::New(info.Env(), file) });
+    const auto it = AttachmentNames.find(name);
+    if (it == AttachmentNames.end()) {
+      return nullptr;
     }
+    const auto spec = Base->GetObjects()->GetObject(it->second);
+    if (named(spec)) {
+      // Some writers use /Type /F, FileSpec expects /Filespec
+      spec->GetDictionary().AddKey(Name::TYPE, PdfName(Name::FILESPEC));
+      return spec;
+    }
+    AttachmentNamesBuilt = false;
   }
-  if (embeddedFiles->GetDictionary().HasKey(Name::KIDS)) {
-    for (auto& i : embeddedFiles->MustGetIndirectKey(Name::KIDS)->GetArray()) {
-      PdfObject* names = nullptr;
-      PdfObject* kid =
-        i.IsReference() ? Base->GetObjects()->GetObject(i.GetReference()) : &i;
-      if (kid->GetDictionary().HasKey(Name::NAMES) ||
-          !kid->MustGetIndirectKey(Name::NAMES)->IsArray()) {
-        names = kid->MustGetIndirectKey(Name::NAMES);
-      } else {
-        break;
+  return nullptr;
+}
+
+namespace {
+
+// The last path component of an attachment's /UF or /F name, files written
+// by extractAll never leave the destination directory
+string
+AttachmentFileName(const PdfVecObjects& objects, const PdfObject& spec)
+{
+  string name;
+  for (const auto& key : { Name::UF, Name::F }) {
+    auto value = spec.GetDictionary().GetKey(key);
+    if (value && value->IsReference()) {
+      value = objects.GetObject(value->GetReference());
+    }
+    if (value && value->IsString()) {
+      name = value->GetString().GetStringUtf8();
+      break;
+    }
+  }
+  const auto separator = name.find_last_of("/\\");
+  if (separator != string::npos) {
+    name = name.substr(separator + 1);
+  }
+  if (name.empty() || name == "." || name == "..") {
+    name = "attachment";
+  }
+  return name;
+}
+
+// Names that differ only in ASCII case are the same file on case
+// insensitive file systems (Windows, macOS)
+string
+FoldCase(string name)
+{
+  std::transform(name.begin(), name.end(), name.begin(), [](char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+  });
+  return name;
+}
+
+struct Extraction
+{
+  string Path;
+  std::unique_ptr<EmbeddedFileDecoder> Decoder;
+  string Failure;
+};
+
+/**
+ * Decodes every embedded file into its own file on up to threads worker
+ * threads. Resolves to the written paths in /EmbeddedFiles order.
+ */
+class ExtractAllAsync final : public AsyncWorker
+{
+public:
+  ExtractAllAsync(const Object& doc,
+                  vector<Extraction> files,
+                  unsigned int threads)
+    : AsyncWorker(doc.Env(), "extract_all_async")
+    , Deferred(Promise::Deferred::New(doc.Env()))
+    , Doc(Persistent(doc))
+    , Files(std::move(files))
+    , Threads(threads)
+  {}
+  Promise GetPromise() { return Deferred.Promise(); }
+
+protected:
+  void Execute() override
+  {
+    ParallelFor(Files.size(), Threads, [this](size_t i) {
+      auto& file = Files[i];
+      try {
+        PdfFileOutputStream out(file.Path.c_str());
+        file.Decoder->Decode(out);
+      } catch (PdfError& err) {
+        std::remove(file.Path.c_str());
+        file.Failure = ErrorHandler::WriteMsg(err);
+      }
+    });
+    for (const auto& file : Files) {
+      if (!file.Failure.empty()) {
+        SetError(file.Path + ": " + file.Failure);
+        return;
+      }
+    }
+  }
+  void OnOK() override
+  {
+    HandleScope scope(Env());
+    auto result = Array::New(Env(), Files.size());
+    for (uint32_t i = 0; i < Files.size(); i++) {
+      result.Set(i, String::New(Env(), Files[i].Path));
+    }
+    Deferred.Resolve(result);
+  }
+  void OnError(const Napi::Error& err) override
+  {
+    Deferred.Reject(err.Value());
+  }
+
+private:
+  Promise::Deferred Deferred;
+  // the decoders borrow the document's stream data
+  ObjectReference Doc;
+  vector<Extraction> Files;
+  unsigned int Threads;
+};
+}
+
+/**
+ * extractAll(dir, opts?) writes every embedded file of /EmbeddedFiles into
+ * dir, decoding up to opts.threads files in parallel. Files are named by the
+ * last component of their /UF (or /F) name, repeated names, compared
+ * ignoring case, get a -n suffix.
+ */
+JsValue
+BaseDocument::ExtractAll(const CallbackInfo& info)
+{
+  if (info.Length() < 1 || !info[0].IsString()) {
+    throw TypeError::New(info.Env(), "extractAll expects a directory path");
+  }
+  auto dir = info[0].As<String>().Utf8Value();
+  if (!dir.empty() && dir.back() != '/' && dir.back() != '\\') {
+    dir += '/';
+  }
+  unsigned int threads = 0;
+  if (info.Length() >= 2 && info[1].IsObject()) {
+    auto opts = info[1].As<Object>();
+    if (opts.Has("threads") && opts.Get("threads").IsNumber()) {
+      threads = opts.Get("threads").As<Number>().Uint32Value();
+    }
+  }
+  vector<Extraction> files;
+  try {
+    const auto names = Base->GetNamesTree(false);
+    const auto tree = names && names->GetObject()
+                        ? names->GetObject()->GetIndirectKey(
+                            Name::EMBEDDED_FILES)
+                        : nullptr;
+    if (tree && tree->IsDictionary()) {
+      const auto& objects = *Base->GetObjects();
+      NameTree::Entries entries;
+      NameTree::Collect(objects, *tree, entries);
+      std::unordered_set<string> used;
+      for (const auto& entry : entries) {
+        const PdfObject* spec = &entry.second;
+        if (spec->IsReference()) {
+          spec = objects.GetObject(spec->GetReference());
+        }
+        const auto file =
+          spec ? EmbeddedFileDecoder::EmbeddedFile(&objects, *spec) : nullptr;
+        if (!file) {
+          continue;
+        }
+        const auto name = AttachmentFileName(objects, *spec);
+        const auto dot = name.find_last_of('.');
+        auto unique = name;
+        for (int n = 1; used.count(FoldCase(unique)); n++) {
+          const auto suffix = "-" + std::to_string(n);
+          unique = dot == string::npos || dot == 0
+                     ? name + suffix
+                     : name.substr(0, dot) + suffix + name.substr(dot);
+        }
+        used.insert(FoldCase(unique));
+        Extraction extraction;
+        extraction.Path = dir + unique;
+        extraction.Decoder.reset(new EmbeddedFileDecoder(*file));
+        files.push_back(std::move(extraction));
       }
-      if ((file = findAttachment(names->GetArray())) != nullptr) {
-        return FileSpec::Constructor.New(
-          { External<PdfObject>::New(info.Env(), file) });
+    }
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+    return info.Env().Undefined();
+  }
+  auto worker =
+    new ExtractAllAsync(info.This().As<Object>(), std::move(files), threads);
+  worker->Queue();
+  return worker->GetPromise();
+}
+/**
+ * addAnnotations(type, pages, rects, opts?) creates one annotation of type
+ * per rect on the page of the same index in the pages Uint32Array, see
+ * Page.addAnnotations. Returns the number of annotations created.
+ */
+JsValue
+BaseDocument::AddAnnotations(const CallbackInfo& info)
+{
+  const auto type = AnnotationBatch::ParseType(info[0]);
+  if (!info[1].IsTypedArray() ||
+      info[1].As<TypedArray>().TypedArrayType() != napi_uint32_array) {
+    throw TypeError::New(info.Env(), "pages must be a Uint32Array");
+  }
+  const auto pageArray = info[1].As<Uint32Array>();
+  const uint32_t* pages = pageArray.Data();
+  const auto rects = AnnotationBatch::ParseRects(info[2]);
+  const auto count = rects.ElementLength() / 4;
+  if (pageArray.ElementLength() != count) {
+    throw RangeError::New(info.Env(), "pages requires one page per rect");
+  }
+  const auto pageCount = static_cast<uint32_t>(Base->GetPageCount());
+  for (size_t i = 0; i < count; i++) {
+    if (pages[i] >= pageCount) {
+      throw RangeError::New(info.Env(), "page index out of range");
+    }
+  }
+  const auto style = info.Length() >= 4 && info[3].IsObject()
+                       ? AnnotationStyle::Parse(info[3].As<Object>(), count)
+                       : AnnotationStyle();
+  try {
+    // one batch per run of rects on the same page
+    for (size_t start = 0, end = 0; start < count; start = end) {
+      while (end < count && pages[end] == pages[start]) {
+        ++end;
       }
+      AnnotationBatch::Add(*Base->GetObjects(),
+                           *Base->GetPage(static_cast<int>(pages[start])),
+                           type,
+                           rects.Data() + start * 4,
+                           end - start,
+                           style,
+                           start);
+    }
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+    return info.Env().Undefined();
+  }
+  return Number::New(info.Env(), count);
+}
+
+/**
+ * getAnnotations(opts?) returns the annotation geometry of every page, see
+ * Page.getAnnotations. Pages are loaded on the calling thread and read in
+ * parallel on up to opts.threads threads.
+ */
+JsValue
+BaseDocument::GetAnnotations(const CallbackInfo& info)
+{
+  const auto types = AnnotationBatch::ParseTypes(info[0]);
+  unsigned int threads = 0;
+  if (info[0].IsObject()) {
+    auto opts = info[0].As<Object>();
+    if (opts.Has("threads") && opts.Get("threads").IsNumber()) {
+      threads = opts.Get("threads").As<Number>().Uint32Value();
+    }
+  }
+  try {
+    const auto& objects = *Base->GetObjects();
+    vector<vector<const PdfObject*>> annotations(
+      static_cast<size_t>(Base->GetPageCount()));
+    for (size_t i = 0; i < annotations.size(); i++) {
+      annotations[i] = AnnotationGeometry::Annotations(
+        objects, *Base->GetPage(static_cast<int>(i)));
     }
+    vector<AnnotationGeometry> geometry(annotations.size());
+    ParallelFor(annotations.size(), threads, [&](size_t i) {
+      geometry[i] = AnnotationGeometry::Read(objects, annotations[i], types);
+    });
+    auto result = Napi::Array::New(info.Env(), geometry.size());
+    for (uint32_t i = 0; i < geometry.size(); i++) {
+      result.Set(i, geometry[i].ToJS(info.Env()));
+    }
+    return result;
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
   }
-  return info.Env().Null();
+  return info.Env().Undefined();
 }
+
 void
 BaseDocument::AddNamedDestination(const Napi::CallbackInfo& info)
 {
@@ -617,8 +1199,8 @@ BaseDocument::AddNamedDestination(const Napi::CallbackInfo& info)
   const auto fit =
     static_cast<EPdfDestinationFit>(info[1].As<Number>().Int32Value());
   const auto name = info[2].As<String>().Utf8Value();
-  const auto destination = new PdfDestination(&page, fit);
-  Base->AddNamedDestination(*destination, name);
+  const PdfDestination destination(&page, fit);
+  Base->AddNamedDestination(destination, name);
 }
 
 JsValue
@@ -652,7 +1234,9 @@ BaseDocument::CreateFontSubset(const Napi::CallbackInfo& info)
     return info.Env().Undefined();
   }
   const auto font = CreateFontObject(info.Env(), info[0].As<Object>(), true);
-  return Font::Constructor.New({ External<PdfFont>::New(info.Env(), font) });
+  return Font::Constructor.New(
+    { External<PdfFont>::New(info.Env(), font),
+      External<BaseDocument>::New(info.Env(), this) });
 }
 PdfFont*
 BaseDocument::CreateFontObject(napi_env env, Napi::Object opts, bool subset)
@@ -20,10 +20,17 @@
 #ifndef NPDF_BASEDOCUMENT_H
 #define NPDF_BASEDOCUMENT_H
 
+#include "FieldIndex.h"
+#include "PageIndex.h"
+#include "TextLayout.h"
 #include <iostream>
+#include <memory>
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 using std::cout;
 using std::endl;
@@ -33,6 +40,36 @@ using JsValue = Napi::Value;
 
 namespace NoPoDoFo {
 
+class EmbeddedFileEncoder;
+class BaseDocument;
+
+/**
+ * Base of the PdfDocument created by a BaseDocument, the BaseDocument of an
+ * object is found through its owner's parent document.
+ */
+class DocumentOwner
+{
+public:
+  explicit DocumentOwner(BaseDocument* owner)
+    : Owner(owner)
+  {}
+  virtual ~DocumentOwner() = default;
+  BaseDocument* const Owner;
+};
+
+template<class T>
+class OwnedDocument final
+  : public T
+  , public DocumentOwner
+{
+public:
+  template<class... Args>
+  explicit OwnedDocument(BaseDocument* owner, Args&&... args)
+    : T(std::forward<Args>(args)...)
+    , DocumentOwner(owner)
+  {}
+};
+
 class BaseDocument
 {
 public:
@@ -40,6 +77,8 @@ public:
   explicit BaseDocument(const BaseDocument&) = delete;
   const BaseDocument& operator=(const BaseDocument&) = delete;
   virtual ~BaseDocument();
+  // The BaseDocument owning objects, nullptr if they do not belong to one
+  static BaseDocument* Of(const PoDoFo::PdfVecObjects* objects);
   JsValue GetPageCount(const Napi::CallbackInfo&);
   virtual JsValue GetPage(const Napi::CallbackInfo&);
   JsValue GetObjects(const Napi::CallbackInfo&);
@@ -61,6 +100,7 @@ public:
   void SetPrintingScale(const Napi::CallbackInfo&, const JsValue&);
   void SetLanguage(const Napi::CallbackInfo&, const JsValue&);
   void AttachFile(const Napi::CallbackInfo&);
+  JsValue AttachStream(const Napi::CallbackInfo&);
   JsValue GetVersion(const Napi::CallbackInfo&);
   JsValue IsLinearized(const Napi::CallbackInfo&);
   JsValue GetWriteMode(const Napi::CallbackInfo&);
@@ -73,20 +113,54 @@ public:
   JsValue InsertPage(const Napi::CallbackInfo&);
   virtual void Append(const Napi::CallbackInfo&);
   JsValue GetAttachment(const Napi::CallbackInfo&);
+  // Registered by Document only, a StreamDocument has already written out
+  // the embedded files' data
+  JsValue ExtractAll(const Napi::CallbackInfo&);
+  JsValue AddAnnotations(const Napi::CallbackInfo&);
+  JsValue GetAnnotations(const Napi::CallbackInfo&);
   void AddNamedDestination(const Napi::CallbackInfo&);
+  PoDoFo::PdfObject* FinishAttachment(EmbeddedFileEncoder&);
   JsValue CreateXObject(const Napi::CallbackInfo&);
 
   PoDoFo::PdfDocument* Base;
   PoDoFo::PdfRefCountedBuffer* StreamDocRefCountedBuffer = nullptr;
   PoDoFo::PdfOutputDevice* StreamDocOutputDevice = nullptr;
+  PoDoFo::PdfEncrypt* StreamDocEncrypt = nullptr;
   string Output;
+  // Classic output of a StreamDocument repacked into Output on close
+  string Spool;
+  bool ObjectStreams = false;
+  bool Linearize = false;
+  // Set when a StreamDocument is closed, pending attachments are rejected
+  bool Closed = false;
+  // Streamed to Spool or memory and rewritten by Writer when closed
+  bool RepackOnClose() const { return ObjectStreams || Linearize; }
+  // Image XObjects embedded in this document by ImageCache key
+  std::unordered_map<string, PoDoFo::PdfReference> Images;
+  // Image XObjects wrapped by more than one Image, copied on first change
+  std::set<PoDoFo::PdfReference> SharedImages;
+  // AcroForm fields by fully qualified name, built on first lookup
+  FieldIndex Fields;
+  // Page dictionaries in page order, built on first use, and the PdfPage of
+  // every Page wrapper
+  PageIndex PageOrder;
+  // Objects removed from the document that wrappers may still point at,
+  // freed with the document
+  std::vector<std::unique_ptr<PoDoFo::PdfObject>> Retired;
+  // Width tables and broken lines of the fonts owned by this document
+  TextLayout Layout;
+  // Embedded file specifications by /UF, for getAttachment names that are
+  // not a key of /EmbeddedFiles. Rebuilt when a hit is stale.
+  std::unordered_map<string, PoDoFo::PdfReference> AttachmentNames;
+  bool AttachmentNamesBuilt = false;
 
 protected:
   PoDoFo::PdfFont* CreateFontObject(napi_env, Napi::Object, bool subset);
+  PoDoFo::PdfObject* AttachmentByName(const PoDoFo::PdfObject& files,
+                                      const string& name);
   std::string Pwd;
   vector<PoDoFo::PdfObject*> Copies;
 
-	std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
@@ -18,9 +18,9 @@
  */
 
 #include "Button.h"
+#include "../Logger.h"
 #include "Field.h"
 #include <iostream>
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -32,12 +32,11 @@ namespace NoPoDoFo {
 Button::Button(PdfField& field)
 {
   Btn = new PdfButton(field);
-  DbgLog = spdlog::get("DbgLog");
 }
 
 Button::~Button()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Button Cleanup");
+  NPDF_LOG_DEBUG("Button Cleanup");
   delete Btn;
 }
 JsValue
@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using JsValue = Napi::Value;
 
@@ -41,7 +40,6 @@ public:
   PoDoFo::PdfButton* Btn;
 
 protected:
-	std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_BUTTON_H
@@ -20,7 +20,6 @@
 #include "CheckBox.h"
 #include "Field.h"
 #include <iostream>
-#include <spdlog/spdlog.h>
 
 
 namespace NoPoDoFo {
@@ -20,7 +20,6 @@
 #include "ComboBox.h"
 #include "Field.h"
 #include <iostream>
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -0,0 +1,311 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CommandBuffer.h"
+#include "ExtGState.h"
+#include "Font.h"
+#include "Image.h"
+#include <string>
+
+using namespace Napi;
+using namespace PoDoFo;
+
+using std::string;
+using std::to_string;
+using std::vector;
+
+namespace NoPoDoFo {
+
+// operand count of every PainterOp, in enum order
+static const uint8_t Arity[] = { 2, 2, 6, 1, 1, 4, 4, 7, 0, 0, 4, 4, 3, 0, 0,
+                                 0, 0, 0, 0, 0, 3, 3, 1, 1, 4, 4, 1, 2, 1, 1,
+                                 1, 4, 1, 1, 4, 3, 5, 7, 5, 2, 2, 1, 0 };
+static_assert(sizeof(Arity) == static_cast<size_t>(PainterOp::Count),
+              "every PainterOp requires an operand count");
+
+void
+CommandBuffer::Validate(const Napi::Value& ops,
+                        const Napi::Value& operands,
+                        const string& method)
+{
+  if (!ops.IsTypedArray() || !operands.IsTypedArray() ||
+      ops.As<TypedArray>().TypedArrayType() != napi_uint8_array ||
+      operands.As<TypedArray>().TypedArrayType() != napi_float64_array) {
+    throw TypeError::New(
+      ops.Env(),
+      method + " requires an opcode Uint8Array and an operand Float64Array");
+  }
+}
+
+vector<PdfString>
+CommandBuffer::Strings(const Napi::Array& js)
+{
+  vector<PdfString> strings;
+  strings.reserve(js.Length());
+  for (uint32_t i = 0; i < js.Length(); i++) {
+    if (!js.Get(i).IsString()) {
+      throw TypeError::New(js.Env(), "string table must contain strings");
+    }
+    string text = js.Get(i).As<String>().Utf8Value();
+    strings.emplace_back(reinterpret_cast<const pdf_utf8*>(text.c_str()));
+  }
+  return strings;
+}
+
+vector<PainterResource>
+CommandBuffer::Resources(const Napi::Array& js)
+{
+  vector<PainterResource> resources(js.Length());
+  for (uint32_t i = 0; i < js.Length(); i++) {
+    auto item = js.Get(i);
+    if (!item.IsObject()) {
+      throw TypeError::New(js.Env(),
+                           "resources must be Font, ExtGState or Image");
+    }
+    auto o = item.As<Object>();
+    if (o.InstanceOf(Font::Constructor.Value())) {
+      resources[i].Font = &Font::Unwrap(o)->GetFont();
+    } else if (o.InstanceOf(ExtGState::Constructor.Value())) {
+      resources[i].State = ExtGState::Unwrap(o)->GetExtGState();
+    } else if (o.InstanceOf(Image::Constructor.Value())) {
+      resources[i].Image = &Image::Unwrap(o)->GetImage();
+    } else {
+      throw TypeError::New(js.Env(),
+                           "resources must be Font, ExtGState or Image");
+    }
+  }
+  return resources;
+}
+
+void
+CommandBuffer::Run(const Napi::Env& env,
+                   PdfPainter& painter,
+                   const uint8_t* ops,
+                   size_t opCount,
+                   const double* args,
+                   size_t argCount,
+                   const vector<PdfString>& strings,
+                   const vector<PainterResource>& resources)
+{
+  size_t a = 0;
+  size_t i = 0;
+
+  auto text = [&](double index) -> const PdfString& {
+    if (!(index >= 0 && index < strings.size())) {
+      throw RangeError::New(
+        env, "op " + to_string(i) + ": string table index out of range");
+    }
+    return strings[static_cast<size_t>(index)];
+  };
+  auto resource = [&](double index) -> const PainterResource& {
+    if (!(index >= 0 && index < resources.size())) {
+      throw RangeError::New(
+        env, "op " + to_string(i) + ": resource table index out of range");
+    }
+    return resources[static_cast<size_t>(index)];
+  };
+
+  for (; i < opCount; i++) {
+    if (ops[i] >= static_cast<uint8_t>(PainterOp::Count)) {
+      throw RangeError::New(
+        env, "op " + to_string(i) + ": unknown opcode " + to_string(ops[i]));
+    }
+    if (a + Arity[ops[i]] > argCount) {
+      throw RangeError::New(
+        env, "op " + to_string(i) + ": operand array is too short");
+    }
+    const double* v = args + a;
+    a += Arity[ops[i]];
+    switch (static_cast<PainterOp>(ops[i])) {
+      case PainterOp::MoveTo:
+        painter.MoveTo(v[0], v[1]);
+        break;
+      case PainterOp::LineTo:
+        painter.LineTo(v[0], v[1]);
+        break;
+      case PainterOp::CubicBezierTo:
+        painter.CubicBezierTo(v[0], v[1], v[2], v[3], v[4], v[5]);
+        break;
+      case PainterOp::HorizontalLineTo:
+        painter.HorizontalLineTo(v[0]);
+        break;
+      case PainterOp::VerticalLineTo:
+        painter.VerticalLineTo(v[0]);
+        break;
+      case PainterOp::SmoothCurveTo:
+        painter.SmoothCurveTo(v[0], v[1], v[2], v[3]);
+        break;
+      case PainterOp::QuadCurveTo:
+        painter.QuadCurveTo(v[0], v[1], v[2], v[3]);
+        break;
+      case PainterOp::ArcTo:
+        painter.ArcTo(v[0], v[1], v[2], v[3], v[4], v[5] != 0, v[6] != 0);
+        break;
+      case PainterOp::ClosePath:
+        painter.ClosePath();
+        break;
+      case PainterOp::Close:
+        painter.Close();
+        break;
+      case PainterOp::Rectangle:
+        painter.Rectangle(v[0], v[1], v[2], v[3]);
+        break;
+      case PainterOp::Ellipse:
+        painter.Ellipse(v[0], v[1], v[2], v[3]);
+        break;
+      case PainterOp::Circle:
+        painter.Circle(v[0], v[1], v[2]);
+        break;
+      case PainterOp::Stroke:
+        painter.Stroke();
+        break;
+      case PainterOp::Fill:
+        painter.Fill();
+        break;
+      case PainterOp::FillAndStroke:
+        painter.FillAndStroke();
+        break;
+      case PainterOp::EndPath:
+        painter.EndPath();
+        break;
+      case PainterOp::Clip:
+        painter.Clip();
+        break;
+      case PainterOp::Save:
+        painter.Save();
+        break;
+      case PainterOp::Restore:
+        painter.Restore();
+        break;
+      case PainterOp::SetColor:
+        painter.SetColor(PdfColor(v[0], v[1], v[2]));
+        break;
+      case PainterOp::SetStrokingColor:
+        painter.SetStrokingColor(PdfColor(v[0], v[1], v[2]));
+        break;
+      case PainterOp::SetGrey:
+        painter.SetGray(v[0]);
+        break;
+      case PainterOp::SetStrokingGrey:
+        painter.SetStrokingGray(v[0]);
+        break;
+      case PainterOp::SetColorCMYK:
+        painter.SetColorCMYK(v[0], v[1], v[2], v[3]);
+        break;
+      case PainterOp::SetStrokingColorCMYK:
+        painter.SetStrokingColorCMYK(v[0], v[1], v[2], v[3]);
+        break;
+      case PainterOp::SetStrokeWidth:
+        painter.SetStrokeWidth(v[0]);
+        break;
+      case PainterOp::SetStrokeStyle:
+        painter.SetStrokeStyle(
+          static_cast<EPdfStrokeStyle>(static_cast<int>(v[0])),
+          nullptr,
+          false,
+          v[1],
+          false);
+        break;
+      case PainterOp::SetLineCapStyle:
+        painter.SetLineCapStyle(
+          static_cast<EPdfLineCapStyle>(static_cast<int>(v[0])));
+        break;
+      case PainterOp::SetLineJoinStyle:
+        painter.SetLineJoinStyle(
+          static_cast<EPdfLineJoinStyle>(static_cast<int>(v[0])));
+        break;
+      case PainterOp::SetMiterLimit:
+        painter.SetMiterLimit(v[0]);
+        break;
+      case PainterOp::SetClipRect:
+        painter.SetClipRect(v[0], v[1], v[2], v[3]);
+        break;
+      case PainterOp::SetFont: {
+        auto& r = resource(v[0]);
+        if (!r.Font) {
+          throw TypeError::New(env,
+                               "op " + to_string(i) +
+                                 ": setFont resource is not a Font");
+        }
+        painter.SetFont(r.Font);
+        break;
+      }
+      case PainterOp::SetExtGState: {
+        auto& r = resource(v[0]);
+        if (!r.State) {
+          throw TypeError::New(env,
+                               "op " + to_string(i) +
+                                 ": setExtGState resource is not an "
+                                 "ExtGState");
+        }
+        painter.SetExtGState(r.State);
+        break;
+      }
+      case PainterOp::DrawLine:
+        painter.DrawLine(v[0], v[1], v[2], v[3]);
+        break;
+      case PainterOp::DrawText:
+        painter.DrawText(v[0], v[1], text(v[2]));
+        break;
+      case PainterOp::DrawTextAligned:
+        painter.DrawTextAligned(
+          v[0],
+          v[1],
+          v[2],
+          text(v[4]),
+          static_cast<EPdfAlignment>(static_cast<int>(v[3])));
+        break;
+      case PainterOp::DrawMultiLineText:
+        painter.DrawMultiLineText(
+          v[0],
+          v[1],
+          v[2],
+          v[3],
+          text(v[6]),
+          static_cast<EPdfAlignment>(static_cast<int>(v[4])),
+          static_cast<EPdfVerticalAlignment>(static_cast<int>(v[5])));
+        break;
+      case PainterOp::DrawImage: {
+        auto& r = resource(v[0]);
+        if (!r.Image) {
+          throw TypeError::New(env,
+                               "op " + to_string(i) +
+                                 ": drawImage resource is not an Image");
+        }
+        painter.DrawImage(v[1], v[2], r.Image, v[3], v[4]);
+        break;
+      }
+      case PainterOp::BeginText:
+        painter.BeginText(v[0], v[1]);
+        break;
+      case PainterOp::MoveTextPosition:
+        painter.MoveTextPos(v[0], v[1]);
+        break;
+      case PainterOp::AddText:
+        painter.AddText(text(v[0]));
+        break;
+      case PainterOp::EndText:
+        painter.EndText();
+        break;
+      case PainterOp::Count:
+        break;
+    }
+  }
+}
+}
@@ -0,0 +1,133 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_COMMANDBUFFER_H
+#define NPDF_COMMANDBUFFER_H
+
+#include <napi.h>
+#include <podofo/podofo.h>
+#include <string>
+#include <vector>
+
+namespace NoPoDoFo {
+
+/**
+ * Opcodes of a Painter command buffer, the values must match
+ * NPDFPainterOp in index.js. The operands of each opcode are listed in the
+ * order they are read from the operand array; str and res are indices into
+ * the string and resource tables.
+ */
+enum class PainterOp : uint8_t
+{
+  MoveTo,               // x y
+  LineTo,               // x y
+  CubicBezierTo,        // x1 y1 x2 y2 x3 y3
+  HorizontalLineTo,     // x
+  VerticalLineTo,       // y
+  SmoothCurveTo,        // x1 y1 x2 y2
+  QuadCurveTo,          // x1 y1 x2 y2
+  ArcTo,                // x1 y1 x2 y2 rotation large sweep
+  ClosePath,            //
+  Close,                //
+  Rectangle,            // x y width height
+  Ellipse,              // x y width height
+  Circle,               // x y radius
+  Stroke,               //
+  Fill,                 //
+  FillAndStroke,        //
+  EndPath,              //
+  Clip,                 //
+  Save,                 //
+  Restore,              //
+  SetColor,             // r g b
+  SetStrokingColor,     // r g b
+  SetGrey,              // v
+  SetStrokingGrey,      // v
+  SetColorCMYK,         // c m y k
+  SetStrokingColorCMYK, // c m y k
+  SetStrokeWidth,       // w
+  SetStrokeStyle,       // style scale
+  SetLineCapStyle,      // style
+  SetLineJoinStyle,     // style
+  SetMiterLimit,        // v
+  SetClipRect,          // x y width height
+  SetFont,              // res
+  SetExtGState,         // res
+  DrawLine,             // x1 y1 x2 y2
+  DrawText,             // x y str
+  DrawTextAligned,      // x y width alignment str
+  DrawMultiLineText,    // x y width height alignment vertical str
+  DrawImage,            // res x y scaleX scaleY
+  BeginText,            // x y
+  MoveTextPosition,     // x y
+  AddText,              // str
+  EndText,              //
+  Count
+};
+
+/**
+ * A Font, ExtGState or Image referenced from a command buffer resource table.
+ * Exactly one member is set.
+ */
+struct PainterResource
+{
+  PoDoFo::PdfFont* Font = nullptr;
+  PoDoFo::PdfExtGState* State = nullptr;
+  PoDoFo::PdfImage* Image = nullptr;
+};
+
+/**
+ * Decodes command buffers (see Painter.execute) and drives a PdfPainter.
+ * The tables are resolved once, Run may then be called any number of times.
+ */
+class CommandBuffer
+{
+public:
+  /**
+   * Throws a TypeError unless ops is a Uint8Array and operands a Float64Array
+   */
+  static void Validate(const Napi::Value& ops,
+                       const Napi::Value& operands,
+                       const std::string& method);
+
+  /**
+   * Convert a javascript array of strings to the string table
+   */
+  static std::vector<PoDoFo::PdfString> Strings(const Napi::Array&);
+
+  /**
+   * Unwrap a javascript array of Font, ExtGState and Image instances
+   */
+  static std::vector<PainterResource> Resources(const Napi::Array&);
+
+  /**
+   * Run opCount ops reading their operands from args. Napi::Error is thrown
+   * for malformed buffers, PdfError is left to the caller.
+   */
+  static void Run(const Napi::Env&,
+                  PoDoFo::PdfPainter&,
+                  const uint8_t* ops,
+                  size_t opCount,
+                  const double* args,
+                  size_t argCount,
+                  const std::vector<PoDoFo::PdfString>& strings,
+                  const std::vector<PainterResource>& resources);
+};
+}
+#endif // NPDF_COMMANDBUFFER_H
@@ -18,6 +18,7 @@
  */
 
 #include "Destination.h"
+#include "../Logger.h"
 #include "../base/Dictionary.h"
 
 #include "../ValidateArguments.h"
@@ -25,7 +26,6 @@
 #include "./Page.h"
 #include "./Rect.h"
 #include <iostream>
-#include <spdlog/spdlog.h>
 
 using namespace PoDoFo;
 using namespace Napi;
@@ -34,7 +34,6 @@ using std::cout;
 using std::endl;
 using std::string;
 using std::vector;
-using tl::nullopt;
 
 namespace NoPoDoFo {
 
@@ -43,13 +42,10 @@ FunctionReference Destination::Constructor; // NOLINT
 Destination::Destination(const CallbackInfo& info)
   : ObjectWrap(info)
 {
-  DbgLog = spdlog::get("DbgLog");
-  auto opts = AssertCallbackInfo(
-    info,
-    { { 0, { option(napi_external), option(napi_object) } },
-      { 1, { option(napi_number), option(napi_object), nullopt } },
-      { 2, { option(napi_number), nullopt } },
-      { 3, { option(napi_number), nullopt } } });
+  auto opts = AssertArguments<ArgTypes<napi_external, napi_object>,
+                              ArgTypes<napi_number, napi_object, ArgOmitted>,
+                              ArgTypes<napi_number, ArgOmitted>,
+                              ArgTypes<napi_number, ArgOmitted>>(info);
   // Create a copy of an existing object
   if (opts[0] == 0) {
     Self =
@@ -86,7 +82,7 @@ Destination::Destination(const CallbackInfo& info)
 }
 Destination::~Destination()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Destination Cleanup");
+  NPDF_LOG_DEBUG("Destination Cleanup");
   delete Self;
   Self = nullptr;
 }
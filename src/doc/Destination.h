@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using JsValue = Napi::Value;
 
@@ -48,7 +47,6 @@ public:
   PoDoFo::PdfDestination& GetDestination() const { return *Self; }
   PoDoFo::PdfDestination* Self;
 private:
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 
 }
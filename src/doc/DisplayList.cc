@@ -0,0 +1,159 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DisplayList.h"
+#include "../base/XObject.h"
+
+using namespace Napi;
+using namespace PoDoFo;
+
+using std::vector;
+
+namespace NoPoDoFo {
+
+FunctionReference DisplayList::Constructor; // NOLINT
+
+DisplayList::DisplayList(const CallbackInfo& info)
+  : ObjectWrap(info)
+{
+  if (info.Length() < 1 || !info[0].IsExternal()) {
+    TypeError::New(info.Env(),
+                   "DisplayList is created with Painter.record")
+      .ThrowAsJavaScriptException();
+    return;
+  }
+  Self.reset(info[0].As<External<PdfXObject>>().Data());
+}
+
+void
+DisplayList::Initialize(Napi::Env& env, Napi::Object& target)
+{
+  HandleScope scope(env);
+  Function ctor = DefineClass(
+    env,
+    "DisplayList",
+    { InstanceAccessor("xobject", &DisplayList::GetXObject, nullptr),
+      InstanceAccessor("numberSlots", &DisplayList::GetNumberSlots, nullptr) });
+  Constructor = Napi::Persistent(ctor);
+  Constructor.SuppressDestruct();
+  target.Set("DisplayList", ctor);
+}
+
+JsValue
+DisplayList::GetXObject(const CallbackInfo& info)
+{
+  return XObject::Constructor.New(
+    { External<PdfXObject>::New(info.Env(), Self.get()) });
+}
+
+JsValue
+DisplayList::GetNumberSlots(const CallbackInfo& info)
+{
+  return Number::New(info.Env(), NumberSlots.size());
+}
+
+void
+DisplayList::SetSlots(const Napi::Object& slots)
+{
+  if (!slots.Has("ops") || !slots.Has("operands")) {
+    throw TypeError::New(slots.Env(),
+                         "slots requires ops and operands command buffers");
+  }
+  CommandBuffer::Validate(slots.Get("ops"), slots.Get("operands"), "slots");
+  auto ops = slots.Get("ops").As<Uint8Array>();
+  auto operands = slots.Get("operands").As<Float64Array>();
+  SlotOps.assign(ops.Data(), ops.Data() + ops.ElementLength());
+  SlotOperands.assign(operands.Data(),
+                      operands.Data() + operands.ElementLength());
+  if (slots.Has("numbers") && slots.Get("numbers").IsTypedArray()) {
+    auto numbers = slots.Get("numbers").As<TypedArray>();
+    if (numbers.TypedArrayType() != napi_uint32_array) {
+      throw TypeError::New(slots.Env(), "slots.numbers must be a Uint32Array");
+    }
+    auto positions = numbers.As<Uint32Array>();
+    for (size_t i = 0; i < positions.ElementLength(); i++) {
+      if (positions[i] >= SlotOperands.size()) {
+        throw RangeError::New(slots.Env(),
+                              "slots.numbers position is outside operands");
+      }
+      NumberSlots.push_back(positions[i]);
+    }
+  }
+  if (slots.Has("resources") && slots.Get("resources").IsArray()) {
+    auto resources = slots.Get("resources").As<Array>();
+    SlotResources = CommandBuffer::Resources(resources);
+    SlotResourceRefs = Napi::Persistent(resources.As<Object>());
+  }
+}
+
+// Owner of a resource drawn by the list, null when there is none
+static const PdfVecObjects*
+Owner(const PainterResource& r)
+{
+  if (r.Font) {
+    return r.Font->GetObject()->GetOwner();
+  }
+  if (r.State) {
+    return r.State->GetObject()->GetOwner();
+  }
+  return r.Image ? r.Image->GetObject()->GetOwner() : nullptr;
+}
+
+void
+DisplayList::Draw(const Napi::Env& env,
+                  PdfPainter& painter,
+                  double x,
+                  double y,
+                  const vector<PdfString>& texts,
+                  const vector<double>& numbers)
+{
+  // the list and its slot resources are referenced, not imported, they
+  // must be objects of the document drawn on
+  const PdfVecObjects* owner =
+    painter.GetPage() ? painter.GetPage()->GetContents()->GetOwner() : nullptr;
+  if (owner && Self->GetObject()->GetOwner() != owner) {
+    throw Error::New(env, "DisplayList belongs to another document");
+  }
+  for (const auto& r : SlotResources) {
+    if (owner && Owner(r) && Owner(r) != owner) {
+      throw Error::New(env,
+                       "DisplayList resource belongs to another document");
+    }
+  }
+  painter.DrawXObject(x, y, Self.get());
+  if (SlotOps.empty()) {
+    return;
+  }
+  vector<double> operands(SlotOperands);
+  for (size_t i = 0; i < NumberSlots.size() && i < numbers.size(); i++) {
+    operands[NumberSlots[i]] = numbers[i];
+  }
+  painter.Save();
+  painter.SetTransformationMatrix(1, 0, 0, 1, x, y);
+  CommandBuffer::Run(env,
+                     painter,
+                     SlotOps.data(),
+                     SlotOps.size(),
+                     operands.data(),
+                     operands.size(),
+                     texts,
+                     SlotResources);
+  painter.Restore();
+}
+}
@@ -0,0 +1,76 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_DISPLAYLIST_H
+#define NPDF_DISPLAYLIST_H
+
+#include "CommandBuffer.h"
+#include <napi.h>
+#include <podofo/podofo.h>
+#include <memory>
+#include <vector>
+
+using JsValue = Napi::Value;
+
+namespace NoPoDoFo {
+
+/**
+ * A recorded command buffer stored as a Form XObject (see Painter.record).
+ * Drawing a DisplayList emits a single Do operator, followed by the optional
+ * slot program which is replayed with per draw text and number values.
+ */
+class DisplayList : public Napi::ObjectWrap<DisplayList>
+{
+public:
+  explicit DisplayList(const Napi::CallbackInfo&);
+  explicit DisplayList(const DisplayList&) = delete;
+  const DisplayList& operator=(const DisplayList&) = delete;
+  static Napi::FunctionReference Constructor;
+  static void Initialize(Napi::Env& env, Napi::Object& target);
+  JsValue GetXObject(const Napi::CallbackInfo&);
+  JsValue GetNumberSlots(const Napi::CallbackInfo&);
+
+  /**
+   * Store the slot program { ops, operands, numbers?, resources? }, numbers
+   * are the positions in operands replaced by the number slot values.
+   */
+  void SetSlots(const Napi::Object&);
+
+  /**
+   * Draw the XObject at x, y then run the slot program translated to x, y
+   * with texts as its string table and numbers substituted into its operands.
+   */
+  void Draw(const Napi::Env&,
+            PoDoFo::PdfPainter&,
+            double x,
+            double y,
+            const std::vector<PoDoFo::PdfString>& texts,
+            const std::vector<double>& numbers);
+
+private:
+  std::unique_ptr<PoDoFo::PdfXObject> Self;
+  std::vector<uint8_t> SlotOps;
+  std::vector<double> SlotOperands;
+  std::vector<uint32_t> NumberSlots;
+  std::vector<PainterResource> SlotResources;
+  // keeps the javascript instances behind SlotResources alive
+  Napi::ObjectReference SlotResourceRefs;
+};
+}
+#endif // NPDF_DISPLAYLIST_H
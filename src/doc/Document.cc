@@ -18,17 +18,25 @@
  */
 
 #include "Document.h"
+#include "../Logger.h"
 #include "../Defines.h"
 #include "../ErrorHandler.h"
 #include "../ValidateArguments.h"
+#include "../base/GarbageCollector.h"
 #include "../base/Names.h"
 #include "../base/Obj.h"
+#include "../base/Parallel.h"
+#include "../base/Writer.h"
 #include "Encrypt.h"
 #include "Font.h"
 #include "Form.h"
+#include "ImageOptimizer.h"
 #include "Page.h"
+#include "Redactor.h"
 #include "SignatureField.h"
-#include <spdlog/spdlog.h>
+#include <fstream>
+#include <memory>
+#include <set>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -66,6 +74,9 @@ Document::Initialize(Napi::Env &env, Napi::Object &target)
 											, InstanceMethod("getPageCount", &Document::GetPageCount)
 											, InstanceMethod("getPage", &Document::GetPage)
 											, InstanceMethod("splicePages", &Document::DeletePages)
+											, InstanceMethod("deletePages", &Document::DeletePageList)
+											, InstanceMethod("reorderPages", &Document::ReorderPages)
+											, InstanceMethod("pages", &Document::GetPages)
 											, InstanceMethod("hideToolbar", &Document::SetHideToolbar)
 											, InstanceMethod("hideMenubar", &Document::SetHideMenubar)
 											, InstanceMethod("hideWindowUI", &Document::SetHideWindowUI)
@@ -74,6 +85,7 @@ Document::Initialize(Napi::Env &env, Napi::Object &target)
 											, InstanceMethod("displayDocTitle", &Document::SetDisplayDocTitle)
 											, InstanceMethod("useFullScreen", &Document::SetUseFullScreen)
 											, InstanceMethod("attachFile", &Document::AttachFile)
+											, InstanceMethod("attachStream", &Document::AttachStream)
 											, InstanceMethod("insertExistingPage", &Document::InsertExistingPage)
 											, InstanceMethod("insertPage", &Document::InsertPage)
 											, InstanceMethod("insertPages", &Document::InsertPages)
@@ -91,8 +103,13 @@ Document::Initialize(Napi::Env &env, Napi::Object &target)
 											, InstanceMethod("createPages", &Document::CreatePages)
 											, InstanceMethod("createXObject", &Document::CreateXObject)
 											, InstanceMethod("getAttachment", &Document::GetAttachment)
+											, InstanceMethod("addAnnotations", &Document::AddAnnotations)
+											, InstanceMethod("getAnnotations", &Document::GetAnnotations)
+											, InstanceMethod("extractAll", &Document::ExtractAll)
 											, InstanceMethod("getFont", &Document::GetFont)
 											, InstanceMethod("listFonts", &Document::ListFonts)
+											, InstanceMethod("optimizeImages", &Document::OptimizeImages)
+											, InstanceMethod("redact", &Document::Redact)
 											, InstanceMethod("addNamedDestination", &Document::AddNamedDestination)});
 	Constructor = Napi::Persistent(ctor);
 	Constructor.SuppressDestruct();
@@ -104,7 +121,7 @@ Document::Document(const CallbackInfo &info)
 
 Document::~Document()
 {
-	if(DbgLog != nullptr) DbgLog->debug("Document Cleanup");
+	NPDF_LOG_DEBUG("Document Cleanup");
 }
 
 void
@@ -143,6 +160,202 @@ Document::ListFonts(const CallbackInfo &info)
 	return list;
 }
 
+/**
+ * Downsample and recompress the images drawn on the pages of the document,
+ * returns a report per image
+ */
+JsValue
+Document::OptimizeImages(const CallbackInfo &info)
+{
+	ImageOptimizeOptions options;
+	if (info.Length() > 0 && info[0].IsObject()) {
+		options = ParseImageOptimizeOptions(info[0].As<Object>());
+	}
+	try {
+		auto reports = ImageOptimizer::Document(GetDocument(), options);
+		auto list = Array::New(info.Env(), reports.size());
+		for (uint32_t i = 0; i < reports.size(); i++) {
+			auto o = reports[i].second.ToJS(info.Env());
+			o.Set("object", Number::New(info.Env(), reports[i].first.ObjectNumber()));
+			o.Set("generation", Number::New(info.Env(), reports[i].first.GenerationNumber()));
+			list.Set(i, o);
+		}
+		return list;
+	} catch (PdfError &err) {
+		ErrorHandler(err, info);
+	}
+	return info.Env().Undefined();
+}
+
+/**
+ * redact(pages, rects, opts?) redacts the rects of a Float64Array on the
+ * page at the same index of pages, see Page.redact. Content is read and
+ * replaced on the calling thread, the content of each page is rewritten on
+ * up to opts.threads threads. Returns a report per page of the document.
+ */
+JsValue
+Document::Redact(const CallbackInfo &info)
+{
+	if (!info[0].IsTypedArray() ||
+		info[0].As<TypedArray>().TypedArrayType() != napi_uint32_array) {
+		throw TypeError::New(info.Env(), "pages must be a Uint32Array");
+	}
+	const auto pageArray = info[0].As<Uint32Array>();
+	const uint32_t *pages = pageArray.Data();
+	const auto rects = Redactor::ParseRects(info[1]);
+	if (pageArray.ElementLength() != rects.size()) {
+		throw RangeError::New(info.Env(), "pages requires one page per rect");
+	}
+	const auto options = info.Length() >= 3 && info[2].IsObject()
+		? ParseRedactOptions(info[2].As<Object>())
+		: RedactOptions();
+	auto &doc = GetDocument();
+	const auto pageCount = static_cast<uint32_t>(doc.GetPageCount());
+	vector<vector<PdfRect>> pageRects(pageCount);
+	for (size_t i = 0; i < rects.size(); i++) {
+		if (pages[i] >= pageCount) {
+			throw RangeError::New(info.Env(), "page index out of range");
+		}
+		pageRects[pages[i]].push_back(rects[i]);
+	}
+	try {
+		vector<std::unique_ptr<Redactor>> redactors(pageCount);
+		vector<PdfPage *> targets;
+		vector<Redactor *> work;
+		for (uint32_t i = 0; i < pageCount; i++) {
+			redactors[i] = std::make_unique<Redactor>(std::move(pageRects[i]));
+			if (redactors[i]->Empty()) {
+				continue;
+			}
+			targets.push_back(doc.GetPage(static_cast<int>(i)));
+			redactors[i]->Load(*targets.back());
+			work.push_back(redactors[i].get());
+		}
+		ParallelFor(work.size(), options.Threads, [&](size_t i) {
+			work[i]->Run(options);
+		});
+		const auto references = Redactor::ContentReferences(doc);
+		auto xobjects = Redactor::XObjectReferences(doc);
+		for (size_t i = 0; i < work.size(); i++) {
+			work[i]->Apply(*targets[i],
+			               Redactor::SharedContents(references, *targets[i]),
+			               xobjects);
+		}
+		// streams shared only by redacted pages are used by none of them now
+		Redactor::RemoveUnusedContents(doc, references);
+		auto list = Array::New(info.Env(), pageCount);
+		for (uint32_t i = 0; i < pageCount; i++) {
+			list.Set(i, redactors[i]->Report().ToJS(info.Env()));
+		}
+		return list;
+	} catch (PdfError &err) {
+		ErrorHandler(err, info);
+	}
+	return info.Env().Undefined();
+}
+
+/**
+ * Page indices of a number[] or Uint32Array, each must be below count
+ */
+static vector<uint32_t>
+PageIndices(const Napi::Value &value, uint32_t count)
+{
+	vector<uint32_t> indices;
+	if (value.IsTypedArray() &&
+		value.As<TypedArray>().TypedArrayType() == napi_uint32_array) {
+		const auto array = value.As<Uint32Array>();
+		indices.assign(array.Data(), array.Data() + array.ElementLength());
+	} else if (value.IsArray()) {
+		const auto array = value.As<Array>();
+		for (uint32_t i = 0; i < array.Length(); i++) {
+			const auto item = array.Get(i);
+			if (!item.IsNumber() || item.As<Number>().DoubleValue() < 0) {
+				throw TypeError::New(value.Env(), "page indices must be unsigned integers");
+			}
+			indices.push_back(item.As<Number>().Uint32Value());
+		}
+	} else {
+		throw TypeError::New(value.Env(), "page indices must be a number[] or Uint32Array");
+	}
+	for (const auto i : indices) {
+		if (i >= count) {
+			throw RangeError::New(value.Env(), "page index out of range");
+		}
+	}
+	return indices;
+}
+
+/**
+ * pages() returns every page of the document in page order from the flat
+ * page index, the tree is walked once instead of once per getPage call.
+ */
+JsValue
+Document::GetPages(const CallbackInfo &info)
+{
+	try {
+		auto &doc = GetDocument();
+		const auto count = PageOrder.Pages(doc).size();
+		auto list = Array::New(info.Env(), count);
+		for (uint32_t i = 0; i < count; i++) {
+			list.Set(i, Page::Constructor.New(
+				{External<PdfPage>::New(info.Env(), PageOrder.Page(doc, i))}));
+		}
+		return list;
+	} catch (PdfError &err) {
+		ErrorHandler(err, info);
+	}
+	return info.Env().Undefined();
+}
+
+/**
+ * reorderPages(order) moves the page at order[i] to index i, order must be a
+ * permutation of the page indices. The page tree is rebuilt once, balanced.
+ */
+void
+Document::ReorderPages(const CallbackInfo &info)
+{
+	auto &doc = GetDocument();
+	try {
+		const auto count = static_cast<uint32_t>(PageOrder.Pages(doc).size());
+		const auto order = PageIndices(info[0], count);
+		vector<bool> placed(count, false);
+		for (const auto i : order) {
+			if (placed[i]) {
+				throw RangeError::New(info.Env(), "order must list every page index once");
+			}
+			placed[i] = true;
+		}
+		if (order.size() != count) {
+			throw RangeError::New(info.Env(), "order must list every page index once");
+		}
+		PageOrder.Reorder(doc, order);
+		// fields are indexed by page number
+		Fields.Invalidate();
+	} catch (PdfError &err) {
+		ErrorHandler(err, info);
+	}
+}
+
+/**
+ * deletePages(indices) removes the pages at indices, in any order, from the
+ * page tree and rebuilds it once. Returns the new page count.
+ */
+JsValue
+Document::DeletePageList(const CallbackInfo &info)
+{
+	auto &doc = GetDocument();
+	try {
+		const auto count = static_cast<uint32_t>(PageOrder.Pages(doc).size());
+		const auto indices = PageIndices(info[0], count);
+		PageOrder.Delete(doc, std::set<uint32_t>(indices.begin(), indices.end()));
+		Fields.Invalidate();
+		return Number::New(info.Env(), doc.GetPageCount());
+	} catch (PdfError &err) {
+		ErrorHandler(err, info);
+	}
+	return info.Env().Undefined();
+}
+
 PoDoFo::PdfFont *
 Document::GetPdfFont(PdfMemDocument &doc, string_view id)
 {
@@ -175,7 +388,8 @@ Document::GetFont(const CallbackInfo &info)
 					cout << "WARNING: This is a font subset" << endl;
 				}
 				return Font::Constructor.New(
-					{External<PdfFont>::New(info.Env(), item)});
+					{External<PdfFont>::New(info.Env(), item),
+					 External<BaseDocument>::New(info.Env(), this)});
 			}
 		}
 		return info.Env().Null();
@@ -232,6 +446,7 @@ Document::DeletePages(const CallbackInfo &info)
 	}
 	try {
 		GetDocument().DeletePages(pageIndex, count);
+		PageOrder.Invalidate();
 	} catch (PdfError &err) {
 		ErrorHandler(err, info);
 	} catch (Error &err) {
@@ -283,13 +498,14 @@ Document::GetCatalog(const CallbackInfo &info)
 class DocumentWriteAsync: public AsyncWorker
 {
 public:
-	DocumentWriteAsync(Napi::Function &cb, Document &doc, string arg)
-		: Napi::AsyncWorker(cb, "document_write_async", doc.Value()), Doc(doc), Arg(std::move(arg))
+	DocumentWriteAsync(Napi::Function &cb, Document &doc, string arg, WriteOptions opts)
+		: Napi::AsyncWorker(cb, "document_write_async", doc.Value()), Doc(doc), Arg(std::move(arg)), Opts(opts)
 	{}
 
 private:
 	Document &Doc;
 	string Arg = "";
+	WriteOptions Opts;
 
 protected:
 	void
@@ -297,7 +513,7 @@ protected:
 	{
 		try {
 			PdfOutputDevice device(Arg.c_str());
-			Doc.GetDocument().Write(&device);
+			Writer::WriteDocument(Doc.GetDocument(), &device, Opts);
 		} catch (PdfError &err) {
 			SetError(String::New(Env(), ErrorHandler::WriteMsg(err)));
 		} catch (Napi::Error &err) {
@@ -429,6 +645,13 @@ Document::Load(const CallbackInfo &info)
 		return info.Env().Undefined();
 	}
 	LoadForIncrementalUpdates = forUpdate;
+	// object numbers of the previous contents are reused by the loaded file
+	Images.clear();
+	SharedImages.clear();
+	Fields.Invalidate();
+	PageOrder.Reset();
+	Layout.Clear();
+	AttachmentNamesBuilt = false;
 	worker->Queue();
 
 	return info.Env().Undefined();
@@ -437,20 +660,25 @@ Document::Load(const CallbackInfo &info)
 class DocumentWriteBufferAsync final: public AsyncWorker
 {
 public:
-	DocumentWriteBufferAsync(Function &cb, Document &doc)
-		: AsyncWorker(cb, "document_write_buffer_async", doc.Value()), Doc(doc)
+	DocumentWriteBufferAsync(Function &cb, Document &doc, WriteOptions opts)
+		: AsyncWorker(cb, "document_write_buffer_async", doc.Value()), Doc(doc), Opts(opts)
 	{}
 
 private:
 	Document &Doc;
 	PdfRefCountedBuffer Output;
+	WriteOptions Opts;
 
 protected:
 	void
 	Execute() override
 	{
-		PdfOutputDevice device(&Output);
-		Doc.GetDocument().Write(&device);
+		try {
+			PdfOutputDevice device(&Output);
+			Writer::WriteDocument(Doc.GetDocument(), &device, Opts);
+		} catch (PdfError &err) {
+			SetError(ErrorHandler::WriteMsg(err));
+		}
 	}
 	void
 	OnOK() override
@@ -466,20 +694,31 @@ protected:
 	}
 };
 
+/**
+ * @details Javascript parameters: (destination?: string, opts?: {objectStreams?:
+ * boolean}, cb: Function)
+ * @param info
+ * @return
+ */
 JsValue
 Document::Write(const CallbackInfo &info)
 {
 	try {
-		if (info[0].IsFunction()) {
-			auto cb = info[0].As<Function>();
-			auto *worker = new DocumentWriteBufferAsync(cb, *this);
+		WriteOptions opts;
+		if (info.Length() > 1 && info[info.Length() - 2].IsObject() &&
+			!info[info.Length() - 2].IsFunction()) {
+			opts = ParseWriteOptions(info[info.Length() - 2].As<Object>());
+		}
+		if (info[0].IsFunction() || (info[0].IsObject() && info.Length() == 2 && info[1].IsFunction())) {
+			auto cb = info[info.Length() - 1].As<Function>();
+			auto *worker = new DocumentWriteBufferAsync(cb, *this, opts);
 			worker->Queue();
 			return info.Env().Undefined();
-		} else if (info.Length() == 2 && info[0].IsString() &&
-			info[1].IsFunction()) {
+		} else if (info.Length() >= 2 && info[0].IsString() &&
+			info[info.Length() - 1].IsFunction()) {
 			string arg = info[0].As<String>();
-			auto cb = info[1].As<Function>();
-			DocumentWriteAsync *worker = new DocumentWriteAsync(cb, *this, arg);
+			auto cb = info[info.Length() - 1].As<Function>();
+			DocumentWriteAsync *worker = new DocumentWriteAsync(cb, *this, arg, opts);
 			worker->Queue();
 		} else {
 			throw Error::New(
@@ -493,11 +732,26 @@ Document::Write(const CallbackInfo &info)
 	return Env().Undefined();
 }
 
+/**
+ * Compacts a document: objects unreachable from the trailer and duplicate
+ * streams are dropped and the rest renumbered densely before writing. The
+ * source is a Buffer, a file path or a loaded Document. A loaded Document is
+ * serialized first and compacted from that copy; the PdfMemDocument keeps
+ * pointers into its objects (fonts, pages) so it is never collected in place.
+ */
 class GCAsync: public AsyncWorker
 {
 public:
-	GCAsync(const Function &cb, PdfRefCountedInputDevice *in, string &pwd)
-		: AsyncWorker(cb, "gc_async"), In(in), Pwd(std::move(pwd))
+	GCAsync(const Function &cb, const Buffer<char> &data, string pwd, WriteOptions opts, string output)
+		: AsyncWorker(cb, "gc_async"),
+			In(new PdfRefCountedInputDevice(data.Data(), data.Length())),
+			Pwd(std::move(pwd)), Opts(opts), Output(std::move(output)), SizeBefore(data.Length())
+	{}
+	GCAsync(const Function &cb, string path, string pwd, WriteOptions opts, string output)
+		: AsyncWorker(cb, "gc_async"), Path(std::move(path)), Pwd(std::move(pwd)), Opts(opts), Output(std::move(output))
+	{}
+	GCAsync(const Function &cb, Document &doc, WriteOptions opts, string output)
+		: AsyncWorker(doc.Value(), cb, "gc_async"), Doc(&doc), Opts(opts), Output(std::move(output))
 	{}
 	~GCAsync()
 	{ delete In; }
@@ -507,35 +761,45 @@ protected:
 	Execute() override
 	{
 		try {
-			PdfVecObjects vecObjects;
-			PdfParser parser(&vecObjects);
-			bool incorrect = false;
-			vecObjects.SetAutoDelete(true);
-			do {
-				try {
-					if (!incorrect) {
-						parser.ParseFile(*In, false);
-					} else {
-						parser.SetPassword(Pwd);
-					}
-				} catch (PdfError &e) {
-					if (e.GetError() == ePdfError_InvalidPassword) {
-						incorrect = true;
-					} else {
-						SetError(e.what());
-					}
+			const PdfEncrypt *encrypt = nullptr;
+			if (Doc) {
+				// Serialized without encryption, the document's encryption is
+				// applied to the collected output. The copy is never decrypted and no
+				// key is derived from the password again.
+				auto &doc = Doc->GetDocument();
+				doc.EmbedSubsetFonts();
+				PdfRefCountedBuffer serialized;
+				PdfOutputDevice device(&serialized);
+				Writer writer(&doc.GetObjects(), doc.GetTrailer());
+				writer.SetPdfVersion(doc.GetPdfVersion());
+				writer.Write(&device);
+				In = new PdfRefCountedInputDevice(serialized.GetBuffer(), device.GetLength());
+				SizeBefore = device.GetLength();
+				encrypt = doc.GetEncrypt();
+			} else if (!Path.empty()) {
+				if (!FileAccess(Path)) {
+					SetError("File: " + Path + " not found");
+					return;
 				}
+				std::ifstream file(Path, std::ios::binary | std::ios::ate);
+				SizeBefore = static_cast<size_t>(file.tellg());
+				In = new PdfRefCountedInputDevice(Path.c_str(), "rb");
 			}
-			while (incorrect);
-			PdfWriter writer(&parser);
-			writer.SetPdfVersion(parser.GetPdfVersion());
-			if (parser.GetEncrypted()) {
-				writer.SetEncrypted(*(parser.GetEncrypt()));
-			}
-			PdfOutputDevice device(&CountedBuffer);
-			writer.Write(&device);
+			std::unique_ptr<PdfOutputDevice> device(Output.empty()
+				? new PdfOutputDevice(&CountedBuffer)
+				: new PdfOutputDevice(Output.c_str()));
+			Writer::Rewrite(*In, device.get(), Opts, Pwd, encrypt,
+				[this](PdfVecObjects &objects, PdfObject &trailer) {
+					GarbageCollector collector(objects, trailer);
+					Stats = collector.Collect(Opts.Threads);
+				});
+			SizeAfter = device->GetLength();
 		} catch (PdfError &e) {
-			SetError(e.what());
+			if (e.GetError() == ePdfError_InvalidPassword) {
+				SetError(Pwd.empty() ? "Password required" : "Password Invalid");
+			} else {
+				SetError(ErrorHandler::WriteMsg(e));
+			}
 		}
 	}
 	void
@@ -543,41 +807,72 @@ protected:
 	{
 		HandleScope
 		scope(Env());
-		auto buffer = Buffer<char>::Copy(Env(), CountedBuffer.GetBuffer(), CountedBuffer.GetSize());
-		Callback().Call({Env().Null(), buffer});
+		auto stats = Object::New(Env());
+		stats.Set("objectsRemoved", Number::New(Env(), Stats.Unreachable + Stats.DuplicateStreams));
+		stats.Set("duplicateStreams", Number::New(Env(), Stats.DuplicateStreams));
+		stats.Set("bytesRemoved",
+			Number::New(Env(), SizeBefore > SizeAfter ? SizeBefore - SizeAfter : 0));
+		stats.Set("size", Number::New(Env(), SizeAfter));
+		JsValue result;
+		if (Output.empty()) {
+			result = Buffer<char>::Copy(Env(), CountedBuffer.GetBuffer(), CountedBuffer.GetSize());
+		} else {
+			result = String::New(Env(), Output);
+		}
+		Callback().Call({Env().Null(), result, stats});
 	}
 
 private:
-	PdfRefCountedInputDevice *In;
+	PdfRefCountedInputDevice *In = nullptr;
+	Document *Doc = nullptr;
+	string Path;
 	PdfRefCountedBuffer CountedBuffer;
 	string Pwd;
+	WriteOptions Opts;
+	string Output;
+	GCStats Stats;
+	size_t SizeBefore = 0;
+	size_t SizeAfter = 0;
 };
 
+/**
+ * @note JS Document.gc(source: Buffer | string | Document, pwd?: string,
+ * opts?: {output?: string} & NPDFWriteOptions,
+ * cb: (err, data: Buffer | string, stats) => void)
+ */
 JsValue
 Document::GC(const Napi::CallbackInfo &info)
 {
-	if (info.Length() < 2) {
-		Error::New(info.Env(), "Required parameters: Buffer, [pwd], callback")
-			.ThrowAsJavaScriptException();
+	string usage = "Required parameters: Buffer | string | Document, [pwd], [opts], callback";
+	if (info.Length() < 2 || !info[info.Length() - 1].IsFunction()) {
+		Error::New(info.Env(), usage).ThrowAsJavaScriptException();
+		return info.Env().Undefined();
 	}
 	string pwd;
-	PdfRefCountedInputDevice *in;
+	string output;
+	WriteOptions opts;
 	if (info.Length() > 2 && info[1].IsString()) {
 		pwd = info[1].As<String>().Utf8Value();
-		cout << "PWD: " << pwd << endl;
-	}
-	if (!info[0].IsBuffer()) {
-		Error::New(info.Env(), "Required parameters: Buffer, [pwd], callback")
-			.ThrowAsJavaScriptException();
 	}
-	auto data = info[0].As<Buffer<char>>();
-	in = new PdfRefCountedInputDevice(data.Data(), data.Length());
-	if (!info[info.Length() - 1].IsFunction()) {
-		Error::New(info.Env(), "Required parameters: Buffer, [pwd], callback")
-			.ThrowAsJavaScriptException();
+	if (info.Length() > 2 && info[info.Length() - 2].IsObject() && !info[info.Length() - 2].IsBuffer()) {
+		auto nObj = info[info.Length() - 2].As<Object>();
+		opts = ParseWriteOptions(nObj);
+		if (nObj.Has("output") && nObj.Get("output").IsString()) {
+			output = nObj.Get("output").As<String>().Utf8Value();
+		}
 	}
 	Function cb = info[info.Length() - 1].As<Function>();
-	auto worker = new GCAsync(cb, in, pwd);
+	GCAsync *worker;
+	if (info[0].IsBuffer()) {
+		worker = new GCAsync(cb, info[0].As<Buffer<char>>(), pwd, opts, output);
+	} else if (info[0].IsString()) {
+		worker = new GCAsync(cb, info[0].As<String>().Utf8Value(), pwd, opts, output);
+	} else if (info[0].IsObject() && info[0].As<Object>().InstanceOf(Document::Constructor.Value())) {
+		worker = new GCAsync(cb, *Document::Unwrap(info[0].As<Object>()), opts, output);
+	} else {
+		TypeError::New(info.Env(), usage).ThrowAsJavaScriptException();
+		return info.Env().Undefined();
+	}
 	worker->Queue();
 	return info.Env().Undefined();
 }
@@ -623,6 +918,7 @@ Document::InsertPages(const Napi::CallbackInfo &info)
 	int start = info[1].As<Number>();
 	int end = info[2].As<Number>();
 	GetDocument().InsertPages(pagesDoc, start, end);
+	PageOrder.Invalidate();
 	return Number::New(info.Env(), GetDocument().GetPageCount());
 }
 
@@ -646,7 +942,8 @@ Document::GetSignatures(const CallbackInfo &info)
 	auto js = Array::New(info.Env());
 	uint32_t jsIndex = 0;
 	for (int i = 0; i < Base->GetPageCount(); i++) {
-		auto page = Base->GetPage(i);
+		// the widgets are owned by the page, which must outlive the wrappers
+		auto page = PageOrder.Page(*Base, static_cast<size_t>(i));
 		for (int j = 0; j < page->GetNumFields(); j++) {
 			auto field = page->GetField(j);
 			if (field.GetType() == ePdfField_Signature) {
@@ -55,6 +55,9 @@ public:
   JsValue Load(const CallbackInfo&);
   JsValue CreatePage(const CallbackInfo&) override;
   void DeletePages(const CallbackInfo&);
+  JsValue DeletePageList(const CallbackInfo&);
+  void ReorderPages(const CallbackInfo&);
+  JsValue GetPages(const CallbackInfo&);
   void SetPassword(const CallbackInfo&);
   JsValue Write(const CallbackInfo&);
   void SetEncrypt(const CallbackInfo&, const JsValue&);
@@ -65,6 +68,8 @@ public:
   JsValue HasSignature(const CallbackInfo&);
   JsValue GetFont(const CallbackInfo&);
   JsValue ListFonts(const CallbackInfo&);
+  JsValue OptimizeImages(const CallbackInfo&);
+  JsValue Redact(const CallbackInfo&);
   JsValue GetSignatures(const CallbackInfo&);
   bool LoadedForIncrementalUpdates() const { return LoadForIncrementalUpdates; }
   inline PdfMemDocument& GetDocument() const
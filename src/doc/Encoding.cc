@@ -18,10 +18,10 @@
  */
 
 #include "Encoding.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "../base/Dictionary.h"
 #include "Font.h"
-#include <spdlog/spdlog.h>
 
 using namespace PoDoFo;
 using namespace Napi;
@@ -36,16 +36,15 @@ Encoding::Encoding(const Napi::CallbackInfo& info)
   : ObjectWrap(info)
   , Self(info[0].As<External<PdfEncoding>>().Data())
 {
-  DbgLog = spdlog::get("DbgLog");
 }
 Encoding::~Encoding()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Encoding Cleanup");
+  NPDF_LOG_DEBUG("Encoding Cleanup");
   if (!Self->IsAutoDelete()) {
-    if(DbgLog != nullptr) DbgLog->debug("Encoding is NOT auto deleted, deleting now");
+    NPDF_LOG_DEBUG("Encoding is NOT auto deleted, deleting now");
     delete Self;
   } else {
-    if(DbgLog != nullptr) DbgLog->debug("Encoding is an auto deleted object, nothing deleted");
+    NPDF_LOG_DEBUG("Encoding is an auto deleted object, nothing deleted");
   }
 }
 void
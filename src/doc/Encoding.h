@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using JsValue = Napi::Value;
 
@@ -42,7 +41,6 @@ public:
 
 private:
   const PoDoFo::PdfEncoding* Self;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_ENCODING_H
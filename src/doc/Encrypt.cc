@@ -18,10 +18,10 @@
  */
 
 #include "Encrypt.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "Document.h"
 #include <algorithm>
-#include <spdlog/spdlog.h>
 #include <sstream>
 
 using namespace Napi;
@@ -65,12 +65,11 @@ Encrypt::Encrypt(const Napi::CallbackInfo& info)
   Error::New(info.Env(), "This build does not include OpenSSL")
     .ThrowAsJavaScriptException();
 #endif
-  DbgLog = spdlog::get("DbgLog");
 }
 
 Encrypt::~Encrypt()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Encrypt Cleanup");
+  NPDF_LOG_DEBUG("Encrypt Cleanup");
 }
 
 void
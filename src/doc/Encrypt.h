@@ -24,7 +24,6 @@
 #include <podofo/podofo.h>
 
 #include <iostream>
-#include <spdlog/logger.h>
 using std::cout;
 using std::endl;
 using JsValue = Napi::Value;
@@ -49,7 +48,6 @@ public:
 
   const PoDoFo::PdfEncrypt* Self;
 private:
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
@@ -18,11 +18,11 @@
  */
 
 #include "ExtGState.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "Document.h"
 #include "StreamDocument.h"
 #include <algorithm>
-#include <spdlog/spdlog.h>
 
 namespace NoPoDoFo {
 
@@ -39,7 +39,6 @@ FunctionReference ExtGState::Constructor; // NOLINT
 ExtGState::ExtGState(const Napi::CallbackInfo& info)
   : ObjectWrap(info)
 {
-  DbgLog = spdlog::get("DbgLog");
   auto o = info[0].As<Object>();
   if (o.InstanceOf(Document::Constructor.Value())) {
     auto d = Document::Unwrap(o);
@@ -57,7 +56,7 @@ ExtGState::ExtGState(const Napi::CallbackInfo& info)
 
 ExtGState::~ExtGState()
 {
-  if(DbgLog != nullptr) DbgLog->debug("ExtGState Cleanup");
+  NPDF_LOG_DEBUG("ExtGState Cleanup");
 }
 
 void
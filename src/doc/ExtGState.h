@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using JsValue = Napi::Value;
 
@@ -50,7 +49,6 @@ public:
 
 private:
   std::unique_ptr<PoDoFo::PdfExtGState> Self;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
@@ -18,16 +18,22 @@
  */
 
 #include "Field.h"
+#include "../Logger.h"
 #include "../ValidateArguments.h"
 #include "../base/Dictionary.h"
 #include "../base/Names.h"
 #include "../base/Obj.h"
 #include "Action.h"
 #include "Annotation.h"
+#include "CheckBox.h"
+#include "ComboBox.h"
 #include "Document.h"
 #include "Form.h"
+#include "ListBox.h"
 #include "Page.h"
-#include <spdlog/spdlog.h>
+#include "PushButton.h"
+#include "SignatureField.h"
+#include "TextField.h"
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -48,7 +54,6 @@ namespace NoPoDoFo {
  */
 Field::Field(EPdfField type, const CallbackInfo& info)
 {
-  DbgLog = spdlog::get("DbgLog");
   if (info[0].IsExternal()) {
     const auto arg = info[0].As<External<PdfField>>().Data();
     Self = new PdfField(*arg);
@@ -102,7 +107,7 @@ Field::Field(EPdfField type, const CallbackInfo& info)
 
 Field::~Field()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Field Cleanup");
+  NPDF_LOG_DEBUG("Field Cleanup");
   delete Self;
   for (auto c : Children) {
     delete c;
@@ -159,6 +164,10 @@ Field::SetFieldName(const CallbackInfo&, const JsValue& value)
 {
   string name = value.As<String>().Utf8Value();
   GetField().SetFieldName(PdfString(name));
+  const auto doc = BaseDocument::Of(GetField().GetFieldObject()->GetOwner());
+  if (doc) {
+    doc->Fields.Rename(*GetField().GetFieldObject());
+  }
 }
 
 JsValue
@@ -403,6 +412,38 @@ Field::GetFieldObject(const CallbackInfo& info)
     { External<PdfObject>::New(info.Env(), Self->GetFieldObject()) });
 }
 
+JsValue
+Field::Wrap(const Napi::Env& env, PdfField& field)
+{
+  switch (field.GetType()) {
+    case ePdfField_PushButton:
+      return PushButton::Constructor.New(
+        { External<PdfField>::New(env, &field) });
+    case ePdfField_CheckBox:
+      return CheckBox::Constructor.New(
+        { External<PdfField>::New(env, &field) });
+    case ePdfField_RadioButton:
+      Error::New(env, "RadioButton not yet implemented")
+        .ThrowAsJavaScriptException();
+      return env.Undefined();
+    case ePdfField_TextField:
+      return TextField::Constructor.New(
+        { External<PdfField>::New(env, &field) });
+    case ePdfField_ComboBox:
+      return ComboBox::Constructor.New(
+        { External<PdfField>::New(env, &field) });
+    case ePdfField_ListBox:
+      return ListBox::Constructor.New({ External<PdfField>::New(env, &field) });
+    case ePdfField_Signature:
+      return SignatureField::Constructor.New(
+        { External<PdfAnnotation>::New(env, field.GetWidgetAnnotation()) });
+    default:
+      Error::New(env, "Unknown field type").ThrowAsJavaScriptException();
+      return env.Undefined();
+  }
+}
+
+
 std::map<std::string, PoDoFo::PdfObject*>
 Field::GetFieldRefreshKeys(PoDoFo::PdfField* f)
 {
@@ -74,6 +74,8 @@ public:
   void SetJustification(const CallbackInfo&, const Value&);
   JsValue GetFieldObject(const CallbackInfo&);
   virtual void RefreshAppearanceStream();
+  // Create the NoPoDoFo wrapper of the field's type, the field is copied
+  static JsValue Wrap(const Napi::Env&, PdfField&);
   PdfField& GetField() const { return *Self; }
   PdfDictionary& GetFieldDictionary() const
   {
@@ -87,7 +89,6 @@ public:
 
 protected:
   string TypeString();
-	std::shared_ptr<spdlog::logger> DbgLog;
 private:
   PdfField* Self;
   vector<PdfObject*> Children;
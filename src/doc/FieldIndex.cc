@@ -0,0 +1,437 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FieldIndex.h"
+#include "../base/Names.h"
+#include <algorithm>
+
+using namespace PoDoFo;
+
+using std::string;
+using std::vector;
+
+namespace NoPoDoFo {
+
+namespace {
+
+// Annotation reference to its page and position in the page's /Annots
+typedef std::map<PdfReference, std::pair<int, int>> WidgetMap;
+
+const PdfArray*
+Annots(const PdfPage& page)
+{
+  const auto annots = page.GetObject()->GetIndirectKey(Name::ANNOTS);
+  return annots && annots->IsArray() ? &annots->GetArray() : nullptr;
+}
+
+string
+PartialName(const PdfObject& node)
+{
+  const auto t = node.GetIndirectKey(Name::T);
+  return t && (t->IsString() || t->IsHexString())
+           ? t->GetString().GetStringUtf8()
+           : "";
+}
+
+void
+CollectKids(const PdfVecObjects& objects,
+        const WidgetMap& widgets,
+        const PdfArray& kids,
+        const string& prefix,
+        std::set<PdfReference>& visited,
+        vector<FieldIndexEntry>& entries)
+{
+  for (const auto& kid : kids) {
+    if (!kid.IsReference() || !visited.insert(kid.GetReference()).second) {
+      continue;
+    }
+    const auto node = objects.GetObject(kid.GetReference());
+    if (!node || !node->IsDictionary()) {
+      continue;
+    }
+    const auto partial = PartialName(*node);
+    const auto name = partial.empty()
+                        ? prefix
+                        : prefix.empty() ? partial : prefix + "." + partial;
+    // Kids without a partial name are widgets of this field
+    const auto children = node->GetIndirectKey(Name::KIDS);
+    auto terminal = true;
+    if (children && children->IsArray()) {
+      for (const auto& child : children->GetArray()) {
+        const auto c = child.IsReference()
+                         ? objects.GetObject(child.GetReference())
+                         : nullptr;
+        if (c && c->IsDictionary() && c->GetDictionary().HasKey(Name::T)) {
+          terminal = false;
+          break;
+        }
+      }
+    }
+    if (!terminal) {
+      CollectKids(
+        objects, widgets, children->GetArray(), name, visited, entries);
+      continue;
+    }
+    FieldIndexEntry entry;
+    entry.Name = name;
+    entry.Field = kid.GetReference();
+    auto widget = widgets.find(entry.Field);
+    if (widget == widgets.end() && children && children->IsArray()) {
+      for (const auto& child : children->GetArray()) {
+        if (child.IsReference() &&
+            (widget = widgets.find(child.GetReference())) != widgets.end()) {
+          break;
+        }
+      }
+    }
+    if (widget != widgets.end()) {
+      entry.Widget = widget->first;
+      entry.Page = widget->second.first;
+      entry.Annotation = widget->second.second;
+    }
+    entries.push_back(entry);
+  }
+}
+
+// Add node and everything below it through /Kids to removed
+void
+RemoveSubtree(const PdfVecObjects& objects,
+              const PdfReference& ref,
+              std::set<PdfReference>& removed)
+{
+  vector<PdfReference> pending{ ref };
+  while (!pending.empty()) {
+    const auto current = pending.back();
+    pending.pop_back();
+    if (!removed.insert(current).second) {
+      continue;
+    }
+    const auto node = objects.GetObject(current);
+    const auto kids =
+      node && node->IsDictionary() ? node->GetIndirectKey(Name::KIDS) : nullptr;
+    if (kids && kids->IsArray()) {
+      for (const auto& kid : kids->GetArray()) {
+        if (kid.IsReference()) {
+          pending.push_back(kid.GetReference());
+        }
+      }
+    }
+  }
+}
+
+// Erase every reference in removed from items, preserving order
+bool
+Compact(PdfArray& items, const std::set<PdfReference>& removed)
+{
+  const auto end =
+    std::remove_if(items.begin(), items.end(), [&removed](const PdfObject& i) {
+      return i.IsReference() && removed.count(i.GetReference());
+    });
+  if (end == items.end()) {
+    return false;
+  }
+  items.erase(end, items.end());
+  return true;
+}
+
+// Post order walk, children are compacted before their parent is examined
+void
+UnlinkKids(const PdfVecObjects& objects,
+           PdfArray& kids,
+           const std::set<PdfReference>& targets,
+           std::set<PdfReference>& visited,
+           std::set<PdfReference>& removed)
+{
+  for (const auto& kid : kids) {
+    if (!kid.IsReference() || !visited.insert(kid.GetReference()).second) {
+      continue;
+    }
+    if (targets.count(kid.GetReference())) {
+      RemoveSubtree(objects, kid.GetReference(), removed);
+      continue;
+    }
+    const auto node = objects.GetObject(kid.GetReference());
+    const auto children =
+      node && node->IsDictionary() ? node->GetIndirectKey(Name::KIDS) : nullptr;
+    if (!children || !children->IsArray() || children->GetArray().empty()) {
+      continue;
+    }
+    auto& array = children->GetArray();
+    UnlinkKids(objects, array, targets, visited, removed);
+    if (Compact(array, removed) && array.empty()) {
+      removed.insert(kid.GetReference());
+    }
+  }
+}
+}
+
+FieldIndex::~FieldIndex()
+{
+  Invalidate();
+}
+
+const FieldIndexEntry*
+FieldIndex::Find(PdfDocument& doc, const string& name)
+{
+  if (!Built) {
+    Build(doc);
+  }
+  auto it = ByName.find(name);
+  if (it != ByName.end() && !Current(doc, Fields.at(it->second))) {
+    Build(doc);
+    it = ByName.find(name);
+  }
+  return it == ByName.end() ? nullptr : &Fields.at(it->second);
+}
+
+vector<string>
+FieldIndex::Names(PdfDocument& doc)
+{
+  if (!Built) {
+    Build(doc);
+  }
+  vector<string> names;
+  names.reserve(ByName.size());
+  for (const auto& ref : Order) {
+    const auto it = Fields.find(ref);
+    if (it != Fields.end() && !it->second.Name.empty()) {
+      names.push_back(it->second.Name);
+    }
+  }
+  return names;
+}
+
+void
+FieldIndex::Invalidate()
+{
+  Built = false;
+  Fields.clear();
+  ByName.clear();
+  Order.clear();
+}
+
+void
+FieldIndex::Add(PdfPage& page, const PdfObject& field)
+{
+  if (!Built || Fields.count(field.Reference())) {
+    return;
+  }
+  FieldIndexEntry entry;
+  entry.Name = QualifiedName(field);
+  entry.Field = field.Reference();
+  entry.Widget = field.Reference();
+  const auto annots = Annots(page);
+  // New widgets are appended, search from the end
+  for (auto i = annots ? static_cast<int>(annots->size()) - 1 : -1; i >= 0;
+       --i) {
+    const auto& item = (*annots)[static_cast<size_t>(i)];
+    if (item.IsReference() && item.GetReference() == entry.Widget) {
+      entry.Page = page.GetPageNumber() - 1;
+      entry.Annotation = i;
+      break;
+    }
+  }
+  Insert(entry);
+}
+
+void
+FieldIndex::Remove(const PdfReference& ref)
+{
+  if (!Built) {
+    return;
+  }
+  auto it = Fields.find(ref);
+  if (it == Fields.end()) {
+    // ref is one widget of a field with separate widget annotations, the
+    // field and its remaining widgets may or may not still exist
+    Invalidate();
+    return;
+  }
+  const auto removed = it->second;
+  Fields.erase(it);
+  const auto named = ByName.find(removed.Name);
+  if (named != ByName.end() && named->second == removed.Field) {
+    ByName.erase(named);
+  }
+  if (removed.Page < 0) {
+    return;
+  }
+  // Widgets after the deleted one moved down in the page's /Annots
+  for (auto& field : Fields) {
+    if (field.second.Page == removed.Page &&
+        field.second.Annotation > removed.Annotation) {
+      --field.second.Annotation;
+    }
+  }
+}
+
+void
+FieldIndex::Rename(const PdfObject& field)
+{
+  if (!Built) {
+    return;
+  }
+  const auto it = Fields.find(field.Reference());
+  if (it == Fields.end()) {
+    // A parent was renamed, the names of all of its descendants change
+    Invalidate();
+    return;
+  }
+  const auto named = ByName.find(it->second.Name);
+  if (named != ByName.end() && named->second == it->first) {
+    ByName.erase(named);
+  }
+  it->second.Name = QualifiedName(field);
+  if (!it->second.Name.empty()) {
+    ByName.emplace(it->second.Name, it->first);
+  }
+}
+
+string
+FieldIndex::QualifiedName(const PdfObject& field)
+{
+  string name;
+  const PdfObject* node = &field;
+  // The depth guards against /Parent cycles
+  for (auto depth = 0; node && node->IsDictionary() && depth < 64; ++depth) {
+    const auto partial = PartialName(*node);
+    if (!partial.empty()) {
+      name = name.empty() ? partial : partial + "." + name;
+    }
+    node = node->GetIndirectKey(Name::PARENT);
+  }
+  return name;
+}
+
+vector<FieldIndexEntry>
+FieldIndex::Entries(PdfDocument& doc)
+{
+  WidgetMap widgets;
+  for (auto i = 0; i < doc.GetPageCount(); ++i) {
+    const auto annots = Annots(*doc.GetPage(i));
+    if (!annots) {
+      continue;
+    }
+    for (size_t a = 0; a < annots->size(); ++a) {
+      const auto& item = (*annots)[a];
+      if (item.IsReference()) {
+        widgets.emplace(item.GetReference(),
+                        std::make_pair(i, static_cast<int>(a)));
+      }
+    }
+  }
+  vector<FieldIndexEntry> entries;
+  const auto form = doc.GetAcroForm(false);
+  const auto fields =
+    form ? form->GetObject()->GetIndirectKey(Name::FIELDS) : nullptr;
+  if (!fields || !fields->IsArray()) {
+    return entries;
+  }
+  std::set<PdfReference> visited;
+  CollectKids(
+    *doc.GetObjects(), widgets, fields->GetArray(), "", visited, entries);
+  return entries;
+}
+
+void
+FieldIndex::Build(PdfDocument& doc)
+{
+  Invalidate();
+  const auto entries = Entries(doc);
+  Built = true;
+  for (const auto& entry : entries) {
+    Insert(entry);
+  }
+}
+
+void
+FieldIndex::Insert(const FieldIndexEntry& entry)
+{
+  Fields[entry.Field] = entry;
+  Order.push_back(entry.Field);
+  if (!entry.Name.empty()) {
+    ByName.emplace(entry.Name, entry.Field);
+  }
+}
+
+bool
+FieldIndex::Current(PdfDocument& doc, const FieldIndexEntry& entry) const
+{
+  const auto field = doc.GetObjects()->GetObject(entry.Field);
+  if (!field || QualifiedName(*field) != entry.Name) {
+    return false;
+  }
+  if (entry.Page < 0) {
+    return true;
+  }
+  if (entry.Page >= doc.GetPageCount()) {
+    return false;
+  }
+  const auto annots = Annots(*doc.GetPage(entry.Page));
+  if (!annots || static_cast<size_t>(entry.Annotation) >= annots->size()) {
+    return false;
+  }
+  const auto& item = (*annots)[static_cast<size_t>(entry.Annotation)];
+  return item.IsReference() && item.GetReference() == entry.Widget;
+}
+
+std::set<PdfReference>
+FieldIndex::Unlink(PdfDocument& doc, const std::set<PdfReference>& fields)
+{
+  std::set<PdfReference> removed;
+  const auto form = doc.GetAcroForm(false);
+  if (fields.empty() || !form) {
+    return removed;
+  }
+  const auto dict = &form->GetObject()->GetDictionary();
+  const auto root = dict->GetKey(Name::FIELDS);
+  const auto array =
+    root && root->IsReference()
+      ? doc.GetObjects()->GetObject(root->GetReference())
+      : root;
+  if (!array || !array->IsArray()) {
+    return removed;
+  }
+  std::set<PdfReference> visited;
+  UnlinkKids(
+    *doc.GetObjects(), array->GetArray(), fields, visited, removed);
+  Compact(array->GetArray(), removed);
+  const auto co = dict->GetKey(Name::CO);
+  if (co && co->IsArray()) {
+    Compact(co->GetArray(), removed);
+  }
+  return removed;
+}
+
+void
+FieldIndex::RemoveWidgets(PdfDocument& doc,
+                          const std::set<PdfReference>& removed)
+{
+  if (removed.empty()) {
+    return;
+  }
+  for (auto i = 0; i < doc.GetPageCount(); ++i) {
+    const auto annots = doc.GetPage(i)->GetObject()->GetIndirectKey(
+      Name::ANNOTS);
+    if (annots && annots->IsArray()) {
+      Compact(annots->GetArray(), removed);
+    }
+  }
+}
+}
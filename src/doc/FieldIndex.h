@@ -0,0 +1,103 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_FIELDINDEX_H
+#define NPDF_FIELDINDEX_H
+
+#include <map>
+#include <podofo/podofo.h>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NoPoDoFo {
+
+struct FieldIndexEntry
+{
+  // Fully qualified name, partial names joined by '.'
+  std::string Name;
+  // Terminal field dictionary
+  PoDoFo::PdfReference Field;
+  // Widget annotation, the same object as Field when they are merged
+  PoDoFo::PdfReference Widget;
+  // Page of the widget and its position in the page's /Annots
+  int Page = -1;
+  int Annotation = -1;
+};
+
+/**
+ * Index of the terminal fields of a document's AcroForm, built once from the
+ * /Fields tree and the pages' /Annots instead of rescanning every page for
+ * each lookup. The index is owned by the BaseDocument, Page and Field reach it
+ * through BaseDocument::Of. Fields created, deleted or renamed through
+ * NoPoDoFo update the index incrementally, an entry that no longer matches the document (i.e.
+ * after pages or annotations were removed) rebuilds it on lookup.
+ */
+class FieldIndex
+{
+public:
+  FieldIndex() = default;
+  FieldIndex(const FieldIndex&) = delete;
+  const FieldIndex& operator=(const FieldIndex&) = delete;
+  ~FieldIndex();
+
+  // nullptr if no field has the fully qualified name
+  const FieldIndexEntry* Find(PoDoFo::PdfDocument&, const std::string& name);
+  // Fully qualified names in /Fields order, unnamed fields are skipped
+  std::vector<std::string> Names(PoDoFo::PdfDocument&);
+  void Invalidate();
+
+  void Add(PoDoFo::PdfPage&, const PoDoFo::PdfObject& field);
+  // Remove a field whose widget annotation has been deleted from its page
+  void Remove(const PoDoFo::PdfReference& field);
+  void Rename(const PoDoFo::PdfObject& field);
+
+  static std::string QualifiedName(const PoDoFo::PdfObject& field);
+  // Scan the terminal fields of doc without indexing them, does not touch
+  // any shared state and is safe to call for separate documents in parallel
+  static std::vector<FieldIndexEntry> Entries(PoDoFo::PdfDocument&);
+
+  /**
+   * Remove fields (or individual widgets of a field) from /Fields, the /Kids
+   * of their parents and /CO in one walk, each array is compacted once.
+   * Parents left without kids are removed as well. Returns every removed
+   * node, including the widgets below removed fields; the objects are only
+   * unlinked, not deleted.
+   */
+  static std::set<PoDoFo::PdfReference> Unlink(
+    PoDoFo::PdfDocument&,
+    const std::set<PoDoFo::PdfReference>& fields);
+  // Drop the removed annotations from every page's /Annots in one pass
+  static void RemoveWidgets(PoDoFo::PdfDocument&,
+                            const std::set<PoDoFo::PdfReference>& removed);
+
+private:
+  void Build(PoDoFo::PdfDocument&);
+  void Insert(const FieldIndexEntry&);
+  bool Current(PoDoFo::PdfDocument&, const FieldIndexEntry&) const;
+
+  bool Built = false;
+  std::map<PoDoFo::PdfReference, FieldIndexEntry> Fields;
+  std::unordered_map<std::string, PoDoFo::PdfReference> ByName;
+  // Fields in /Fields order, removed fields are skipped when listed
+  std::vector<PoDoFo::PdfReference> Order;
+};
+}
+#endif // NPDF_FIELDINDEX_H
@@ -18,16 +18,21 @@
  */
 
 #include "FileSpec.h"
+#include "../ErrorHandler.h"
+#include "../Logger.h"
 #include "../base/Names.h"
 #include "../base/Obj.h"
 #include "Document.h"
 #include "StreamDocument.h"
-#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 
 using namespace Napi;
 using namespace PoDoFo;
 
 using std::make_shared;
+using std::shared_ptr;
 using std::string;
 
 namespace NoPoDoFo {
@@ -42,7 +47,8 @@ FileSpec::Initialize(Napi::Env& env, Napi::Object& target)
     DefineClass(env,
                 "FileSpec",
                 { InstanceAccessor("name", &FileSpec::GetFileName, nullptr),
-                  InstanceMethod("getContents", &FileSpec::Data) });
+                  InstanceMethod("getContents", &FileSpec::Data),
+                  InstanceMethod("extractTo", &FileSpec::ExtractTo) });
   Constructor = Napi::Persistent(ctor);
   Constructor.SuppressDestruct();
   target.Set("FileSpec", ctor);
@@ -50,14 +56,26 @@ FileSpec::Initialize(Napi::Env& env, Napi::Object& target)
 FileSpec::FileSpec(const CallbackInfo& info)
   : ObjectWrap<FileSpec>(info)
 {
-  DbgLog = spdlog::get("DbgLog");
-  if (info.Length() == 1 && info[0].IsObject() &&
+  if (info.Length() >= 1 && info[0].IsObject() &&
       info[0].As<Object>().InstanceOf(Obj::Constructor.Value())) {
     Self =
       make_shared<PdfFileSpec>(&Obj::Unwrap(info[0].As<Object>())->GetObject());
-  } else if (info.Length() == 1 && info[0].Type() == napi_external) {
+    if (info.Length() >= 2 && info[1].IsObject()) {
+      auto docObj = info[1].As<Object>();
+      if (!docObj.InstanceOf(Document::Constructor.Value()) &&
+          !docObj.InstanceOf(StreamDocument::Constructor.Value())) {
+        TypeError::New(info.Env(), "2nd argument must be the document")
+          .ThrowAsJavaScriptException();
+        return;
+      }
+      Parent = Persistent(docObj);
+    }
+  } else if (info.Length() >= 1 && info[0].Type() == napi_external) {
     auto pObj = info[0].As<External<PdfObject>>().Data();
     Self = make_shared<PdfFileSpec>(pObj);
+    if (info.Length() >= 2 && info[1].IsObject()) {
+      Parent = Persistent(info[1].As<Object>());
+    }
   } else if (info.Length() >= 2) {
     string file = info[0].As<String>().Utf8Value();
     auto docObj = info[1].As<Object>();
@@ -71,7 +89,9 @@ FileSpec::FileSpec(const CallbackInfo& info)
         info.Env(),
         "Unknown Document type. Requires a Document or StreamDocument")
         .ThrowAsJavaScriptException();
+      return;
     }
+    Parent = Persistent(docObj);
     bool embed = true;
     if (info.Length() >= 3 && info[2].IsBuffer()) {
       embed = info[2].As<Boolean>();
@@ -79,17 +99,17 @@ FileSpec::FileSpec(const CallbackInfo& info)
     Self = make_shared<PdfFileSpec>(file.c_str(), embed, doc, true);
   } else {
     TypeError::New(info.Env(),
-                   "Valid constructor args: [ [Obj], [External<PdfObject>], "
-                   "[string, BaseDocument] ]")
+                   "Valid constructor args: [ [Obj, BaseDocument?], "
+                   "[External<PdfObject>], [string, BaseDocument] ]")
       .ThrowAsJavaScriptException();
   }
 }
 
 FileSpec::~FileSpec()
 {
-  if(DbgLog != nullptr) DbgLog->debug("FileSpec Cleanup");
+  NPDF_LOG_DEBUG("FileSpec Cleanup");
   if(Self.use_count() == 0) {
-  	if(DbgLog != nullptr) DbgLog->debug("FileSpec resource count: {}", Self.use_count());
+  	NPDF_LOG_DEBUG("FileSpec resource count: {}", Self.use_count());
   }
 }
 
@@ -123,4 +143,522 @@ FileSpec::Data(const Napi::CallbackInfo& info)
   }
   return info.Env().Undefined();
 }
+
+EmbeddedFileDecoder::EmbeddedFileDecoder(const PdfObject& file)
+  : Filters(PdfFilterFactory::CreateFilterList(&file))
+  , Dictionary(file.GetDictionary())
+{
+  // PdfStreamedDocument streams are written out as they are created
+  const auto stream = dynamic_cast<const PdfMemStream*>(file.GetStream());
+  if (!stream) {
+    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidStream,
+                            "The embedded file stream is not in memory");
+  }
+  Data = stream->Get();
+  Length = static_cast<size_t>(stream->GetLength());
+}
+
+EmbeddedFileDecoder::~EmbeddedFileDecoder() = default;
+
+bool
+EmbeddedFileDecoder::Next(PdfOutputStream& sink)
+{
+  if (Done) {
+    return false;
+  }
+  if (!Filters.empty() && !Stream) {
+    Stream.reset(
+      PdfFilterFactory::CreateDecodeStream(Filters, &sink, &Dictionary));
+  }
+  PdfOutputStream* out = Stream ? Stream.get() : &sink;
+  const auto size = std::min(ChunkSize, Length - Offset);
+  if (size > 0) {
+    out->Write(Data + Offset, static_cast<pdf_long>(size));
+    Offset += size;
+  }
+  if (Offset == Length) {
+    // closing the filter chain flushes the filters and closes the sink
+    out->Close();
+    Done = true;
+  }
+  return !Done;
+}
+
+void
+EmbeddedFileDecoder::Decode(PdfOutputStream& sink)
+{
+  while (Next(sink)) {
+  }
+}
+
+const PdfObject*
+EmbeddedFileDecoder::EmbeddedFile(const PdfVecObjects* objects,
+                                  const PdfObject& spec)
+{
+  const auto resolve = [objects](const PdfObject* o) -> const PdfObject* {
+    if (o && o->IsReference()) {
+      return objects ? objects->GetObject(o->GetReference()) : nullptr;
+    }
+    return o;
+  };
+  if (!spec.IsDictionary()) {
+    return nullptr;
+  }
+  const auto ef = resolve(spec.GetDictionary().GetKey(Name::EF));
+  if (!ef || !ef->IsDictionary()) {
+    return nullptr;
+  }
+  const auto f = resolve(ef->GetDictionary().GetKey(Name::F));
+  return f && f->HasStream() ? f : nullptr;
+}
+
+namespace {
+
+// Writes to a temporary file, Close only flushes it so it can be read back
+class TempOutputStream final : public PdfOutputStream
+{
+public:
+  explicit TempOutputStream(FILE* file)
+    : File(file)
+  {}
+  pdf_long Write(const char* buffer, pdf_long length) override
+  {
+    if (fwrite(buffer, 1, static_cast<size_t>(length), File) !=
+        static_cast<size_t>(length)) {
+      PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidDeviceOperation,
+                              "Failed to write a temporary file");
+    }
+    return length;
+  }
+  void Close() override { fflush(File); }
+
+private:
+  FILE* File;
+};
+
+// Reads a temporary file back from its current position
+class TempInputStream final : public PdfInputStream
+{
+public:
+  explicit TempInputStream(FILE* file)
+    : File(file)
+  {}
+  pdf_long Read(char* buffer, pdf_long length, pdf_long* = nullptr) override
+  {
+    return static_cast<pdf_long>(
+      fread(buffer, 1, static_cast<size_t>(length), File));
+  }
+
+private:
+  FILE* File;
+};
+}
+
+EmbeddedFileEncoder::EmbeddedFileEncoder(PdfDocument& doc, const string& name)
+  : Doc(doc)
+  , FileName(name)
+  , Temp(std::tmpfile())
+  , Digest(EVP_MD_CTX_create())
+{
+  if (!Temp) {
+    EVP_MD_CTX_destroy(Digest);
+    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidDeviceOperation,
+                            "Failed to create a temporary file");
+  }
+  EVP_DigestInit_ex(Digest, EVP_md5(), nullptr);
+  Sink.reset(new TempOutputStream(Temp));
+  TVecFilters filters;
+  filters.push_back(ePdfFilter_FlateDecode);
+  Stream.reset(PdfFilterFactory::CreateEncodeStream(filters, Sink.get()));
+}
+
+EmbeddedFileEncoder::~EmbeddedFileEncoder()
+{
+  Close();
+  EVP_MD_CTX_destroy(Digest);
+}
+
+void
+EmbeddedFileEncoder::Append(const char* data, size_t length)
+{
+  EVP_DigestUpdate(Digest, data, length);
+  Stream->Write(data, static_cast<pdf_long>(length));
+  Size += length;
+}
+
+void
+EmbeddedFileEncoder::AppendFile(const string& path)
+{
+  std::ifstream input(path, std::ios::binary);
+  if (!input) {
+    PODOFO_RAISE_ERROR_INFO(ePdfError_FileNotFound, path.c_str());
+  }
+  std::vector<char> chunk(ChunkSize);
+  while (input) {
+    input.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    if (input.gcount() > 0) {
+      Append(chunk.data(), static_cast<size_t>(input.gcount()));
+    }
+  }
+  if (input.bad()) {
+    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidDeviceOperation, path.c_str());
+  }
+}
+
+PdfObject*
+EmbeddedFileEncoder::Finish()
+{
+  Open = false;
+  // flushes the deflate stream into the temporary file
+  Stream->Close();
+  const auto length = ftell(Temp);
+  if (length < 0 || ferror(Temp)) {
+    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidDeviceOperation,
+                            "Failed to write a temporary file");
+  }
+  rewind(Temp);
+  unsigned char md5[EVP_MAX_MD_SIZE];
+  unsigned int md5Length = 0;
+  EVP_DigestFinal_ex(Digest, md5, &md5Length);
+  PdfDictionary params;
+  params.AddKey(Name::SIZE, static_cast<pdf_int64>(Size));
+  params.AddKey(
+    Name::CHECK_SUM,
+    PdfString(reinterpret_cast<const char*>(md5), md5Length, true));
+  // A StreamDocument writes the stream dictionary when the data is set, the
+  // data is already Flate encoded so only /Filter is added
+  auto file = Doc.GetObjects()->CreateObject("EmbeddedFile");
+  file->GetDictionary().AddKey(Name::FILTER, PdfName("FlateDecode"));
+  file->GetDictionary().AddKey(Name::PARAMS, params);
+  TempInputStream input(Temp);
+  file->GetStream()->SetRawData(&input, static_cast<pdf_long>(length));
+  PdfFileSpec spec(FileName.c_str(), false, &Doc);
+  PdfDictionary ef;
+  ef.AddKey(Name::F, file->Reference());
+  spec.GetObject()->GetDictionary().AddKey(Name::EF, ef);
+  Doc.AttachFile(spec);
+  return spec.GetObject();
+}
+
+void
+EmbeddedFileEncoder::Abort()
+{
+  Open = false;
+  Stream->Close();
+}
+
+void
+EmbeddedFileEncoder::Close()
+{
+  if (!Temp) {
+    return;
+  }
+  if (Open) {
+    try {
+      Abort();
+    } catch (PdfError&) {
+    }
+  }
+  // the encode stream has to go before the sink it writes to
+  Stream.reset();
+  Sink.reset();
+  fclose(Temp);
+  Temp = nullptr;
+}
+
+namespace {
+
+// Counts the bytes written to another output stream
+class CountingOutputStream final : public PdfOutputStream
+{
+public:
+  explicit CountingOutputStream(PdfOutputStream& target)
+    : Target(target)
+  {}
+  pdf_long Write(const char* buffer, pdf_long length) override
+  {
+    Count += static_cast<size_t>(length);
+    return Target.Write(buffer, length);
+  }
+  void Close() override { Target.Close(); }
+  size_t Count = 0;
+
+private:
+  PdfOutputStream& Target;
+};
+
+// Collects decoded data until it is handed to javascript
+class StringOutputStream final : public PdfOutputStream
+{
+public:
+  pdf_long Write(const char* buffer, pdf_long length) override
+  {
+    Data.append(buffer, static_cast<size_t>(length));
+    return length;
+  }
+  void Close() override {}
+  string Data;
+};
+
+/**
+ * Decodes an embedded file into a file on a worker thread. A partially
+ * written file is removed when decoding fails.
+ */
+class ExtractFileAsync final : public AsyncWorker
+{
+public:
+  ExtractFileAsync(const Object& spec, const PdfObject& file, string path)
+    : AsyncWorker(spec.Env(), "filespec_extract_async")
+    , Deferred(Promise::Deferred::New(spec.Env()))
+    , Spec(Persistent(spec))
+    , Decoder(file)
+    , Path(std::move(path))
+  {}
+  Promise GetPromise() { return Deferred.Promise(); }
+
+protected:
+  void Execute() override
+  {
+    try {
+      PdfFileOutputStream file(Path.c_str());
+      CountingOutputStream sink(file);
+      Decoder.Decode(sink);
+      Length = sink.Count;
+    } catch (PdfError& err) {
+      std::remove(Path.c_str());
+      SetError(ErrorHandler::WriteMsg(err));
+    }
+  }
+  void OnOK() override
+  {
+    HandleScope scope(Env());
+    Deferred.Resolve(Number::New(Env(), static_cast<double>(Length)));
+  }
+  void OnError(const Napi::Error& err) override
+  {
+    Deferred.Reject(err.Value());
+  }
+
+private:
+  Promise::Deferred Deferred;
+  ObjectReference Spec;
+  EmbeddedFileDecoder Decoder;
+  string Path;
+  size_t Length = 0;
+};
+
+/**
+ * The state of FileSpec.extractTo(Writable). Each ExtractChunkAsync decodes
+ * the next ChunkSize bytes on a worker and writes them to the Writable on
+ * the main thread. Decoding pauses while write returns false and resumes on
+ * 'drain', so at most one chunk is buffered by the extraction.
+ */
+struct WritableExtraction
+{
+  WritableExtraction(const Object& spec,
+                     const PdfObject& file,
+                     const Object& writable,
+                     bool end)
+    : Deferred(Promise::Deferred::New(spec.Env()))
+    , Spec(Persistent(spec))
+    , Writable(Persistent(writable))
+    , Decoder(file)
+    , End(end)
+  {}
+  void Settle(const Napi::Env& env, const JsValue& failure)
+  {
+    if (Settled) {
+      return;
+    }
+    Settled = true;
+    auto writable = Writable.Value();
+    writable.Get("removeListener")
+      .As<Function>()
+      .Call(writable, { String::New(env, "error"), OnError.Value() });
+    // OnError's function holds this extraction, drop the references so the
+    // extraction, the Writable and the document can be collected
+    OnError.Reset();
+    Writable.Reset();
+    Release();
+    if (failure.IsEmpty()) {
+      Deferred.Resolve(Number::New(env, static_cast<double>(Total)));
+    } else {
+      Deferred.Reject(failure);
+    }
+  }
+  // The FileSpec keeps the document, and the data the decoder borrows from
+  // it, alive; it is held until no chunk is being decoded
+  void Release()
+  {
+    if (Settled && !Running) {
+      Spec.Reset();
+    }
+  }
+
+  Promise::Deferred Deferred;
+  ObjectReference Spec;
+  ObjectReference Writable;
+  FunctionReference OnError;
+  EmbeddedFileDecoder Decoder;
+  StringOutputStream Chunk;
+  bool End;
+  bool Done = false;
+  bool Settled = false;
+  // a chunk worker is queued or running
+  bool Running = false;
+  size_t Total = 0;
+};
+
+void
+QueueChunk(const shared_ptr<WritableExtraction>&);
+
+class ExtractChunkAsync final : public AsyncWorker
+{
+public:
+  explicit ExtractChunkAsync(shared_ptr<WritableExtraction> extraction)
+    : AsyncWorker(extraction->Spec.Env(), "filespec_extract_chunk_async")
+    , Extraction(std::move(extraction))
+  {}
+
+protected:
+  void Execute() override
+  {
+    auto& x = *Extraction;
+    try {
+      while (!x.Done && x.Chunk.Data.size() < EmbeddedFileDecoder::ChunkSize) {
+        x.Done = !x.Decoder.Next(x.Chunk);
+      }
+    } catch (PdfError& err) {
+      SetError(ErrorHandler::WriteMsg(err));
+    }
+  }
+  void OnOK() override
+  {
+    HandleScope scope(Env());
+    auto& x = *Extraction;
+    x.Running = false;
+    if (x.Settled) {
+      x.Release();
+      return;
+    }
+    try {
+      auto writable = x.Writable.Value();
+      bool more = true;
+      if (!x.Chunk.Data.empty()) {
+        auto chunk =
+          Buffer<char>::Copy(Env(), x.Chunk.Data.data(), x.Chunk.Data.size());
+        x.Total += x.Chunk.Data.size();
+        x.Chunk.Data.clear();
+        more = writable.Get("write")
+                 .As<Function>()
+                 .Call(writable, { chunk })
+                 .ToBoolean();
+      }
+      if (x.Done) {
+        if (!x.End) {
+          x.Settle(Env(), JsValue());
+          return;
+        }
+        auto extraction = Extraction;
+        writable.Get("end").As<Function>().Call(
+          writable,
+          { Function::New(Env(), [extraction](const CallbackInfo& info) {
+              extraction->Settle(info.Env(),
+                                 info.Length() > 0 && info[0].IsObject()
+                                   ? info[0]
+                                   : JsValue());
+            }) });
+      } else if (more) {
+        QueueChunk(Extraction);
+      } else {
+        auto extraction = Extraction;
+        writable.Get("once").As<Function>().Call(
+          writable,
+          { String::New(Env(), "drain"),
+            Function::New(Env(), [extraction](const CallbackInfo&) {
+              QueueChunk(extraction);
+            }) });
+      }
+    } catch (Napi::Error& err) {
+      x.Settle(Env(), err.Value());
+    }
+  }
+  void OnError(const Napi::Error& err) override
+  {
+    Extraction->Running = false;
+    Extraction->Settle(Env(), err.Value());
+    Extraction->Release();
+  }
+
+private:
+  shared_ptr<WritableExtraction> Extraction;
+};
+
+void
+QueueChunk(const shared_ptr<WritableExtraction>& extraction)
+{
+  if (extraction->Settled) {
+    return;
+  }
+  auto worker = new ExtractChunkAsync(extraction);
+  extraction->Running = true;
+  worker->Queue();
+}
+}
+
+/**
+ * extractTo(destination, opts?) decodes the embedded file on a worker
+ * thread, ChunkSize bytes of encoded data at a time, into a file path or a
+ * Writable stream. Resolves to the decoded length. A Writable is ended when
+ * the file has been written unless opts.end is false.
+ */
+JsValue
+FileSpec::ExtractTo(const CallbackInfo& info)
+{
+  if (info.Length() < 1 ||
+      !(info[0].IsString() ||
+        (info[0].IsObject() &&
+         info[0].As<Object>().Get("write").IsFunction()))) {
+    throw TypeError::New(info.Env(),
+                         "extractTo expects a file path or a Writable");
+  }
+  const auto file = EmbeddedFileDecoder::EmbeddedFile(
+    Self->GetObject()->GetOwner(), *Self->GetObject());
+  if (!file) {
+    throw Error::New(info.Env(), "The file is not embedded in the document");
+  }
+  try {
+    if (info[0].IsString()) {
+      auto worker = new ExtractFileAsync(
+        info.This().As<Object>(), *file, info[0].As<String>().Utf8Value());
+      worker->Queue();
+      return worker->GetPromise();
+    }
+    bool end = true;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+      auto opts = info[1].As<Object>();
+      if (opts.Has("end") && opts.Get("end").IsBoolean()) {
+        end = opts.Get("end").As<Boolean>();
+      }
+    }
+    auto writable = info[0].As<Object>();
+    auto extraction = make_shared<WritableExtraction>(
+      info.This().As<Object>(), *file, writable, end);
+    // a failed Writable never drains, reject instead of waiting on it
+    auto onError = Function::New(
+      info.Env(),
+      [extraction](const CallbackInfo& args) {
+        extraction->Settle(
+          args.Env(), args.Length() > 0 ? args[0] : args.Env().Undefined());
+      });
+    extraction->OnError = Persistent(onError);
+    writable.Get("once").As<Function>().Call(
+      writable, { String::New(info.Env(), "error"), onError });
+    QueueChunk(extraction);
+    return extraction->Deferred.Promise();
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
 }
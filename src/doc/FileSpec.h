@@ -20,13 +20,100 @@
 #ifndef NPDF_FILESPEC_H
 #define NPDF_FILESPEC_H
 
+#include <cstdio>
+#include <memory>
 #include <napi.h>
+#include <openssl/evp.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
+#include <string>
 
 using JsValue = Napi::Value;
 
 namespace NoPoDoFo {
+
+/**
+ * EmbeddedFileDecoder decodes the data of an embedded file stream through
+ * the stream's filter chain, ChunkSize bytes of encoded data at a time, so
+ * the decoded file never has to be held in memory. The encoded data is
+ * borrowed from the stream: the document must outlive the decoder and the
+ * stream must not change while it runs. Construct it on the main thread,
+ * Next and Decode may run on a worker.
+ */
+class EmbeddedFileDecoder
+{
+public:
+  explicit EmbeddedFileDecoder(const PoDoFo::PdfObject& file);
+  explicit EmbeddedFileDecoder(const EmbeddedFileDecoder&) = delete;
+  const EmbeddedFileDecoder& operator=(const EmbeddedFileDecoder&) = delete;
+  ~EmbeddedFileDecoder();
+
+  // Decode the next piece of data into sink, every call must pass the same
+  // sink. The sink is closed with the last piece, after which this returns
+  // false.
+  bool Next(PoDoFo::PdfOutputStream& sink);
+  // Decode all of the remaining data into sink
+  void Decode(PoDoFo::PdfOutputStream& sink);
+
+  // The /EF /F stream of a file specification, nullptr if the file is not
+  // embedded. References are resolved through objects.
+  static const PoDoFo::PdfObject* EmbeddedFile(
+    const PoDoFo::PdfVecObjects* objects,
+    const PoDoFo::PdfObject& spec);
+
+  static const size_t ChunkSize = 64 * 1024;
+
+private:
+  const char* Data = nullptr;
+  size_t Length = 0;
+  size_t Offset = 0;
+  bool Done = false;
+  PoDoFo::TVecFilters Filters;
+  // a copy of the stream dictionary for the filters' /DecodeParms
+  PoDoFo::PdfDictionary Dictionary;
+  std::unique_ptr<PoDoFo::PdfOutputStream> Stream;
+};
+
+/**
+ * EmbeddedFileEncoder embeds a new file a chunk at a time. Appended data is
+ * Flate encoded into a private temporary file, and /Params /Size and the MD5
+ * /CheckSum are computed on the way. The document is not touched until
+ * Finish, so Append may run on a worker thread and other streams may be
+ * written meanwhile. Finish creates the embedded file stream from the
+ * temporary file in one step on the calling (main) thread.
+ */
+class EmbeddedFileEncoder
+{
+public:
+  // name is the file name (or path) of the new file specification
+  EmbeddedFileEncoder(PoDoFo::PdfDocument&, const std::string& name);
+  explicit EmbeddedFileEncoder(const EmbeddedFileEncoder&) = delete;
+  const EmbeddedFileEncoder& operator=(const EmbeddedFileEncoder&) = delete;
+  ~EmbeddedFileEncoder();
+
+  void Append(const char*, size_t);
+  // Append the contents of a file ChunkSize bytes at a time
+  void AppendFile(const std::string& path);
+  // Write the encoded data to a new stream, fill in /Params and add a file
+  // specification to /EmbeddedFiles. Returns the file specification.
+  PoDoFo::PdfObject* Finish();
+  // Discard the encoded data, nothing is added to the document
+  void Abort();
+  // Abort if still open and close the temporary file
+  void Close();
+
+  static const size_t ChunkSize = 64 * 1024;
+
+private:
+  PoDoFo::PdfDocument& Doc;
+  std::string FileName;
+  FILE* Temp;
+  std::unique_ptr<PoDoFo::PdfOutputStream> Sink;
+  std::unique_ptr<PoDoFo::PdfOutputStream> Stream;
+  EVP_MD_CTX* Digest;
+  size_t Size = 0;
+  bool Open = true;
+};
+
 class FileSpec : public Napi::ObjectWrap<FileSpec>
 {
 public:
@@ -38,13 +125,16 @@ public:
   static void Initialize(Napi::Env& env, Napi::Object& target);
   JsValue GetFileName(const Napi::CallbackInfo&);
   JsValue Data(const Napi::CallbackInfo&);
+  JsValue ExtractTo(const Napi::CallbackInfo&);
   std::shared_ptr<PoDoFo::PdfFileSpec> GetFileSpec() const {
   	auto copy = Self;
   	return copy;
   }
 private:
   std::shared_ptr<PoDoFo::PdfFileSpec> Self;
-  std::shared_ptr<spdlog::logger> DbgLog;
+  // The document owning the file specification, kept alive as long as this
+  // FileSpec. Unknown only for a FileSpec of an Obj created without one.
+  Napi::ObjectReference Parent;
 };
 }
 #endif // NPDF_FILESPEC_H
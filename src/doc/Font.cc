@@ -18,12 +18,13 @@
  */
 
 #include "Font.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "../base/Obj.h"
 #include "../base/Stream.h"
+#include "BaseDocument.h"
 #include "Encoding.h"
 #include <iostream>
-#include <spdlog/spdlog.h>
 
 using namespace PoDoFo;
 using namespace Napi;
@@ -39,13 +40,13 @@ FunctionReference Font::Constructor; // NOLINT
 Font::Font(const Napi::CallbackInfo& info)
   : ObjectWrap(info)
   , Self(*info[0].As<External<PdfFont>>().Data())
+  , Parent(info[1].As<External<BaseDocument>>().Data())
 {
-  DbgLog = spdlog::get("DbgLog");
 }
 
 Font::~Font()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Font Cleanup");
+  NPDF_LOG_DEBUG("Font Cleanup");
 }
 
 void
@@ -71,6 +72,7 @@ Font::Initialize(Napi::Env& env, Napi::Object& target)
       InstanceMethod("write", &Font::WriteToStream),
       InstanceMethod("embed", &Font::EmbedFont),
       InstanceMethod("stringWidth", &Font::StringWidth),
+      InstanceMethod("measure", &Font::Measure),
       InstanceMethod("isSubsetting", &Font::IsSubsetting),
       InstanceMethod("embedSubsetFont", &Font::EmbedSubsetFont) });
   Constructor = Napi::Persistent(ctor);
@@ -214,7 +216,34 @@ Napi::Value
 Font::StringWidth(const CallbackInfo& info)
 {
   const string text = info[0].As<String>().Utf8Value();
-  return Number::New(info.Env(), GetFont().GetFontMetrics()->StringWidth(text));
+  return Number::New(info.Env(),
+                     Parent->Layout.Table(GetFont())->Width(text));
+}
+
+/**
+ * Measure an array of strings in one call: info[0] string[], info[1]
+ * (optional) { kerning?: boolean }. Returns a Float64Array of widths.
+ */
+Napi::Value
+Font::Measure(const CallbackInfo& info)
+{
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    throw TypeError::New(info.Env(), "measure requires an array of strings");
+  }
+  bool kerning = false;
+  if (info.Length() >= 2 && info[1].IsObject()) {
+    kerning = info[1].As<Object>().Get("kerning").ToBoolean();
+  }
+  auto js = info[0].As<Array>();
+  auto table = Parent->Layout.Table(GetFont());
+  auto widths = Float64Array::New(info.Env(), js.Length());
+  for (uint32_t i = 0; i < js.Length(); i++) {
+    auto item = js.Get(i);
+    widths[i] = item.IsString()
+                  ? table->Width(item.As<String>().Utf8Value(), kerning)
+                  : 0.0;
+  }
+  return widths;
 }
 
 Napi::Value
@@ -23,13 +23,14 @@
 #include <iostream>
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using std::cout;
 using std::endl;
 using JsValue = Napi::Value;
 
 namespace NoPoDoFo {
+class BaseDocument;
+
 class Font : public Napi::ObjectWrap<Font>
 {
 public:
@@ -57,6 +58,7 @@ public:
   JsValue IsBold(const Napi::CallbackInfo&);
   JsValue IsItalic(const Napi::CallbackInfo&);
   JsValue StringWidth(const Napi::CallbackInfo&);
+  JsValue Measure(const Napi::CallbackInfo&);
   JsValue GetObject(const Napi::CallbackInfo&);
   void WriteToStream(const Napi::CallbackInfo&);
   void EmbedFont(const Napi::CallbackInfo&);
@@ -67,7 +69,7 @@ public:
 
 private:
   PoDoFo::PdfFont& Self; // owned by the document
-  std::shared_ptr<spdlog::logger> DbgLog;
+  BaseDocument* Parent;   // the document, measures with its TextLayout
 };
 }
 #endif // NPDF_FONT_H
@@ -18,18 +18,24 @@
  */
 
 #include "Form.h"
+#include "../Logger.h"
 #include "../Defines.h"
 #include "../ErrorHandler.h"
 #include "../ValidateArguments.h"
 #include "../base/Dictionary.h"
 #include "../base/Names.h"
 #include "../base/Obj.h"
+#include "../base/Parallel.h"
 #include "../base/Ref.h"
 #include "../base/XObject.h"
 #include "Document.h"
+#include "Field.h"
+#include "FieldIndex.h"
+#include "FormDescription.h"
 #include "StreamDocument.h"
 #include <iostream>
-#include <spdlog/spdlog.h>
+#include <set>
+#include <utility>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -37,7 +43,9 @@ using namespace PoDoFo;
 using std::cout;
 using std::endl;
 using std::ostringstream;
+using std::string;
 using std::stringstream;
+using std::vector;
 
 namespace NoPoDoFo {
 
@@ -46,18 +54,19 @@ FunctionReference Form::Constructor; // NOLINT
 Form::Form(const Napi::CallbackInfo& info)
   : ObjectWrap(info)
   , Create(info[1].As<Boolean>())
-  , Doc(info[0].IsExternal()
-          ? *info[0].As<External<BaseDocument>>().Data()->Base
-          : *(info[0].As<Object>().InstanceOf(Document::Constructor.Value())
-                ? Document::Unwrap(info[0].As<Object>())->Base
-                : StreamDocument::Unwrap(info[0].As<Object>())->Base))
+  , Parent(info[0].IsExternal()
+             ? info[0].As<External<BaseDocument>>().Data()
+             : info[0].As<Object>().InstanceOf(Document::Constructor.Value())
+                 ? static_cast<BaseDocument*>(
+                     Document::Unwrap(info[0].As<Object>()))
+                 : StreamDocument::Unwrap(info[0].As<Object>()))
+  , Doc(*Parent->Base)
 {
-  DbgLog = spdlog::get("DbgLog");
 }
 
 Form::~Form()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Form Cleanup");
+  NPDF_LOG_DEBUG("Form Cleanup");
 }
 
 void
@@ -76,7 +85,12 @@ Form::Initialize(Napi::Env& env, Napi::Object& target)
         "DA", &Form::GetDefaultAppearance, &Form::SetDefaultAppearance),
       InstanceAccessor(
         "CO", &Form::GetCalculationOrder, &Form::SetCalculationOrder),
-      InstanceAccessor("DR", &Form::GetResource, &Form::SetResource) });
+      InstanceAccessor("DR", &Form::GetResource, &Form::SetResource),
+      InstanceMethod("getField", &Form::GetField),
+      InstanceMethod("fieldNames", &Form::GetFieldNames),
+      InstanceMethod("describe", &Form::Describe),
+      InstanceMethod("deleteFields", &Form::DeleteFields),
+      StaticMethod("describeMany", &Form::DescribeMany) });
   Constructor = Napi::Persistent(ctor);
   Constructor.SuppressDestruct();
   target.Set("Form", ctor);
@@ -271,8 +285,7 @@ Form::RefreshAppearances(const CallbackInfo& info)
   PdfXObject* xApp = nullptr;
   vector<PdfField*> fields;
   vector<PdfAnnotation*> annots;
-  vector<int> opts =
-    AssertCallbackInfo(info, { { 0, { napi_object, napi_external } } });
+  auto opts = AssertArguments<ArgTypes<napi_object, napi_external>>(info);
   if (opts[0] == 0) {
     auto obj = info[0].As<Object>();
     if (obj.InstanceOf(Ref::Constructor.Value())) {
@@ -371,4 +384,216 @@ Form::GetFieldAPKeys(PoDoFo::PdfField* f)
   }
   return keys;
 }
+
+/**
+ * Look up a field by its fully qualified name through the document's field
+ * index, null if there is no such field or it has no widget on a page
+ */
+JsValue
+Form::GetField(const CallbackInfo& info)
+{
+  if (info.Length() < 1 || !info[0].IsString()) {
+    throw TypeError::New(info.Env(), "The fully qualified name is required");
+  }
+  try {
+    const auto entry =
+      Parent->Fields.Find(Doc, info[0].As<String>().Utf8Value());
+    if (!entry || entry->Page < 0) {
+      return info.Env().Null();
+    }
+    const auto widget =
+      Parent->PageOrder.Page(Doc, static_cast<size_t>(entry->Page))
+        ->GetAnnotation(entry->Annotation);
+    PdfField field(Doc.GetObjects()->GetObject(entry->Field), widget);
+    return Field::Wrap(info.Env(), field);
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
+
+JsValue
+Form::GetFieldNames(const CallbackInfo& info)
+{
+  try {
+    const auto names = Parent->Fields.Names(Doc);
+    auto js = Napi::Array::New(info.Env(), names.size());
+    for (uint32_t i = 0; i < names.size(); ++i) {
+      js.Set(i, String::New(info.Env(), names[i]));
+    }
+    return js;
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
+
+/**
+ * deleteFields(fields: Array<string | Ref>) removes the fields identified by
+ * fully qualified name or reference and their widgets, returns the number of
+ * fields removed. Unknown names and references are skipped.
+ */
+JsValue
+Form::DeleteFields(const CallbackInfo& info)
+{
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    throw TypeError::New(info.Env(),
+                         "deleteFields requires an array of names or Refs");
+  }
+  auto items = info[0].As<Napi::Array>();
+  try {
+    std::set<PdfReference> targets;
+    for (uint32_t i = 0; i < items.Length(); i++) {
+      auto item = items.Get(i);
+      if (item.IsString()) {
+        const auto entry =
+          Parent->Fields.Find(Doc, item.As<String>().Utf8Value());
+        if (entry) {
+          targets.insert(entry->Field);
+        }
+      } else if (item.IsObject() &&
+                 item.As<Object>().InstanceOf(Ref::Constructor.Value())) {
+        targets.insert(*Ref::Unwrap(item.As<Object>())->Self);
+      } else {
+        throw TypeError::New(info.Env(),
+                             "deleteFields requires an array of names or Refs");
+      }
+    }
+    const auto removed = FieldIndex::Unlink(Doc, targets);
+    FieldIndex::RemoveWidgets(Doc, removed);
+    Parent->Fields.Invalidate();
+    uint32_t count = 0;
+    for (const auto& ref : targets) {
+      count += removed.count(ref);
+    }
+    return Number::New(info.Env(), count);
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
+
+/**
+ * Columnar metadata of every terminal field, see FormDescription
+ */
+JsValue
+Form::Describe(const CallbackInfo& info)
+{
+  try {
+    return FormDescription::Describe(Doc).ToJS(info.Env());
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
+
+/**
+ * Parses each buffer into its own PdfMemDocument and describes its form on
+ * the worker pool, the descriptions are converted on the main thread.
+ */
+class FormDescribeAsync final : public AsyncWorker
+{
+public:
+  FormDescribeAsync(const Napi::Env& env,
+                    vector<Reference<Buffer<char>>> buffers,
+                    vector<std::pair<const char*, size_t>> sources,
+                    unsigned int threads)
+    : AsyncWorker(env, "form_describe_async")
+    , Deferred(Promise::Deferred::New(env))
+    , Buffers(std::move(buffers))
+    , Sources(std::move(sources))
+    , Descriptions(Sources.size())
+    , Failures(Sources.size())
+    , Threads(threads)
+  {}
+  Promise GetPromise() { return Deferred.Promise(); }
+
+protected:
+  void Execute() override
+  {
+    ParallelFor(Sources.size(), Threads, [this](size_t i) {
+      try {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(Sources[i].first,
+                           static_cast<long>(Sources[i].second));
+        Descriptions[i] = FormDescription::Describe(doc);
+      } catch (PdfError& err) {
+        Failures[i] = ErrorHandler::WriteMsg(err);
+      }
+    });
+    for (size_t i = 0; i < Failures.size(); i++) {
+      if (!Failures[i].empty()) {
+        SetError("buffer " + std::to_string(i) + ": " + Failures[i]);
+        return;
+      }
+    }
+  }
+  void OnOK() override
+  {
+    HandleScope scope(Env());
+    try {
+      auto result = Napi::Array::New(Env(), Descriptions.size());
+      for (uint32_t i = 0; i < Descriptions.size(); i++) {
+        result.Set(i, Descriptions[i].ToJS(Env()));
+      }
+      Deferred.Resolve(result);
+    } catch (Napi::Error& err) {
+      Deferred.Reject(err.Value());
+    }
+  }
+  void OnError(const Napi::Error& err) override
+  {
+    Deferred.Reject(err.Value());
+  }
+
+private:
+  Promise::Deferred Deferred;
+  // keep the buffers alive while the workers parse them
+  vector<Reference<Buffer<char>>> Buffers;
+  // data and length of each buffer, read on the main thread since N-API
+  // must not be called from the workers
+  vector<std::pair<const char*, size_t>> Sources;
+  vector<FormDescription> Descriptions;
+  vector<string> Failures;
+  unsigned int Threads;
+};
+
+/**
+ * Form.describeMany(buffers, opts?) resolves to one description per PDF
+ * buffer in input order, the buffers are parsed in parallel on up to
+ * opts.threads threads
+ */
+JsValue
+Form::DescribeMany(const CallbackInfo& info)
+{
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    throw TypeError::New(info.Env(),
+                         "Form.describeMany expects an array of Buffers");
+  }
+  unsigned int threads = 0;
+  if (info.Length() >= 2 && info[1].IsObject()) {
+    auto opts = info[1].As<Object>();
+    if (opts.Has("threads") && opts.Get("threads").IsNumber()) {
+      threads = opts.Get("threads").As<Number>().Uint32Value();
+    }
+  }
+  auto sources = info[0].As<Napi::Array>();
+  vector<Reference<Buffer<char>>> buffers;
+  vector<std::pair<const char*, size_t>> data;
+  for (uint32_t i = 0; i < sources.Length(); i++) {
+    auto item = sources.Get(i);
+    if (!item.IsBuffer()) {
+      throw TypeError::New(info.Env(),
+                           "Form.describeMany expects an array of Buffers");
+    }
+    auto buffer = item.As<Buffer<char>>();
+    data.emplace_back(buffer.Data(), buffer.Length());
+    buffers.push_back(Persistent(buffer));
+  }
+  auto worker = new FormDescribeAsync(
+    info.Env(), std::move(buffers), std::move(data), threads);
+  auto promise = worker->GetPromise();
+  worker->Queue();
+  return promise;
+}
 }
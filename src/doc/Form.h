@@ -23,13 +23,13 @@
 #include <iostream>
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using std::cout;
 using std::endl;
 using JsValue = Napi::Value;
 
 namespace NoPoDoFo {
+class BaseDocument;
 class Form : public Napi::ObjectWrap<Form>
 {
 public:
@@ -51,6 +51,11 @@ public:
   JsValue GetCalculationOrder(const Napi::CallbackInfo&);
   void SetCalculationOrder(const Napi::CallbackInfo&, const JsValue&);
   void RefreshAppearances(const Napi::CallbackInfo&);
+  JsValue GetField(const Napi::CallbackInfo&);
+  JsValue GetFieldNames(const Napi::CallbackInfo&);
+  JsValue DeleteFields(const Napi::CallbackInfo&);
+  JsValue Describe(const Napi::CallbackInfo&);
+  static JsValue DescribeMany(const Napi::CallbackInfo&);
   PoDoFo::PdfAcroForm* GetForm() const { return Doc.GetAcroForm(Create); }
 
   PoDoFo::PdfDictionary* GetDictionary() const
@@ -61,8 +66,8 @@ public:
   std::map<std::string, PoDoFo::PdfObject*> GetFieldAPKeys(PoDoFo::PdfField*);
 private:
   bool Create = true;
+  BaseDocument* Parent;
   PoDoFo::PdfDocument& Doc;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
@@ -0,0 +1,199 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FormDescription.h"
+#include "../base/Names.h"
+#include "FieldIndex.h"
+
+using namespace Napi;
+using namespace PoDoFo;
+
+using std::string;
+using std::vector;
+
+namespace NoPoDoFo {
+
+namespace {
+
+// Ff bits that select the field type of button and choice fields
+const pdf_int64 RadioFlag = 1 << 15;
+const pdf_int64 PushButtonFlag = 1 << 16;
+const pdf_int64 ComboFlag = 1 << 17;
+
+// FT, Ff and V are inheritable, look them up through /Parent
+const PdfObject*
+Inherited(const PdfObject& field, const string& key)
+{
+  const PdfObject* node = &field;
+  for (auto depth = 0; node && node->IsDictionary() && depth < 64; ++depth) {
+    if (node->GetDictionary().HasKey(key)) {
+      return node->GetIndirectKey(key);
+    }
+    node = node->GetIndirectKey(Name::PARENT);
+  }
+  return nullptr;
+}
+
+EPdfField
+FieldType(const PdfObject* ft, pdf_int64 flags)
+{
+  if (!ft || !ft->IsName()) {
+    return ePdfField_Unknown;
+  }
+  const auto& type = ft->GetName().GetName();
+  if (type == Name::BTN) {
+    return flags & PushButtonFlag
+             ? ePdfField_PushButton
+             : flags & RadioFlag ? ePdfField_RadioButton : ePdfField_CheckBox;
+  }
+  if (type == Name::TX) {
+    return ePdfField_TextField;
+  }
+  if (type == Name::CH) {
+    return flags & ComboFlag ? ePdfField_ComboBox : ePdfField_ListBox;
+  }
+  if (type == Name::SIG) {
+    return ePdfField_Signature;
+  }
+  return ePdfField_Unknown;
+}
+
+bool
+ValueString(const PdfObject& v, string& out)
+{
+  if (v.IsString() || v.IsHexString()) {
+    out = v.GetString().GetStringUtf8();
+  } else if (v.IsName()) {
+    out = v.GetName().GetName();
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Selected options of a multiple selection list box are joined by '\n'
+bool
+Value(const PdfObject* v, string& out)
+{
+  if (!v) {
+    return false;
+  }
+  if (!v->IsArray()) {
+    return ValueString(*v, out);
+  }
+  string item;
+  auto found = false;
+  for (const auto& option : v->GetArray()) {
+    if (ValueString(option, item)) {
+      out += found ? "\n" + item : item;
+      found = true;
+    }
+  }
+  return found;
+}
+}
+
+FormDescription
+FormDescription::Describe(PdfDocument& doc)
+{
+  FormDescription description;
+  const auto objects = doc.GetObjects();
+  const auto entries = FieldIndex::Entries(doc);
+  const auto n = entries.size();
+  description.Names.reserve(n);
+  description.Types.reserve(n);
+  description.Values.reserve(n);
+  description.Rects.reserve(n * 4);
+  description.Flags.reserve(n);
+  description.Pages.reserve(n);
+  for (const auto& entry : entries) {
+    const auto field = objects->GetObject(entry.Field);
+    const auto ff = Inherited(*field, Name::FF);
+    const auto flags = ff && ff->IsNumber() ? ff->GetNumber() : 0;
+    description.Names.push_back(description.Intern(entry.Name));
+    description.Types.push_back(static_cast<uint8_t>(
+      FieldType(Inherited(*field, Name::FT), flags)));
+    string value;
+    description.Values.push_back(
+      Value(Inherited(*field, Name::V), value)
+        ? static_cast<int32_t>(description.Intern(value))
+        : -1);
+    description.Flags.push_back(static_cast<uint32_t>(flags));
+    description.Pages.push_back(entry.Page);
+
+    // A field merged with its widget has the /Rect itself
+    const auto widget =
+      entry.Page >= 0 ? objects->GetObject(entry.Widget) : field;
+    const auto rect = widget ? widget->GetIndirectKey(Name::RECT) : nullptr;
+    if (rect && rect->IsArray() && rect->GetArray().size() == 4) {
+      const PdfRect r(rect->GetArray());
+      description.Rects.insert(
+        description.Rects.end(),
+        { r.GetLeft(), r.GetBottom(), r.GetWidth(), r.GetHeight() });
+    } else {
+      description.Rects.insert(description.Rects.end(), 4, 0.0);
+    }
+  }
+  return description;
+}
+
+Object
+FormDescription::ToJS(const Napi::Env& env) const
+{
+  auto js = Object::New(env);
+  auto strings = Napi::Array::New(env, Strings.size());
+  for (uint32_t i = 0; i < Strings.size(); ++i) {
+    strings.Set(i, String::New(env, Strings[i]));
+  }
+  auto names = Uint32Array::New(env, Names.size());
+  auto types = Uint8Array::New(env, Types.size());
+  auto values = Int32Array::New(env, Values.size());
+  auto rects = Float64Array::New(env, Rects.size());
+  auto flags = Uint32Array::New(env, Flags.size());
+  auto pages = Int32Array::New(env, Pages.size());
+  std::copy(Names.begin(), Names.end(), names.Data());
+  std::copy(Types.begin(), Types.end(), types.Data());
+  std::copy(Values.begin(), Values.end(), values.Data());
+  std::copy(Rects.begin(), Rects.end(), rects.Data());
+  std::copy(Flags.begin(), Flags.end(), flags.Data());
+  std::copy(Pages.begin(), Pages.end(), pages.Data());
+  js.Set("count", Number::New(env, Size()));
+  js.Set("strings", strings);
+  js.Set("name", names);
+  js.Set("type", types);
+  js.Set("value", values);
+  js.Set("rect", rects);
+  js.Set("flags", flags);
+  js.Set("page", pages);
+  return js;
+}
+
+uint32_t
+FormDescription::Intern(const string& value)
+{
+  const auto it = Interned.find(value);
+  if (it != Interned.end()) {
+    return it->second;
+  }
+  const auto index = static_cast<uint32_t>(Strings.size());
+  Strings.push_back(value);
+  Interned.emplace(value, index);
+  return index;
+}
+}
@@ -0,0 +1,65 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_FORMDESCRIPTION_H
+#define NPDF_FORMDESCRIPTION_H
+
+#include <cstdint>
+#include <napi.h>
+#include <podofo/podofo.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NoPoDoFo {
+
+/**
+ * Columnar metadata of every terminal field of a form, one column per
+ * attribute. Strings (names and values) are stored once in a string table
+ * and referenced by index. Describe does not touch V8 and may run on a
+ * worker thread, ToJS converts the columns to typed arrays.
+ */
+class FormDescription
+{
+public:
+  static FormDescription Describe(PoDoFo::PdfDocument&);
+  Napi::Object ToJS(const Napi::Env&) const;
+
+  size_t Size() const { return Names.size(); }
+
+private:
+  uint32_t Intern(const std::string&);
+
+  std::vector<std::string> Strings;
+  std::unordered_map<std::string, uint32_t> Interned;
+  // index into Strings
+  std::vector<uint32_t> Names;
+  // EPdfField code
+  std::vector<uint8_t> Types;
+  // index into Strings, -1 when the field has no value
+  std::vector<int32_t> Values;
+  // left, bottom, width, height of the widget, four per field
+  std::vector<double> Rects;
+  // /Ff field flags, inherited from the parent fields
+  std::vector<uint32_t> Flags;
+  // page of the widget, -1 when the widget is not on a page
+  std::vector<int32_t> Pages;
+};
+}
+#endif // NPDF_FORMDESCRIPTION_H
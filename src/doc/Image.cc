@@ -18,18 +18,23 @@
  */
 
 #include "Image.h"
+#include "../Logger.h"
 #include "../Defines.h"
 #include "../ErrorHandler.h"
 #include "../ValidateArguments.h"
+#include "../base/Parallel.h"
 #include "Document.h"
+#include "ImageCache.h"
 #include "StreamDocument.h"
-#include <spdlog/spdlog.h>
+#include <fstream>
+#include <iterator>
 
 using namespace Napi;
 using namespace PoDoFo;
 
 using std::make_unique;
 using std::string;
+using std::vector;
 
 namespace NoPoDoFo {
 
@@ -38,14 +43,76 @@ namespace NoPoDoFo {
 FunctionReference Image::Constructor; // NOLINT
 #pragma clang diagnostic pop
 
+/**
+ * An image source decoded off the main thread, passed to the Image
+ * constructor as an External by ImageLoadAsync.
+ */
+struct DecodedImage
+{
+  string File;
+  const char* Buffer = nullptr;
+  size_t BufferLength = 0;
+  string FileData;
+  int Format = 0;
+  bool Optimize = false;
+  ImageOptimizeOptions Options;
+  string Key;
+  std::shared_ptr<const ImageData> Data;
+  string Failure;
+
+  const char* Bytes() const { return Buffer ? Buffer : FileData.data(); }
+  size_t Length() const { return Buffer ? BufferLength : FileData.size(); }
+};
+
+// Optimize every image of decoded data for the placement in options, the
+// report covers the image and its soft mask
+static std::shared_ptr<const ImageData>
+OptimizeDecoded(const std::shared_ptr<const ImageData>& decoded,
+                const ImageOptimizeOptions& options)
+{
+  if (!decoded) {
+    return decoded;
+  }
+  auto optimized = std::make_shared<ImageData>(*decoded);
+  optimized->Optimized = true;
+  for (size_t i = 0; i < optimized->Objects.size(); i++) {
+    auto& obj = optimized->Objects[i];
+    auto subtype = obj.Dictionary.GetKey(PdfName::KeySubtype);
+    if (!obj.HasStream || !subtype || !subtype->IsName() ||
+        subtype->GetName() != PdfName("Image")) {
+      continue;
+    }
+    auto report = ImageOptimizer::Optimize(
+      obj.Dictionary, obj.Stream, options.Width, options.Height, options);
+    if (i == 0) {
+      optimized->Report = report;
+    } else {
+      optimized->Report.OriginalBytes += report.OriginalBytes;
+      optimized->Report.Bytes += report.Bytes;
+    }
+  }
+  return optimized;
+}
+
+static bool
+ReadFile(const string& file, string& data)
+{
+  std::ifstream input(file, std::ios::binary);
+  if (!input) {
+    return false;
+  }
+  data.assign(std::istreambuf_iterator<char>(input),
+              std::istreambuf_iterator<char>());
+  return !input.bad();
+}
+
 Image::Image(const CallbackInfo& info)
   : ObjectWrap(info)
 {
-  DbgLog = spdlog::get("DbgLog");
 #if defined(PODOFO_HAVE_JPEG_LIB) && defined(PODOFO_HAVE_PNG_LIB) &&           \
   defined(PODOFO_HAVE_TIFF_LIB)
   if (info.Length() < 2 || !info[0].IsObject() ||
-      (!info[1].IsString() && !info[1].IsBuffer())) {
+      (!info[1].IsString() && !info[1].IsBuffer() && !info[1].IsExternal())) {
     Error::New(info.Env(),
                "Image requires the document and image source [file or buffer].")
       .ThrowAsJavaScriptException();
@@ -53,56 +120,52 @@ Image::Image(const CallbackInfo& info)
   }
   auto iObj = info[0].As<Object>();
   if (iObj.InstanceOf(Document::Constructor.Value())) {
-    Doc = Document::Unwrap(iObj)->Base;
+    Parent = Document::Unwrap(iObj);
   } else if (iObj.InstanceOf(StreamDocument::Constructor.Value())) {
-    Doc = StreamDocument::Unwrap(iObj)->Base;
+    Parent = StreamDocument::Unwrap(iObj);
+  } else {
+    throw TypeError::New(info.Env(),
+                         "Image requires a Document or StreamDocument");
   }
+  Doc = Parent->Base;
+  Owner = Persistent(iObj);
   int format = 0;
-  if (info.Length() >= 3 && info[2].IsString()) {
+  if (info.Length() >= 3 && info[2].IsNumber()) {
     format = info[2].As<Number>();
   }
-  Self = make_unique<PdfImage>(Doc);
-  string file;
-  unsigned char* buffer = nullptr;
-  size_t bufLen = 0;
-  if (info[1].IsString()) {
-    file = info[1].As<String>().Utf8Value();
-    if (!FileAccess(file)) {
-      Error::New(info.Env(), "File not found").ThrowAsJavaScriptException();
-      return;
+  try {
+    if (info[1].IsExternal()) {
+      // decoded by Image.load on a worker thread
+      auto decoded = info[1].As<External<DecodedImage>>().Data();
+      Key = decoded->Key;
+      if (decoded->Data && decoded->Data->Optimized) {
+        Report = make_unique<ImageReport>(decoded->Data->Report);
+      }
+      if (!Reuse()) {
+        Embed(decoded->Data,
+              decoded->Bytes(),
+              decoded->Length(),
+              decoded->Format);
+      }
+    } else if (info[1].IsString()) {
+      string file = info[1].As<String>().Utf8Value();
+      string data;
+      if (!FileAccess(file)) {
+        Error::New(info.Env(), "File not found").ThrowAsJavaScriptException();
+        return;
+      }
+      if (!ReadFile(file, data)) {
+        Error::New(info.Env(), "Failed to read " + file)
+          .ThrowAsJavaScriptException();
+        return;
+      }
+      Load(data.data(), data.size(), format);
+    } else {
+      auto buffer = info[1].As<Buffer<char>>();
+      Load(buffer.Data(), buffer.Length(), format);
     }
-  } else if (info[1].IsBuffer()) {
-    buffer = info[1].As<Buffer<unsigned char>>().Data();
-    bufLen = info[1].As<Buffer<unsigned char>>().Length();
-  }
-  // data = 0, png =1, tiff =2, jpeg=3
-  switch (format) {
-    case 0:
-      if (bufLen > 0)
-        Self->LoadFromData(buffer, bufLen);
-      else
-        Self->LoadFromFile(file.c_str());
-      break;
-    case 1:
-      if (bufLen > 0)
-        Self->LoadFromPngData(buffer, bufLen);
-      else
-        Self->LoadFromPng(file.c_str());
-      break;
-    case 2:
-      if (bufLen > 0)
-        Self->LoadFromTiffData(buffer, bufLen);
-      else
-        Self->LoadFromTiff(file.c_str());
-      break;
-    case 3:
-      if (bufLen > 0)
-        Self->LoadFromJpegData(buffer, bufLen);
-      else
-        Self->LoadFromJpeg(file.c_str());
-      break;
-    default:
-      break;
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
   }
 
 #else
@@ -111,12 +174,126 @@ Image::Image(const CallbackInfo& info)
 #endif
 }
 
+/**
+ * Resolve the source to an image XObject in Doc. An image already embedded
+ * from the same bytes is reused, otherwise the decoded and compressed data
+ * is taken from the process wide ImageCache or decoded and added to it.
+ */
+void
+Image::Load(const char* data, size_t length, int format)
+{
+  Key = ImageCache::Key(data, length, format);
+  if (Reuse()) {
+    return;
+  }
+  auto cached = ImageCache::Find(Key);
+  if (!cached) {
+    cached = ImageCache::Decode(data, length, format);
+    ImageCache::Insert(Key, cached);
+  }
+  Embed(cached, data, length, format);
+}
+
+/**
+ * Wrap the XObject this document already embedded from Key, if any
+ */
+bool
+Image::Reuse()
+{
+  auto embedded = Parent->Images.find(Key);
+  if (embedded == Parent->Images.end()) {
+    return false;
+  }
+  PdfObject* obj = Doc->GetObjects()->GetObject(embedded->second);
+  if (obj && obj->IsDictionary() &&
+      obj->GetDictionary().GetKey(PdfName::KeySubtype) &&
+      obj->GetDictionary().GetKey(PdfName::KeySubtype)->IsName() &&
+      obj->GetDictionary().GetKey(PdfName::KeySubtype)->GetName() ==
+        PdfName("Image")) {
+    ImageCache::DocumentHit();
+    Self = make_unique<PdfImage>(obj);
+    Parent->SharedImages.insert(embedded->second);
+    return true;
+  }
+  // removed from the document since
+  Parent->Images.erase(embedded);
+  return false;
+}
+
+void
+Image::Embed(const std::shared_ptr<const ImageData>& cached,
+             const char* data,
+             size_t length,
+             int format)
+{
+  if (cached) {
+    Self = make_unique<PdfImage>(ImageCache::Embed(*cached, Doc->GetObjects()));
+  } else {
+    // the decoded image references objects that can not be copied, decode
+    // it again directly into the document
+    Self = make_unique<PdfImage>(Doc);
+    ImageCache::Load(*Self, data, length, format);
+  }
+  Parent->Images[Key] = Self->GetObject()->Reference();
+}
+
+/**
+ * Called before the image is modified. An XObject also wrapped by other
+ * Images is copied first so the change only applies to this Image, otherwise
+ * later Images from the same source get their own unmodified XObject.
+ * Returns false when a JS exception is pending.
+ */
+bool
+Image::Detach(const CallbackInfo& info)
+{
+  const PdfReference ref = Self->GetObject()->Reference();
+  if (Parent->SharedImages.find(ref) == Parent->SharedImages.end()) {
+    auto it = Parent->Images.find(Key);
+    if (it != Parent->Images.end() && it->second == ref) {
+      Parent->Images.erase(it);
+    }
+    return true;
+  }
+  try {
+    if (dynamic_cast<PdfMemDocument*>(Doc)) {
+      PdfObject* original = Self->GetObject();
+      PdfObject* copy = Doc->GetObjects()->CreateObject(*original);
+      char* data = nullptr;
+      pdf_long length = 0;
+      original->GetStream()->GetCopy(&data, &length);
+      PdfMemoryInputStream input(data, length);
+      copy->GetStream()->SetRawData(&input, length);
+      podofo_free(data);
+      Self = make_unique<PdfImage>(copy);
+    } else {
+      // the stream of a StreamDocument XObject is already written, embed
+      // the source again
+      auto cached = ImageCache::Find(Key);
+      if (!cached) {
+        Error::New(info.Env(),
+                   "The image is shared with other Images and its source is "
+                   "no longer cached, load it again to change it")
+          .ThrowAsJavaScriptException();
+        return false;
+      }
+      Self =
+        make_unique<PdfImage>(ImageCache::Embed(*cached, Doc->GetObjects()));
+    }
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+    return false;
+  }
+  return true;
+}
+
 Image::~Image()
 {
-  if (DbgLog != nullptr)
-    DbgLog->debug("Image Cleanup");
+  NPDF_LOG_DEBUG("Image Cleanup");
   HandleScope scope(Env());
+  Self.reset();
   Doc = nullptr;
+  Parent = nullptr;
+  Owner.Reset();
 }
 void
 Image::Initialize(Napi::Env& env, Napi::Object& target)
@@ -128,11 +305,17 @@ Image::Initialize(Napi::Env& env, Napi::Object& target)
     {
       InstanceAccessor("width", &Image::GetWidth, nullptr),
       InstanceAccessor("height", &Image::GetHeight, nullptr),
+      InstanceAccessor("report", &Image::GetReport, nullptr),
       InstanceMethod("setChromaKeyMask", &Image::SetImageChromaKeyMask),
       InstanceMethod("setSoftMask", &Image::SetImageSoftMask),
       InstanceMethod("setColorSpace", &Image::SetImageColorSpace),
       InstanceMethod("setICCProfile", &Image::SetImageICCProfile),
       InstanceMethod("setInterpolate", &Image::SetInterpolate),
+      StaticMethod("load", &Image::LoadAsync),
+      StaticMethod("loadMany", &Image::LoadMany),
+      StaticMethod("cacheStats", &Image::CacheStats),
+      StaticMethod("setCacheLimit", &Image::SetCacheLimit),
+      StaticMethod("clearCache", &Image::ClearCache),
     });
   Constructor = Napi::Persistent(ctor);
   Constructor.SuppressDestruct();
@@ -140,6 +323,266 @@ Image::Initialize(Napi::Env& env, Napi::Object& target)
   target.Set("Image", ctor);
 }
 
+/**
+ * Reads, hashes, decodes and compresses image sources on the worker pool,
+ * Image instances are created from the results on the main thread.
+ */
+class ImageLoadAsync final : public AsyncWorker
+{
+public:
+  ImageLoadAsync(Function& cb,
+                 const Object& doc,
+                 vector<DecodedImage> images,
+                 vector<Reference<Buffer<char>>> buffers,
+                 unsigned int threads,
+                 bool many)
+    : AsyncWorker(cb, "image_load_async", doc)
+    , Doc(Persistent(doc))
+    , Images(std::move(images))
+    , Buffers(std::move(buffers))
+    , Threads(threads)
+    , Many(many)
+  {}
+
+protected:
+  void Execute() override
+  {
+    ParallelFor(Images.size(), Threads, [this](size_t i) {
+      auto& image = Images[i];
+      try {
+        if (!image.Buffer && !ReadFile(image.File, image.FileData)) {
+          image.Failure = "Failed to read " + image.File;
+          return;
+        }
+        image.Key =
+          ImageCache::Key(image.Bytes(), image.Length(), image.Format);
+        if (image.Optimize) {
+          image.Key += image.Options.Tag();
+        }
+        image.Data = ImageCache::Find(image.Key);
+        if (!image.Data) {
+          image.Data =
+            ImageCache::Decode(image.Bytes(), image.Length(), image.Format);
+          if (image.Optimize) {
+            image.Data = OptimizeDecoded(image.Data, image.Options);
+          }
+          ImageCache::Insert(image.Key, image.Data);
+        }
+      } catch (PdfError& err) {
+        image.Failure = ErrorHandler::WriteMsg(err);
+      }
+    });
+    for (size_t i = 0; i < Images.size(); i++) {
+      if (!Images[i].Failure.empty()) {
+        SetError(Many ? "image " + std::to_string(i) + ": " + Images[i].Failure
+                      : Images[i].Failure);
+        return;
+      }
+    }
+  }
+  void OnOK() override
+  {
+    HandleScope scope(Env());
+    auto result = Array::New(Env(), Images.size());
+    try {
+      for (uint32_t i = 0; i < Images.size(); i++) {
+        result.Set(i,
+                   Image::Constructor.New(
+                     { Doc.Value(),
+                       External<DecodedImage>::New(Env(), &Images[i]) }));
+      }
+    } catch (Napi::Error& err) {
+      Callback().Call({ err.Value() });
+      return;
+    }
+    Callback().Call(
+      { Env().Null(), Many ? JsValue(result) : result.Get(0u) });
+  }
+
+private:
+  ObjectReference Doc;
+  vector<DecodedImage> Images;
+  // keep Buffer sources alive while the workers read them
+  vector<Reference<Buffer<char>>> Buffers;
+  unsigned int Threads;
+  bool Many;
+};
+
+// Queue one file path or Buffer image source
+static void
+AddSource(const Napi::Env& env,
+          const JsValue& source,
+          int format,
+          const ImageOptimizeOptions* optimize,
+          vector<DecodedImage>& images,
+          vector<Reference<Buffer<char>>>& buffers)
+{
+  DecodedImage image;
+  image.Format = format;
+  if (optimize) {
+    image.Optimize = true;
+    image.Options = *optimize;
+  }
+  if (source.IsString()) {
+    image.File = source.As<String>().Utf8Value();
+  } else if (source.IsBuffer()) {
+    auto buffer = source.As<Buffer<char>>();
+    image.Buffer = buffer.Data();
+    image.BufferLength = buffer.Length();
+    buffers.push_back(Persistent(buffer));
+  } else {
+    throw TypeError::New(env, "image source must be a file path or Buffer");
+  }
+  images.push_back(std::move(image));
+}
+
+static void
+AssertDocument(const Napi::CallbackInfo& info)
+{
+  if (info.Length() < 3 || !info[0].IsObject() ||
+      !(info[0].As<Object>().InstanceOf(Document::Constructor.Value()) ||
+        info[0].As<Object>().InstanceOf(StreamDocument::Constructor.Value()))) {
+    throw TypeError::New(info.Env(),
+                         "Image.load requires a Document or StreamDocument "
+                         "and the image source");
+  }
+  if (!info[info.Length() - 1].IsFunction()) {
+    throw TypeError::New(info.Env(), "A callback is required");
+  }
+}
+
+/**
+ * Image.load(doc, source, format?, optimize?, cb) calls back with an Image,
+ * the source is decoded, optimized and compressed on a worker thread
+ */
+JsValue
+Image::LoadAsync(const CallbackInfo& info)
+{
+  AssertDocument(info);
+  vector<DecodedImage> images;
+  vector<Reference<Buffer<char>>> buffers;
+  auto cb = info[info.Length() - 1].As<Function>();
+  int format = info.Length() >= 4 && info[2].IsNumber()
+                 ? info[2].As<Number>().Int32Value()
+                 : 0;
+  std::unique_ptr<ImageOptimizeOptions> optimize;
+  if (info.Length() >= 5 && info[3].IsObject()) {
+    optimize = make_unique<ImageOptimizeOptions>(
+      ParseImageOptimizeOptions(info[3].As<Object>()));
+  }
+  AddSource(info.Env(), info[1], format, optimize.get(), images, buffers);
+  auto worker = new ImageLoadAsync(
+    cb, info[0].As<Object>(), std::move(images), std::move(buffers), 1, false);
+  worker->Queue();
+  return info.Env().Undefined();
+}
+
+/**
+ * Image.loadMany(doc, sources, opts?, cb) calls back with an array of Images
+ * in source order, sources are decoded in parallel on up to opts.threads
+ * threads. A source is a file path, a Buffer or {source, format}.
+ */
+JsValue
+Image::LoadMany(const CallbackInfo& info)
+{
+  AssertDocument(info);
+  if (!info[1].IsArray()) {
+    throw TypeError::New(info.Env(), "Image.loadMany expects an array");
+  }
+  auto cb = info[info.Length() - 1].As<Function>();
+  int format = 0;
+  unsigned int threads = 0;
+  std::unique_ptr<ImageOptimizeOptions> optimize;
+  if (info.Length() >= 4 && info[2].IsObject()) {
+    auto opts = info[2].As<Object>();
+    if (opts.Has("format") && opts.Get("format").IsNumber()) {
+      format = opts.Get("format").As<Number>().Int32Value();
+    }
+    if (opts.Has("threads") && opts.Get("threads").IsNumber()) {
+      threads = opts.Get("threads").As<Number>().Uint32Value();
+    }
+    if (opts.Has("optimize") && opts.Get("optimize").IsObject()) {
+      optimize = make_unique<ImageOptimizeOptions>(
+        ParseImageOptimizeOptions(opts.Get("optimize").As<Object>()));
+    }
+  }
+  auto sources = info[1].As<Array>();
+  vector<DecodedImage> images;
+  vector<Reference<Buffer<char>>> buffers;
+  for (uint32_t i = 0; i < sources.Length(); i++) {
+    auto item = sources.Get(i);
+    if (item.IsObject() && !item.IsBuffer()) {
+      auto o = item.As<Object>();
+      int itemFormat = o.Get("format").IsNumber()
+                         ? o.Get("format").As<Number>().Int32Value()
+                         : format;
+      AddSource(info.Env(),
+                o.Get("source"),
+                itemFormat,
+                optimize.get(),
+                images,
+                buffers);
+    } else {
+      AddSource(info.Env(), item, format, optimize.get(), images, buffers);
+    }
+  }
+  auto worker = new ImageLoadAsync(cb,
+                                   info[0].As<Object>(),
+                                   std::move(images),
+                                   std::move(buffers),
+                                   threads,
+                                   true);
+  worker->Queue();
+  return info.Env().Undefined();
+}
+
+/**
+ * Counters and size of the process wide image cache
+ */
+JsValue
+Image::CacheStats(const CallbackInfo& info)
+{
+  auto stats = ImageCache::Stats();
+  auto o = Object::New(info.Env());
+  o.Set("entries", Number::New(info.Env(), stats.Entries));
+  o.Set("bytes", Number::New(info.Env(), stats.Bytes));
+  o.Set("limit", Number::New(info.Env(), stats.Limit));
+  o.Set("hits", Number::New(info.Env(), stats.Hits));
+  o.Set("documentHits", Number::New(info.Env(), stats.DocumentHits));
+  o.Set("misses", Number::New(info.Env(), stats.Misses));
+  return o;
+}
+
+/**
+ * Bound the stream data kept by the image cache in bytes, 0 disables the
+ * process wide cache. Images are still shared within a document.
+ */
+void
+Image::SetCacheLimit(const CallbackInfo& info)
+{
+  if (info.Length() < 1 || !info[0].IsNumber() ||
+      info[0].As<Number>().DoubleValue() < 0) {
+    throw TypeError::New(info.Env(), "cache limit must be a positive number");
+  }
+  ImageCache::SetLimit(
+    static_cast<size_t>(info[0].As<Number>().DoubleValue()));
+}
+
+void
+Image::ClearCache(const CallbackInfo&)
+{
+  ImageCache::Clear();
+}
+
+Napi::Value
+Image::GetReport(const CallbackInfo& info)
+{
+  if (!Report) {
+    return info.Env().Null();
+  }
+  return Report->ToJS(info.Env());
+}
+
 Napi::Value
 Image::GetHeight(const CallbackInfo& info)
 {
@@ -155,6 +598,9 @@ Image::GetWidth(const CallbackInfo& info)
 void
 Image::SetInterpolate(const CallbackInfo& info)
 {
+  if (!Detach(info)) {
+    return;
+  }
   Self->SetInterpolate(info[0].As<Boolean>());
 }
 void
@@ -166,16 +612,17 @@ Image::SetImageColorSpace(const Napi::CallbackInfo& info)
   }
   auto colorSpace =
     static_cast<EPdfColorSpace>(info[0].As<Number>().Int64Value());
+  if (!Detach(info)) {
+    return;
+  }
   Self->SetImageColorSpace(colorSpace);
 }
 void
 Image::SetImageICCProfile(const Napi::CallbackInfo& info)
 {
-  auto opts =
-    AssertCallbackInfo(info,
-                       { { 0, { option(napi_object) } },
-                         { 1, { option(napi_number) } },
-                         { 2, { tl::nullopt, option(napi_number) } } });
+  auto opts = AssertArguments<ArgTypes<napi_object>,
+                              ArgTypes<napi_number>,
+                              ArgTypes<ArgOmitted, napi_number>>(info);
   auto buf = info[0].As<Buffer<char>>();
   PdfMemoryInputStream input(buf.Data(), buf.Length());
   long colorComponent = info[1].As<Number>().Int64Value();
@@ -183,36 +630,41 @@ Image::SetImageICCProfile(const Napi::CallbackInfo& info)
   if (opts[2] == 1) {
     alt = static_cast<EPdfColorSpace>(info[2].As<Number>().Int64Value());
   }
+  if (!Detach(info)) {
+    return;
+  }
   Self->SetImageICCProfile(&input, colorComponent, alt);
 }
 void
 Image::SetImageSoftMask(const Napi::CallbackInfo& info)
 {
   if (info[0].As<Object>().InstanceOf(Image::Constructor.Value())) {
-    auto img = Image::Unwrap(info[0].As<Object>())->GetImage();
+    PdfImage& img = Image::Unwrap(info[0].As<Object>())->GetImage();
+    if (!Detach(info)) {
+      return;
+    }
     Self->SetImageSoftmask(&img);
   } else {
     Error::New(info.Env(), "soft mask expects an image as the argument value")
       .ThrowAsJavaScriptException();
   }
-  Self->SetImageSoftmask(nullptr);
 }
 void
 Image::SetImageChromaKeyMask(const Napi::CallbackInfo& info)
 {
-  AssertCallbackInfo(info,
-                     {
-                       { 0, { option(napi_number) } },
-                       { 1, { option(napi_number) } },
-                       { 2, { option(napi_number) } },
-                       { 3, { option(napi_number) } },
-                     });
+  AssertArguments<ArgTypes<napi_number>,
+                  ArgTypes<napi_number>,
+                  ArgTypes<napi_number>,
+                  ArgTypes<napi_number>>(info);
 
   pdf_int64 r = 0, g = 0, b = 0, threshold = 0;
   r = info[0].As<Number>().Int64Value();
   g = info[1].As<Number>().Int64Value();
   b = info[2].As<Number>().Int64Value();
   threshold = info[3].As<Number>().Int64Value();
+  if (!Detach(info)) {
+    return;
+  }
   Self->SetImageChromaKeyMask(r, g, b, threshold);
 }
 }
@@ -22,10 +22,16 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
+#include <memory>
+#include <string>
 using JsValue = Napi::Value;
 
 namespace NoPoDoFo {
+class BaseDocument;
+struct DecodedImage;
+struct ImageData;
+struct ImageReport;
+
 class Image : public Napi::ObjectWrap<Image>
 {
 public:
@@ -35,19 +41,37 @@ public:
   ~Image();
   static Napi::FunctionReference Constructor;
   static void Initialize(Napi::Env& env, Napi::Object& target);
+  static JsValue LoadAsync(const Napi::CallbackInfo&);
+  static JsValue LoadMany(const Napi::CallbackInfo&);
+  static JsValue CacheStats(const Napi::CallbackInfo&);
+  static void SetCacheLimit(const Napi::CallbackInfo&);
+  static void ClearCache(const Napi::CallbackInfo&);
   JsValue GetWidth(const Napi::CallbackInfo&);
   JsValue GetHeight(const Napi::CallbackInfo&);
+  JsValue GetReport(const Napi::CallbackInfo&);
   void SetInterpolate(const Napi::CallbackInfo&);
   void SetImageColorSpace(const Napi::CallbackInfo& info);
   void SetImageICCProfile(const Napi::CallbackInfo& info);
   void SetImageSoftMask(const Napi::CallbackInfo& info);
   void SetImageChromaKeyMask(const Napi::CallbackInfo&);
-  PoDoFo::PdfImage GetImage() const { return *Self; }
+  PoDoFo::PdfImage& GetImage() const { return *Self; }
 
 private:
+  void Load(const char* data, size_t length, int format);
+  bool Reuse();
+  void Embed(const std::shared_ptr<const ImageData>&,
+             const char* data,
+             size_t length,
+             int format);
+  bool Detach(const Napi::CallbackInfo&);
+
   std::unique_ptr<PoDoFo::PdfImage> Self;
-  PoDoFo::PdfDocument* Doc;
-  std::shared_ptr<spdlog::logger> DbgLog;
+  PoDoFo::PdfDocument* Doc = nullptr;
+  // Owner keeps the document (and Parent, Doc) alive as long as this Image
+  Napi::ObjectReference Owner;
+  BaseDocument* Parent = nullptr;
+  std::string Key;
+  std::unique_ptr<ImageReport> Report;
 };
 }
 #endif // NPDF_IMAGE_H
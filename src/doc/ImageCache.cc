@@ -0,0 +1,279 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ImageCache.h"
+#include <map>
+#include <openssl/evp.h>
+#include <set>
+
+using namespace PoDoFo;
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace NoPoDoFo {
+
+std::mutex ImageCache::Lock;
+std::list<ImageCache::Entry> ImageCache::Recent;
+std::unordered_map<string, std::list<ImageCache::Entry>::iterator>
+  ImageCache::Index;
+size_t ImageCache::Bytes = 0;
+size_t ImageCache::Limit = 64 * 1024 * 1024;
+std::atomic<uint64_t> ImageCache::Hits(0);
+std::atomic<uint64_t> ImageCache::DocumentHits(0);
+std::atomic<uint64_t> ImageCache::Misses(0);
+
+namespace {
+// Replace references to snapshot objects by references to embedded objects
+void
+Remap(PdfVariant& value, const std::map<PdfReference, PdfReference>& refs)
+{
+  switch (value.GetDataType()) {
+    case ePdfDataType_Reference: {
+      const auto it = refs.find(value.GetReference());
+      value =
+        it == refs.end() ? PdfVariant::NullValue : PdfVariant(it->second);
+      break;
+    }
+    case ePdfDataType_Array:
+      for (auto& item : value.GetArray()) {
+        Remap(item, refs);
+      }
+      break;
+    case ePdfDataType_Dictionary:
+      for (auto& key : value.GetDictionary().GetKeys()) {
+        Remap(*key.second, refs);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// Collect the references of value not yet in seen
+void
+References(const PdfVariant& value,
+           std::set<PdfReference>& seen,
+           vector<PdfReference>& pending)
+{
+  if (value.IsReference()) {
+    if (seen.insert(value.GetReference()).second) {
+      pending.push_back(value.GetReference());
+    }
+  } else if (value.IsArray()) {
+    for (const auto& item : value.GetArray()) {
+      References(item, seen, pending);
+    }
+  } else if (value.IsDictionary()) {
+    for (const auto& key : value.GetDictionary().GetKeys()) {
+      References(*key.second, seen, pending);
+    }
+  }
+}
+}
+
+size_t
+ImageData::Size() const
+{
+  size_t size = 0;
+  for (const auto& obj : Objects) {
+    size += obj.Stream.size();
+  }
+  return size;
+}
+
+string
+ImageCache::Key(const char* data, size_t length, int format)
+{
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int digestLength = 0;
+  if (!EVP_Digest(data, length, digest, &digestLength, EVP_sha256(),
+                  nullptr)) {
+    PODOFO_RAISE_ERROR_INFO(ePdfError_InternalLogic, "SHA-256 failed");
+  }
+  const auto size = static_cast<uint64_t>(length);
+  string key(1, static_cast<char>(format));
+  key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+  key.append(reinterpret_cast<const char*>(digest), digestLength);
+  return key;
+}
+
+shared_ptr<const ImageData>
+ImageCache::Find(const string& key)
+{
+  std::lock_guard<std::mutex> guard(Lock);
+  auto it = Index.find(key);
+  if (it == Index.end()) {
+    ++Misses;
+    return nullptr;
+  }
+  ++Hits;
+  Recent.splice(Recent.begin(), Recent, it->second);
+  return it->second->second;
+}
+
+void
+ImageCache::Insert(const string& key, shared_ptr<const ImageData> data)
+{
+  if (!data) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(Lock);
+  if (data->Size() > Limit || Index.count(key)) {
+    return;
+  }
+  Bytes += data->Size();
+  Recent.emplace_front(key, std::move(data));
+  Index[key] = Recent.begin();
+  Evict();
+}
+
+void
+ImageCache::Load(PdfImage& image, const char* data, size_t length, int format)
+{
+  auto bytes = reinterpret_cast<const unsigned char*>(data);
+  auto size = static_cast<pdf_uint32>(length);
+  switch (format) {
+    case 0:
+      image.LoadFromData(bytes, size);
+      break;
+    case 1:
+      image.LoadFromPngData(bytes, size);
+      break;
+    case 2:
+      image.LoadFromTiffData(bytes, size);
+      break;
+    case 3:
+      image.LoadFromJpegData(bytes, size);
+      break;
+    default:
+      break;
+  }
+}
+
+shared_ptr<const ImageData>
+ImageCache::Decode(const char* data, size_t length, int format)
+{
+  PdfVecObjects scratch;
+  PdfImage image(&scratch);
+  Load(image, data, length, format);
+  return Snapshot(*image.GetObject());
+}
+
+shared_ptr<const ImageData>
+ImageCache::Snapshot(const PdfObject& image)
+{
+  auto data = std::make_shared<ImageData>();
+  std::set<PdfReference> seen{ image.Reference() };
+  vector<PdfReference> pending{ image.Reference() };
+  for (size_t i = 0; i < pending.size(); i++) {
+    const PdfObject* obj =
+      i == 0 ? &image : image.GetOwner()->GetObject(pending[i]);
+    if (obj == nullptr || !obj->IsDictionary()) {
+      return nullptr;
+    }
+    ImageObject copy;
+    copy.Reference = obj->Reference();
+    copy.Dictionary = obj->GetDictionary();
+    copy.Dictionary.RemoveKey(PdfName::KeyLength);
+    if (obj->HasStream()) {
+      auto stream = dynamic_cast<const PdfMemStream*>(obj->GetStream());
+      if (!stream) {
+        return nullptr;
+      }
+      copy.HasStream = true;
+      copy.Stream.assign(stream->Get(),
+                         static_cast<size_t>(stream->GetLength()));
+    }
+    References(*obj, seen, pending);
+    data->Objects.push_back(std::move(copy));
+  }
+  return data;
+}
+
+PdfObject*
+ImageCache::Embed(const ImageData& data, PdfVecObjects* objects)
+{
+  std::map<PdfReference, PdfReference> refs;
+  vector<PdfObject*> created;
+  for (const auto& item : data.Objects) {
+    created.push_back(objects->CreateObject(PdfVariant(PdfDictionary())));
+    refs[item.Reference] = created.back()->Reference();
+  }
+  // A StreamDocument writes an object when its stream data is set, the
+  // dictionary has to be complete by then
+  for (size_t i = 0; i < created.size(); i++) {
+    const auto& item = data.Objects[i];
+    PdfVariant dictionary(item.Dictionary);
+    Remap(dictionary, refs);
+    created[i]->GetDictionary() = dictionary.GetDictionary();
+    if (item.HasStream) {
+      PdfMemoryInputStream input(item.Stream.data(),
+                                 static_cast<pdf_long>(item.Stream.size()));
+      // raw data keeps the cached /Filter and /DecodeParms entries
+      created[i]->GetStream()->SetRawData(
+        &input, static_cast<pdf_long>(item.Stream.size()));
+    }
+  }
+  return created.front();
+}
+
+void
+ImageCache::SetLimit(size_t bytes)
+{
+  std::lock_guard<std::mutex> guard(Lock);
+  Limit = bytes;
+  Evict();
+}
+
+void
+ImageCache::Clear()
+{
+  std::lock_guard<std::mutex> guard(Lock);
+  Recent.clear();
+  Index.clear();
+  Bytes = 0;
+}
+
+ImageCacheStats
+ImageCache::Stats()
+{
+  std::lock_guard<std::mutex> guard(Lock);
+  ImageCacheStats stats;
+  stats.Entries = Index.size();
+  stats.Bytes = Bytes;
+  stats.Limit = Limit;
+  stats.Hits = Hits;
+  stats.DocumentHits = DocumentHits;
+  stats.Misses = Misses;
+  return stats;
+}
+
+// Lock must be held
+void
+ImageCache::Evict()
+{
+  while (Bytes > Limit && !Recent.empty()) {
+    Bytes -= Recent.back().second->Size();
+    Index.erase(Recent.back().first);
+    Recent.pop_back();
+  }
+}
+}
@@ -0,0 +1,143 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_IMAGECACHE_H
+#define NPDF_IMAGECACHE_H
+
+#include "ImageOptimizer.h"
+#include <podofo/podofo.h>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NoPoDoFo {
+
+/**
+ * A dictionary or stream object detached from its document, the stream is
+ * kept encoded (filtered) and the dictionary without /Length.
+ */
+struct ImageObject
+{
+  PoDoFo::PdfReference Reference;
+  PoDoFo::PdfDictionary Dictionary;
+  bool HasStream = false;
+  std::string Stream;
+};
+
+/**
+ * An image XObject and the objects it references (e.g. the /SMask of a PNG
+ * with an alpha channel), the image is the first object.
+ */
+struct ImageData
+{
+  std::vector<ImageObject> Objects;
+  // Set when the image was optimized on load
+  bool Optimized = false;
+  ImageReport Report;
+  size_t Size() const;
+};
+
+struct ImageCacheStats
+{
+  size_t Entries = 0;
+  size_t Bytes = 0;
+  size_t Limit = 0;
+  uint64_t Hits = 0;
+  uint64_t DocumentHits = 0;
+  uint64_t Misses = 0;
+};
+
+/**
+ * Process wide cache of decoded and compressed images, keyed by a digest of
+ * the source bytes and the requested format. Entries are evicted least
+ * recently used first once the cached stream data exceeds the limit.
+ */
+class ImageCache
+{
+public:
+  /**
+   * SHA-256 of the source bytes, with their length and the format. The cache
+   * is shared by every document of the process, so a hit must not be
+   * forgeable by a colliding input.
+   */
+  static std::string Key(const char* data, size_t length, int format);
+
+  static std::shared_ptr<const ImageData> Find(const std::string& key);
+  static void Insert(const std::string& key,
+                     std::shared_ptr<const ImageData>);
+
+  /**
+   * Decode the source into an empty image, data = 0, png = 1, tiff = 2,
+   * jpeg = 3
+   */
+  static void Load(PoDoFo::PdfImage&,
+                   const char* data,
+                   size_t length,
+                   int format);
+
+  /**
+   * Decode the source into a detached image on scratch objects. Does not
+   * touch any document and may run on any thread, throws PdfError when the
+   * source can not be decoded.
+   */
+  static std::shared_ptr<const ImageData> Decode(const char* data,
+                                                 size_t length,
+                                                 int format);
+
+  /**
+   * Copy an image XObject and the objects it references out of its
+   * document, nullptr when an object is not a dictionary or stream or its
+   * stream data can not be read back (already written by a StreamDocument).
+   */
+  static std::shared_ptr<const ImageData> Snapshot(const PoDoFo::PdfObject&);
+
+  /**
+   * Create new objects from detached image data and return the image
+   * XObject, the stream data is copied as is without being decoded or
+   * compressed again.
+   */
+  static PoDoFo::PdfObject* Embed(const ImageData&, PoDoFo::PdfVecObjects*);
+
+  // Count a lookup resolved to an image already embedded in the document
+  static void DocumentHit() { ++DocumentHits; }
+  static void SetLimit(size_t bytes);
+  static void Clear();
+  static ImageCacheStats Stats();
+
+private:
+  using Entry = std::pair<std::string, std::shared_ptr<const ImageData>>;
+
+  static void Evict();
+
+  static std::mutex Lock;
+  static std::list<Entry> Recent;
+  static std::unordered_map<std::string, std::list<Entry>::iterator> Index;
+  static size_t Bytes;
+  static size_t Limit;
+  static std::atomic<uint64_t> Hits;
+  static std::atomic<uint64_t> DocumentHits;
+  static std::atomic<uint64_t> Misses;
+};
+}
+#endif // NPDF_IMAGECACHE_H
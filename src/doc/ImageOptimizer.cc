@@ -0,0 +1,548 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ImageOptimizer.h"
+#include "../base/Names.h"
+#include "../base/Parallel.h"
+#include "../base/Writer.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using namespace Napi;
+using namespace PoDoFo;
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace NoPoDoFo {
+
+namespace {
+const int MaxFormDepth = 8;
+
+PdfObject*
+Resolve(PdfVecObjects* objects, PdfObject* obj)
+{
+  return obj && obj->IsReference() ? objects->GetObject(obj->GetReference())
+                                   : obj;
+}
+
+bool
+IsImage(const PdfObject* obj)
+{
+  if (!obj || !obj->IsDictionary() || !obj->HasStream()) {
+    return false;
+  }
+  auto subtype = obj->GetDictionary().GetKey(PdfName::KeySubtype);
+  return subtype && subtype->IsName() &&
+         subtype->GetName() == PdfName(Name::IMAGE);
+}
+
+long
+Dimension(const PdfDictionary& dict, const string& key)
+{
+  auto value = dict.GetKey(PdfName(key));
+  return value && value->IsNumber() ? static_cast<long>(value->GetNumber())
+                                    : 0;
+}
+
+// Components of the device color spaces, 0 for any other color space
+int
+Components(const PdfDictionary& dict)
+{
+  auto cs = dict.GetKey(PdfName(Name::COLORSPACE));
+  if (!cs || !cs->IsName()) {
+    return 0;
+  }
+  if (cs->GetName() == PdfName(Name::DEVICEGRAY)) {
+    return 1;
+  }
+  if (cs->GetName() == PdfName(Name::DEVICERGB)) {
+    return 3;
+  }
+  if (cs->GetName() == PdfName(Name::DEVICECMYK)) {
+    return 4;
+  }
+  return 0;
+}
+
+// The single filter of a stream, "" when unfiltered, false for filter chains
+bool
+SingleFilter(const PdfDictionary& dict, string& filter)
+{
+  auto value = dict.GetKey(PdfName::KeyFilter);
+  if (!value) {
+    filter.clear();
+    return true;
+  }
+  if (value->IsArray() && value->GetArray().size() == 1) {
+    value = &value->GetArray()[0];
+  }
+  if (!value->IsName()) {
+    return false;
+  }
+  filter = value->GetName().GetName();
+  return true;
+}
+
+const PdfDictionary*
+DecodeParms(const PdfDictionary& dict)
+{
+  auto value = dict.GetKey(PdfName(Name::DECODE_PARMS));
+  if (value && value->IsArray() && value->GetArray().size() == 1) {
+    value = &value->GetArray()[0];
+  }
+  return value && value->IsDictionary() ? &value->GetDictionary() : nullptr;
+}
+
+// cm concatenates m with the current transformation matrix
+vector<double>
+Concat(const vector<double>& m, const vector<double>& ctm)
+{
+  return { m[0] * ctm[0] + m[1] * ctm[2],
+           m[0] * ctm[1] + m[1] * ctm[3],
+           m[2] * ctm[0] + m[3] * ctm[2],
+           m[2] * ctm[1] + m[3] * ctm[3],
+           m[4] * ctm[0] + m[5] * ctm[2] + ctm[4],
+           m[4] * ctm[1] + m[5] * ctm[3] + ctm[5] };
+}
+
+PdfObject*
+XObjects(PdfVecObjects* objects, PdfObject* resources)
+{
+  resources = Resolve(objects, resources);
+  if (!resources || !resources->IsDictionary()) {
+    return nullptr;
+  }
+  auto xobjects = Resolve(
+    objects, resources->GetDictionary().GetKey(PdfName(Name::XOBJECT)));
+  return xobjects && xobjects->IsDictionary() ? xobjects : nullptr;
+}
+}
+
+string
+ImageOptimizeOptions::Tag() const
+{
+  std::ostringstream tag;
+  tag << Dpi << ':' << Threshold << ':' << CompressionLevel << ':' << Width
+      << ':' << Height;
+  return tag.str();
+}
+
+ImageOptimizeOptions
+ParseImageOptimizeOptions(const Napi::Object& opts)
+{
+  ImageOptimizeOptions options;
+  if (opts.Has("dpi") && opts.Get("dpi").IsNumber()) {
+    options.Dpi = opts.Get("dpi").As<Number>().DoubleValue();
+  }
+  if (opts.Has("threshold") && opts.Get("threshold").IsNumber()) {
+    options.Threshold =
+      std::max(1.0, opts.Get("threshold").As<Number>().DoubleValue());
+  }
+  if (opts.Has("compressionLevel") && opts.Get("compressionLevel").IsNumber()) {
+    options.CompressionLevel = std::min(
+      9, std::max(-1, opts.Get("compressionLevel").As<Number>().Int32Value()));
+  }
+  if (opts.Has("threads") && opts.Get("threads").IsNumber()) {
+    options.Threads = opts.Get("threads").As<Number>().Uint32Value();
+  }
+  if (opts.Has("width") && opts.Get("width").IsNumber()) {
+    options.Width = opts.Get("width").As<Number>().DoubleValue();
+  }
+  if (opts.Has("height") && opts.Get("height").IsNumber()) {
+    options.Height = opts.Get("height").As<Number>().DoubleValue();
+  }
+  if (!(options.Dpi > 0)) {
+    throw TypeError::New(opts.Env(), "dpi must be a positive number");
+  }
+  return options;
+}
+
+Napi::Object
+ImageReport::ToJS(const Napi::Env& env) const
+{
+  auto o = Object::New(env);
+  o.Set("action", String::New(env, Action));
+  o.Set("originalWidth", Number::New(env, OriginalWidth));
+  o.Set("originalHeight", Number::New(env, OriginalHeight));
+  o.Set("width", Number::New(env, Width));
+  o.Set("height", Number::New(env, Height));
+  o.Set("dpi", Number::New(env, Dpi));
+  o.Set("originalBytes", Number::New(env, OriginalBytes));
+  o.Set("bytes", Number::New(env, Bytes));
+  o.Set("saved", Number::New(env, OriginalBytes - Bytes));
+  return o;
+}
+
+ImageReport
+ImageOptimizer::Optimize(PdfDictionary& dict,
+                         string& data,
+                         double width,
+                         double height,
+                         const ImageOptimizeOptions& options)
+{
+  ImageReport report;
+  report.OriginalWidth = report.Width = Dimension(dict, Name::WIDTH);
+  report.OriginalHeight = report.Height = Dimension(dict, Name::HEIGHT);
+  report.OriginalBytes = report.Bytes = data.size();
+  if (width > 0 && height > 0) {
+    report.Dpi = std::max(report.Width * 72.0 / width,
+                          report.Height * 72.0 / height);
+  }
+  string filter;
+  if (!SingleFilter(dict, filter) || report.Width <= 0 ||
+      report.Height <= 0 || data.empty()) {
+    report.Action = "skipped";
+    return report;
+  }
+
+  if (report.Dpi <= options.Dpi * options.Threshold) {
+    if (filter.empty()) {
+      string deflated =
+        Writer::Deflate(data.data(), data.size(), options.CompressionLevel);
+      if (deflated.size() < data.size()) {
+        data = std::move(deflated);
+        dict.AddKey(PdfName::KeyFilter, PdfName(Name::FLATE_DECODE));
+        report.Action = "recompressed";
+        report.Bytes = data.size();
+      }
+    }
+    return report;
+  }
+
+  const int components = Components(dict);
+  auto bits = dict.GetKey(PdfName(Name::BITS_PER_COMPONENT));
+  auto mask = dict.GetKey(PdfName(Name::IMAGE_MASK));
+  bool supported = components > 0 && bits && bits->IsNumber() &&
+                   bits->GetNumber() == 8 && !(mask && mask->IsBool() &&
+                                               mask->GetBool());
+  if (filter == Name::DCT_DECODE) {
+    // CMYK JPEGs are commonly stored inverted (Adobe APP14)
+    supported = supported && components != 4;
+  } else if (!filter.empty() && filter != Name::FLATE_DECODE) {
+    supported = false;
+  }
+  if (!supported) {
+    report.Action = "skipped";
+    return report;
+  }
+
+  string pixels;
+  if (filter.empty()) {
+    pixels = data;
+  } else {
+    auto decoder = PdfFilterFactory::CreateFilter(
+      filter == Name::DCT_DECODE ? ePdfFilter_DCTDecode
+                                 : ePdfFilter_FlateDecode);
+    if (!decoder.get()) {
+      // PoDoFo built without libjpeg
+      report.Action = "skipped";
+      return report;
+    }
+    char* buffer = nullptr;
+    pdf_long length = 0;
+    decoder->Decode(data.data(),
+                    static_cast<pdf_long>(data.size()),
+                    &buffer,
+                    &length,
+                    DecodeParms(dict));
+    pixels.assign(buffer, static_cast<size_t>(length));
+    podofo_free(buffer);
+  }
+  if (pixels.size() !=
+      static_cast<size_t>(report.Width) * report.Height * components) {
+    report.Action = "skipped";
+    return report;
+  }
+
+  const double scale = report.Dpi / options.Dpi;
+  long toWidth = std::max(1L, std::lround(report.Width / scale));
+  long toHeight = std::max(1L, std::lround(report.Height / scale));
+  string resampled = Resample(
+    pixels, report.Width, report.Height, components, toWidth, toHeight);
+  string deflated = Writer::Deflate(
+    resampled.data(), resampled.size(), options.CompressionLevel);
+  if (deflated.size() >= data.size()) {
+    // e.g. a photo whose JPEG data is smaller than the Flate encoded pixels
+    return report;
+  }
+  data = std::move(deflated);
+  dict.AddKey(PdfName(Name::WIDTH), static_cast<pdf_int64>(toWidth));
+  dict.AddKey(PdfName(Name::HEIGHT), static_cast<pdf_int64>(toHeight));
+  dict.AddKey(PdfName::KeyFilter, PdfName(Name::FLATE_DECODE));
+  dict.RemoveKey(PdfName(Name::DECODE_PARMS));
+  report.Action = "downsampled";
+  report.Width = toWidth;
+  report.Height = toHeight;
+  report.Bytes = data.size();
+  return report;
+}
+
+// Box filter, every destination sample is the mean of the source samples it
+// covers
+string
+ImageOptimizer::Resample(const string& pixels,
+                         long width,
+                         long height,
+                         int components,
+                         long toWidth,
+                         long toHeight)
+{
+  string out(static_cast<size_t>(toWidth) * toHeight * components, '\0');
+  auto src = reinterpret_cast<const unsigned char*>(pixels.data());
+  auto dst = reinterpret_cast<unsigned char*>(&out[0]);
+  vector<uint64_t> sums(static_cast<size_t>(toWidth) * components);
+  vector<long> columns(static_cast<size_t>(toWidth) + 1);
+  for (long x = 0; x <= toWidth; x++) {
+    columns[x] = x * width / toWidth;
+  }
+  for (long y = 0; y < toHeight; y++) {
+    const long y0 = y * height / toHeight;
+    const long y1 = std::max(y0 + 1, (y + 1) * height / toHeight);
+    std::fill(sums.begin(), sums.end(), 0);
+    for (long sy = y0; sy < y1; sy++) {
+      const unsigned char* row = src + sy * width * components;
+      for (long x = 0; x < toWidth; x++) {
+        const long x1 = std::max(columns[x] + 1, columns[x + 1]);
+        for (long sx = columns[x]; sx < x1; sx++) {
+          for (int c = 0; c < components; c++) {
+            sums[x * components + c] += row[sx * components + c];
+          }
+        }
+      }
+    }
+    for (long x = 0; x < toWidth; x++) {
+      const uint64_t count = static_cast<uint64_t>(y1 - y0) *
+                             (std::max(columns[x] + 1, columns[x + 1]) -
+                              columns[x]);
+      for (int c = 0; c < components; c++) {
+        dst[(y * toWidth + x) * components + c] = static_cast<unsigned char>(
+          (sums[x * components + c] + count / 2) / count);
+      }
+    }
+  }
+  return out;
+}
+
+void
+ImageOptimizer::Scan(PdfVecObjects* objects,
+                     PdfContentsTokenizer& tokenizer,
+                     PdfObject* resources,
+                     Matrix ctm,
+                     int depth,
+                     map<PdfReference, Placement>& placements)
+{
+  EPdfContentsType type;
+  const char* keyword = nullptr;
+  PdfVariant value;
+  vector<PdfVariant> operands;
+  vector<Matrix> stack;
+  while (tokenizer.ReadNext(type, keyword, value)) {
+    if (type == ePdfContentsType_Variant) {
+      operands.push_back(value);
+      continue;
+    }
+    if (type != ePdfContentsType_Keyword) {
+      operands.clear();
+      continue;
+    }
+    const string op(keyword);
+    if (op == "q") {
+      stack.push_back(ctm);
+    } else if (op == "Q" && !stack.empty()) {
+      ctm = stack.back();
+      stack.pop_back();
+    } else if (op == "cm" && operands.size() == 6) {
+      Matrix m;
+      for (auto& operand : operands) {
+        m.push_back(operand.IsNumber() || operand.IsReal() ? operand.GetReal()
+                                                           : 0);
+      }
+      ctm = Concat(m, ctm);
+    } else if (op == "Do" && !operands.empty() && operands.back().IsName()) {
+      auto xobjects = XObjects(objects, resources);
+      auto entry = xobjects ? xobjects->GetDictionary().GetKey(
+                                operands.back().GetName())
+                            : nullptr;
+      auto xobj = Resolve(objects, entry);
+      if (!xobj || !xobj->IsDictionary()) {
+        operands.clear();
+        continue;
+      }
+      if (IsImage(xobj) && entry->IsReference()) {
+        auto& placement = placements[entry->GetReference()];
+        placement.Width = std::max(placement.Width, std::hypot(ctm[0], ctm[1]));
+        placement.Height =
+          std::max(placement.Height, std::hypot(ctm[2], ctm[3]));
+      } else if (xobj->HasStream() && depth < MaxFormDepth) {
+        // Form XObject
+        Matrix m = { 1, 0, 0, 1, 0, 0 };
+        auto matrix = xobj->GetDictionary().GetKey(PdfName(Name::MATRIX));
+        if (matrix && matrix->IsArray() && matrix->GetArray().size() == 6) {
+          for (size_t i = 0; i < 6; i++) {
+            const auto& item = matrix->GetArray()[i];
+            m[i] = item.IsNumber() || item.IsReal() ? item.GetReal() : 0;
+          }
+        }
+        auto formResources =
+          xobj->GetDictionary().GetKey(PdfName(Name::RESOURCES));
+        char* buffer = nullptr;
+        pdf_long length = 0;
+        xobj->GetStream()->GetFilteredCopy(&buffer, &length);
+        PdfContentsTokenizer form(buffer, length);
+        try {
+          Scan(objects,
+               form,
+               formResources ? formResources : resources,
+               Concat(m, ctm),
+               depth + 1,
+               placements);
+        } catch (PdfError&) {
+          podofo_free(buffer);
+          throw;
+        }
+        podofo_free(buffer);
+      }
+    }
+    operands.clear();
+  }
+}
+
+vector<std::pair<PdfReference, ImageReport>>
+ImageOptimizer::Document(PdfMemDocument& doc,
+                         const ImageOptimizeOptions& options)
+{
+  auto objects = doc.GetObjects();
+  map<PdfReference, Placement> placements;
+  vector<PdfReference> excluded;
+  // Images of content that can not be read and of annotation appearances
+  // are left alone, their placement size is unknown
+  auto exclude = [&](PdfObject* resources) {
+    auto xobjects = XObjects(objects, resources);
+    if (!xobjects) {
+      return;
+    }
+    for (auto& key : xobjects->GetDictionary().GetKeys()) {
+      if (key.second->IsReference()) {
+        excluded.push_back(key.second->GetReference());
+      }
+    }
+  };
+  for (int i = 0; i < doc.GetPageCount(); i++) {
+    PdfPage* page = doc.GetPage(i);
+    try {
+      PdfContentsTokenizer tokenizer(page);
+      Scan(objects,
+           tokenizer,
+           page->GetResources(),
+           { 1, 0, 0, 1, 0, 0 },
+           0,
+           placements);
+    } catch (PdfError&) {
+      exclude(page->GetResources());
+    }
+    for (int n = 0; n < page->GetNumAnnots(); n++) {
+      auto ap = Resolve(
+        objects, page->GetAnnotation(n)->GetObject()->GetDictionary().GetKey(
+                   PdfName(Name::AP)));
+      if (!ap || !ap->IsDictionary()) {
+        continue;
+      }
+      for (auto& state : ap->GetDictionary().GetKeys()) {
+        auto appearance = Resolve(objects, state.second);
+        if (appearance && appearance->HasStream()) {
+          exclude(appearance->GetDictionary().GetKey(PdfName(Name::RESOURCES)));
+        } else if (appearance && appearance->IsDictionary()) {
+          for (auto& sub : appearance->GetDictionary().GetKeys()) {
+            auto stream = Resolve(objects, sub.second);
+            if (stream && stream->HasStream()) {
+              exclude(stream->GetDictionary().GetKey(PdfName(Name::RESOURCES)));
+            }
+          }
+        }
+      }
+    }
+  }
+  for (const auto& ref : excluded) {
+    placements.erase(ref);
+  }
+  // A soft mask is drawn with its image
+  for (const auto& placement : map<PdfReference, Placement>(placements)) {
+    auto smask = objects->GetObject(placement.first)
+                   ->GetDictionary()
+                   .GetKey(PdfName(Name::SMASK));
+    if (smask && smask->IsReference() &&
+        std::find(excluded.begin(), excluded.end(), smask->GetReference()) ==
+          excluded.end()) {
+      auto& target = placements[smask->GetReference()];
+      target.Width = std::max(target.Width, placement.second.Width);
+      target.Height = std::max(target.Height, placement.second.Height);
+    }
+  }
+
+  struct Candidate
+  {
+    PdfObject* Obj;
+    Placement At;
+    PdfDictionary Dictionary;
+    string Data;
+    ImageReport Report;
+  };
+  vector<Candidate> candidates;
+  for (const auto& placement : placements) {
+    PdfObject* obj = objects->GetObject(placement.first);
+    if (!IsImage(obj)) {
+      continue;
+    }
+    char* buffer = nullptr;
+    pdf_long length = 0;
+    obj->GetStream()->GetCopy(&buffer, &length);
+    candidates.push_back({ obj,
+                           placement.second,
+                           obj->GetDictionary(),
+                           string(buffer, static_cast<size_t>(length)),
+                           {} });
+    podofo_free(buffer);
+  }
+  ParallelFor(candidates.size(), options.Threads, [&](size_t i) {
+    auto& item = candidates[i];
+    try {
+      item.Report = Optimize(
+        item.Dictionary, item.Data, item.At.Width, item.At.Height, options);
+    } catch (PdfError&) {
+      item.Report.Action = "skipped";
+      item.Report.OriginalBytes = item.Report.Bytes = item.Data.size();
+    }
+  });
+
+  vector<std::pair<PdfReference, ImageReport>> reports;
+  for (auto& item : candidates) {
+    if (item.Report.Bytes < item.Report.OriginalBytes) {
+      item.Obj->GetDictionary() = item.Dictionary;
+      PdfInputDevice input(item.Data.data(), item.Data.size());
+      item.Obj->GetStream()->SetRawData(
+        &input, static_cast<pdf_long>(item.Data.size()));
+    }
+    reports.emplace_back(item.Obj->Reference(), item.Report);
+  }
+  return reports;
+}
+}
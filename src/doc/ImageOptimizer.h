@@ -0,0 +1,127 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_IMAGEOPTIMIZER_H
+#define NPDF_IMAGEOPTIMIZER_H
+
+#include <napi.h>
+#include <podofo/podofo.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace NoPoDoFo {
+
+/**
+ * Options of Image.load({optimize}) and Document.optimizeImages
+ */
+struct ImageOptimizeOptions
+{
+  // Target resolution of downsampled images
+  double Dpi = 150;
+  // Images are only downsampled above Dpi * Threshold
+  double Threshold = 1.5;
+  // zlib compression level, -1 (zlib default) or 0 - 9
+  int CompressionLevel = -1;
+  // Worker threads, 0 uses the hardware concurrency
+  unsigned int Threads = 0;
+  // Placement size in points, known up front when optimizing on load
+  double Width = 0;
+  double Height = 0;
+
+  // Distinguishes the cached results of different options
+  std::string Tag() const;
+};
+
+ImageOptimizeOptions
+ParseImageOptimizeOptions(const Napi::Object&);
+
+/**
+ * What optimizing one image did, bytes are the encoded stream sizes
+ */
+struct ImageReport
+{
+  // passthrough, recompressed, downsampled or skipped
+  std::string Action = "passthrough";
+  long OriginalWidth = 0;
+  long OriginalHeight = 0;
+  long Width = 0;
+  long Height = 0;
+  // Resolution at the largest placement, 0 when the placement is unknown
+  double Dpi = 0;
+  size_t OriginalBytes = 0;
+  size_t Bytes = 0;
+
+  Napi::Object ToJS(const Napi::Env&) const;
+};
+
+/**
+ * Downsamples and recompresses image XObjects. Oversize 8 bit DeviceGray,
+ * DeviceRGB and DeviceCMYK images (unfiltered, FlateDecode or grey / RGB
+ * DCTDecode) are box filtered to the target resolution and Flate encoded,
+ * other unfiltered images are Flate encoded. The result is only used when it
+ * is smaller, JPEG data is otherwise passed through untouched.
+ */
+class ImageOptimizer
+{
+public:
+  /**
+   * Optimize an image placed at width x height points, dictionary and data
+   * (the encoded stream) are replaced when the result is smaller. Does not
+   * touch any document and may run on any thread.
+   */
+  static ImageReport Optimize(PoDoFo::PdfDictionary&,
+                              std::string& data,
+                              double width,
+                              double height,
+                              const ImageOptimizeOptions&);
+
+  /**
+   * Optimize every image drawn on the pages of a document, at the largest
+   * size it is drawn with. Images are decoded, resampled and compressed in
+   * parallel, objects are only read and replaced on the calling thread.
+   */
+  static std::vector<std::pair<PoDoFo::PdfReference, ImageReport>> Document(
+    PoDoFo::PdfMemDocument&,
+    const ImageOptimizeOptions&);
+
+private:
+  struct Placement
+  {
+    double Width = 0;
+    double Height = 0;
+  };
+  using Matrix = std::vector<double>;
+
+  static void Scan(PoDoFo::PdfVecObjects*,
+                   PoDoFo::PdfContentsTokenizer&,
+                   PoDoFo::PdfObject* resources,
+                   Matrix ctm,
+                   int depth,
+                   std::map<PoDoFo::PdfReference, Placement>&);
+  static std::string Resample(const std::string& pixels,
+                              long width,
+                              long height,
+                              int components,
+                              long toWidth,
+                              long toHeight);
+};
+}
+#endif // NPDF_IMAGEOPTIMIZER_H
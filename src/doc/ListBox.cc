@@ -19,7 +19,6 @@
 
 #include "ListBox.h"
 #include "Field.h"
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -18,9 +18,9 @@
  */
 
 #include "ListField.h"
+#include "../Logger.h"
 #include "Field.h"
 #include <iostream>
-#include <spdlog/spdlog.h>
 
 using namespace PoDoFo;
 using namespace Napi;
@@ -30,12 +30,11 @@ namespace NoPoDoFo {
 ListField::ListField(PdfField& field)
   : Self(field)
 {
-  DbgLog = spdlog::get("DbgLog");
 }
 
 ListField::~ListField()
 {
-  if(DbgLog != nullptr) DbgLog->debug("ListField Cleanup");
+  NPDF_LOG_DEBUG("ListField Cleanup");
 }
 
 void
@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using JsValue = Napi::Value;
 
@@ -51,7 +50,6 @@ public:
 
 private:
   PoDoFo::PdfField& Self;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
@@ -0,0 +1,442 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "NameTree.h"
+#include "../Logger.h"
+#include "../ErrorHandler.h"
+#include "../base/Names.h"
+#include "../base/Obj.h"
+#include "../base/Ref.h"
+#include "BaseDocument.h"
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+using namespace Napi;
+using namespace PoDoFo;
+
+using std::string;
+
+namespace NoPoDoFo {
+
+FunctionReference NameTree::Constructor; // NOLINT
+
+namespace {
+
+// Trees deeper than this are treated as malformed (or cyclic)
+const int MaxDepth = 32;
+
+// Name tree keys are ordered by their bytes
+int
+Compare(const PdfString& a, const PdfString& b)
+{
+  const auto n = std::min(a.GetLength(), b.GetLength());
+  const auto c = n ? std::memcmp(a.GetString(), b.GetString(), n) : 0;
+  if (c != 0) {
+    return c;
+  }
+  return a.GetLength() < b.GetLength() ? -1
+                                       : a.GetLength() > b.GetLength() ? 1 : 0;
+}
+
+bool
+IsKey(const PdfObject& o)
+{
+  return o.IsString() || o.IsHexString();
+}
+
+PdfObject*
+Resolve(const PdfVecObjects& objects, PdfObject& value)
+{
+  return value.IsReference() ? objects.GetObject(value.GetReference())
+                             : &value;
+}
+
+// -1, 0 or 1 when key is below, within or above the node's /Limits, 2 if
+// the node has no usable /Limits
+int
+Within(const PdfObject& node, const PdfString& key)
+{
+  const auto limits = node.GetIndirectKey(Name::LIMITS);
+  if (!limits || !limits->IsArray() || limits->GetArray().size() != 2 ||
+      !IsKey(limits->GetArray()[0]) || !IsKey(limits->GetArray()[1])) {
+    return 2;
+  }
+  if (Compare(key, limits->GetArray()[0].GetString()) < 0) {
+    return -1;
+  }
+  return Compare(key, limits->GetArray()[1].GetString()) > 0 ? 1 : 0;
+}
+
+// The value entry of key in a leaf /Names array, references unresolved
+PdfObject*
+FindIn(const PdfVecObjects& objects,
+       const PdfObject& node,
+       const PdfString& key,
+       int depth)
+{
+  if (depth > MaxDepth || !node.IsDictionary()) {
+    return nullptr;
+  }
+  const auto names = node.GetIndirectKey(Name::NAMES);
+  if (names && names->IsArray()) {
+    auto& items = names->GetArray();
+    size_t lo = 0;
+    size_t hi = items.size() / 2;
+    while (lo < hi) {
+      const auto mid = lo + (hi - lo) / 2;
+      const auto c =
+        IsKey(items[mid * 2]) ? Compare(key, items[mid * 2].GetString()) : 1;
+      if (c == 0) {
+        return &items[mid * 2 + 1];
+      }
+      if (c < 0) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return nullptr;
+  }
+  const auto kids = node.GetIndirectKey(Name::KIDS);
+  if (!kids || !kids->IsArray()) {
+    return nullptr;
+  }
+  auto& items = kids->GetArray();
+  size_t lo = 0;
+  size_t hi = items.size();
+  while (lo < hi) {
+    const auto mid = lo + (hi - lo) / 2;
+    const auto kid = Resolve(objects, items[mid]);
+    const auto c = kid ? Within(*kid, key) : 2;
+    if (c == 2) {
+      // Without /Limits the kids can not be bisected, search each of them
+      for (auto& item : items) {
+        const auto k = Resolve(objects, item);
+        const auto value = k ? FindIn(objects, *k, key, depth + 1) : nullptr;
+        if (value) {
+          return value;
+        }
+      }
+      return nullptr;
+    }
+    if (c == 0) {
+      return FindIn(objects, *kid, key, depth + 1);
+    }
+    if (c < 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return nullptr;
+}
+
+void
+CollectIn(const PdfVecObjects& objects,
+          const PdfObject& node,
+          int depth,
+          NameTree::Entries& entries)
+{
+  if (depth > MaxDepth || !node.IsDictionary()) {
+    return;
+  }
+  const auto names = node.GetIndirectKey(Name::NAMES);
+  if (names && names->IsArray()) {
+    const auto& items = names->GetArray();
+    for (size_t i = 0; i + 1 < items.size(); i += 2) {
+      if (IsKey(items[i])) {
+        entries.emplace_back(items[i].GetString(), items[i + 1]);
+      }
+    }
+  }
+  const auto kids = node.GetIndirectKey(Name::KIDS);
+  if (kids && kids->IsArray()) {
+    for (auto& item : kids->GetArray()) {
+      const auto kid = Resolve(objects, item);
+      if (kid) {
+        CollectIn(objects, *kid, depth + 1, entries);
+      }
+    }
+  }
+}
+
+// Indirect intermediate and leaf nodes below node
+void
+Nodes(const PdfVecObjects& objects,
+      const PdfObject& node,
+      std::set<PdfReference>& refs)
+{
+  const auto kids = node.GetIndirectKey(Name::KIDS);
+  if (!kids || !kids->IsArray()) {
+    return;
+  }
+  for (const auto& item : kids->GetArray()) {
+    if (item.IsReference() && refs.insert(item.GetReference()).second) {
+      const auto kid = objects.GetObject(item.GetReference());
+      if (kid && kid->IsDictionary()) {
+        Nodes(objects, *kid, refs);
+      }
+    }
+  }
+}
+
+struct Node
+{
+  PdfReference Ref;
+  PdfString First;
+  PdfString Last;
+};
+
+PdfArray
+Limits(const PdfString& first, const PdfString& last)
+{
+  PdfArray limits;
+  limits.push_back(first);
+  limits.push_back(last);
+  return limits;
+}
+
+PdfArray
+NamesArray(NameTree::Entries::const_iterator begin,
+           NameTree::Entries::const_iterator end)
+{
+  PdfArray names;
+  for (auto it = begin; it != end; ++it) {
+    names.push_back(it->first);
+    names.push_back(it->second);
+  }
+  return names;
+}
+}
+
+NameTree::NameTree(const CallbackInfo& info)
+  : ObjectWrap(info)
+  , Parent(info[0].As<External<BaseDocument>>().Data())
+  , Root(info[1].As<External<PdfObject>>().Data())
+  , Type(info[2].As<String>().Utf8Value())
+{
+}
+
+NameTree::~NameTree()
+{
+  NPDF_LOG_DEBUG("NameTree Cleanup");
+}
+
+void
+NameTree::Initialize(Napi::Env& env, Napi::Object& target)
+{
+  HandleScope scope(env);
+  Function ctor = DefineClass(env,
+                              "NameTree",
+                              { InstanceMethod("get", &NameTree::Get),
+                                InstanceMethod("keys", &NameTree::Keys),
+                                InstanceMethod("set", &NameTree::Set) });
+  Constructor = Napi::Persistent(ctor);
+  Constructor.SuppressDestruct();
+  target.Set("NameTree", ctor);
+}
+
+JsValue
+NameTree::Get(const CallbackInfo& info)
+{
+  if (info.Length() < 1 || !info[0].IsString()) {
+    throw TypeError::New(info.Env(), "get requires a key");
+  }
+  auto& objects = *Parent->Base->GetObjects();
+  const auto entry =
+    FindIn(objects, *Root, Key(info[0].As<String>().Utf8Value()), 0);
+  if (!entry) {
+    return info.Env().Null();
+  }
+  const auto value = Resolve(objects, *entry);
+  if (!value) {
+    return info.Env().Null();
+  }
+  if (value == entry) {
+    // A direct value lives in a node that set() replaces, the Obj owns a
+    // copy of it
+    auto copy = new PdfObject(*entry);
+    copy->SetOwner(&objects);
+    return Obj::Constructor.New({ External<PdfObject>::New(info.Env(), copy),
+                                  Boolean::New(info.Env(), true) });
+  }
+  return Obj::Constructor.New(
+    { External<PdfObject>::New(info.Env(), value) });
+}
+
+JsValue
+NameTree::Keys(const CallbackInfo& info)
+{
+  Entries entries;
+  Collect(*Parent->Base->GetObjects(), *Root, entries);
+  auto keys = Napi::Array::New(info.Env(), entries.size());
+  for (uint32_t i = 0; i < entries.size(); ++i) {
+    keys.Set(i, String::New(info.Env(), entries[i].first.GetStringUtf8()));
+  }
+  return keys;
+}
+
+/**
+ * set(entries: Array<[string, Object | Ref]>) merges the entries into the
+ * tree and rebuilds it balanced, returns the number of keys in the tree
+ */
+JsValue
+NameTree::Set(const CallbackInfo& info)
+{
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    throw TypeError::New(info.Env(), "set requires an array of [key, value]");
+  }
+  auto items = info[0].As<Napi::Array>();
+  try {
+    Entries entries;
+    Collect(*Parent->Base->GetObjects(), *Root, entries);
+    for (uint32_t i = 0; i < items.Length(); ++i) {
+      auto item = items.Get(i);
+      auto pair =
+        item.IsArray() ? item.As<Napi::Array>() : Napi::Array::New(info.Env());
+      if (pair.Length() != 2 || !pair.Get(0u).IsString() ||
+          !pair.Get(1u).IsObject()) {
+        throw TypeError::New(info.Env(),
+                             "set requires an array of [key, value]");
+      }
+      auto key = Key(pair.Get(0u).As<String>().Utf8Value());
+      auto value = pair.Get(1u).As<Object>();
+      if (value.InstanceOf(Ref::Constructor.Value())) {
+        entries.emplace_back(key, *Ref::Unwrap(value)->Self);
+      } else if (value.InstanceOf(Obj::Constructor.Value())) {
+        const auto& obj = Obj::Unwrap(value)->GetObject();
+        entries.emplace_back(
+          key,
+          obj.Reference().IsIndirect() ? PdfObject(obj.Reference()) : obj);
+      } else {
+        throw TypeError::New(info.Env(), "name tree values must be a Ref or "
+                                         "Object");
+      }
+    }
+    Build(*Parent->Base->GetObjects(), *Root, entries, Parent->Retired);
+    if (Type == Name::EMBEDDED_FILES) {
+      Parent->AttachmentNamesBuilt = false;
+    }
+    return Number::New(info.Env(), entries.size());
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
+
+PdfObject*
+NameTree::Find(const PdfVecObjects& objects,
+               const PdfObject& root,
+               const PdfString& key)
+{
+  const auto entry = FindIn(objects, root, key, 0);
+  return entry ? Resolve(objects, *entry) : nullptr;
+}
+
+void
+NameTree::Collect(const PdfVecObjects& objects,
+                  const PdfObject& root,
+                  Entries& entries)
+{
+  CollectIn(objects, root, 0, entries);
+}
+
+void
+NameTree::Build(PdfVecObjects& objects,
+                PdfObject& root,
+                Entries& entries,
+                std::vector<std::unique_ptr<PdfObject>>& retired)
+{
+  std::stable_sort(
+    entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+      return Compare(a.first, b.first) < 0;
+    });
+  // Keep the last of each run of equal keys
+  Entries unique;
+  unique.reserve(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (i + 1 < entries.size() &&
+        Compare(entries[i].first, entries[i + 1].first) == 0) {
+      continue;
+    }
+    unique.push_back(std::move(entries[i]));
+  }
+  entries.swap(unique);
+
+  std::set<PdfReference> previous;
+  Nodes(objects, root, previous);
+  auto& dict = root.GetDictionary();
+  dict.RemoveKey(Name::LIMITS);
+  if (entries.size() <= NodeSize) {
+    dict.RemoveKey(Name::KIDS);
+    dict.AddKey(Name::NAMES, NamesArray(entries.begin(), entries.end()));
+  } else {
+    std::vector<Node> level;
+    for (size_t i = 0; i < entries.size(); i += NodeSize) {
+      const auto end = std::min(i + NodeSize, entries.size());
+      auto leaf = objects.CreateObject();
+      leaf->GetDictionary().AddKey(
+        Name::NAMES, NamesArray(entries.begin() + i, entries.begin() + end));
+      leaf->GetDictionary().AddKey(
+        Name::LIMITS, Limits(entries[i].first, entries[end - 1].first));
+      level.push_back({ leaf->Reference(), entries[i].first,
+                        entries[end - 1].first });
+    }
+    while (level.size() > NodeSize) {
+      std::vector<Node> parents;
+      for (size_t i = 0; i < level.size(); i += NodeSize) {
+        const auto end = std::min(i + NodeSize, level.size());
+        PdfArray kids;
+        for (auto k = i; k < end; ++k) {
+          kids.push_back(level[k].Ref);
+        }
+        auto node = objects.CreateObject();
+        node->GetDictionary().AddKey(Name::KIDS, kids);
+        node->GetDictionary().AddKey(
+          Name::LIMITS, Limits(level[i].First, level[end - 1].Last));
+        parents.push_back({ node->Reference(), level[i].First,
+                            level[end - 1].Last });
+      }
+      level.swap(parents);
+    }
+    PdfArray kids;
+    for (const auto& node : level) {
+      kids.push_back(node.Ref);
+    }
+    dict.RemoveKey(Name::NAMES);
+    dict.AddKey(Name::KIDS, kids);
+  }
+  for (const auto& ref : previous) {
+    std::unique_ptr<PdfObject> node(objects.RemoveObject(ref));
+    if (node) {
+      retired.push_back(std::move(node));
+    }
+  }
+}
+
+PdfString
+NameTree::Key(const string& key)
+{
+  const auto ascii = std::all_of(
+    key.begin(), key.end(), [](char c) { return (c & 0x80) == 0; });
+  return ascii ? PdfString(key)
+               : PdfString(reinterpret_cast<const pdf_utf8*>(key.c_str()));
+}
+}
@@ -0,0 +1,85 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_NAMETREE_H
+#define NPDF_NAMETREE_H
+
+#include <napi.h>
+#include <podofo/podofo.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using JsValue = Napi::Value;
+
+namespace NoPoDoFo {
+
+class BaseDocument;
+
+/**
+ * A name tree of the document's /Names dictionary, i.e. /EmbeddedFiles or
+ * /Dests. Keys are found by binary search of each level's /Limits and the
+ * sorted leaf /Names arrays rather than a scan of every leaf. Bulk inserts
+ * rebuild the tree balanced, with at most NodeSize entries or kids per node.
+ */
+class NameTree : public Napi::ObjectWrap<NameTree>
+{
+public:
+  typedef std::vector<std::pair<PoDoFo::PdfString, PoDoFo::PdfObject>>
+    Entries;
+
+  explicit NameTree(const Napi::CallbackInfo&);
+  explicit NameTree(const NameTree&) = delete;
+  const NameTree& operator=(const NameTree&) = delete;
+  ~NameTree();
+  static Napi::FunctionReference Constructor;
+  static void Initialize(Napi::Env& env, Napi::Object& target);
+  JsValue Get(const Napi::CallbackInfo&);
+  JsValue Keys(const Napi::CallbackInfo&);
+  JsValue Set(const Napi::CallbackInfo&);
+
+  // The value of key with references resolved, nullptr if there is none
+  static PoDoFo::PdfObject* Find(const PoDoFo::PdfVecObjects&,
+                                 const PoDoFo::PdfObject& root,
+                                 const PoDoFo::PdfString& key);
+  // Copy every key and value in tree order
+  static void Collect(const PoDoFo::PdfVecObjects&,
+                      const PoDoFo::PdfObject& root,
+                      Entries&);
+  // Replace the contents of root with a balanced tree of entries, later
+  // entries win over earlier ones with the same key. The previous
+  // intermediate and leaf nodes are removed from the document and moved to
+  // retired, wrappers of them stay valid.
+  static void Build(PoDoFo::PdfVecObjects&,
+                    PoDoFo::PdfObject& root,
+                    Entries&,
+                    std::vector<std::unique_ptr<PoDoFo::PdfObject>>& retired);
+  // A PdfString key for a javascript string, UTF-16BE when it is not ASCII
+  static PoDoFo::PdfString Key(const std::string&);
+
+  static const size_t NodeSize = 64;
+
+private:
+  BaseDocument* Parent;
+  PoDoFo::PdfObject* Root;
+  std::string Type;
+};
+}
+#endif // NPDF_NAMETREE_H
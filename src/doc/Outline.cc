@@ -18,19 +18,25 @@
  */
 
 #include "Outline.h"
+#include "../Logger.h"
 #include "../Defines.h"
+#include "../ErrorHandler.h"
 #include "../base/Color.h"
+#include "../base/Names.h"
 #include "../base/Obj.h"
 #include "Action.h"
 #include "Destination.h"
 #include "Document.h"
 #include "StreamDocument.h"
 #include <algorithm>
-#include <spdlog/spdlog.h>
+#include <map>
+#include <memory>
+#include <tuple>
 
 using namespace Napi;
 using namespace PoDoFo;
 
+using std::map;
 using std::string;
 
 namespace NoPoDoFo {
@@ -41,11 +47,10 @@ Outline::Outline(const CallbackInfo& info)
   : ObjectWrap(info)
   , Self(*info[0].As<External<PdfOutlineItem>>().Data())
 {
-  DbgLog = spdlog::get("DbgLog");
 }
 Outline::~Outline()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Outline Cleanup");
+  NPDF_LOG_DEBUG("Outline Cleanup");
 }
 void
 Outline::Initialize(Napi::Env& env, Napi::Object& target)
@@ -70,7 +75,9 @@ Outline::Initialize(Napi::Env& env, Napi::Object& target)
       InstanceMethod("createNext", &Outline::CreateNext),
       InstanceMethod("insertChild", &Outline::InsertChild),
       InstanceMethod("getParent", &Outline::GetParent),
-      InstanceMethod("erase", &Outline::Erase) });
+      InstanceMethod("erase", &Outline::Erase),
+      InstanceMethod("build", &Outline::Build),
+      InstanceMethod("toTree", &Outline::ToTree) });
 	Constructor = Napi::Persistent(ctor);
 	Constructor.SuppressDestruct();
   target.Set("Outline", ctor);
@@ -248,4 +255,246 @@ Outline::SetTextColor(const Napi::CallbackInfo& info, const Napi::Value& value)
   }
   GetOutline().SetTextColor(color.GetRed(), color.GetGreen(), color.GetBlue());
 }
+
+namespace {
+
+const char* FitNames[] = { "Fit", "FitH", "FitV", "FitB", "FitBH", "FitBV" };
+
+// Nesting deeper than this is rejected instead of exhausting the stack
+const int MaxOutlineDepth = 256;
+
+/**
+ * Creates outline items from nested {title, page, fit?, value?, open?,
+ * children?} nodes. Every item pointing at the same page and fit shares one
+ * PdfDestination, PoDoFo creates an indirect object per destination.
+ */
+class OutlineBuilder
+{
+public:
+  explicit OutlineBuilder(PdfDocument& doc)
+    : Doc(doc)
+  {}
+
+  void Children(const Napi::Env& env,
+                PdfOutlineItem& parent,
+                const Napi::Array& nodes,
+                int depth)
+  {
+    if (depth > MaxOutlineDepth) {
+      throw Error::New(env, "outline tree is nested too deeply");
+    }
+    for (uint32_t i = 0; i < nodes.Length(); ++i) {
+      auto value = nodes.Get(i);
+      if (!value.IsObject() || !value.As<Object>().Get("title").IsString() ||
+          !value.As<Object>().Get("page").IsNumber()) {
+        throw TypeError::New(env, "outline node requires a title and page");
+      }
+      auto node = value.As<Object>();
+      const auto page = node.Get("page").As<Number>().Int32Value();
+      const auto fit = node.Get("fit").IsNumber()
+                         ? node.Get("fit").As<Number>().Int32Value()
+                         : ePdfDestinationFit_Fit;
+      const auto item = parent.CreateChild(
+        PdfString(node.Get("title").As<String>().Utf8Value()),
+        Destination(env, page, fit, node.Get("value")));
+      ++Created;
+      auto children = node.Get("children");
+      if (children.IsArray() && children.As<Napi::Array>().Length() > 0) {
+        // The sign marks the item open or closed until the counts are set
+        item->GetObject()->GetDictionary().AddKey(
+          Name::COUNT,
+          static_cast<pdf_int64>(node.Get("open").ToBoolean() ? 1 : -1));
+        Children(env, *item, children.As<Napi::Array>(), depth + 1);
+      }
+    }
+  }
+
+  uint32_t Created = 0;
+
+private:
+  const PdfDestination& Destination(const Napi::Env& env,
+                                    int page,
+                                    int fit,
+                                    const JsValue& value)
+  {
+    if (page < 0 || page >= Doc.GetPageCount()) {
+      throw RangeError::New(env, "outline page index out of range");
+    }
+    if (fit < ePdfDestinationFit_Fit || fit > ePdfDestinationFit_FitBV) {
+      throw RangeError::New(env, "outline fit must be a NPDFDestinationFit");
+    }
+    const auto p = Doc.GetPage(page);
+    const auto type = static_cast<EPdfDestinationFit>(fit);
+    const auto scalar = type != ePdfDestinationFit_Fit &&
+                        type != ePdfDestinationFit_FitB;
+    // FitH and FitBH default to the top of the page, FitV and FitBV to its
+    // left edge
+    const auto box = p->GetMediaBox();
+    const auto horizontal =
+      type == ePdfDestinationFit_FitH || type == ePdfDestinationFit_FitBH;
+    const auto position =
+      !scalar ? 0.0
+              : value.IsNumber()
+                  ? value.As<Number>().DoubleValue()
+                  : horizontal ? box.GetBottom() + box.GetHeight()
+                               : box.GetLeft();
+    auto& dest = Destinations[std::make_tuple(page, fit, position)];
+    if (!dest) {
+      dest.reset(scalar ? new PdfDestination(p, type, position)
+                        : new PdfDestination(p, type));
+    }
+    return *dest;
+  }
+
+  PdfDocument& Doc;
+  map<std::tuple<int, int, double>, std::unique_ptr<PdfDestination>>
+    Destinations;
+};
+
+/**
+ * Set /Count of item and every descendant in one post order pass and return
+ * the number of descendants visible when item is open. An item is open when
+ * its /Count is positive, the outline root always is.
+ */
+pdf_int64
+UpdateCount(PdfOutlineItem& item, bool root)
+{
+  pdf_int64 visible = 0;
+  for (auto child = item.First(); child; child = child->Next()) {
+    const auto below = UpdateCount(*child, false);
+    const auto count = child->GetObject()->GetDictionary().GetKey(Name::COUNT);
+    const auto open = count && count->IsNumber() && count->GetNumber() > 0;
+    visible += 1 + (open ? below : 0);
+  }
+  auto& dict = item.GetObject()->GetDictionary();
+  if (visible == 0) {
+    dict.RemoveKey(Name::COUNT);
+  } else {
+    const auto count = dict.GetKey(Name::COUNT);
+    const auto open =
+      root || (count && count->IsNumber() && count->GetNumber() > 0);
+    dict.AddKey(Name::COUNT, open ? visible : -visible);
+  }
+  return visible;
+}
+
+// Page index and fit of an explicit destination array, page is -1 when the
+// first element is not a page of the document
+void
+DestinationOf(const PdfArray& dest,
+              const map<PdfReference, int>& pages,
+              Object& node)
+{
+  if (dest.empty() || !dest[0].IsReference()) {
+    return;
+  }
+  const auto page = pages.find(dest[0].GetReference());
+  node.Set("page",
+           Number::New(node.Env(), page == pages.end() ? -1 : page->second));
+  if (dest.size() < 2 || !dest[1].IsName()) {
+    return;
+  }
+  const auto& fit = dest[1].GetName().GetName();
+  for (auto i = 0; i <= ePdfDestinationFit_FitBV; ++i) {
+    if (fit == FitNames[i]) {
+      node.Set("fit", Number::New(node.Env(), i));
+      if (dest.size() > 2 && (dest[2].IsNumber() || dest[2].IsReal())) {
+        node.Set("value", Number::New(node.Env(), dest[2].GetReal()));
+      }
+      break;
+    }
+  }
+}
+
+Napi::Array
+TreeOf(const Napi::Env& env,
+       PdfDocument& doc,
+       PdfOutlineItem& item,
+       const map<PdfReference, int>& pages,
+       int depth)
+{
+  auto nodes = Napi::Array::New(env);
+  uint32_t n = 0;
+  for (auto child = item.First(); child && depth <= MaxOutlineDepth;
+       child = child->Next()) {
+    auto node = Object::New(env);
+    node.Set("title", String::New(env, child->GetTitle().GetStringUtf8()));
+    auto& dict = child->GetObject()->GetDictionary();
+    const auto dest = child->GetObject()->GetIndirectKey(Name::DEST);
+    const auto action = child->GetObject()->GetIndirectKey(Name::A);
+    const auto goTo =
+      action && action->IsDictionary() ? action->GetIndirectKey(Name::D)
+                                       : nullptr;
+    if (dest && dest->IsArray()) {
+      DestinationOf(dest->GetArray(), pages, node);
+    } else if (goTo && goTo->IsArray()) {
+      DestinationOf(goTo->GetArray(), pages, node);
+    } else if (dest) {
+      // Named destination, resolved through the document's /Dests
+      const auto named = child->GetDestination(&doc);
+      const auto page = named ? named->GetPage(&doc) : nullptr;
+      if (page) {
+        node.Set("page", Number::New(env, page->GetPageNumber() - 1));
+      }
+    }
+    if (child->First()) {
+      const auto count = dict.GetKey(Name::COUNT);
+      node.Set(
+        "open",
+        Boolean::New(env,
+                     count && count->IsNumber() && count->GetNumber() > 0));
+      node.Set("children", TreeOf(env, doc, *child, pages, depth + 1));
+    }
+    nodes.Set(n++, node);
+  }
+  return nodes;
+}
+}
+
+/**
+ * build(tree: NPDFOutlineNode[]) appends the nodes as children of this item
+ * and updates /Count of the whole outline once, returns the number of items
+ * created
+ */
+JsValue
+Outline::Build(const CallbackInfo& info)
+{
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    throw TypeError::New(info.Env(), "build requires an array of nodes");
+  }
+  try {
+    const auto doc = Self.GetObject()->GetOwner()->GetParentDocument();
+    OutlineBuilder builder(*doc);
+    builder.Children(info.Env(), Self, info[0].As<Napi::Array>(), 0);
+    auto root = &Self;
+    while (root->GetParentOutline()) {
+      root = root->GetParentOutline();
+    }
+    UpdateCount(*root, true);
+    return Number::New(info.Env(), builder.Created);
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
+
+/**
+ * toTree(): NPDFOutlineNode[] serializes the children of this item, pages are
+ * resolved to page indexes
+ */
+JsValue
+Outline::ToTree(const CallbackInfo& info)
+{
+  try {
+    auto& doc = *Self.GetObject()->GetOwner()->GetParentDocument();
+    map<PdfReference, int> pages;
+    for (auto i = 0; i < doc.GetPageCount(); ++i) {
+      pages.emplace(doc.GetPage(i)->GetObject()->Reference(), i);
+    }
+    return TreeOf(info.Env(), doc, Self, pages, 0);
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
 }
@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using std::vector;
 using JsValue = Napi::Value;
@@ -51,6 +50,8 @@ public:
   JsValue Last(const Napi::CallbackInfo&);
   JsValue GetParent(const Napi::CallbackInfo&);
   JsValue Erase(const Napi::CallbackInfo&);
+  JsValue Build(const Napi::CallbackInfo&);
+  JsValue ToTree(const Napi::CallbackInfo&);
   JsValue GetDestination(const Napi::CallbackInfo&);
   void SetDestination(const Napi::CallbackInfo&, const JsValue&);
   JsValue GetAction(const Napi::CallbackInfo&);
@@ -65,7 +66,6 @@ public:
 
 private:
   PoDoFo::PdfOutlineItem& Self; // owned by the document
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_OUTLINE_H
@@ -18,7 +18,7 @@
  */
 
 #include "Page.h"
-#include <spdlog/spdlog.h>
+#include "../Logger.h"
 #if NOPODOFO_SDK
 #include "../../sdk/FlattenFields.h"
 #endif // NOPODOFO_SDK
@@ -26,12 +26,16 @@
 #include "../base/Names.h"
 #include "../base/Obj.h"
 #include "Annotation.h"
+#include "AnnotationBatch.h"
+#include "BaseDocument.h"
 #include "CheckBox.h"
 #include "ComboBox.h"
+#include "FieldIndex.h"
 #include "Form.h"
 #include "ListBox.h"
 #include "PushButton.h"
 #include "Rect.h"
+#include "Redactor.h"
 #include "SignatureField.h"
 #include "TextField.h"
 
@@ -52,12 +56,11 @@ Page::Page(const CallbackInfo& info)
   : ObjectWrap(info)
   , Self(*info[0].As<External<PdfPage>>().Data())
 {
-  DbgLog = spdlog::get("DbgLog");
 }
 
 Page::~Page()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Page Cleanup");
+  NPDF_LOG_DEBUG("Page Cleanup");
 }
 
 void
@@ -86,6 +89,9 @@ Page::Initialize(Napi::Env& env, Napi::Object& target)
       InstanceMethod("getBleedBox", &Page::GetBleedBox),
       InstanceMethod("getArtBox", &Page::GetArtBox),
       InstanceMethod("createAnnotation", &Page::CreateAnnotation),
+      InstanceMethod("addAnnotations", &Page::AddAnnotations),
+      InstanceMethod("getAnnotations", &Page::GetAnnotations),
+      InstanceMethod("redact", &Page::Redact),
       InstanceMethod("getAnnotation", &Page::GetAnnotation),
       InstanceMethod("annotationCount", &Page::GetNumAnnots),
       InstanceMethod("deleteAnnotation", &Page::DeleteAnnotation)
@@ -120,33 +126,7 @@ Napi::Value
 Page::GetField(const Napi::Env& env, int index)
 {
   auto field = Self.GetField(index);
-  EPdfField t = field.GetType();
-  switch (t) {
-    case ePdfField_PushButton:
-      return PushButton::Constructor.New(
-        { External<PdfField>::New(env, &field) });
-    case ePdfField_CheckBox:
-      return CheckBox::Constructor.New(
-        { External<PdfField>::New(env, &field) });
-    case ePdfField_RadioButton:
-      Error::New(env, "RadioButton not yet implemented")
-        .ThrowAsJavaScriptException();
-      return env.Undefined();
-    case ePdfField_TextField:
-      return TextField::Constructor.New(
-        { External<PdfField>::New(env, &field) });
-    case ePdfField_ComboBox:
-      return ComboBox::Constructor.New(
-        { External<PdfField>::New(env, &field) });
-    case ePdfField_ListBox:
-      return ListBox::Constructor.New({ External<PdfField>::New(env, &field) });
-    case ePdfField_Signature:
-      return SignatureField::Constructor.New(
-        { External<PdfAnnotation>::New(env, field.GetWidgetAnnotation()) });
-    default:
-      Error::New(env, "Unknown field type").ThrowAsJavaScriptException();
-      return env.Undefined();
-  }
+  return Field::Wrap(env, field);
 }
 
 Napi::Value
@@ -349,6 +329,89 @@ Page::CreateAnnotation(const CallbackInfo& info)
     { External<PdfAnnotation>::New(info.Env(), annot) });
   return instance;
 }
+
+/**
+ * addAnnotations(type, rects, opts?) creates one annotation of type per
+ * rect of a Float64Array of left, bottom, width and height values, styled
+ * by opts. Returns the annotation index of the first new annotation.
+ */
+JsValue
+Page::AddAnnotations(const CallbackInfo& info)
+{
+  const auto type = AnnotationBatch::ParseType(info[0]);
+  const auto rects = AnnotationBatch::ParseRects(info[1]);
+  const auto count = rects.ElementLength() / 4;
+  const auto style =
+    info.Length() >= 3 && info[2].IsObject()
+      ? AnnotationStyle::Parse(info[2].As<Object>(), count)
+      : AnnotationStyle();
+  try {
+    const auto first = AnnotationBatch::Add(*Self.GetObject()->GetOwner(),
+                                            Self,
+                                            type,
+                                            rects.Data(),
+                                            count,
+                                            style);
+    return Number::New(info.Env(), first);
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
+
+/**
+ * getAnnotations(opts?) returns the geometry of the page's annotations, of
+ * opts.types only when given, as typed array columns
+ */
+JsValue
+Page::GetAnnotations(const CallbackInfo& info)
+{
+  const auto types = AnnotationBatch::ParseTypes(info[0]);
+  try {
+    const auto& objects = *Self.GetObject()->GetOwner();
+    return AnnotationGeometry::Read(
+             objects, AnnotationGeometry::Annotations(objects, Self), types)
+      .ToJS(info.Env());
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
+
+/**
+ * redact(rects, opts?) removes the text, images and forms drawn under rects
+ * from the page's content and fills the rects unless opts.fill is false.
+ * Returns what was removed.
+ */
+JsValue
+Page::Redact(const CallbackInfo& info)
+{
+  auto rects = Redactor::ParseRects(info[0]);
+  const auto options = info.Length() >= 2 && info[1].IsObject()
+                         ? ParseRedactOptions(info[1].As<Object>())
+                         : RedactOptions();
+  auto doc = dynamic_cast<PdfMemDocument*>(
+    Self.GetObject()->GetOwner()->GetParentDocument());
+  if (!doc) {
+    throw Error::New(info.Env(),
+                     "redact requires a Document, StreamDocument pages are "
+                     "written as they are created");
+  }
+  try {
+    Redactor redactor(std::move(rects));
+    redactor.Load(Self);
+    redactor.Run(options);
+    auto xobjects = Redactor::XObjectReferences(*doc);
+    redactor.Apply(
+      Self,
+      Redactor::SharedContents(Redactor::ContentReferences(*doc), Self),
+      xobjects);
+    return redactor.Report().ToJS(info.Env());
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  return info.Env().Undefined();
+}
 /**
  * JS call(type: NPDFFieldType, widget: Annotation, form: Form): PdfField
  * @param info
@@ -374,83 +437,57 @@ Page::CreateField(const CallbackInfo& info)
   auto type = static_cast<EPdfField>(typeArg);
   Form* form = Form::Unwrap(info[2].As<Object>());
   Annotation* widget = Annotation::Unwrap(info[1].As<Object>());
+  Napi::Value field = info.Env().Undefined();
   switch (type) {
     case ePdfField_PushButton:
-      return PushButton::Constructor.New({ widget->Value(), form->Value() });
+      field = PushButton::Constructor.New({ widget->Value(), form->Value() });
+      break;
     case ePdfField_CheckBox:
-      return CheckBox::Constructor.New({ widget->Value(), form->Value() });
+      field = CheckBox::Constructor.New({ widget->Value(), form->Value() });
+      break;
     case ePdfField_RadioButton:
       break;
     case ePdfField_TextField:
-      return TextField::Constructor.New(
+      field = TextField::Constructor.New(
         { widget->Value(), form->Value(), opts });
+      break;
     case ePdfField_ComboBox:
-      return ComboBox::Constructor.New({ widget->Value(), form->Value() });
+      field = ComboBox::Constructor.New({ widget->Value(), form->Value() });
+      break;
     case ePdfField_ListBox:
-      return ListBox::Constructor.New({ widget->Value(), form->Value() });
+      field = ListBox::Constructor.New({ widget->Value(), form->Value() });
+      break;
     case ePdfField_Signature:
       break;
     case ePdfField_Unknown:
       Error::New(info.Env(), "Unknown Field Type").ThrowAsJavaScriptException();
       return info.Env().Undefined();
   }
-  return info.Env().Undefined();
+  // The widget annotation is the new field's dictionary
+  const auto doc = BaseDocument::Of(Self.GetObject()->GetOwner());
+  if (doc && !field.IsUndefined()) {
+    doc->Fields.Add(Self, *widget->GetAnnotation().GetObject());
+  }
+  return field;
 }
 void
 Page::DeleteField(const Napi::CallbackInfo& info)
 {
   int index = info[0].As<Number>();
-  auto form =
-    Self.GetObject()->GetOwner()->GetParentDocument()->GetAcroForm(false);
   auto item = Self.GetField(index).GetFieldObject();
-  auto fields = form->GetObject()->MustGetIndirectKey(Name::FIELDS);
-  bool found = DeleteFormField(Self, *item, *fields);
-  if (!found) {
+  const auto removed = FieldIndex::Unlink(
+    *Self.GetObject()->GetOwner()->GetParentDocument(), { item->Reference() });
+  if (removed.empty()) {
     Error::New(info.Env(), "Failed to find field in AcroForm Fields")
       .ThrowAsJavaScriptException();
     return;
   }
-  Self.DeleteAnnotation(item->Reference());
-}
-bool
-Page::DeleteFormField(PdfPage& page, PdfObject& item, PdfObject& coll)
-{
-  if (!coll.IsArray()) {
-    return false;
-  }
-  auto it = coll.GetArray().begin();
-  while (it != coll.GetArray().end()) {
-    if (it->IsReference() && it->GetReference() == item.Reference()) {
-      coll.GetArray().erase(it);
-      return true;
-    } else if (it->IsReference() &&
-               page.GetObject()
-                 ->GetOwner()
-                 ->GetObject(it->GetReference())
-                 ->IsDictionary() &&
-               page.GetObject()
-                 ->GetOwner()
-                 ->GetObject(it->GetReference())
-                 ->GetDictionary()
-                 .HasKey(Name::KIDS)) {
-      if (DeleteFormField(page,
-                          item,
-                          *page.GetObject()
-                             ->GetOwner()
-                             ->GetObject(it->GetReference())
-                             ->MustGetIndirectKey(Name::KIDS))) {
-        return true;
-      }
-    } else if (it->IsDictionary() && it->GetDictionary().HasKey(Name::KIDS)) {
-      if (DeleteFormField(page, item, *it->MustGetIndirectKey(Name::KIDS))) {
-        return true;
-      }
-    } else {
-      return false;
-    }
-    ++it;
+  const auto ref = item->Reference();
+  Self.DeleteAnnotation(ref);
+  const auto doc = BaseDocument::Of(Self.GetObject()->GetOwner());
+  if (doc) {
+    doc->Fields.Remove(ref);
   }
-  return false;
 }
 #if NOPODOFO_SDK
 void
@@ -25,7 +25,6 @@
 #include <iostream>
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using std::cout;
 using std::endl;
@@ -62,14 +61,14 @@ public:
   JsValue GetBleedBox(const Napi::CallbackInfo&);
   JsValue GetArtBox(const Napi::CallbackInfo&);
   JsValue CreateAnnotation(const Napi::CallbackInfo&);
+  JsValue AddAnnotations(const Napi::CallbackInfo&);
+  JsValue GetAnnotations(const Napi::CallbackInfo&);
+  JsValue Redact(const Napi::CallbackInfo&);
   JsValue GetAnnotation(const Napi::CallbackInfo&);
   JsValue CreateField(const Napi::CallbackInfo&);
   JsValue GetNumAnnots(const Napi::CallbackInfo&);
   void DeleteAnnotation(const Napi::CallbackInfo&);
   void DeleteField(const Napi::CallbackInfo&);
-  static bool DeleteFormField(PoDoFo::PdfPage&,
-                              PoDoFo::PdfObject&,
-                              PoDoFo::PdfObject&);
 #if NOPODOFO_SDK
   void FlattenFields(const Napi::CallbackInfo&);
 #endif
@@ -78,7 +77,6 @@ public:
                                          PoDoFo::PdfRect&);
 
 private:
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_PDFPAGE_HPP
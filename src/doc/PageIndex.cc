@@ -0,0 +1,298 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PageIndex.h"
+#include "../base/Names.h"
+#include <algorithm>
+#include <deque>
+
+using namespace PoDoFo;
+
+using std::vector;
+
+namespace NoPoDoFo {
+
+namespace {
+
+// Deeper trees than this are treated as broken (or cyclic /Parent chains)
+const size_t MaxDepth = 256;
+
+struct Node
+{
+  PdfObject* Object;
+  pdf_int64 Count;
+};
+
+bool
+IsPagesNode(const PdfObject& obj)
+{
+  const auto type = obj.GetDictionary().GetKey(Name::TYPE);
+  if (type && type->IsName()) {
+    return type->GetName() == PdfName(Name::PAGES);
+  }
+  return obj.GetDictionary().HasKey(Name::KIDS);
+}
+
+// Copy the attributes a page inherits from its ancestors into the page, the
+// ancestors are replaced when the tree is rebuilt. A direct /Resources
+// dictionary is moved to an indirect object shared by the pages instead of
+// being copied into each of them.
+void
+Inherit(PdfVecObjects& objects, PdfObject& page)
+{
+  auto& dict = page.GetDictionary();
+  for (const auto& key :
+       { Name::RESOURCES, Name::MEDIA_BOX, Name::CROP_BOX, Name::ROTATE }) {
+    if (dict.HasKey(key)) {
+      continue;
+    }
+    auto parent = page.GetIndirectKey(Name::PARENT);
+    for (size_t depth = 0; parent && parent->IsDictionary() && depth < MaxDepth;
+         ++depth) {
+      const auto value = parent->GetDictionary().GetKey(key);
+      if (value && value->IsDictionary()) {
+        const auto shared = objects.CreateObject(*value);
+        parent->GetDictionary().AddKey(key, shared->Reference());
+        dict.AddKey(key, shared->Reference());
+        break;
+      }
+      if (value) {
+        dict.AddKey(key, *value);
+        break;
+      }
+      parent = parent->GetIndirectKey(Name::PARENT);
+    }
+  }
+}
+
+// Move /Resources inherited as a direct dictionary of an ancestor to an
+// indirect object, a PdfPage keeps a pointer to its resources and the
+// ancestors are replaced when the tree is rebuilt. Returns true if an
+// ancestor was changed.
+bool
+Share(PdfVecObjects& objects, PdfObject& page)
+{
+  if (page.GetDictionary().HasKey(Name::RESOURCES)) {
+    return false;
+  }
+  auto parent = page.GetIndirectKey(Name::PARENT);
+  for (size_t depth = 0; parent && parent->IsDictionary() && depth < MaxDepth;
+       ++depth) {
+    const auto value = parent->GetDictionary().GetKey(Name::RESOURCES);
+    if (value && value->IsDictionary()) {
+      const auto shared = objects.CreateObject(*value);
+      parent->GetDictionary().AddKey(Name::RESOURCES, shared->Reference());
+      return true;
+    }
+    if (value) {
+      return false;
+    }
+    parent = parent->GetIndirectKey(Name::PARENT);
+  }
+  return false;
+}
+
+pdf_int64
+Link(PdfObject& node, vector<Node>::iterator first, vector<Node>::iterator last)
+{
+  PdfArray kids;
+  pdf_int64 count = 0;
+  for (auto it = first; it != last; ++it) {
+    kids.push_back(it->Object->Reference());
+    it->Object->GetDictionary().AddKey(Name::PARENT, node.Reference());
+    count += it->Count;
+  }
+  node.GetDictionary().AddKey(Name::KIDS, kids);
+  node.GetDictionary().AddKey(Name::COUNT, PdfVariant(count));
+  return count;
+}
+}
+
+const vector<PdfObject*>&
+PageIndex::Pages(PdfDocument& doc)
+{
+  if (!Built || Order.size() != static_cast<size_t>(doc.GetPageCount())) {
+    Build(doc);
+  }
+  return Order;
+}
+
+PdfPage*
+PageIndex::Page(PdfDocument& doc, size_t n)
+{
+  return Page(doc, *Pages(doc).at(n));
+}
+
+PdfPage*
+PageIndex::Page(PdfDocument& doc, PdfObject& obj)
+{
+  auto& page = Instances[&obj];
+  if (!page) {
+    // PoDoFo's cached pages may point at the moved dictionary
+    if (Share(*doc.GetObjects(), obj)) {
+      doc.GetPagesTree()->ClearCache();
+    }
+    std::deque<PdfObject*> parents;
+    auto parent = obj.GetIndirectKey(Name::PARENT);
+    while (parent && parent->IsDictionary() && parents.size() < MaxDepth) {
+      parents.push_front(parent);
+      parent = parent->GetIndirectKey(Name::PARENT);
+    }
+    page.reset(new PdfPage(&obj, parents));
+  }
+  return page.get();
+}
+
+void
+PageIndex::Invalidate()
+{
+  Built = false;
+  Order.clear();
+  Nodes.clear();
+}
+
+void
+PageIndex::Reset()
+{
+  Invalidate();
+  for (auto& instance : Instances) {
+    Retired.push_back(std::move(instance.second));
+  }
+  Instances.clear();
+}
+
+void
+PageIndex::Release()
+{
+  Invalidate();
+  Instances.clear();
+  Retired.clear();
+}
+
+void
+PageIndex::Reorder(PdfDocument& doc, const vector<uint32_t>& order)
+{
+  const auto& current = Pages(doc);
+  vector<PdfObject*> pages;
+  pages.reserve(order.size());
+  for (const auto i : order) {
+    pages.push_back(current.at(i));
+  }
+  Rebuild(doc, pages);
+}
+
+void
+PageIndex::Delete(PdfDocument& doc, const std::set<uint32_t>& removed)
+{
+  const auto& current = Pages(doc);
+  vector<PdfObject*> pages;
+  pages.reserve(current.size());
+  for (size_t i = 0; i < current.size(); ++i) {
+    if (removed.count(static_cast<uint32_t>(i))) {
+      // a removed page may still be wrapped, copied or imported, it keeps
+      // its inherited attributes
+      Inherit(*doc.GetObjects(), *current[i]);
+      current[i]->GetDictionary().RemoveKey(Name::PARENT);
+    } else {
+      pages.push_back(current[i]);
+    }
+  }
+  Rebuild(doc, pages);
+}
+
+void
+PageIndex::Build(PdfDocument& doc)
+{
+  Invalidate();
+  Built = true;
+  const auto root = doc.GetCatalog()->GetIndirectKey(Name::PAGES);
+  if (!root || !root->IsDictionary()) {
+    return;
+  }
+  const auto& objects = *doc.GetObjects();
+  // Iterative walk, the kids of each node on the stack are visited in order
+  vector<std::pair<PdfObject*, size_t>> stack{ { root, 0 } };
+  std::set<PdfReference> seen{ root->Reference() };
+  while (!stack.empty()) {
+    const auto node = stack.back().first;
+    const auto kids = node->GetIndirectKey(Name::KIDS);
+    const auto next = stack.back().second++;
+    if (!kids || !kids->IsArray() || next >= kids->GetArray().size()) {
+      stack.pop_back();
+      continue;
+    }
+    const auto& item = kids->GetArray()[next];
+    if (!item.IsReference() || !seen.insert(item.GetReference()).second) {
+      continue;
+    }
+    const auto kid = objects.GetObject(item.GetReference());
+    if (!kid || !kid->IsDictionary()) {
+      continue;
+    }
+    if (IsPagesNode(*kid)) {
+      Nodes.insert(kid->Reference());
+      if (stack.size() < MaxDepth) {
+        stack.emplace_back(kid, 0);
+      }
+    } else {
+      Order.push_back(kid);
+    }
+  }
+}
+
+void
+PageIndex::Rebuild(PdfDocument& doc, vector<PdfObject*>& pages)
+{
+  const auto root = doc.GetCatalog()->GetIndirectKey(Name::PAGES);
+  if (!root || !root->IsDictionary()) {
+    return;
+  }
+  auto& objects = *doc.GetObjects();
+  for (const auto page : pages) {
+    Inherit(objects, *page);
+  }
+  std::set<PdfReference> created;
+  vector<Node> level;
+  level.reserve(pages.size());
+  for (const auto page : pages) {
+    level.push_back({ page, 1 });
+  }
+  while (level.size() > NodeSize) {
+    vector<Node> parents;
+    for (size_t i = 0; i < level.size(); i += NodeSize) {
+      const auto end = std::min(i + NodeSize, level.size());
+      const auto node = objects.CreateObject(Name::PAGES.c_str());
+      const auto count = Link(*node, level.begin() + i, level.begin() + end);
+      parents.push_back({ node, count });
+      created.insert(node->Reference());
+    }
+    level.swap(parents);
+  }
+  Link(*root, level.begin(), level.end());
+  // None of the index's PdfPage instances points into the removed nodes, see
+  // Share, the pages cached by PoDoFo are deleted with its cache
+  for (const auto& ref : Nodes) {
+    delete objects.RemoveObject(ref);
+  }
+  doc.GetPagesTree()->ClearCache();
+  Order.swap(pages);
+  Nodes.swap(created);
+  Built = true;
+}
+}
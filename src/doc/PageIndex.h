@@ -0,0 +1,83 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_PAGEINDEX_H
+#define NPDF_PAGEINDEX_H
+
+#include <map>
+#include <memory>
+#include <podofo/podofo.h>
+#include <set>
+#include <vector>
+
+namespace NoPoDoFo {
+
+/**
+ * Flat index of a document's page dictionaries in page order, built by one
+ * walk of the page tree and kept until the page count changes or the index is
+ * invalidated. Bulk reorders and deletes are applied to the index and the
+ * page tree is written back once, balanced, with at most NodeSize kids per
+ * node, instead of updating /Kids and /Count for each page.
+ *
+ * The index also owns the PdfPage of every page handed to javascript. They
+ * are kept until the document is destroyed, so a rebuild, which clears
+ * PoDoFo's page cache, does not invalidate a Page or an open Painter.
+ */
+class PageIndex
+{
+public:
+  PageIndex() = default;
+  PageIndex(const PageIndex&) = delete;
+  const PageIndex& operator=(const PageIndex&) = delete;
+
+  const std::vector<PoDoFo::PdfObject*>& Pages(PoDoFo::PdfDocument&);
+  // The PdfPage of a page dictionary, owned by the index
+  PoDoFo::PdfPage* Page(PoDoFo::PdfDocument&, PoDoFo::PdfObject& page);
+  PoDoFo::PdfPage* Page(PoDoFo::PdfDocument&, size_t n);
+  // Drop the page order after pages were added or removed elsewhere
+  void Invalidate();
+  // Drop the order when a new file is loaded, the PdfPage instances of the
+  // previous file are retired but kept until Release
+  void Reset();
+  // Delete every PdfPage, only when the document is destroyed
+  void Release();
+
+  // The page at order[i] is moved to i, order must be a permutation of the
+  // page indices
+  void Reorder(PoDoFo::PdfDocument&, const std::vector<uint32_t>& order);
+  // Remove the pages from the page tree, the page objects are only unlinked
+  // after the attributes they inherit are copied into them
+  void Delete(PoDoFo::PdfDocument&, const std::set<uint32_t>& pages);
+
+  static const size_t NodeSize = 32;
+
+private:
+  void Build(PoDoFo::PdfDocument&);
+  void Rebuild(PoDoFo::PdfDocument&, std::vector<PoDoFo::PdfObject*>& pages);
+
+  bool Built = false;
+  std::vector<PoDoFo::PdfObject*> Order;
+  // Intermediate /Pages nodes below the root found by the last walk
+  std::set<PoDoFo::PdfReference> Nodes;
+  std::map<const PoDoFo::PdfObject*, std::unique_ptr<PoDoFo::PdfPage>>
+    Instances;
+  std::vector<std::unique_ptr<PoDoFo::PdfPage>> Retired;
+};
+}
+#endif // NPDF_PAGEINDEX_H
@@ -18,10 +18,13 @@
  */
 
 #include "Painter.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "../base/Color.h"
 #include "../base/Stream.h"
 #include "../base/XObject.h"
+#include "CommandBuffer.h"
+#include "DisplayList.h"
 #include "Document.h"
 #include "ExtGState.h"
 #include "Font.h"
@@ -29,7 +32,7 @@
 #include "Page.h"
 #include "Rect.h"
 #include "StreamDocument.h"
-#include <spdlog/spdlog.h>
+#include "TextLayout.h"
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -38,33 +41,66 @@ using std::cout;
 using std::endl;
 using std::make_unique;
 using std::string;
+using std::vector;
 
 namespace NoPoDoFo {
 
 FunctionReference Painter::constructor; // NOLINT
 
+// Read { kerning?: boolean, hyphenate?: (word: string) => number[] }, the
+// hook only runs inside the calling painter method
+static LayoutOptions
+ParseLayoutOptions(const Napi::Value& value)
+{
+  LayoutOptions opts;
+  if (!value.IsObject()) {
+    return opts;
+  }
+  auto o = value.As<Object>();
+  if (o.Has("kerning")) {
+    opts.Kerning = o.Get("kerning").ToBoolean();
+  }
+  if (o.Has("hyphenate") && o.Get("hyphenate").IsFunction()) {
+    auto fn = o.Get("hyphenate").As<Function>();
+    opts.Hyphenate = [fn](const string& word) {
+      vector<size_t> breaks;
+      auto result = fn.Call({ String::New(fn.Env(), word) });
+      if (result.IsArray()) {
+        auto js = result.As<Array>();
+        for (uint32_t i = 0; i < js.Length(); i++) {
+          if (js.Get(i).IsNumber()) {
+            breaks.push_back(js.Get(i).As<Number>().Uint32Value());
+          }
+        }
+      }
+      return breaks;
+    };
+  }
+  return opts;
+}
+
 Painter::Painter(const Napi::CallbackInfo& info)
   : ObjectWrap(info)
 {
-  DbgLog = spdlog::get("DbgLog");
   auto o = info[0].As<Object>();
   if (o.InstanceOf(Document::Constructor.Value())) {
     IsMemDoc = true;
-    Doc = Document::Unwrap(o)->Base;
+    Parent = Document::Unwrap(o);
   } else if (o.InstanceOf(StreamDocument::Constructor.Value())) {
     IsMemDoc = false;
-    Doc = StreamDocument::Unwrap(o)->Base;
+    Parent = StreamDocument::Unwrap(o);
   } else {
     TypeError::New(info.Env(), "requires an instance of BaseDocument")
       .ThrowAsJavaScriptException();
     return;
   }
+  Doc = Parent->Base;
   Self = make_unique<PdfPainter>();
 }
 
 Painter::~Painter()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Painter Cleanup");
+  NPDF_LOG_DEBUG("Painter Cleanup");
   HandleScope scope(Env());
   Doc = nullptr;
 }
@@ -127,7 +163,10 @@ Painter::Initialize(Napi::Env& env, Napi::Object& target)
       InstanceMethod("drawLine", &Painter::DrawLine),
       InstanceMethod("drawMultiLineText", &Painter::DrawMultiLineText),
       InstanceMethod("drawText", &Painter::DrawText),
-      InstanceMethod("drawImage", &Painter::DrawImage) });
+      InstanceMethod("drawImage", &Painter::DrawImage),
+      InstanceMethod("execute", &Painter::Execute),
+      InstanceMethod("record", &Painter::Record),
+      InstanceMethod("drawList", &Painter::DrawList) });
   constructor = Napi::Persistent(ctor);
   constructor.SuppressDestruct();
   target.Set("Painter", ctor);
@@ -274,12 +313,57 @@ Painter::DrawMultiLineText(const CallbackInfo& info)
     verticalAlignment =
       static_cast<EPdfVerticalAlignment>(info[3].As<Number>().Int32Value());
   }
+  PdfFont* font = Self->GetFont();
+  if (!font) {
+    throw Error::New(info.Env(), "Font has not been set");
+  }
+  LayoutOptions opts =
+    ParseLayoutOptions(info.Length() >= 5 ? info[4] : info.Env().Undefined());
   try {
-    Self->DrawMultiLineText(
-      rect,
-      PdfString(reinterpret_cast<const pdf_utf8*>(text.c_str())),
-      alignment,
-      verticalAlignment);
+    // same placement as PdfPainter::DrawMultiLineText, with the lines and
+    // alignment widths taken from the layout cache
+    vector<string> lines =
+      Parent->Layout.Lines(*font, text, rect.GetWidth(), opts);
+    auto table = Parent->Layout.Table(*font);
+    const PdfFontMetrics* metrics = font->GetFontMetrics();
+    double lineSpacing = metrics->GetLineSpacing();
+    double lineGap =
+      lineSpacing - metrics->GetAscent() + metrics->GetDescent();
+    double x = rect.GetLeft();
+    double y = rect.GetBottom();
+    double height = rect.GetHeight();
+    switch (verticalAlignment) {
+      default:
+      case ePdfVerticalAlignment_Top:
+        y += height;
+        break;
+      case ePdfVerticalAlignment_Bottom:
+        y += lineSpacing * lines.size();
+        break;
+      case ePdfVerticalAlignment_Center:
+        y += height - (height - lineSpacing * lines.size()) / 2.0;
+        break;
+    }
+    y -= metrics->GetAscent() + lineGap / 2.0;
+    Self->Save();
+    Self->SetClipRect(rect);
+    for (auto& line : lines) {
+      if (!line.empty()) {
+        double offset = 0.0;
+        if (alignment != ePdfAlignment_Left) {
+          offset = rect.GetWidth() - table->Width(line, opts.Kerning);
+          if (alignment == ePdfAlignment_Center) {
+            offset /= 2.0;
+          }
+        }
+        Self->DrawText(
+          x + offset,
+          y,
+          PdfString(reinterpret_cast<const pdf_utf8*>(line.c_str())));
+      }
+      y -= lineSpacing;
+    }
+    Self->Restore();
   } catch (PdfError& err) {
     ErrorHandler(err, info);
   }
@@ -296,7 +380,7 @@ Painter::DrawImage(const CallbackInfo& info)
     // Image
     auto imgObj = info[0].As<Object>();
     Image* imgInstance = Image::Unwrap(imgObj);
-    PdfImage img = imgInstance->GetImage();
+    PdfImage& img = imgInstance->GetImage();
 
     // Coordinates
     double x, y;
@@ -326,6 +410,7 @@ Painter::DrawImage(const CallbackInfo& info)
           .ThrowAsJavaScriptException();
       }
     }
+    // draws the shared XObject by reference, the image is not copied
     Self->DrawImage(x, y, &img, width, height);
   } catch (PdfError& err) {
     ErrorHandler(err, info);
@@ -388,7 +473,8 @@ Painter::GetFont(const Napi::CallbackInfo& info)
     return info.Env().Null();
   }
   return Font::Constructor.New(
-    { External<PdfFont>::New(info.Env(), Self->GetFont()) });
+    { External<PdfFont>::New(info.Env(), Self->GetFont()),
+      External<BaseDocument>::New(info.Env(), Parent) });
 }
 void
 Painter::SetClipRect(const Napi::CallbackInfo& info)
@@ -738,13 +824,18 @@ Painter::GetMultiLineText(const CallbackInfo& info)
 {
   double width = info[0].As<Number>();
   string text = info[1].As<String>().Utf8Value();
-  bool skipSpaces = info[2].As<Boolean>();
-  vector<PdfString> lines =
-    Self->GetMultiLineTextAsLines(width, PdfString(text), skipSpaces);
+  LayoutOptions opts =
+    ParseLayoutOptions(info.Length() >= 4 ? info[3] : info.Env().Undefined());
+  opts.SkipSpaces = info.Length() < 3 || info[2].ToBoolean();
+  PdfFont* font = Self->GetFont();
+  if (!font) {
+    throw Error::New(info.Env(), "Font has not been set");
+  }
+  vector<string> lines = Parent->Layout.Lines(*font, text, width, opts);
   auto js = Array::New(info.Env());
   uint32_t count = 0;
   for (auto& i : lines) {
-    js.Set(count, i.GetStringUtf8());
+    js.Set(count, String::New(info.Env(), i));
     count++;
   }
   return js;
@@ -820,6 +911,135 @@ Painter::DrawGlyph(const CallbackInfo& info)
   }
 }
 
+/**
+ * Decode and run a command buffer: info[0] Uint8Array of PainterOp,
+ * info[1] Float64Array of operands consumed in order, info[2] (optional)
+ * string table, info[3] (optional) resource table of Font, ExtGState and
+ * Image instances. The whole buffer runs in a single call.
+ */
+void
+Painter::Execute(const CallbackInfo& info)
+{
+  if (info.Length() < 2) {
+    throw TypeError::New(
+      info.Env(),
+      "execute requires an opcode Uint8Array and an operand Float64Array");
+  }
+  CommandBuffer::Validate(info[0], info[1], "execute");
+  auto ops = info[0].As<Uint8Array>();
+  auto operands = info[1].As<Float64Array>();
+  vector<PdfString> strings;
+  if (info.Length() >= 3 && info[2].IsArray()) {
+    strings = CommandBuffer::Strings(info[2].As<Array>());
+  }
+  vector<PainterResource> resources;
+  if (info.Length() >= 4 && info[3].IsArray()) {
+    resources = CommandBuffer::Resources(info[3].As<Array>());
+  }
+  try {
+    CommandBuffer::Run(info.Env(),
+                       *Self,
+                       ops.Data(),
+                       ops.ElementLength(),
+                       operands.Data(),
+                       operands.ElementLength(),
+                       strings,
+                       resources);
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+}
+
+/**
+ * Run a command buffer once into a new Form XObject and return it as a
+ * DisplayList: info[0] Rect (the XObject bounding box), info[1] - info[4]
+ * as Painter.execute, info[5] (optional) slot program { ops, operands,
+ * numbers?, resources? } replayed on top of the XObject by drawList.
+ */
+JsValue
+Painter::Record(const CallbackInfo& info)
+{
+  if (info.Length() < 3 || !info[0].IsObject() ||
+      !info[0].As<Object>().InstanceOf(Rect::constructor.Value())) {
+    throw TypeError::New(info.Env(),
+                         "record requires a Rect, an opcode Uint8Array and "
+                         "an operand Float64Array");
+  }
+  CommandBuffer::Validate(info[1], info[2], "record");
+  auto ops = info[1].As<Uint8Array>();
+  auto operands = info[2].As<Float64Array>();
+  vector<PdfString> strings;
+  if (info.Length() >= 4 && info[3].IsArray()) {
+    strings = CommandBuffer::Strings(info[3].As<Array>());
+  }
+  vector<PainterResource> resources;
+  if (info.Length() >= 5 && info[4].IsArray()) {
+    resources = CommandBuffer::Resources(info[4].As<Array>());
+  }
+  std::unique_ptr<PdfXObject> xobj;
+  try {
+    xobj = make_unique<PdfXObject>(
+      Rect::Unwrap(info[0].As<Object>())->GetRect(), Doc);
+    PdfPainter painter;
+    painter.SetPage(xobj.get());
+    CommandBuffer::Run(info.Env(),
+                       painter,
+                       ops.Data(),
+                       ops.ElementLength(),
+                       operands.Data(),
+                       operands.ElementLength(),
+                       strings,
+                       resources);
+    painter.FinishPage();
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+    return info.Env().Undefined();
+  }
+  auto list = DisplayList::Constructor.New(
+    { External<PdfXObject>::New(info.Env(), xobj.release()) });
+  if (info.Length() >= 6 && info[5].IsObject()) {
+    DisplayList::Unwrap(list)->SetSlots(info[5].As<Object>());
+  }
+  return list;
+}
+
+/**
+ * Draw a DisplayList: info[0] DisplayList, info[1] x, info[2] y,
+ * info[3] (optional) { texts?: string[], numbers?: number[] } slot values
+ */
+void
+Painter::DrawList(const CallbackInfo& info)
+{
+  if (info.Length() < 3 || !info[0].IsObject() ||
+      !info[0].As<Object>().InstanceOf(DisplayList::Constructor.Value()) ||
+      !info[1].IsNumber() || !info[2].IsNumber()) {
+    throw TypeError::New(info.Env(),
+                         "drawList requires a DisplayList, x and y");
+  }
+  auto list = DisplayList::Unwrap(info[0].As<Object>());
+  double x = info[1].As<Number>();
+  double y = info[2].As<Number>();
+  vector<PdfString> texts;
+  vector<double> numbers;
+  if (info.Length() >= 4 && info[3].IsObject()) {
+    auto values = info[3].As<Object>();
+    if (values.Has("texts") && values.Get("texts").IsArray()) {
+      texts = CommandBuffer::Strings(values.Get("texts").As<Array>());
+    }
+    if (values.Has("numbers") && values.Get("numbers").IsArray()) {
+      auto js = values.Get("numbers").As<Array>();
+      for (uint32_t i = 0; i < js.Length(); i++) {
+        numbers.push_back(js.Get(i).As<Number>().DoubleValue());
+      }
+    }
+  }
+  try {
+    list->Draw(info.Env(), *Self, x, y, texts, numbers);
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+}
+
 void
 Painter::GetCMYK(Napi::Value& value, float* CMYK)
 {
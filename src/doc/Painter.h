@@ -24,10 +24,11 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 using JsValue = Napi::Value;
 
 namespace NoPoDoFo {
+class BaseDocument;
+
 class Painter : public Napi::ObjectWrap<Painter>
 {
 public:
@@ -91,6 +92,9 @@ public:
   void DrawGlyph(const Napi::CallbackInfo&);
   JsValue GetPrecision(const Napi::CallbackInfo&);
   void SetPrecision(const Napi::CallbackInfo&, const JsValue&);
+  void Execute(const Napi::CallbackInfo&);
+  JsValue Record(const Napi::CallbackInfo&);
+  void DrawList(const Napi::CallbackInfo&);
 
   PoDoFo::PdfPainter& GetPainter() const { return *Self; }
 
@@ -98,9 +102,9 @@ private:
   bool IsMemDoc = false;
   std::unique_ptr<PoDoFo::PdfPainter> Self;
   PoDoFo::PdfDocument* Doc;
+  BaseDocument* Parent = nullptr;
   void GetCMYK(JsValue&, float* CMYK);
   void GetRGB(JsValue&, float* rgb);
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_PAINTER_H
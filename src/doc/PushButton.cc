@@ -18,7 +18,6 @@
  */
 
 #include "PushButton.h"
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -33,7 +32,6 @@ PushButton::PushButton(const Napi::CallbackInfo& info)
   , Button(Field::GetField())
   , Self(Field::GetField())
 {
-  DbgLog = spdlog::get("DbgLog");
 }
 
 void
@@ -46,7 +46,6 @@ public:
   PdfPushButton GetPushButton() { return PdfPushButton(Self); }
   PdfField& Self;
 private:
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_PUSHBUTTON_H
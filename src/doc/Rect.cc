@@ -18,16 +18,15 @@
  */
 
 #include "Rect.h"
+#include "../Logger.h"
 #include "../ValidateArguments.h"
 #include <iostream>
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
 using std::cout;
 using std::endl;
 using std::vector;
-using tl::nullopt;
 
 namespace NoPoDoFo {
 
@@ -36,15 +35,10 @@ FunctionReference Rect::constructor; // NOLINT
 Rect::Rect(const CallbackInfo& info)
   : ObjectWrap(info)
 {
-  DbgLog = spdlog::get("DbgLog");
-  vector<int> opts = AssertCallbackInfo(
-    info,
-    {
-      { 0, { nullopt, option(napi_external), option(napi_number) } },
-      { 1, { nullopt, option(napi_number) } },
-      { 2, { nullopt, option(napi_number) } },
-      { 3, { nullopt, option(napi_number) } },
-    });
+  auto opts = AssertArguments<ArgTypes<ArgOmitted, napi_external, napi_number>,
+                              ArgTypes<ArgOmitted, napi_number>,
+                              ArgTypes<ArgOmitted, napi_number>,
+                              ArgTypes<ArgOmitted, napi_number>>(info);
   switch (opts[0]) {
     case 0:
       Self = new PdfRect();
@@ -75,7 +69,7 @@ Rect::Rect(const CallbackInfo& info)
 
 Rect::~Rect()
 {
-  if(DbgLog != nullptr) DbgLog->debug("Rect Cleanup");
+  NPDF_LOG_DEBUG("Rect Cleanup");
   HandleScope scope(Env());
   delete Self;
 }
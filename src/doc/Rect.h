@@ -22,7 +22,6 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 using JsValue = Napi::Value;
 
 namespace NoPoDoFo {
@@ -49,7 +48,6 @@ public:
 
 private:
   PoDoFo::PdfRect* Self;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_RECT_H
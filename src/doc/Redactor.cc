@@ -0,0 +1,887 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Redactor.h"
+#include "../base/Names.h"
+#include "Rect.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <memory>
+
+using namespace Napi;
+using namespace PoDoFo;
+
+using std::string;
+using std::vector;
+
+namespace NoPoDoFo {
+
+namespace {
+PdfObject*
+Resolve(PdfVecObjects* objects, PdfObject* obj)
+{
+  return obj && obj->IsReference() ? objects->GetObject(obj->GetReference())
+                                   : obj;
+}
+
+double
+Real(const PdfVariant& value)
+{
+  return value.IsNumber() || value.IsReal() ? value.GetReal() : 0;
+}
+
+// A missing object, or a reference to one, is null and read as 0
+double
+Real(const PdfObject* obj)
+{
+  return obj ? Real(*obj) : 0;
+}
+
+bool
+IsName(const PdfObject* obj, const string& name)
+{
+  return obj && obj->IsName() && obj->GetName() == PdfName(name);
+}
+
+string
+Format(const PdfVariant& value)
+{
+  string out;
+  value.ToString(out);
+  return out;
+}
+}
+
+RedactOptions
+ParseRedactOptions(const Napi::Object& opts)
+{
+  RedactOptions options;
+  if (opts.Has("fill") && opts.Get("fill").IsBoolean()) {
+    options.Fill = opts.Get("fill").As<Boolean>();
+  }
+  if (opts.Has("color") && !opts.Get("color").IsUndefined()) {
+    if (!opts.Get("color").IsArray() ||
+        opts.Get("color").As<Napi::Array>().Length() != 3) {
+      throw TypeError::New(opts.Env(), "color must be an RGB array");
+    }
+    auto color = opts.Get("color").As<Napi::Array>();
+    for (uint32_t i = 0; i < 3; i++) {
+      options.Color[i] = color.Get(i).As<Number>().DoubleValue();
+    }
+  }
+  if (opts.Has("threads") && opts.Get("threads").IsNumber()) {
+    options.Threads = opts.Get("threads").As<Number>().Uint32Value();
+  }
+  return options;
+}
+
+Napi::Object
+RedactReport::ToJS(const Napi::Env& env) const
+{
+  auto o = Object::New(env);
+  o.Set("glyphs", Number::New(env, Glyphs));
+  o.Set("images", Number::New(env, Images));
+  o.Set("forms", Number::New(env, Forms));
+  o.Set("resources", Number::New(env, Resources));
+  return o;
+}
+
+Redactor::Redactor(vector<PdfRect> rects)
+  : Rects(std::move(rects))
+{}
+
+vector<PdfRect>
+Redactor::ParseRects(const Napi::Value& value)
+{
+  vector<PdfRect> rects;
+  if (value.IsTypedArray() &&
+      value.As<TypedArray>().TypedArrayType() == napi_float64_array) {
+    auto packed = value.As<Float64Array>();
+    if (packed.ElementLength() % 4 != 0) {
+      throw RangeError::New(value.Env(),
+                            "rects requires left, bottom, width and height "
+                            "per rect");
+    }
+    const double* data = packed.Data();
+    for (size_t i = 0; i < packed.ElementLength(); i += 4) {
+      rects.emplace_back(data[i], data[i + 1], data[i + 2], data[i + 3]);
+    }
+    return rects;
+  }
+  if (!value.IsArray()) {
+    throw TypeError::New(value.Env(),
+                         "rects must be an Array of Rect or a Float64Array");
+  }
+  auto list = value.As<Napi::Array>();
+  for (uint32_t i = 0; i < list.Length(); i++) {
+    auto item = list.Get(i);
+    if (!item.IsObject() ||
+        !item.As<Object>().InstanceOf(Rect::constructor.Value())) {
+      throw TypeError::New(value.Env(),
+                           "rects must be an Array of Rect or a Float64Array");
+    }
+    rects.push_back(Rect::Unwrap(item.As<Object>())->GetRect());
+  }
+  return rects;
+}
+
+vector<PdfReference>
+Redactor::ContentStreams(PdfPage& page)
+{
+  vector<PdfReference> refs;
+  auto objects = page.GetObject()->GetOwner();
+  auto contents = page.GetObject()->GetDictionary().GetKey(
+    PdfName(Name::CONTENTS));
+  if (contents && contents->IsReference()) {
+    auto resolved = objects->GetObject(contents->GetReference());
+    if (!resolved || !resolved->IsArray()) {
+      refs.push_back(contents->GetReference());
+      return refs;
+    }
+    contents = resolved;
+  }
+  if (contents && contents->IsArray()) {
+    for (auto& item : contents->GetArray()) {
+      if (item.IsReference()) {
+        refs.push_back(item.GetReference());
+      }
+    }
+  }
+  return refs;
+}
+
+std::map<PdfReference, int>
+Redactor::ContentReferences(PdfDocument& doc)
+{
+  std::map<PdfReference, int> references;
+  for (int i = 0; i < doc.GetPageCount(); i++) {
+    auto streams = ContentStreams(*doc.GetPage(i));
+    std::sort(streams.begin(), streams.end());
+    streams.erase(std::unique(streams.begin(), streams.end()), streams.end());
+    for (const auto& ref : streams) {
+      references[ref]++;
+    }
+  }
+  return references;
+}
+
+std::set<PdfReference>
+Redactor::SharedContents(const std::map<PdfReference, int>& references,
+                         PdfPage& page)
+{
+  std::set<PdfReference> shared;
+  for (const auto& ref : ContentStreams(page)) {
+    auto count = references.find(ref);
+    if (count != references.end() && count->second > 1) {
+      shared.insert(ref);
+    }
+  }
+  return shared;
+}
+
+void
+Redactor::RemoveUnusedContents(PdfDocument& doc,
+                               const std::map<PdfReference, int>& before)
+{
+  const auto after = ContentReferences(doc);
+  for (const auto& entry : before) {
+    if (entry.second > 1 && after.find(entry.first) == after.end()) {
+      delete doc.GetObjects()->RemoveObject(entry.first);
+    }
+  }
+}
+
+std::map<PdfReference, int>
+Redactor::XObjectReferences(PdfDocument& doc)
+{
+  std::map<PdfReference, int> references;
+  std::set<PdfReference> visited;
+  for (int i = 0; i < doc.GetPageCount(); i++) {
+    auto page = doc.GetPage(i);
+    CountXObjects(
+      doc.GetObjects(), page->GetResources(), references, visited);
+  }
+  return references;
+}
+
+void
+Redactor::CountXObjects(PdfVecObjects* objects,
+                        PdfObject* resources,
+                        std::map<PdfReference, int>& references,
+                        std::set<PdfReference>& visited)
+{
+  resources = Resolve(objects, resources);
+  if (!resources || !resources->IsDictionary()) {
+    return;
+  }
+  auto xobjects = Resolve(
+    objects, resources->GetDictionary().GetKey(PdfName(Name::XOBJECT)));
+  if (!xobjects || !xobjects->IsDictionary()) {
+    return;
+  }
+  for (auto& key : xobjects->GetDictionary().GetKeys()) {
+    if (!key.second->IsReference()) {
+      continue;
+    }
+    const auto ref = key.second->GetReference();
+    references[ref]++;
+    auto xobj = objects->GetObject(ref);
+    if (xobj && xobj->IsDictionary() && visited.insert(ref).second) {
+      CountXObjects(objects,
+                    xobj->GetDictionary().GetKey(PdfName(Name::RESOURCES)),
+                    references,
+                    visited);
+    }
+  }
+}
+
+void
+Redactor::Unreference(PdfVecObjects* objects,
+                      const PdfReference& ref,
+                      std::map<PdfReference, int>& references)
+{
+  auto count = references.find(ref);
+  if (count == references.end() || --count->second > 0) {
+    return;
+  }
+  references.erase(count);
+  std::unique_ptr<PdfObject> xobj(objects->RemoveObject(ref));
+  if (!xobj || !xobj->IsDictionary()) {
+    return;
+  }
+  auto resources = Resolve(
+    objects, xobj->GetDictionary().GetKey(PdfName(Name::RESOURCES)));
+  auto nested = resources && resources->IsDictionary()
+                  ? Resolve(objects,
+                            resources->GetDictionary().GetKey(
+                              PdfName(Name::XOBJECT)))
+                  : nullptr;
+  if (!nested || !nested->IsDictionary()) {
+    return;
+  }
+  for (auto& key : nested->GetDictionary().GetKeys()) {
+    if (key.second->IsReference()) {
+      Unreference(objects, key.second->GetReference(), references);
+    }
+  }
+}
+
+double
+Redactor::FontWidths::Width(uint32_t code) const
+{
+  auto width = Widths.find(code);
+  return width == Widths.end() ? DefaultWidth : width->second;
+}
+
+Redactor::FontWidths
+Redactor::Widths(PdfVecObjects* objects, PdfObject* font)
+{
+  FontWidths widths;
+  if (!font || !font->IsDictionary()) {
+    return widths;
+  }
+  auto& dict = font->GetDictionary();
+  PdfObject* descriptor = nullptr;
+  if (IsName(dict.GetKey(PdfName(Name::SUBTYPE)), Name::TYPE0)) {
+    widths.CodeBytes = 2;
+    widths.DefaultWidth = 1000;
+    auto descendants =
+      Resolve(objects, dict.GetKey(PdfName(Name::DESCENDANT_FONTS)));
+    auto cid = descendants && descendants->IsArray() &&
+                   !descendants->GetArray().empty()
+                 ? Resolve(objects, &descendants->GetArray()[0])
+                 : nullptr;
+    if (!cid || !cid->IsDictionary()) {
+      return widths;
+    }
+    auto& cidDict = cid->GetDictionary();
+    auto dw = Resolve(objects, cidDict.GetKey(PdfName(Name::DW)));
+    if (dw && (dw->IsNumber() || dw->IsReal())) {
+      widths.DefaultWidth = dw->GetReal();
+    }
+    // [c [w1 w2 ...] cFirst cLast w ...]
+    auto w = Resolve(objects, cidDict.GetKey(PdfName(Name::W)));
+    if (w && w->IsArray()) {
+      auto& list = w->GetArray();
+      for (size_t i = 0; i + 1 < list.size();) {
+        const auto first = static_cast<uint32_t>(Real(list[i]));
+        auto next = Resolve(objects, &list[i + 1]);
+        if (next && next->IsArray()) {
+          auto& values = next->GetArray();
+          for (size_t j = 0; j < values.size(); j++) {
+            widths.Widths[first + static_cast<uint32_t>(j)] =
+              Real(Resolve(objects, &values[j]));
+          }
+          i += 2;
+        } else if (i + 2 < list.size()) {
+          const auto last = static_cast<uint32_t>(Real(list[i + 1]));
+          const auto width = Real(Resolve(objects, &list[i + 2]));
+          for (uint32_t c = first; c <= last && c - first <= 0xFFFF; c++) {
+            widths.Widths[c] = width;
+          }
+          i += 3;
+        } else {
+          break;
+        }
+      }
+    }
+    descriptor = Resolve(objects, cidDict.GetKey(PdfName(Name::FONT_DESC)));
+  } else {
+    // Type3 widths are in glyph space, mapped to text space by /FontMatrix
+    double scale = 1;
+    auto matrix = Resolve(objects, dict.GetKey(PdfName(Name::FONT_MATRIX)));
+    if (IsName(dict.GetKey(PdfName(Name::SUBTYPE)), Name::TYPE3) && matrix &&
+        matrix->IsArray() && matrix->GetArray().size() == 6) {
+      scale = Real(matrix->GetArray()[0]) * 1000;
+    }
+    descriptor = Resolve(objects, dict.GetKey(PdfName(Name::FONT_DESC)));
+    auto list = Resolve(objects, dict.GetKey(PdfName(Name::WIDTHS)));
+    auto first = Resolve(objects, dict.GetKey(PdfName(Name::FIRST_CHAR)));
+    if (list && list->IsArray()) {
+      const auto firstChar =
+        static_cast<uint32_t>(std::max(0.0, Real(first)));
+      auto& values = list->GetArray();
+      for (size_t i = 0; i < values.size(); i++) {
+        widths.Widths[firstChar + static_cast<uint32_t>(i)] =
+          Real(Resolve(objects, &values[i])) * scale;
+      }
+      widths.DefaultWidth = 0;
+      if (descriptor && descriptor->IsDictionary()) {
+        widths.DefaultWidth = Real(Resolve(
+          objects,
+          descriptor->GetDictionary().GetKey(PdfName(Name::MISSING_WIDTH))));
+      }
+    } else if (objects->GetParentDocument()) {
+      // Standard 14 fonts may omit /Widths, use PoDoFo's built in metrics
+      try {
+        auto pdfFont = objects->GetParentDocument()->GetFont(font);
+        auto metrics = pdfFont ? pdfFont->GetFontMetrics() : nullptr;
+        const double unit =
+          metrics ? metrics->GetFontSize() * metrics->GetFontScale() / 100 : 0;
+        if (unit > 0) {
+          for (uint32_t c = 0; c < 256; c++) {
+            widths.Widths[c] =
+              metrics->CharWidth(static_cast<unsigned char>(c)) / unit * 1000;
+          }
+        }
+      } catch (PdfError&) {
+      }
+    }
+  }
+  if (descriptor && descriptor->IsDictionary()) {
+    const auto ascent = Real(Resolve(
+      objects, descriptor->GetDictionary().GetKey(PdfName(Name::ASCENT))));
+    const auto descent = Real(Resolve(
+      objects, descriptor->GetDictionary().GetKey(PdfName(Name::DESCENT))));
+    if (ascent > 0) {
+      widths.Ascent = ascent;
+    }
+    if (descent < 0) {
+      widths.Descent = descent;
+    }
+  }
+  return widths;
+}
+
+void
+Redactor::Load(PdfPage& page)
+{
+  auto objects = page.GetObject()->GetOwner();
+  for (const auto& ref : ContentStreams(page)) {
+    auto stream = objects->GetObject(ref);
+    if (!stream || !stream->HasStream()) {
+      continue;
+    }
+    char* buffer = nullptr;
+    pdf_long length = 0;
+    stream->GetStream()->GetFilteredCopy(&buffer, &length);
+    Content.append(buffer, static_cast<size_t>(length));
+    Content += '\n';
+    podofo_free(buffer);
+  }
+  auto resources = Resolve(objects, page.GetResources());
+  if (!resources || !resources->IsDictionary()) {
+    return;
+  }
+  auto fonts = Resolve(
+    objects, resources->GetDictionary().GetKey(PdfName(Name::FONT)));
+  if (fonts && fonts->IsDictionary()) {
+    for (auto& key : fonts->GetDictionary().GetKeys()) {
+      Fonts[key.first.GetName()] =
+        Widths(objects, Resolve(objects, key.second));
+    }
+  }
+  auto xobjects = Resolve(
+    objects, resources->GetDictionary().GetKey(PdfName(Name::XOBJECT)));
+  if (!xobjects || !xobjects->IsDictionary()) {
+    return;
+  }
+  for (auto& key : xobjects->GetDictionary().GetKeys()) {
+    auto xobj = Resolve(objects, key.second);
+    if (!xobj || !xobj->IsDictionary()) {
+      continue;
+    }
+    auto& dict = xobj->GetDictionary();
+    auto subtype = dict.GetKey(PdfName(Name::SUBTYPE));
+    XObjectBounds bounds;
+    if (IsName(subtype, Name::IMAGE)) {
+      bounds.Image = true;
+      XObjects[key.first.GetName()] = bounds;
+      continue;
+    }
+    auto bbox = Resolve(objects, dict.GetKey(PdfName(Name::BBOX)));
+    if (!IsName(subtype, Name::FORM) || !bbox || !bbox->IsArray() ||
+        bbox->GetArray().size() != 4) {
+      continue;
+    }
+    Matrix m = { { 1, 0, 0, 1, 0, 0 } };
+    auto matrix = Resolve(objects, dict.GetKey(PdfName(Name::MATRIX)));
+    if (matrix && matrix->IsArray() && matrix->GetArray().size() == 6) {
+      for (size_t i = 0; i < 6; i++) {
+        m[i] = Real(matrix->GetArray()[i]);
+      }
+    }
+    const auto& box = bbox->GetArray();
+    const double x[] = { Real(box[0]), Real(box[2]) };
+    const double y[] = { Real(box[1]), Real(box[3]) };
+    for (size_t i = 0; i < 4; i++) {
+      const double px = x[i & 1], py = y[i >> 1];
+      bounds.Corners[i * 2] = m[0] * px + m[2] * py + m[4];
+      bounds.Corners[i * 2 + 1] = m[1] * px + m[3] * py + m[5];
+    }
+    XObjects[key.first.GetName()] = bounds;
+  }
+}
+
+Redactor::Matrix
+Redactor::Concat(const Matrix& m, const Matrix& ctm)
+{
+  return { { m[0] * ctm[0] + m[1] * ctm[2],
+             m[0] * ctm[1] + m[1] * ctm[3],
+             m[2] * ctm[0] + m[3] * ctm[2],
+             m[2] * ctm[1] + m[3] * ctm[3],
+             m[4] * ctm[0] + m[5] * ctm[2] + ctm[4],
+             m[4] * ctm[1] + m[5] * ctm[3] + ctm[5] } };
+}
+
+void
+Redactor::Transform(const Matrix& m, double* points, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    const double x = points[i * 2], y = points[i * 2 + 1];
+    points[i * 2] = m[0] * x + m[2] * y + m[4];
+    points[i * 2 + 1] = m[1] * x + m[3] * y + m[5];
+  }
+}
+
+bool
+Redactor::Intersects(const double* points, size_t count) const
+{
+  double left = std::numeric_limits<double>::max();
+  double bottom = left, right = -left, top = -left;
+  for (size_t i = 0; i < count; i++) {
+    left = std::min(left, points[i * 2]);
+    right = std::max(right, points[i * 2]);
+    bottom = std::min(bottom, points[i * 2 + 1]);
+    top = std::max(top, points[i * 2 + 1]);
+  }
+  // Bounds that only touch a rect do not intersect it, unless they are
+  // degenerate (a zero width glyph)
+  auto overlaps = [](double a0, double a1, double b0, double b1) {
+    const double overlap = std::min(a1, b1) - std::max(a0, b0);
+    return overlap > 0 || (a0 == a1 && overlap >= 0);
+  };
+  for (const auto& rect : Rects) {
+    if (overlaps(left,
+                 right,
+                 rect.GetLeft(),
+                 rect.GetLeft() + rect.GetWidth()) &&
+        overlaps(bottom,
+                 top,
+                 rect.GetBottom(),
+                 rect.GetBottom() + rect.GetHeight())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+double
+Redactor::Show(const PdfArray& shown,
+               const TextState& text,
+               const Matrix& tm,
+               const Matrix& ctm,
+               PdfArray& out,
+               bool& removed)
+{
+  const FontWidths unknown;
+  const auto& font = text.Font ? *text.Font : unknown;
+  const Matrix trm = Concat(tm, ctm);
+  const double scale = text.Size * text.Scale;
+  const double low = text.Rise + font.Descent / 1000 * text.Size;
+  const double high = text.Rise + font.Ascent / 1000 * text.Size;
+  double x = 0;
+  // displacement of the removed glyphs (and numbers) not yet written to out
+  double pending = 0;
+  string run;
+  auto flushRun = [&]() {
+    if (!run.empty()) {
+      out.push_back(
+        PdfString(run.data(), static_cast<pdf_long>(run.size()), true));
+      run.clear();
+    }
+  };
+  auto flushPending = [&]() {
+    if (pending != 0 && scale != 0) {
+      flushRun();
+      out.push_back(PdfVariant(-pending / scale * 1000));
+    }
+    pending = 0;
+  };
+  for (const auto& item : shown) {
+    if (item.IsNumber() || item.IsReal()) {
+      const double tx = -item.GetReal() / 1000 * scale;
+      pending += tx;
+      x += tx;
+      continue;
+    }
+    if (!item.IsString() && !item.IsHexString()) {
+      continue;
+    }
+    const auto& s = item.GetString();
+    const char* data = s.GetString();
+    const auto length = static_cast<size_t>(s.GetLength());
+    const auto bytes = static_cast<size_t>(font.CodeBytes);
+    for (size_t i = 0; i + bytes <= length; i += bytes) {
+      uint32_t code = 0;
+      for (size_t b = 0; b < bytes; b++) {
+        code = code << 8 | static_cast<unsigned char>(data[i + b]);
+      }
+      const double w = font.Width(code) / 1000;
+      const double tx =
+        (w * text.Size + text.CharSpacing +
+         (bytes == 1 && code == 32 ? text.WordSpacing : 0)) *
+        text.Scale;
+      double corners[] = { x, low, x + w * scale, low, x + w * scale, high,
+                           x, high };
+      Transform(trm, corners, 4);
+      if (Intersects(corners, 4)) {
+        pending += tx;
+        removed = true;
+        Result.Glyphs++;
+      } else {
+        flushPending();
+        run.append(data + i, bytes);
+      }
+      x += tx;
+    }
+  }
+  flushPending();
+  flushRun();
+  return x;
+}
+
+void
+Redactor::Run(const RedactOptions& options)
+{
+  Output.clear();
+  Output.reserve(Content.size() + 64);
+  Dropped.clear();
+  Drawn.clear();
+  if (options.Fill) {
+    Output += "q\n";
+  }
+  struct GraphicsState
+  {
+    Matrix Ctm;
+    TextState Text;
+  };
+  const Matrix identity = { { 1, 0, 0, 1, 0, 0 } };
+  GraphicsState state = { identity, {} };
+  vector<GraphicsState> stack;
+  Matrix tm = identity, tlm = identity;
+  auto nextLine = [&](double tx, double ty) {
+    tlm = Concat({ { 1, 0, 0, 1, tx, ty } }, tlm);
+    tm = tlm;
+  };
+
+  PdfContentsTokenizer tokenizer(Content.data(),
+                                 static_cast<pdf_long>(Content.size()));
+  EPdfContentsType type;
+  const char* keyword = nullptr;
+  PdfVariant value;
+  vector<PdfVariant> operands;
+  // BI ... ID data EI is written or dropped as a whole at EI
+  string inlineImage;
+  bool inInlineImage = false;
+  auto write = [&](string& to, const string& op) {
+    for (auto& operand : operands) {
+      to += Format(operand);
+      to += ' ';
+    }
+    to += op;
+    to += '\n';
+  };
+  while (tokenizer.ReadNext(type, keyword, value)) {
+    if (type == ePdfContentsType_Variant) {
+      operands.push_back(value);
+      continue;
+    }
+    if (type == ePdfContentsType_ImageData) {
+      inlineImage += Format(value);
+      inlineImage += '\n';
+      continue;
+    }
+    const string op(keyword);
+    bool keep = true;
+    if (op == "BI") {
+      inInlineImage = true;
+      inlineImage.clear();
+      write(inlineImage, op);
+      keep = false;
+    } else if (inInlineImage) {
+      keep = false;
+      if (op == "ID") {
+        write(inlineImage, op);
+      } else if (op == "EI") {
+        inInlineImage = false;
+        double corners[] = { 0, 0, 1, 0, 1, 1, 0, 1 };
+        Transform(state.Ctm, corners, 4);
+        if (Intersects(corners, 4)) {
+          Result.Images++;
+        } else {
+          Output += inlineImage;
+          Output += "EI\n";
+        }
+      }
+    } else if (op == "q") {
+      stack.push_back(state);
+    } else if (op == "Q") {
+      if (!stack.empty()) {
+        state = stack.back();
+        stack.pop_back();
+      }
+    } else if (op == "cm" && operands.size() == 6) {
+      Matrix m;
+      for (size_t i = 0; i < 6; i++) {
+        m[i] = Real(operands[i]);
+      }
+      state.Ctm = Concat(m, state.Ctm);
+    } else if (op == "BT") {
+      tm = tlm = identity;
+    } else if (op == "Tc" && !operands.empty()) {
+      state.Text.CharSpacing = Real(operands.back());
+    } else if (op == "Tw" && !operands.empty()) {
+      state.Text.WordSpacing = Real(operands.back());
+    } else if (op == "Tz" && !operands.empty()) {
+      state.Text.Scale = Real(operands.back()) / 100;
+    } else if (op == "TL" && !operands.empty()) {
+      state.Text.Leading = Real(operands.back());
+    } else if (op == "Ts" && !operands.empty()) {
+      state.Text.Rise = Real(operands.back());
+    } else if (op == "Tf" && operands.size() >= 2) {
+      const auto& name = operands[operands.size() - 2];
+      auto font = name.IsName() ? Fonts.find(name.GetName().GetName())
+                                : Fonts.end();
+      state.Text.Font = font == Fonts.end() ? nullptr : &font->second;
+      state.Text.Size = Real(operands.back());
+    } else if ((op == "Td" || op == "TD") && operands.size() >= 2) {
+      const double ty = Real(operands.back());
+      if (op == "TD") {
+        state.Text.Leading = -ty;
+      }
+      nextLine(Real(operands[operands.size() - 2]), ty);
+    } else if (op == "Tm" && operands.size() == 6) {
+      for (size_t i = 0; i < 6; i++) {
+        tm[i] = Real(operands[i]);
+      }
+      tlm = tm;
+    } else if (op == "T*") {
+      nextLine(0, -state.Text.Leading);
+    } else if ((op == "Tj" || op == "'" || op == "\"" || op == "TJ") &&
+               !operands.empty()) {
+      string prefix;
+      if (op == "'") {
+        nextLine(0, -state.Text.Leading);
+        prefix = "T*\n";
+      } else if (op == "\"" && operands.size() >= 3) {
+        const auto& aw = operands[operands.size() - 3];
+        const auto& ac = operands[operands.size() - 2];
+        state.Text.WordSpacing = Real(aw);
+        state.Text.CharSpacing = Real(ac);
+        nextLine(0, -state.Text.Leading);
+        prefix = Format(aw) + " Tw " + Format(ac) + " Tc T*\n";
+      }
+      PdfArray shown;
+      if (operands.back().IsArray()) {
+        shown = operands.back().GetArray();
+      } else {
+        shown.push_back(PdfObject(operands.back()));
+      }
+      PdfArray replacement;
+      bool removed = false;
+      const double tx =
+        Show(shown, state.Text, tm, state.Ctm, replacement, removed);
+      if (removed) {
+        keep = false;
+        Output += prefix;
+        Output += Format(PdfVariant(replacement));
+        Output += " TJ\n";
+      }
+      tm = Concat({ { 1, 0, 0, 1, tx, 0 } }, tm);
+    } else if (op == "Do" && !operands.empty() && operands.back().IsName()) {
+      const auto& name = operands.back().GetName().GetName();
+      auto xobj = XObjects.find(name);
+      if (xobj != XObjects.end()) {
+        double corners[8] = { 0, 0, 1, 0, 1, 1, 0, 1 };
+        if (!xobj->second.Image) {
+          std::copy(
+            xobj->second.Corners.begin(), xobj->second.Corners.end(), corners);
+        }
+        Transform(state.Ctm, corners, 4);
+        if (Intersects(corners, 4)) {
+          keep = false;
+          if (xobj->second.Image) {
+            Result.Images++;
+          } else {
+            Result.Forms++;
+          }
+          Dropped.insert(name);
+        }
+      }
+      if (keep) {
+        Drawn.insert(name);
+      }
+    }
+    if (keep) {
+      write(Output, op);
+    }
+    operands.clear();
+  }
+
+  if (options.Fill) {
+    Output += "Q\nq\n";
+    for (const auto& c : options.Color) {
+      Output += Format(PdfVariant(c));
+      Output += ' ';
+    }
+    Output += "rg\n";
+    for (const auto& rect : Rects) {
+      Output += Format(PdfVariant(rect.GetLeft())) + ' ' +
+                Format(PdfVariant(rect.GetBottom())) + ' ' +
+                Format(PdfVariant(rect.GetWidth())) + ' ' +
+                Format(PdfVariant(rect.GetHeight())) + " re\n";
+    }
+    Output += "f\nQ\n";
+  }
+  Modified = options.Fill || Result.Glyphs || Result.Images || Result.Forms;
+}
+
+void
+Redactor::Apply(PdfPage& page,
+                const std::set<PdfReference>& shared,
+                std::map<PdfReference, int>& xobjects)
+{
+  if (!Modified) {
+    return;
+  }
+  auto objects = page.GetObject()->GetOwner();
+  auto& dict = page.GetObject()->GetDictionary();
+  const auto streams = ContentStreams(page);
+  // Reuse the first content stream owned by this page only, the page's
+  // PdfContents keeps pointing at a live object
+  PdfObject* target = nullptr;
+  for (const auto& ref : streams) {
+    if (shared.find(ref) == shared.end()) {
+      target = objects->GetObject(ref);
+      if (target && target->HasStream()) {
+        break;
+      }
+      target = nullptr;
+    }
+  }
+  if (!target) {
+    target = objects->CreateObject();
+  }
+  target->GetDictionary().RemoveKey(PdfName(Name::DECODE_PARMS));
+  target->GetStream()->Set(Output.data(), static_cast<pdf_long>(Output.size()));
+  auto contents = Resolve(objects, dict.GetKey(PdfName(Name::CONTENTS)));
+  if (contents && contents->IsArray()) {
+    contents->GetArray().clear();
+    contents->GetArray().push_back(target->Reference());
+  } else if (contents != target) {
+    dict.AddKey(PdfName(Name::CONTENTS), target->Reference());
+  }
+  // The redacted content must not survive in an unreferenced stream
+  const std::set<PdfReference> unique(streams.begin(), streams.end());
+  for (const auto& ref : unique) {
+    if (ref != target->Reference() && shared.find(ref) == shared.end()) {
+      delete objects->RemoveObject(ref);
+    }
+  }
+  RemoveResources(page, xobjects);
+}
+
+void
+Redactor::RemoveResources(PdfPage& page,
+                          std::map<PdfReference, int>& references)
+{
+  vector<string> unused;
+  std::set_difference(Dropped.begin(),
+                      Dropped.end(),
+                      Drawn.begin(),
+                      Drawn.end(),
+                      std::back_inserter(unused));
+  auto objects = page.GetObject()->GetOwner();
+  auto resources = Resolve(objects, page.GetResources());
+  if (unused.empty() || !resources || !resources->IsDictionary()) {
+    return;
+  }
+  auto xobjects = Resolve(
+    objects, resources->GetDictionary().GetKey(PdfName(Name::XOBJECT)));
+  if (!xobjects || !xobjects->IsDictionary()) {
+    return;
+  }
+  // The resources may be inherited or shared with other pages, the page
+  // gets a direct copy without the unused entries
+  PdfDictionary copy(resources->GetDictionary());
+  PdfDictionary names(xobjects->GetDictionary());
+  vector<PdfReference> removed;
+  for (const auto& name : unused) {
+    auto value = names.GetKey(PdfName(name));
+    if (!value) {
+      continue;
+    }
+    if (value->IsReference()) {
+      removed.push_back(value->GetReference());
+    }
+    names.RemoveKey(PdfName(name));
+    Result.Resources++;
+  }
+  copy.AddKey(PdfName(Name::XOBJECT), names);
+  page.GetObject()->GetDictionary().AddKey(PdfName(Name::RESOURCES), copy);
+  // The redacted images must not survive in unreferenced objects, a plain
+  // write keeps every object
+  for (const auto& ref : removed) {
+    Unreference(objects, ref, references);
+  }
+}
+}
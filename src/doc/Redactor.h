@@ -0,0 +1,197 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_REDACTOR_H
+#define NPDF_REDACTOR_H
+
+#include <napi.h>
+#include <podofo/podofo.h>
+#include <array>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NoPoDoFo {
+
+/**
+ * Options of Page.redact and Document.redact
+ */
+struct RedactOptions
+{
+  // Paint the rects after the content below them is removed
+  bool Fill = true;
+  // DeviceRGB fill color
+  std::array<double, 3> Color = { { 0, 0, 0 } };
+  // Worker threads used by Document.redact, 0 uses the hardware concurrency
+  unsigned int Threads = 0;
+};
+
+RedactOptions
+ParseRedactOptions(const Napi::Object&);
+
+/**
+ * What redacting one page removed
+ */
+struct RedactReport
+{
+  // Glyphs removed from text show operators
+  size_t Glyphs = 0;
+  // Image XObject placements and inline images
+  size_t Images = 0;
+  // Form XObject placements, a form is removed whole
+  size_t Forms = 0;
+  // /Resources /XObject entries no remaining placement uses. XObjects no
+  // other page uses any more are deleted with them.
+  size_t Resources = 0;
+
+  Napi::Object ToJS(const Napi::Env&) const;
+};
+
+/**
+ * Redactor removes the content drawn under a set of rects from a page's
+ * content stream. Glyphs of text show operators that intersect a rect are
+ * replaced by the equivalent TJ displacement, so the remaining text keeps its
+ * position. Image XObjects, inline images and form XObjects are removed when
+ * their bounds intersect a rect, and so are the page's XObject resource
+ * entries nothing draws any more. Vector graphics are left untouched.
+ *
+ * Load and Apply read and write the document and run on the calling thread,
+ * Run only works on the data collected by Load and may run on any thread.
+ */
+class Redactor
+{
+public:
+  explicit Redactor(std::vector<PoDoFo::PdfRect> rects);
+
+  // Decode the page's content and collect the font widths and XObject
+  // bounds the content refers to
+  void Load(PoDoFo::PdfPage&);
+  void Run(const RedactOptions&);
+  // Replace the page's content when Run removed anything or fills the
+  // rects. Content streams in shared (used by other pages) are left in
+  // place, the others are reused or removed. XObject resources of removed
+  // placements are dropped from a copy of the page's resources, and the
+  // XObjects whose count in xobjects drops to zero are deleted.
+  void Apply(PoDoFo::PdfPage&,
+             const std::set<PoDoFo::PdfReference>& shared,
+             std::map<PoDoFo::PdfReference, int>& xobjects);
+
+  const RedactReport& Report() const { return Result; }
+  bool Empty() const { return Rects.empty(); }
+
+  // References of the content streams of every page, counted once per page
+  static std::map<PoDoFo::PdfReference, int> ContentReferences(
+    PoDoFo::PdfDocument&);
+  static std::vector<PoDoFo::PdfReference> ContentStreams(PoDoFo::PdfPage&);
+  // The page's content streams with a count above one in references
+  static std::set<PoDoFo::PdfReference> SharedContents(
+    const std::map<PoDoFo::PdfReference, int>& references,
+    PoDoFo::PdfPage&);
+  // Delete the content streams of before that no page uses any more, after
+  // pages sharing them were redacted
+  static void RemoveUnusedContents(
+    PoDoFo::PdfDocument&,
+    const std::map<PoDoFo::PdfReference, int>& before);
+  // Uses of each XObject: one per /XObject entry of every page's resources,
+  // and of the resources of the form XObjects they use (once per form)
+  static std::map<PoDoFo::PdfReference, int> XObjectReferences(
+    PoDoFo::PdfDocument&);
+
+  // Rect instances or a Float64Array of left, bottom, width, height values
+  static std::vector<PoDoFo::PdfRect> ParseRects(const Napi::Value&);
+
+private:
+  using Matrix = std::array<double, 6>;
+
+  struct FontWidths
+  {
+    // Bytes per character code, 2 for Type0 fonts
+    int CodeBytes = 1;
+    // Widths in glyph space, 1000 units per text space unit
+    std::unordered_map<uint32_t, double> Widths;
+    // Width of codes without an entry, a font that can not be read is
+    // assumed to be half an em wide
+    double DefaultWidth = 500;
+    double Ascent = 800;
+    double Descent = -200;
+
+    double Width(uint32_t code) const;
+  };
+
+  struct XObjectBounds
+  {
+    bool Image = false;
+    // Form XObject /BBox corners mapped by its /Matrix
+    std::array<double, 8> Corners;
+  };
+
+  struct TextState
+  {
+    const FontWidths* Font = nullptr;
+    double Size = 0;
+    double CharSpacing = 0;
+    double WordSpacing = 0;
+    double Scale = 1;
+    double Leading = 0;
+    double Rise = 0;
+  };
+
+  static Matrix Concat(const Matrix&, const Matrix&);
+  static void Transform(const Matrix&, double* points, size_t count);
+  static FontWidths Widths(PoDoFo::PdfVecObjects*, PoDoFo::PdfObject* font);
+  // Show a TJ array (a Tj string is a one element array) at tm, removed
+  // glyphs are replaced by displacements in out. Returns the total
+  // displacement in text space and whether anything was removed.
+  double Show(const PoDoFo::PdfArray&,
+              const TextState&,
+              const Matrix& tm,
+              const Matrix& ctm,
+              PoDoFo::PdfArray& out,
+              bool& removed);
+  bool Intersects(const double* corners, size_t points) const;
+  // Drop the XObject resources of Dropped names that are not also Drawn
+  void RemoveResources(PoDoFo::PdfPage&, std::map<PoDoFo::PdfReference, int>&);
+  // Count the XObjects of a /Resources dictionary, forms not in visited are
+  // counted recursively
+  static void CountXObjects(PoDoFo::PdfVecObjects*,
+                            PoDoFo::PdfObject* resources,
+                            std::map<PoDoFo::PdfReference, int>&,
+                            std::set<PoDoFo::PdfReference>& visited);
+  // Drop one use of an XObject, once it has none it is deleted and the
+  // XObjects of its own resources lose a use
+  static void Unreference(PoDoFo::PdfVecObjects*,
+                          const PoDoFo::PdfReference&,
+                          std::map<PoDoFo::PdfReference, int>&);
+
+  std::vector<PoDoFo::PdfRect> Rects;
+  std::string Content;
+  std::string Output;
+  std::map<std::string, FontWidths> Fonts;
+  std::map<std::string, XObjectBounds> XObjects;
+  // XObject names of removed placements and of the placements kept
+  std::set<std::string> Dropped;
+  std::set<std::string> Drawn;
+  RedactReport Result;
+  // Set by Run when the content has to be replaced
+  bool Modified = false;
+};
+}
+#endif // NPDF_REDACTOR_H
@@ -18,6 +18,7 @@
  */
 
 #include "SignatureField.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "../ValidateArguments.h"
 #include "../base/Data.h"
@@ -28,7 +29,6 @@
 #include "../doc/Annotation.h"
 #include "../doc/Document.h"
 #include "StreamDocument.h"
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -45,7 +45,6 @@ FunctionReference SignatureField::Constructor; // NOLINT
 SignatureField::SignatureField(const CallbackInfo& info)
   : ObjectWrap<SignatureField>(info)
 {
-  DbgLog = spdlog::get("DbgLog");
   try {
     // Create a new Signature Field
     if (info.Length() == 2) {
@@ -109,7 +108,7 @@ SignatureField::SignatureField(const CallbackInfo& info)
 
 SignatureField::~SignatureField()
 {
-  if(DbgLog != nullptr) DbgLog->debug("SignatureField Cleanup");
+  NPDF_LOG_DEBUG("SignatureField Cleanup");
 }
 
 
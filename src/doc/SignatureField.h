@@ -23,7 +23,6 @@
 #include <napi.h>
 #include <openssl/evp.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 
 using std::string;
 using std::vector;
@@ -66,7 +65,6 @@ private:
   std::shared_ptr<PoDoFo::PdfSignatureField> Self;
   std::unique_ptr<PoDoFo::PdfData> SigningContent;
   SignatureInfo Info;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
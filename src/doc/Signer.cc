@@ -18,6 +18,7 @@
  */
 
 #include "Signer.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "../ValidateArguments.h"
 #include "../base/Names.h"
@@ -32,7 +33,6 @@ using namespace PoDoFo;
 
 using std::string;
 using std::stringstream;
-using tl::nullopt;
 
 #if defined(_WIN64)
 #define fseeko _fseeki64
@@ -55,7 +55,6 @@ Signer::Signer(const Napi::CallbackInfo& info)
   : ObjectWrap(info)
   , Doc(Document::Unwrap(info[0].As<Object>())->GetDocument())
 {
-  DbgLog = spdlog::get("DbgLog");
   if (info.Length() < 1) {
     Error::New(info.Env(), "Document required to construct Signer")
       .ThrowAsJavaScriptException();
@@ -73,8 +72,7 @@ Signer::Signer(const Napi::CallbackInfo& info)
 
 Signer::~Signer()
 {
-  if(DbgLog != nullptr)
-    DbgLog->debug("Signer Cleanup");
+  NPDF_LOG_DEBUG("Signer Cleanup");
   HandleScope scope(Env());
   if (Cert != nullptr) {
     X509_free(Cert);
@@ -185,11 +183,9 @@ protected:
         PdfDate now;
         PdfString str;
         now.ToString(str);
-        if (Self.DbgLog) {
-          Self.DbgLog->debug("Signer::SignAsync::Execute SignatureField Date "
-                             "Null, setting to now: {}",
-                             str.GetStringUtf8());
-        }
+        NPDF_LOG_DEBUG("Signer::SignAsync::Execute SignatureField Date "
+                       "Null, setting to now: {}",
+                       str.GetStringUtf8());
 
         Self.Field->SetSignatureDate(now);
       }
@@ -489,14 +485,10 @@ Signer::LoadCertificateAndKey(const CallbackInfo& info)
   Function cb;
   const auto optPassword = "password";
   const auto optPrivateKey = "pKey";
-  vector<int> optsIndices =
-    AssertCallbackInfo(info,
-                       { { 0, // certificate
-                           { option(napi_string), option(napi_object) } },
-                         { 1, // opts object or callback function
-                           { option(napi_object), option(napi_function) } },
-                         { 2, // callback function
-                           { nullopt, option(napi_function) } } });
+  auto optsIndices =
+    AssertArguments<ArgTypes<napi_string, napi_object>,      // certificate
+                    ArgTypes<napi_object, napi_function>,    // opts or callback
+                    ArgTypes<ArgOmitted, napi_function>>(info); // callback
 
   if (optsIndices[0] == 0) {
     certFile = info[0].As<String>().Utf8Value();
@@ -31,7 +31,6 @@
 #include <openssl/ssl.h>
 #include <openssl/x509.h>
 #include <podofo/podofo.h>
-#include <spdlog/spdlog.h>
 
 using JsValue = Napi::Value;
 namespace NoPoDoFo {
@@ -56,7 +55,6 @@ public:
 
   EVP_PKEY* Pkey = nullptr;
   X509* Cert = nullptr;
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif
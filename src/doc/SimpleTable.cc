@@ -18,6 +18,7 @@
  */
 
 #include "SimpleTable.h"
+#include "../Logger.h"
 #include "../Defines.h"
 #include "../ErrorHandler.h"
 #include "../base/Color.h"
@@ -26,12 +27,9 @@
 #include "Page.h"
 #include "Painter.h"
 #include "StreamDocument.h"
-#include <optional/optional.hpp>
-#include <spdlog/spdlog.h>
 
 using namespace PoDoFo;
 using namespace Napi;
-using tl::nullopt;
 
 namespace NoPoDoFo {
 
@@ -40,12 +38,14 @@ FunctionReference SimpleTable::Constructor; // NOLINT
 SimpleTable::SimpleTable(const CallbackInfo& info)
   : ObjectWrap(info)
 {
-  DbgLog = spdlog::get("DbgLog");
   if (info[0].As<Object>().InstanceOf(Document::Constructor.Value())) {
-    Doc = Document::Unwrap(info[0].As<Object>())->Base;
+    Parent = Document::Unwrap(info[0].As<Object>());
   } else if (info[0].As<Object>().InstanceOf(
                StreamDocument::Constructor.Value())) {
-    Doc = StreamDocument::Unwrap(info[0].As<Object>())->Base;
+    Parent = StreamDocument::Unwrap(info[0].As<Object>());
+  }
+  if (Parent) {
+    Doc = Parent->Base;
   }
   const int cols = info[1].As<Number>();
   const int rows = info[2].As<Number>();
@@ -55,7 +55,7 @@ SimpleTable::SimpleTable(const CallbackInfo& info)
 
 SimpleTable::~SimpleTable()
 {
-  if(DbgLog != nullptr) DbgLog->debug("SimpleTable Cleanup");
+  NPDF_LOG_DEBUG("SimpleTable Cleanup");
   HandleScope scope(Env());
   delete Model;
   delete Table;
@@ -121,7 +121,8 @@ SimpleTable::GetFont(const CallbackInfo& info)
   const int col = info[0].As<Number>();
   const int row = info[1].As<Number>();
   return Font::Constructor.New(
-    { External<PdfFont>::New(info.Env(), Model->GetFont(col, row)) });
+    { External<PdfFont>::New(info.Env(), Model->GetFont(col, row)),
+      External<BaseDocument>::New(info.Env(), Parent) });
 }
 
 void
@@ -22,10 +22,10 @@
 
 #include <napi.h>
 #include <podofo/podofo.h>
-#include <spdlog/logger.h>
 using JsValue = Napi::Value;
 
 namespace NoPoDoFo {
+class BaseDocument;
 
 class SimpleTable : public Napi::ObjectWrap<SimpleTable>
 {
@@ -78,7 +78,7 @@ private:
   PoDoFo::PdfSimpleTableModel* Model = nullptr;
   PoDoFo::PdfTable* Table = nullptr;
   PoDoFo::PdfDocument* Doc = nullptr;
-  std::shared_ptr<spdlog::logger> DbgLog;
+  BaseDocument* Parent = nullptr;
 };
 }
 #endif // NPDF_SIMPLETABLE_H
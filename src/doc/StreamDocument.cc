@@ -18,10 +18,13 @@
  */
 
 #include "StreamDocument.h"
+#include "../Logger.h"
+#include "../ErrorHandler.h"
+#include "../base/Writer.h"
 #include "Encrypt.h"
 
+#include <cstdio>
 #include <iostream>
-#include <spdlog/spdlog.h>
 
 using namespace PoDoFo;
 using namespace Napi;
@@ -45,7 +48,7 @@ StreamDocument::StreamDocument(const CallbackInfo& info)
 }
 StreamDocument::~StreamDocument()
 {
- if(DbgLog != nullptr) DbgLog->debug("StreamDocument Cleanup");
+  NPDF_LOG_DEBUG("StreamDocument Cleanup");
 }
 void
 StreamDocument::Initialize(Napi::Env& env, Napi::Object& target)
@@ -77,6 +80,7 @@ StreamDocument::Initialize(Napi::Env& env, Napi::Object& target)
       InstanceMethod("displayDocTitle", &StreamDocument::SetDisplayDocTitle),
       InstanceMethod("useFullScreen", &StreamDocument::SetUseFullScreen),
       InstanceMethod("attachFile", &StreamDocument::AttachFile),
+      InstanceMethod("attachStream", &StreamDocument::AttachStream),
       InstanceMethod("insertExistingPage", &StreamDocument::InsertExistingPage),
       InstanceMethod("insertPage", &StreamDocument::InsertPage),
       InstanceMethod("append", &StreamDocument::Append),
@@ -92,6 +96,8 @@ StreamDocument::Initialize(Napi::Env& env, Napi::Object& target)
       InstanceMethod("createPages", &StreamDocument::CreatePages),
       InstanceMethod("createXObject", &StreamDocument::CreateXObject),
       InstanceMethod("getAttachment", &StreamDocument::GetAttachment),
+      InstanceMethod("addAnnotations", &StreamDocument::AddAnnotations),
+      InstanceMethod("getAnnotations", &StreamDocument::GetAnnotations),
       InstanceMethod("addNamedDestination",
                      &StreamDocument::AddNamedDestination)
 
@@ -105,6 +111,15 @@ JsValue
 StreamDocument::Close(const CallbackInfo& info)
 {
   GetStreamedDocument().Close();
+  Closed = true;
+  if (RepackOnClose()) {
+    try {
+      return Repack(info);
+    } catch (PdfError& err) {
+      ErrorHandler(err, info);
+      return info.Env().Undefined();
+    }
+  }
   if (Output.empty()) {
     return Napi::Value(Buffer<char>::Copy(info.Env(),
                                           StreamDocRefCountedBuffer->GetBuffer(),
@@ -112,6 +127,36 @@ StreamDocument::Close(const CallbackInfo& info)
   }
   return String::New(info.Env(), Output);
 }
+/**
+ * Rewrite the streamed (classic xref) output with object streams and/or
+ * linearized to the destination file, or to a new buffer when no destination
+ * was provided. The streamed output is parsed on demand and, with object
+ * streams, each object is released once written.
+ */
+JsValue
+StreamDocument::Repack(const CallbackInfo& info)
+{
+  WriteOptions opts;
+  opts.ObjectStreams = ObjectStreams;
+  opts.Linearize = Linearize;
+  if (!Spool.empty()) {
+    StreamDocOutputDevice->Flush();
+    {
+      const PdfRefCountedInputDevice input(Spool.c_str(), "rb");
+      PdfOutputDevice device(Output.c_str());
+      Writer::Rewrite(input, &device, opts, "", StreamDocEncrypt);
+    }
+    std::remove(Spool.c_str());
+    return String::New(info.Env(), Output);
+  }
+  const PdfRefCountedInputDevice input(StreamDocRefCountedBuffer->GetBuffer(),
+                                       StreamDocOutputDevice->GetLength());
+  PdfRefCountedBuffer packed;
+  PdfOutputDevice device(&packed);
+  Writer::Rewrite(input, &device, opts, "", StreamDocEncrypt);
+  return Buffer<char>::Copy(
+    info.Env(), packed.GetBuffer(), static_cast<size_t>(device.GetLength()));
+}
 void
 StreamDocument::Append(const Napi::CallbackInfo& info)
 {
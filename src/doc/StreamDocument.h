@@ -39,6 +39,7 @@ public:
   ~StreamDocument();
   static void Initialize(Napi::Env& env, Napi::Object& target);
   JsValue Close(const Napi::CallbackInfo&);
+  JsValue Repack(const Napi::CallbackInfo&);
   void Append(const Napi::CallbackInfo&) override;
   JsValue InsertExistingPage(const Napi::CallbackInfo&) override;
 
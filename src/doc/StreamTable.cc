@@ -0,0 +1,390 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StreamTable.h"
+#include "../Logger.h"
+#include "../ErrorHandler.h"
+#include "../base/Color.h"
+#include "Document.h"
+#include "Font.h"
+#include "Rect.h"
+#include "StreamDocument.h"
+#include "TextLayout.h"
+#include <algorithm>
+#include <cstdio>
+
+using namespace PoDoFo;
+using namespace Napi;
+
+using std::string;
+using std::vector;
+
+namespace NoPoDoFo {
+
+FunctionReference StreamTable::Constructor; // NOLINT
+
+/**
+ * info[0] Document or StreamDocument, info[1] options:
+ * { font, columns: [{ width, alignment?, decimals? }], header?, headerFont?,
+ *   headerBackground?, pageSize?, margin?, padding?, border?, wordWrap? }
+ */
+StreamTable::StreamTable(const CallbackInfo& info)
+  : ObjectWrap(info)
+{
+  if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsObject()) {
+    TypeError::New(info.Env(), "StreamTable requires a document and options")
+      .ThrowAsJavaScriptException();
+    return;
+  }
+  auto doc = info[0].As<Object>();
+  Owner = Persistent(doc);
+  if (doc.InstanceOf(Document::Constructor.Value())) {
+    Parent = Document::Unwrap(doc);
+  } else if (doc.InstanceOf(StreamDocument::Constructor.Value())) {
+    Parent = StreamDocument::Unwrap(doc);
+  } else {
+    TypeError::New(info.Env(), "requires an instance of BaseDocument")
+      .ThrowAsJavaScriptException();
+    return;
+  }
+  Doc = Parent->Base;
+  auto opts = info[1].As<Object>();
+  auto font = opts.Get("font");
+  if (!font.IsObject() ||
+      !font.As<Object>().InstanceOf(Font::Constructor.Value())) {
+    TypeError::New(info.Env(), "options.font must be an instance of Font")
+      .ThrowAsJavaScriptException();
+    return;
+  }
+  BodyFont = &Font::Unwrap(font.As<Object>())->GetFont();
+  auto headerFont = opts.Get("headerFont");
+  if (headerFont.IsObject() &&
+      headerFont.As<Object>().InstanceOf(Font::Constructor.Value())) {
+    HeaderFont = &Font::Unwrap(headerFont.As<Object>())->GetFont();
+  }
+  if (!opts.Get("columns").IsArray() ||
+      opts.Get("columns").As<Array>().Length() == 0) {
+    TypeError::New(info.Env(), "options.columns must be a non-empty array")
+      .ThrowAsJavaScriptException();
+    return;
+  }
+  auto columns = opts.Get("columns").As<Array>();
+  for (uint32_t i = 0; i < columns.Length(); i++) {
+    if (!columns.Get(i).IsObject() ||
+        !columns.Get(i).As<Object>().Get("width").IsNumber()) {
+      TypeError::New(info.Env(), "every column requires a width")
+        .ThrowAsJavaScriptException();
+      return;
+    }
+    auto c = columns.Get(i).As<Object>();
+    Column column;
+    column.Width = c.Get("width").As<Number>();
+    if (c.Get("alignment").IsNumber()) {
+      column.Alignment = static_cast<EPdfAlignment>(
+        c.Get("alignment").As<Number>().Int32Value());
+    }
+    if (c.Get("decimals").IsNumber()) {
+      column.Decimals = c.Get("decimals").As<Number>();
+    }
+    Columns.push_back(column);
+  }
+  if (opts.Get("header").IsArray()) {
+    auto header = opts.Get("header").As<Array>();
+    for (uint32_t i = 0; i < header.Length(); i++) {
+      Header.push_back(header.Get(i).ToString().Utf8Value());
+    }
+  }
+  auto background = opts.Get("headerBackground");
+  if (background.IsObject() &&
+      background.As<Object>().InstanceOf(Color::Constructor.Value())) {
+    HeaderBackground = std::make_unique<PdfColor>(
+      *Color::Unwrap(background.As<Object>())->Self);
+  }
+  auto pageSize = opts.Get("pageSize");
+  if (pageSize.IsObject() &&
+      pageSize.As<Object>().InstanceOf(Rect::constructor.Value())) {
+    PageSize = Rect::Unwrap(pageSize.As<Object>())->GetRect();
+  }
+  if (opts.Get("margin").IsNumber()) {
+    Margin = opts.Get("margin").As<Number>();
+  }
+  if (opts.Get("padding").IsNumber()) {
+    Padding = opts.Get("padding").As<Number>();
+  }
+  if (opts.Get("border").IsNumber()) {
+    Border = opts.Get("border").As<Number>();
+  }
+  if (opts.Get("wordWrap").IsBoolean()) {
+    WordWrap = opts.Get("wordWrap").As<Boolean>();
+  }
+  Painter = std::make_unique<PdfPainter>();
+}
+
+StreamTable::~StreamTable()
+{
+  NPDF_LOG_DEBUG("StreamTable Cleanup");
+  // the rows of a page left open are dropped, drawing into the document
+  // is not safe while it may be finalized itself
+  Painter.reset();
+  Doc = nullptr;
+  Parent = nullptr;
+  Owner.Reset();
+}
+
+void
+StreamTable::Initialize(Napi::Env& env, Napi::Object& target)
+{
+  HandleScope scope(env);
+  const auto ctor = DefineClass(
+    env,
+    "StreamTable",
+    { InstanceAccessor("pageCount", &StreamTable::GetPageCount, nullptr),
+      InstanceAccessor("rowCount", &StreamTable::GetRowCount, nullptr),
+      InstanceMethod("addRows", &StreamTable::AddRows),
+      InstanceMethod("draw", &StreamTable::Draw),
+      InstanceMethod("finish", &StreamTable::Finish) });
+  Constructor = Napi::Persistent(ctor);
+  Constructor.SuppressDestruct();
+  target.Set("StreamTable", ctor);
+}
+
+/**
+ * Render one chunk of rows: a flat, row major string[] or Float64Array with
+ * one value per column, or an array of rows (string[][])
+ */
+void
+StreamTable::AddRows(const CallbackInfo& info)
+{
+  if (Finished) {
+    throw Error::New(info.Env(), "StreamTable is finished");
+  }
+  try {
+    AddChunk(info[0]);
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+}
+
+/**
+ * Pull chunks from info[0], a function returning the next chunk (see
+ * addRows) or null / undefined when there are no more rows
+ */
+void
+StreamTable::Draw(const CallbackInfo& info)
+{
+  if (info.Length() < 1 || !info[0].IsFunction()) {
+    throw TypeError::New(info.Env(), "draw requires a function");
+  }
+  if (Finished) {
+    throw Error::New(info.Env(), "StreamTable is finished");
+  }
+  auto source = info[0].As<Function>();
+  try {
+    while (true) {
+      auto chunk = source.Call({});
+      if (chunk.IsNull() || chunk.IsUndefined()) {
+        break;
+      }
+      AddChunk(chunk);
+    }
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+}
+
+JsValue
+StreamTable::Finish(const CallbackInfo& info)
+{
+  try {
+    FinishPage();
+  } catch (PdfError& err) {
+    ErrorHandler(err, info);
+  }
+  Finished = true;
+  return Number::New(info.Env(), Pages);
+}
+
+JsValue
+StreamTable::GetPageCount(const CallbackInfo& info)
+{
+  return Number::New(info.Env(), Pages);
+}
+
+JsValue
+StreamTable::GetRowCount(const CallbackInfo& info)
+{
+  return Number::New(info.Env(), Rows);
+}
+
+void
+StreamTable::AddChunk(const Napi::Value& chunk)
+{
+  const size_t cols = Columns.size();
+  vector<string> cells(cols);
+  if (chunk.IsTypedArray() &&
+      chunk.As<TypedArray>().TypedArrayType() == napi_float64_array) {
+    auto values = chunk.As<Float64Array>();
+    if (values.ElementLength() % cols != 0) {
+      throw RangeError::New(chunk.Env(),
+                            "chunk length must be a multiple of the columns");
+    }
+    char buffer[64];
+    for (size_t r = 0; r < values.ElementLength() / cols; r++) {
+      for (size_t c = 0; c < cols; c++) {
+        double v = values[r * cols + c];
+        if (Columns[c].Decimals >= 0) {
+          snprintf(buffer, sizeof(buffer), "%.*f", Columns[c].Decimals, v);
+        } else {
+          snprintf(buffer, sizeof(buffer), "%.15g", v);
+        }
+        cells[c] = buffer;
+      }
+      Row(cells, false);
+    }
+  } else if (chunk.IsArray()) {
+    auto values = chunk.As<Array>();
+    if (values.Length() > 0 && values.Get(0u).IsArray()) {
+      for (uint32_t r = 0; r < values.Length(); r++) {
+        auto row = values.Get(r).As<Array>();
+        for (uint32_t c = 0; c < cols; c++) {
+          cells[c] =
+            c < row.Length() ? row.Get(c).ToString().Utf8Value() : string();
+        }
+        Row(cells, false);
+      }
+    } else {
+      if (values.Length() % cols != 0) {
+        throw RangeError::New(
+          chunk.Env(), "chunk length must be a multiple of the columns");
+      }
+      for (uint32_t r = 0; r < values.Length() / cols; r++) {
+        for (size_t c = 0; c < cols; c++) {
+          cells[c] = values.Get(static_cast<uint32_t>(r * cols + c))
+                       .ToString()
+                       .Utf8Value();
+        }
+        Row(cells, false);
+      }
+    }
+  } else {
+    throw TypeError::New(chunk.Env(),
+                         "rows must be a string[], string[][] or Float64Array");
+  }
+}
+
+void
+StreamTable::Row(const vector<string>& cells, bool header)
+{
+  PdfFont* font = header && HeaderFont ? HeaderFont : BodyFont;
+  const PdfFontMetrics* metrics = font->GetFontMetrics();
+  const double lineSpacing = metrics->GetLineSpacing();
+  auto table = Parent->Layout.Table(*font);
+  vector<vector<string>> lines(Columns.size());
+  size_t lineCount = 1;
+  for (size_t c = 0; c < Columns.size(); c++) {
+    if (WordWrap) {
+      lines[c] = Parent->Layout.Lines(
+        *font, cells[c], std::max(Columns[c].Width - 2 * Padding, 0.0));
+    } else {
+      lines[c].push_back(cells[c]);
+    }
+    lineCount = std::max(lineCount, lines[c].size());
+  }
+  const double height = lineCount * lineSpacing + 2 * Padding;
+  if (!header) {
+    if (!PageOpen ||
+        (RowsOnPage > 0 && Cursor - height < PageSize.GetBottom() + Margin)) {
+      NewPage();
+    }
+    Rows++;
+    RowsOnPage++;
+  }
+
+  double x = PageSize.GetLeft() + Margin;
+  const double top = Cursor;
+  if (header && HeaderBackground) {
+    double width = 0.0;
+    for (auto& column : Columns) {
+      width += column.Width;
+    }
+    Painter->Save();
+    Painter->SetColor(*HeaderBackground);
+    Painter->Rectangle(x, top - height, width, height);
+    Painter->Fill();
+    Painter->Restore();
+  }
+  Painter->SetFont(font);
+  const double baseline = top - Padding - metrics->GetAscent();
+  for (size_t c = 0; c < Columns.size(); c++) {
+    for (size_t i = 0; i < lines[c].size(); i++) {
+      const string& line = lines[c][i];
+      if (line.empty()) {
+        continue;
+      }
+      double offset = Padding;
+      if (Columns[c].Alignment != ePdfAlignment_Left) {
+        double free = Columns[c].Width - 2 * Padding - table->Width(line);
+        offset +=
+          Columns[c].Alignment == ePdfAlignment_Center ? free / 2.0 : free;
+      }
+      Painter->DrawText(
+        x + offset,
+        baseline - i * lineSpacing,
+        PdfString(reinterpret_cast<const pdf_utf8*>(line.c_str())));
+    }
+    if (Border > 0.0) {
+      Painter->Rectangle(x, top - height, Columns[c].Width, height);
+    }
+    x += Columns[c].Width;
+  }
+  if (Border > 0.0) {
+    Painter->Stroke();
+  }
+  Cursor -= height;
+}
+
+void
+StreamTable::NewPage()
+{
+  FinishPage();
+  PdfPage* page = Doc->CreatePage(PageSize);
+  Painter->SetPage(page);
+  if (Border > 0.0) {
+    Painter->SetStrokeWidth(Border);
+  }
+  PageOpen = true;
+  Pages++;
+  RowsOnPage = 0;
+  Cursor = PageSize.GetBottom() + PageSize.GetHeight() - Margin;
+  if (!Header.empty()) {
+    vector<string> header(Header);
+    header.resize(Columns.size());
+    Row(header, true);
+  }
+}
+
+void
+StreamTable::FinishPage()
+{
+  if (PageOpen) {
+    PageOpen = false;
+    Painter->FinishPage();
+  }
+}
+}
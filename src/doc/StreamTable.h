@@ -0,0 +1,93 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_STREAMTABLE_H
+#define NPDF_STREAMTABLE_H
+
+#include <napi.h>
+#include <podofo/podofo.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using JsValue = Napi::Value;
+
+namespace NoPoDoFo {
+class BaseDocument;
+
+/**
+ * StreamTable draws rows as they are added instead of building a complete
+ * PdfSimpleTableModel first. Rows are laid out with the cached font widths,
+ * a new page is created when the next row does not fit and the header row
+ * is repeated at the top of every page, so memory is bounded by the current
+ * row no matter how many rows are rendered.
+ */
+class StreamTable : public Napi::ObjectWrap<StreamTable>
+{
+public:
+  explicit StreamTable(const Napi::CallbackInfo&);
+  explicit StreamTable(const StreamTable&) = delete;
+  const StreamTable& operator=(const StreamTable&) = delete;
+  ~StreamTable();
+  static Napi::FunctionReference Constructor;
+  static void Initialize(Napi::Env&, Napi::Object&);
+  void AddRows(const Napi::CallbackInfo&);
+  void Draw(const Napi::CallbackInfo&);
+  JsValue Finish(const Napi::CallbackInfo&);
+  JsValue GetPageCount(const Napi::CallbackInfo&);
+  JsValue GetRowCount(const Napi::CallbackInfo&);
+
+private:
+  struct Column
+  {
+    double Width = 0.0;
+    PoDoFo::EPdfAlignment Alignment = PoDoFo::ePdfAlignment_Left;
+    int Decimals = -1; // -1 formats numbers with up to 15 significant digits
+  };
+
+  void AddChunk(const Napi::Value&);
+  void Row(const std::vector<std::string>&, bool header);
+  void NewPage();
+  void FinishPage();
+
+  PoDoFo::PdfDocument* Doc = nullptr;
+  BaseDocument* Parent = nullptr;
+  // keeps the document, and the fonts it owns, alive until the table is
+  // collected
+  Napi::ObjectReference Owner;
+  std::unique_ptr<PoDoFo::PdfPainter> Painter;
+  PoDoFo::PdfFont* BodyFont = nullptr;
+  PoDoFo::PdfFont* HeaderFont = nullptr;
+  std::vector<Column> Columns;
+  std::vector<std::string> Header;
+  std::unique_ptr<PoDoFo::PdfColor> HeaderBackground;
+  PoDoFo::PdfRect PageSize = PoDoFo::PdfRect(0, 0, 612, 792);
+  double Margin = 36.0;
+  double Padding = 2.0;
+  double Border = 0.5;
+  bool WordWrap = true;
+  double Cursor = 0.0; // top of the next row on the current page
+  bool PageOpen = false;
+  bool Finished = false;
+  size_t Pages = 0;
+  size_t Rows = 0;
+  size_t RowsOnPage = 0;
+};
+}
+#endif // NPDF_STREAMTABLE_H
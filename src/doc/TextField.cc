@@ -18,10 +18,10 @@
  */
 
 #include "TextField.h"
+#include "../Logger.h"
 #include "../ErrorHandler.h"
 #include "Document.h"
 #include "StreamDocument.h"
-#include <spdlog/spdlog.h>
 
 using namespace Napi;
 using namespace PoDoFo;
@@ -39,7 +39,6 @@ TextField::TextField(const CallbackInfo& info)
   , Field(ePdfField_TextField, info)
   , Self(GetField())
 {
-  DbgLog = spdlog::get("DbgLog");
   if (info[info.Length() - 1].IsObject() &&
       !info[info.Length() - 1].As<Object>().InstanceOf(
         Document::Constructor.Value()) &&
@@ -82,7 +81,7 @@ TextField::TextField(const CallbackInfo& info)
 }
 TextField::~TextField()
 {
- if(DbgLog != nullptr) DbgLog->debug("TextField Cleanup");
+ NPDF_LOG_DEBUG("TextField Cleanup");
 }
 void
 TextField::Initialize(Napi::Env& env, Napi::Object& target)
@@ -57,7 +57,6 @@ public:
   PoDoFo::PdfTextField GetText() const { return PoDoFo::PdfTextField(Self); }
   PoDoFo::PdfField& Self;
 private:
-  std::shared_ptr<spdlog::logger> DbgLog;
 };
 }
 #endif // NPDF_TEXTFIELD_H
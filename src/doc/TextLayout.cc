@@ -0,0 +1,393 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TextLayout.h"
+#include <algorithm>
+
+using namespace PoDoFo;
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace NoPoDoFo {
+
+static const uint32_t SoftHyphen = 0xAD;
+static const size_t RecentLimit = 4096;
+static const size_t TableLimit = 256;
+
+// Decode the code point at s[i] and advance i, invalid sequences decode to
+// their first byte
+static uint32_t
+NextCodePoint(const char* s, size_t n, size_t& i)
+{
+  auto b = static_cast<unsigned char>(s[i]);
+  size_t extra = b >= 0xF0 ? 3 : b >= 0xE0 ? 2 : b >= 0xC0 ? 1 : 0;
+  uint32_t cp = extra == 3 ? b & 0x07u : extra == 2 ? b & 0x0Fu : b & 0x1Fu;
+  if (extra == 0 || i + extra >= n) {
+    i++;
+    return b;
+  }
+  for (size_t k = 1; k <= extra; k++) {
+    auto c = static_cast<unsigned char>(s[i + k]);
+    if ((c & 0xC0) != 0x80) {
+      i++;
+      return b;
+    }
+    cp = (cp << 6) | (c & 0x3Fu);
+  }
+  i += extra + 1;
+  return cp;
+}
+
+static string
+RemoveSoftHyphens(const string& text)
+{
+  string clean;
+  clean.reserve(text.size());
+  for (size_t i = 0; i < text.size(); i++) {
+    if (static_cast<unsigned char>(text[i]) == 0xC2 && i + 1 < text.size() &&
+        static_cast<unsigned char>(text[i + 1]) == 0xAD) {
+      i++;
+      continue;
+    }
+    clean += text[i];
+  }
+  return clean;
+}
+
+WidthTable::WidthTable(const PdfFontMetrics* metrics)
+  : Metrics(metrics)
+  , Freetype(dynamic_cast<const PdfFontMetricsFreetype*>(metrics))
+  , Scale(static_cast<double>(metrics->GetFontSize()) *
+          static_cast<double>(metrics->GetFontScale()) / 100.0 / 1000.0)
+{
+  Ascii[0] = 0.0;
+  for (int c = 1; c < 128; c++) {
+    const char s[2] = { static_cast<char>(c), '\0' };
+    Ascii[c] = Metrics->StringWidth(s, 1);
+  }
+}
+
+double
+WidthTable::CodePointWidth(uint32_t cp)
+{
+  if (cp < 128) {
+    return Ascii[cp];
+  }
+  if (cp == SoftHyphen || cp > 0xFFFF) {
+    return 0.0;
+  }
+  std::lock_guard<std::mutex> guard(Lock);
+  auto it = Wide.find(cp);
+  if (it != Wide.end()) {
+    return it->second;
+  }
+  double w = Metrics->UnicodeCharWidth(static_cast<unsigned short>(cp));
+  Wide.emplace(cp, w);
+  return w;
+}
+
+double
+WidthTable::Kerning(uint32_t left, uint32_t right)
+{
+  if (!Freetype || !Freetype->HasKerning()) {
+    return 0.0;
+  }
+  // PdfFontMetricsFreetype reports kerning in 1/1000 em
+  return Freetype->GetKerning(static_cast<int>(Freetype->GetGlyphId(left)),
+                              static_cast<int>(Freetype->GetGlyphId(right))) *
+         Scale;
+}
+
+double
+WidthTable::Width(const string& text, bool kerning)
+{
+  return Width(text.data(), text.size(), kerning);
+}
+
+double
+WidthTable::Width(const char* text, size_t n, bool kerning)
+{
+  // four independent sums let the compiler pipeline ASCII runs
+  double w0 = 0.0, w1 = 0.0, w2 = 0.0, w3 = 0.0;
+  uint32_t previous = 0;
+  size_t i = 0;
+  while (i < n) {
+    if (!kerning) {
+      size_t end = i;
+      while (end < n && static_cast<unsigned char>(text[end]) < 0x80) {
+        end++;
+      }
+      const auto* p = reinterpret_cast<const unsigned char*>(text);
+      for (; i + 4 <= end; i += 4) {
+        w0 += Ascii[p[i]];
+        w1 += Ascii[p[i + 1]];
+        w2 += Ascii[p[i + 2]];
+        w3 += Ascii[p[i + 3]];
+      }
+      for (; i < end; i++) {
+        w0 += Ascii[p[i]];
+      }
+      if (i >= n) {
+        break;
+      }
+    }
+    uint32_t cp = NextCodePoint(text, n, i);
+    if (cp == SoftHyphen) {
+      continue;
+    }
+    w0 += CodePointWidth(cp);
+    if (kerning && previous) {
+      w0 += Kerning(previous, cp);
+    }
+    previous = cp;
+  }
+  return w0 + w1 + w2 + w3;
+}
+
+string
+TextLayout::TableKey(const PdfFontMetrics* metrics)
+{
+  // the metrics of a font live as long as the document owning this layout
+  return std::to_string(reinterpret_cast<uintptr_t>(metrics)) + '|' +
+         metrics->GetFontname() + '|' +
+         std::to_string(metrics->GetFontSize()) + '|' +
+         std::to_string(metrics->GetFontScale()) + '|' +
+         std::to_string(metrics->GetFontCharSpace()) + '|' +
+         std::to_string(metrics->GetWordSpace());
+}
+
+shared_ptr<WidthTable>
+TextLayout::Table(const PdfFont& font)
+{
+  const PdfFontMetrics* metrics = font.GetFontMetrics();
+  string key = TableKey(metrics);
+  std::lock_guard<std::mutex> guard(Lock);
+  auto it = Tables.find(key);
+  if (it != Tables.end()) {
+    return it->second;
+  }
+  if (Tables.size() >= TableLimit) {
+    Tables.clear();
+  }
+  auto table = std::make_shared<WidthTable>(metrics);
+  Tables.emplace(key, table);
+  return table;
+}
+
+void
+TextLayout::Clear()
+{
+  std::lock_guard<std::mutex> guard(Lock);
+  Tables.clear();
+  RecentIndex.clear();
+  Recent.clear();
+}
+
+vector<string>
+TextLayout::Lines(const PdfFont& font,
+                  const string& text,
+                  double width,
+                  const LayoutOptions& opts)
+{
+  vector<string> lines;
+  if (text.empty()) {
+    return lines;
+  }
+  string key;
+  if (!opts.Hyphenate) {
+    key = TableKey(font.GetFontMetrics()) + '|' + std::to_string(width) +
+          (opts.SkipSpaces ? 's' : '-') + (opts.Kerning ? 'k' : '-') + '|' +
+          text;
+    std::lock_guard<std::mutex> guard(Lock);
+    auto it = RecentIndex.find(key);
+    if (it != RecentIndex.end()) {
+      Recent.splice(Recent.begin(), Recent, it->second);
+      return it->second->second;
+    }
+  }
+  auto table = Table(font);
+  size_t start = 0;
+  while (start <= text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == string::npos) {
+      end = text.size();
+    }
+    size_t length = end - start;
+    if (length > 0 && text[end - 1] == '\r') {
+      length--;
+    }
+    Paragraph(*table, text.substr(start, length), width, opts, lines);
+    start = end + 1;
+  }
+  if (!opts.Hyphenate) {
+    std::lock_guard<std::mutex> guard(Lock);
+    if (RecentIndex.find(key) == RecentIndex.end()) {
+      Recent.emplace_front(key, lines);
+      RecentIndex.emplace(key, Recent.begin());
+      if (Recent.size() > RecentLimit) {
+        RecentIndex.erase(Recent.back().first);
+        Recent.pop_back();
+      }
+    }
+  }
+  return lines;
+}
+
+// Find the widest head of word, ending in a hyphen, that fits in avail. The
+// break candidates are soft hyphens and the indices returned by the hook.
+static bool
+Hyphenate(WidthTable& table,
+          const string& word,
+          double avail,
+          const LayoutOptions& opts,
+          string& head,
+          string& tail)
+{
+  // offsets[k] is the byte offset in word of the k-th visible code point
+  vector<size_t> offsets;
+  vector<size_t> candidates;
+  size_t i = 0;
+  while (i < word.size()) {
+    size_t at = i;
+    if (NextCodePoint(word.data(), word.size(), i) == SoftHyphen) {
+      candidates.push_back(offsets.size());
+    } else {
+      offsets.push_back(at);
+    }
+  }
+  offsets.push_back(word.size());
+  if (opts.Hyphenate) {
+    for (size_t k : opts.Hyphenate(RemoveSoftHyphens(word))) {
+      candidates.push_back(k);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  for (auto k = candidates.rbegin(); k != candidates.rend(); ++k) {
+    if (*k == 0 || *k >= offsets.size() - 1) {
+      continue;
+    }
+    string h = RemoveSoftHyphens(word.substr(0, offsets[*k])) + "-";
+    if (table.Width(h, opts.Kerning) <= avail) {
+      head = h;
+      tail = word.substr(offsets[*k]);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Split word after the last code point that fits in avail, at least one code
+// point always goes to head
+static void
+SplitWord(WidthTable& table,
+          const string& word,
+          double avail,
+          const LayoutOptions& opts,
+          string& head,
+          string& tail)
+{
+  size_t i = 0;
+  size_t fit = 0;
+  while (i < word.size()) {
+    NextCodePoint(word.data(), word.size(), i);
+    if (fit > 0 && table.Width(word.data(), i, opts.Kerning) > avail) {
+      break;
+    }
+    fit = i;
+  }
+  head = RemoveSoftHyphens(word.substr(0, fit));
+  tail = word.substr(fit);
+}
+
+void
+TextLayout::Paragraph(WidthTable& table,
+                      const string& text,
+                      double width,
+                      const LayoutOptions& opts,
+                      vector<string>& lines)
+{
+  const size_t first = lines.size();
+  string line;
+  string space; // spaces between line and the next word
+  double lineWidth = 0.0;
+  size_t i = 0;
+  while (i < text.size()) {
+    size_t start = i;
+    if (text[i] == ' ') {
+      while (i < text.size() && text[i] == ' ') {
+        i++;
+      }
+      space.append(text, start, i - start);
+      continue;
+    }
+    while (i < text.size() && text[i] != ' ') {
+      i++;
+    }
+    string word = text.substr(start, i - start);
+    bool dropSpace = line.empty() && opts.SkipSpaces;
+    double spaceWidth = dropSpace ? 0.0 : table.Width(space);
+    double wordWidth = table.Width(word, opts.Kerning);
+    if (lineWidth + spaceWidth + wordWidth <= width) {
+      if (!dropSpace) {
+        line += space;
+      }
+      line += word;
+      lineWidth += spaceWidth + wordWidth;
+      space.clear();
+      continue;
+    }
+    if (!line.empty()) {
+      string head, tail;
+      if (Hyphenate(
+            table, word, width - lineWidth - spaceWidth, opts, head, tail)) {
+        line += space;
+        line += head;
+        word = tail;
+      } else if (!opts.SkipSpaces) {
+        line += space;
+      }
+      lines.push_back(RemoveSoftHyphens(line));
+      line.clear();
+      lineWidth = 0.0;
+    }
+    space.clear();
+    while (table.Width(word, opts.Kerning) > width) {
+      string head, tail;
+      if (!Hyphenate(table, word, width, opts, head, tail)) {
+        SplitWord(table, word, width, opts, head, tail);
+      }
+      if (tail.empty()) {
+        break;
+      }
+      lines.push_back(head);
+      word = tail;
+    }
+    line = word;
+    lineWidth = table.Width(word, opts.Kerning);
+  }
+  if (!opts.SkipSpaces) {
+    line += space;
+  }
+  if (!line.empty() || lines.size() == first) {
+    lines.push_back(RemoveSoftHyphens(line));
+  }
+}
+}
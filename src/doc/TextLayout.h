@@ -0,0 +1,124 @@
+/**
+ * This file is part of the NoPoDoFo (R) project.
+ * Copyright (c) 2017-2019
+ * Authors: Cory Mickelson, et al.
+ *
+ * NoPoDoFo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NoPoDoFo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NPDF_TEXTLAYOUT_H
+#define NPDF_TEXTLAYOUT_H
+
+#include <podofo/podofo.h>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NoPoDoFo {
+
+/**
+ * Glyph advance widths of one font at one size, scale, char and word
+ * spacing, indexed by code point. ASCII widths are filled when the table is
+ * created, other code points on first use.
+ */
+class WidthTable
+{
+public:
+  explicit WidthTable(const PoDoFo::PdfFontMetrics*);
+  explicit WidthTable(const WidthTable&) = delete;
+  const WidthTable& operator=(const WidthTable&) = delete;
+
+  /**
+   * Width of UTF-8 text in PDF points, kerning adds the font's pair
+   * adjustments (TrueType / OpenType fonts loaded through FreeType only)
+   */
+  double Width(const std::string&, bool kerning = false);
+  double Width(const char*, size_t, bool kerning = false);
+  double CodePointWidth(uint32_t);
+
+private:
+  double Kerning(uint32_t left, uint32_t right);
+
+  const PoDoFo::PdfFontMetrics* Metrics;
+  const PoDoFo::PdfFontMetricsFreetype* Freetype = nullptr;
+  double Scale; // font size * font scale, converts 1/1000 em to points
+  double Ascii[128];
+  std::unordered_map<uint32_t, double> Wide;
+  std::mutex Lock;
+};
+
+struct LayoutOptions
+{
+  bool SkipSpaces = true;
+  bool Kerning = false;
+  // Returns the character indices of a word where it may be hyphenated.
+  // Soft hyphens (U+00AD) in the text are always break opportunities.
+  std::function<std::vector<size_t>(const std::string&)> Hyphenate;
+};
+
+/**
+ * Text measuring and line breaking on cached width tables. Every document
+ * owns one TextLayout for the fonts it owns, width tables are shared by
+ * font metrics and size, the lines of recently broken paragraphs are kept
+ * in a bounded LRU cache (not used with a Hyphenate hook, whose results may
+ * change between calls).
+ */
+class TextLayout
+{
+public:
+  TextLayout() = default;
+  explicit TextLayout(const TextLayout&) = delete;
+  const TextLayout& operator=(const TextLayout&) = delete;
+
+  std::shared_ptr<WidthTable> Table(const PoDoFo::PdfFont&);
+
+  /**
+   * Break UTF-8 text into lines no wider than width. Newlines always break,
+   * words longer than a line are hyphenated when possible and split between
+   * characters otherwise.
+   */
+  std::vector<std::string> Lines(const PoDoFo::PdfFont&,
+                                 const std::string& text,
+                                 double width,
+                                 const LayoutOptions& = {});
+
+  /**
+   * Drop every cached table and line, called when the fonts of the document
+   * are freed
+   */
+  void Clear();
+
+private:
+  static void Paragraph(WidthTable&,
+                        const std::string&,
+                        double width,
+                        const LayoutOptions&,
+                        std::vector<std::string>& lines);
+  static std::string TableKey(const PoDoFo::PdfFontMetrics*);
+
+  std::mutex Lock;
+  std::unordered_map<std::string, std::shared_ptr<WidthTable>> Tables;
+  std::list<std::pair<std::string, std::vector<std::string>>> Recent;
+  std::unordered_map<
+    std::string,
+    std::list<std::pair<std::string, std::vector<std::string>>>::iterator>
+    RecentIndex;
+};
+}
+#endif // NPDF_TEXTLAYOUT_H